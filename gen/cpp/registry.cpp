@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #include <halley.hpp>
 using namespace Halley;
 
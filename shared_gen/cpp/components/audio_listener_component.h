@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -40,4 +40,9 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(speedOfSound)>::deserialize(speedOfSound, float{ 343 }, _context, _node, componentName, "speedOfSound", makeMask(Type::Prefab));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(referenceDistance)>::serialize(referenceDistance, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(lastPos)>::serialize(lastPos, _context, _s);
+	}
+
 };
@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -46,4 +46,10 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(canAutoVel)>::deserialize(canAutoVel, bool{ false }, _context, _node, componentName, "canAutoVel", makeMask(Type::Prefab));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(event)>::serialize(event, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(rangeMin)>::serialize(rangeMin, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(rangeMax)>::serialize(rangeMax, _context, _s);
+	}
+
 };
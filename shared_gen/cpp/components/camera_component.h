@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -40,4 +40,10 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(offset)>::deserialize(offset, Halley::Vector2f{}, _context, _node, componentName, "offset", makeMask(Type::Prefab, Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(zoom)>::serialize(zoom, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(id)>::serialize(id, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(offset)>::serialize(offset, _context, _s);
+	}
+
 };
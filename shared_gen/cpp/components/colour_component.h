@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -32,4 +32,8 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(colour)>::deserialize(colour, Halley::Colour4f{ "#FFFFFF" }, _context, _node, componentName, "colour", makeMask(Type::Prefab, Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(colour)>::serialize(colour, _context, _s);
+	}
+
 };
@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -32,4 +32,7 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(script)>::deserialize(script, Halley::ScriptGraph{}, _context, _node, componentName, "script", makeMask(Type::Prefab));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+	}
+
 };
@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -32,4 +32,9 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(sendUpdates)>::deserialize(sendUpdates, bool{ false }, _context, _node, componentName, "sendUpdates", makeMask(Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(locks)>::serialize(locks, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(sendUpdates)>::serialize(sendUpdates, _context, _s);
+	}
+
 };
@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -48,4 +48,12 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(mask)>::deserialize(mask, Halley::OptionalLite<int>{}, _context, _node, componentName, "mask", makeMask(Type::Prefab, Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(particles)>::serialize(particles, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(sprites)>::serialize(sprites, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(animation)>::serialize(animation, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(layer)>::serialize(layer, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(mask)>::serialize(mask, _context, _s);
+	}
+
 };
@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -42,4 +42,10 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(variables)>::deserialize(variables, Halley::ScriptVariables{}, _context, _node, componentName, "variables", makeMask(Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(activeStates)>::serialize(activeStates, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(tags)>::serialize(tags, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(variables)>::serialize(variables, _context, _s);
+	}
+
 };
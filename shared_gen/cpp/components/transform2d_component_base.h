@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -9,6 +9,7 @@ class Transform2DComponentBase : public Halley::Component {
 public:
 	static constexpr int componentIndex{ 0 };
 	static const constexpr char* componentName{ "Transform2D" };
+	static constexpr std::array<Halley::NetworkQuantizedField, 2> networkQuantizedFields{ Halley::NetworkQuantizedField{ "position", Halley::BitQuantization::makeFloat2(-262144, 262144, 0.03125) }, Halley::NetworkQuantizedField{ "rotation", Halley::BitQuantization::makeAngle(14) } };
 
 	Transform2DComponentBase() {
 	}
@@ -42,6 +43,14 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(subWorld)>::deserialize(subWorld, Halley::OptionalLite<int16_t>{}, _context, _node, componentName, "subWorld", makeMask(Type::Prefab, Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(position)>::serialize(position, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(scale)>::serialize(scale, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(rotation)>::serialize(rotation, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(height)>::serialize(height, _context, _s);
+		Halley::EntityNetworkStateSerializer<decltype(subWorld)>::serialize(subWorld, _context, _s);
+	}
+
 protected:
 	Halley::Vector2f position{};
 	Halley::Vector2f scale{ 1.0f, 1.0f };
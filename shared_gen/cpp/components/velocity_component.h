@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 125
 #pragma once
 
 #ifndef DONT_INCLUDE_HALLEY_HPP
@@ -32,4 +32,8 @@ public:
 		Halley::EntityConfigNodeSerializer<decltype(velocity)>::deserialize(velocity, Halley::Vector2f{}, _context, _node, componentName, "velocity", makeMask(Type::Prefab, Type::SaveData, Type::Network));
 	}
 
+	void serializeNetworkState(const Halley::EntitySerializationContext& _context, Halley::Serializer& _s) const {
+		Halley::EntityNetworkStateSerializer<decltype(velocity)>::serialize(velocity, _context, _s);
+	}
+
 };
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <gsl/gsl>
+#include "halley/data_structures/vector.h"
+
+namespace Halley {
+	// Describes how a value is quantized into a fixed number of bits by BitSerializer
+	// Float and Float2 map [min, max] in steps of precision, Angle maps degrees in [0, 360) to the given number of bits, and Int maps [min, max] exactly.
+	class BitQuantization {
+	public:
+		enum class Type : uint8_t {
+			Float,
+			Float2,
+			Angle,
+			Int
+		};
+
+		Type type = Type::Float;
+		double min = 0;
+		double max = 0;
+		double precision = 1;
+		uint8_t bits = 0;
+
+		constexpr BitQuantization() = default;
+		constexpr BitQuantization(Type type, double min, double max, double precision, uint8_t bits)
+			: type(type)
+			, min(min)
+			, max(max)
+			, precision(precision)
+			, bits(bits)
+		{}
+
+		constexpr static BitQuantization makeFloat(double min, double max, double precision)
+		{
+			return BitQuantization(Type::Float, min, max, precision, getBitsForSteps(static_cast<uint64_t>((max - min) / precision + 0.999)));
+		}
+
+		constexpr static BitQuantization makeFloat2(double min, double max, double precision)
+		{
+			return BitQuantization(Type::Float2, min, max, precision, getBitsForSteps(static_cast<uint64_t>((max - min) / precision + 0.999)));
+		}
+
+		constexpr static BitQuantization makeAngle(int bits)
+		{
+			return BitQuantization(Type::Angle, 0, 360, 360.0 / static_cast<double>(uint64_t(1) << bits), static_cast<uint8_t>(bits));
+		}
+
+		constexpr static BitQuantization makeInt(int64_t min, int64_t max)
+		{
+			return BitQuantization(Type::Int, static_cast<double>(min), static_cast<double>(max), 1, getBitsForSteps(static_cast<uint64_t>(max - min)));
+		}
+
+		uint64_t quantize(double value) const;
+		double dequantize(uint64_t value) const;
+
+		constexpr static uint8_t getBitsForSteps(uint64_t steps)
+		{
+			uint8_t n = 0;
+			while (n < 64 && (steps >> n) != 0) {
+				++n;
+			}
+			return n;
+		}
+	};
+
+	struct NetworkQuantizedField {
+		std::string_view name;
+		BitQuantization quantization;
+	};
+
+	class BitSerializer {
+	public:
+		explicit BitSerializer(Bytes& dst); // Clears dst, output is padded to a whole byte
+
+		void writeBits(uint64_t value, int nBits);
+		void writeBool(bool value);
+		void writeVarUInt(uint64_t value);
+		void writeQuantized(double value, const BitQuantization& quantization);
+
+		size_t getBitPosition() const { return bitPos; }
+
+	private:
+		Bytes& dst;
+		size_t bitPos = 0;
+	};
+
+	class BitDeserializer {
+	public:
+		explicit BitDeserializer(gsl::span<const gsl::byte> src);
+
+		uint64_t readBits(int nBits);
+		bool readBool();
+		uint64_t readVarUInt();
+		double readQuantized(const BitQuantization& quantization);
+
+		size_t getBitPosition() const { return bitPos; }
+
+	private:
+		gsl::span<const gsl::byte> src;
+		size_t bitPos = 0;
+	};
+}
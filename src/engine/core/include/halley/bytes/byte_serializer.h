@@ -69,15 +69,14 @@ namespace Halley {
 	public:
 		Serializer(SerializerOptions options);
 		explicit Serializer(gsl::span<gsl::byte> dst, SerializerOptions options);
+		explicit Serializer(Bytes& dst, SerializerOptions options); // Clears dst and grows it as data is written, keeping its capacity
+		explicit Serializer(Vector<Bytes>& dstChunks, size_t chunkSize, SerializerOptions options); // Appends chunks of up to chunkSize bytes, to avoid one huge allocation
 
 		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
 		static Bytes toBytes(const T& f, SerializerOptions options = {})
 		{
-			auto dry = Serializer(options);
-			f(dry);
-			Bytes result(dry.getSize());
-			auto s = Serializer(gsl::as_writable_bytes(gsl::span<Halley::Byte>(result)), options);
-			f(s);
+			Bytes result;
+			toBytesInto(f, result, std::move(options));
 			return result;
 		}
 
@@ -86,6 +85,35 @@ namespace Halley {
 		{
 			return toBytes([&value](Serializer& s) { s << value; }, options);
 		}
+
+		// Same as toBytes, but writes into an existing buffer, so callers serializing every frame can reuse its memory
+		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static void toBytesInto(const T& f, Bytes& dst, SerializerOptions options = {})
+		{
+			auto s = Serializer(dst, std::move(options));
+			f(s);
+		}
+
+		template <typename T, typename std::enable_if<!std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static void toBytesInto(const T& value, Bytes& dst, SerializerOptions options = {})
+		{
+			toBytesInto([&value](Serializer& s) { s << value; }, dst, std::move(options));
+		}
+
+		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static Vector<Bytes> toChunks(const T& f, size_t chunkSize, SerializerOptions options = {})
+		{
+			Vector<Bytes> result;
+			auto s = Serializer(result, chunkSize, std::move(options));
+			f(s);
+			return result;
+		}
+
+		template <typename T, typename std::enable_if<!std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
+		static Vector<Bytes> toChunks(const T& value, size_t chunkSize, SerializerOptions options = {})
+		{
+			return toChunks([&value](Serializer& s) { s << value; }, chunkSize, std::move(options));
+		}
 		
 		template <typename T, typename std::enable_if<std::is_convertible<T, std::function<void(Serializer&)>>::value, int>::type = 0>
 		static size_t getSize(const T& f, SerializerOptions options = {})
@@ -258,9 +286,19 @@ namespace Halley {
 		}
 
 	private:
+		enum class Mode : uint8_t {
+			DryRun,
+			Span,
+			Growable,
+			Chunked
+		};
+
 		size_t size = 0;
 		gsl::span<gsl::byte> dst;
-		bool dryRun;
+		Bytes* growableDst = nullptr;
+		Vector<Bytes>* chunkedDst = nullptr;
+		size_t chunkSize = 0;
+		Mode mode;
 
 		template <typename T>
 		Serializer& serializePod(T val)
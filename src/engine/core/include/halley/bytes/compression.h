@@ -1,9 +1,12 @@
 #pragma once
 #include "../utils/utils.h"
+#include <array>
 #include <gsl/gsl>
 #include <limits>
 #include <optional>
 
+struct z_stream_s;
+
 namespace Halley {
 	class Compression {
 	public:
@@ -42,5 +45,39 @@ namespace Halley {
 		static Bytes lz4CompressFile(gsl::span<const gsl::byte> src, gsl::span<const gsl::byte> header, LZ4Options options = {});
 		static Bytes lz4DecompressFile(gsl::span<const gsl::byte> src, gsl::span<gsl::byte> header);
 		static std::shared_ptr<const char> lz4DecompressFileToSharedPtr(gsl::span<const gsl::byte> src, gsl::span<gsl::byte> header, size_t& outSize);
+
+		// Chunked LZ4 files compress every chunk on its own, and start with a table of where each chunk lives, so any part of them can be decompressed without the rest.
+		// Layout: LZ4ChunkedHeader, then numChunks + 1 offsets (uint64_t, from the start of the file), then the chunks. Chunks that don't shrink are stored as they are.
+		struct LZ4ChunkedHeader {
+			std::array<char, 8> id;
+			uint32_t chunkSize;
+			uint32_t numChunks;
+			uint64_t size;
+		};
+
+		constexpr static size_t defaultLZ4ChunkSize = 64 * 1024;
+
+		static Bytes lz4CompressChunked(gsl::span<const gsl::byte> src, size_t chunkSize = defaultLZ4ChunkSize, LZ4Options options = {});
+		static std::shared_ptr<const char> lz4DecompressChunkedToSharedPtr(gsl::span<const gsl::byte> src, size_t& outSize);
+		static LZ4ChunkedHeader lz4ReadChunkedHeader(gsl::span<const gsl::byte> src);
+		static size_t lz4GetChunkedTableSize(const LZ4ChunkedHeader& header);
+		static void lz4DecompressChunk(const LZ4ChunkedHeader& header, size_t chunkIdx, gsl::span<const gsl::byte> src, gsl::span<gsl::byte> dst);
+	};
+
+	// Inflates raw deflate streams (as written by Compression::compressRaw), reusing zlib's state and the output buffer between calls
+	// Use this instead of Compression::decompressRaw when inflating many small buffers, such as network packets
+	class ZlibInflater {
+	public:
+		ZlibInflater();
+		~ZlibInflater();
+
+		ZlibInflater(const ZlibInflater& other) = delete;
+		ZlibInflater& operator=(const ZlibInflater& other) = delete;
+
+		// Replaces the contents of dst, keeping its capacity
+		void decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSize, Bytes& dst);
+
+	private:
+		std::unique_ptr<z_stream_s> stream;
 	};
 }
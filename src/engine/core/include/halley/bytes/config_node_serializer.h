@@ -6,6 +6,7 @@
 #include "halley/maths/rect.h"
 #include "halley/utils/type_traits.h"
 #include "config_node_serializer_base.h"
+#include "byte_serializer.h"
 #include <set>
 
 
@@ -776,6 +777,128 @@ namespace Halley {
 		}
 	};
 
+	// Writes a networked component field into a compact binary form, used by the network session to find out which entities changed
+	// without serializing them to ConfigNode. The output is only ever compared, never read back, so it just needs to be deterministic.
+	// Types without a specialisation go through their ConfigNode serialization.
+	template <typename T, typename Enable = void>
+	class EntityNetworkStateSerializer {
+	public:
+		static void serialize(const T& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << ConfigNodeHelper<T>::serialize(value, context);
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>> {
+	public:
+		static void serialize(T value, const EntitySerializationContext& context, Serializer& s)
+		{
+			if constexpr (std::is_same_v<T, bool>) {
+				s << value;
+			} else if constexpr (std::is_floating_point_v<T>) {
+				s << static_cast<double>(value);
+			} else if constexpr (std::is_enum_v<T>) {
+				s << static_cast<int64_t>(value);
+			} else if constexpr (std::is_signed_v<T>) {
+				s << static_cast<int64_t>(value);
+			} else {
+				s << static_cast<uint64_t>(value);
+			}
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Vector2D<T>> {
+	public:
+		static void serialize(const Vector2D<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			EntityNetworkStateSerializer<T>::serialize(value.x, context, s);
+			EntityNetworkStateSerializer<T>::serialize(value.y, context, s);
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Vector4D<T>> {
+	public:
+		static void serialize(const Vector4D<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value;
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Colour4<T>> {
+	public:
+		static void serialize(const Colour4<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value;
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Rect2D<T>> {
+	public:
+		static void serialize(const Rect2D<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value;
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Angle<T>> {
+	public:
+		static void serialize(const Angle<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			EntityNetworkStateSerializer<T>::serialize(value.getRadians(), context, s);
+		}
+	};
+
+	template <>
+	class EntityNetworkStateSerializer<String> {
+	public:
+		static void serialize(const String& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value;
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<std::optional<T>> {
+	public:
+		static void serialize(const std::optional<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value.has_value();
+			if (value) {
+				EntityNetworkStateSerializer<T>::serialize(*value, context, s);
+			}
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<OptionalLite<T>> {
+	public:
+		static void serialize(const OptionalLite<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value.has_value();
+			if (value) {
+				EntityNetworkStateSerializer<T>::serialize(*value, context, s);
+			}
+		}
+	};
+
+	template <typename T>
+	class EntityNetworkStateSerializer<Vector<T>> {
+	public:
+		static void serialize(const Vector<T>& value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << static_cast<uint64_t>(value.size());
+			for (const auto& v: value) {
+				EntityNetworkStateSerializer<T>::serialize(v, context, s);
+			}
+		}
+	};
+
 	template<>
 	class ConfigNodeSerializer<ConfigNode>
 	{
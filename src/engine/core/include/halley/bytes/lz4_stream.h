@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <gsl/gsl>
+#include "halley/utils/utils.h"
+
+union LZ4_stream_u;
+
+namespace Halley {
+	// Compresses a sequence of blocks with LZ4, where each block can reference the dictionary and the blocks before it.
+	// Blocks must be decompressed in the same order by a LZ4StreamDecompressor using the same dictionary.
+	// Both sides keep the last 64 KB of history in a window, sliding it when it fills up, so they always stay in sync.
+	class LZ4StreamCompressor {
+	public:
+		explicit LZ4StreamCompressor(std::shared_ptr<const Bytes> dictionary = {});
+		~LZ4StreamCompressor();
+
+		LZ4StreamCompressor(const LZ4StreamCompressor& other) = delete;
+		LZ4StreamCompressor(LZ4StreamCompressor&& other) noexcept;
+		LZ4StreamCompressor& operator=(const LZ4StreamCompressor& other) = delete;
+		LZ4StreamCompressor& operator=(LZ4StreamCompressor&& other) noexcept;
+
+		// Forgets every block compressed so far, going back to just the dictionary
+		void reset();
+
+		// True if no blocks have been compressed since the last reset, so the next one starts the stream
+		bool isAtStart() const;
+
+		// Blocks larger than this can't be compressed by the stream
+		static size_t getMaxBlockSize();
+
+		// Appends the compressed block to dst, returning its size
+		size_t compress(gsl::span<const gsl::byte> src, Bytes& dst, int acceleration = 1);
+
+		// Like compress, but the block only references the dictionary, so it can be decompressed on its own and in any order.
+		// Doesn't affect the stream.
+		size_t compressIndependent(gsl::span<const gsl::byte> src, Bytes& dst, int acceleration = 1);
+
+	private:
+		std::shared_ptr<const Bytes> dictionary;
+		LZ4_stream_u* stream = nullptr;
+		LZ4_stream_u* dictionaryStream = nullptr;
+		Bytes window;
+		size_t windowUsed = 0;
+		bool atStart = true;
+	};
+
+	class LZ4StreamDecompressor {
+	public:
+		explicit LZ4StreamDecompressor(std::shared_ptr<const Bytes> dictionary = {});
+
+		void reset();
+
+		// Appends the decompressed block to dst. Throws if the block is invalid or doesn't decompress to exactly originalSize bytes.
+		void decompress(gsl::span<const gsl::byte> src, size_t originalSize, Bytes& dst);
+
+		// Decompresses a block from LZ4StreamCompressor::compressIndependent, without affecting the stream
+		void decompressIndependent(gsl::span<const gsl::byte> src, size_t originalSize, Bytes& dst) const;
+
+	private:
+		std::shared_ptr<const Bytes> dictionary;
+		Bytes window;
+		size_t windowUsed = 0;
+	};
+}
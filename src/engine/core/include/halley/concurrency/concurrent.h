@@ -27,6 +27,13 @@ namespace Halley
 			return TaskQueueHelper<R>::enqueueOn(e, MovableFunction<R>(std::move(f)));
 		}
 
+		template <typename F>
+		auto execute(ExecutionQueue& e, ExecutionPriority priority, F f) -> Future<typename std::invoke_result<F>::type>
+		{
+			using R = typename std::invoke_result<F>::type;
+			return TaskQueueHelper<R>::enqueueOn(e, MovableFunction<R>(std::move(f)), priority);
+		}
+
 		template <typename F>
 		auto execute(F f) -> Future<typename std::invoke_result<F>::type>
 		{
@@ -72,5 +79,9 @@ namespace Halley
 		{
 			foreach(ExecutionQueue::getDefault(), begin, end, f);
 		}
+
+		// Calls f(i) for every i in [0, n), spread across the calling thread and the threads of e.
+		// Unlike foreach, the calling thread does its share of the work and only waits on calls already in progress, so it's safe to use from a task running on e.
+		void parallelFor(ExecutionQueue& e, size_t n, const std::function<void(size_t)>& f);
 	}
 }
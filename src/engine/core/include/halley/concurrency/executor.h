@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <deque>
 #include <thread>
 #include <mutex>
@@ -12,11 +13,18 @@ namespace Halley
 {
 	using TaskBase = std::function<void()>;
 
+	// Tasks of higher priority are always taken from a queue before lower priority ones
+	enum class ExecutionPriority {
+		Low,
+		Normal,
+		High
+	};
+
 	class ExecutionQueue
 	{
 	public:
 		ExecutionQueue();
-		void addToQueue(TaskBase task);
+		void addToQueue(TaskBase task, ExecutionPriority priority = ExecutionPriority::Normal);
 
 		TaskBase getNext();
 		Vector<TaskBase> getAll();
@@ -31,7 +39,7 @@ namespace Halley
 		static ExecutionQueue& getDefault();
 
 	private:
-		std::deque<TaskBase> queue;
+		std::array<std::deque<TaskBase>, 3> queues; // Indexed by ExecutionPriority
 		std::mutex mutex;
 		std::condition_variable condition;
 
@@ -40,6 +48,8 @@ namespace Halley
 		std::atomic<bool> aborted;
 
 		bool immediate = false;
+
+		bool isEmpty() const;
 	};
 
 	class Executors
@@ -49,6 +59,7 @@ namespace Halley
 
 		static Executors& get();
 		static void setInstance(Executors& e);
+		static bool hasInstance();
 
 		static ExecutionQueue& getCPU() { return instance->cpu; }
 		static ExecutionQueue& getCPUAux() { return instance->cpuAux; }
@@ -260,7 +260,13 @@ namespace Halley
 		}
 
 		template <typename E, typename F>
-		auto then(E& e, F f)->Future<typename TaskHelper<T>::template FunctionHelper<F>::ReturnType>;
+		auto then(E& e, F f)->Future<typename TaskHelper<T>::template FunctionHelper<F>::ReturnType>
+		{
+			return then(e, ExecutionPriority::Normal, f);
+		}
+
+		template <typename E, typename F>
+		auto then(E& e, ExecutionPriority priority, F f)->Future<typename TaskHelper<T>::template FunctionHelper<F>::ReturnType>;
 
 		template <typename F>
 		auto thenNotify(F joinFuture) -> void
@@ -497,31 +503,31 @@ namespace Halley
 	class TaskQueueHelper
 	{
 	public:
-		[[nodiscard]] static Future<T> enqueueOn(ExecutionQueue& e, MovableFunction<T> payload)
+		[[nodiscard]] static Future<T> enqueueOn(ExecutionQueue& e, MovableFunction<T> payload, ExecutionPriority priority = ExecutionPriority::Normal)
 		{
 			Promise<T> promise;
-			enqueueOn(e, std::move(payload), promise);
+			enqueueOn(e, std::move(payload), promise, priority);
 			return promise.getFuture();
 		}
 		
-		static void enqueueOn(ExecutionQueue& e, MovableFunction<T> payload, Promise<T> promise)
+		static void enqueueOn(ExecutionQueue& e, MovableFunction<T> payload, Promise<T> promise, ExecutionPriority priority = ExecutionPriority::Normal)
 		{
 			e.addToQueue([payload(std::move(payload)), promise(promise)]() mutable {
 				TaskHelper<T>::setPromise(promise, payload);
-			});
+			}, priority);
 		}
 	};
 
 	template<typename T>
 	template<typename E, typename F>
-	inline auto Future<T>::then(E & e, F f) -> Future<typename TaskHelper<T>::template FunctionHelper<F>::ReturnType>
+	inline auto Future<T>::then(E & e, ExecutionPriority priority, F f) -> Future<typename TaskHelper<T>::template FunctionHelper<F>::ReturnType>
 	{
 		using R = typename TaskHelper<T>::template FunctionHelper<F>::ReturnType;
 		std::reference_wrapper<E> executor(e);
 
 		auto promise = Promise<R>();
-		data->addContinuation([promise, f, executor](typename TaskHelper<T>::DataType v) mutable {
-			TaskQueueHelper<R>::enqueueOn(executor.get(), MovableFunction<R>(f, std::move(v)), promise);
+		data->addContinuation([promise, f, executor, priority](typename TaskHelper<T>::DataType v) mutable {
+			TaskQueueHelper<R>::enqueueOn(executor.get(), MovableFunction<R>(f, std::move(v)), promise, priority);
 		});
 		return promise.getFuture();
 	}
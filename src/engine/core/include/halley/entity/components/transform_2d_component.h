@@ -4,6 +4,7 @@
 #include "halley/entity/component.h"
 #include "halley/entity/entity.h"
 #include "halley/file_formats/config_file.h"
+#include "halley/bytes/bit_serializer.h"
 #include "halley/bytes/config_node_serializer.h"
 #include "components/transform2d_component_base.h"
 
@@ -21,19 +22,15 @@ public:
 	~Transform2DComponent();
 
 	const Halley::Vector2f& getLocalPosition() const { return position; }
-	Halley::Vector2f& getLocalPosition() { return position; }
 	void setLocalPosition(Halley::Vector2f v);
 
 	const Halley::Vector2f& getLocalScale() const { return scale; }
-	Halley::Vector2f& getLocalScale() { return scale; }
 	void setLocalScale(Halley::Vector2f v);
 
 	const Halley::Angle1f& getLocalRotation() const { return rotation; }
-	Halley::Angle1f& getLocalRotation() { return rotation; }
 	void setLocalRotation(Halley::Angle1f v);
 
 	float getLocalHeight() const { return height; }
-	float& getLocalHeight() { return height; }
 	void setLocalHeight(float v);
 
 	Halley::Vector2f getGlobalPosition() const;
@@ -64,6 +61,7 @@ public:
 	void onHierarchyChanged();
 
 	uint16_t getRevision() const { return revision; }
+	uint64_t getWriteVersion() const { return writeVersion; }
 	uint8_t getWorldPartition() const { return worldPartition; }
 
 	void deserialize(const Halley::EntitySerializationContext& context, const Halley::ConfigNode& node);
@@ -74,6 +72,10 @@ private:
 	friend class Halley::EntityRef;
 
 	mutable Transform2DComponent* parentTransform = nullptr;
+
+	// Changes whenever the local transform is written, unlike revision, which isn't bumped if nothing has been cached.
+	// Taken from a global counter, so a replaced component never repeats an earlier version.
+	uint64_t writeVersion = 0;
 	mutable uint8_t worldPartition = 0;
 
 	mutable uint8_t cachedValues = 0;
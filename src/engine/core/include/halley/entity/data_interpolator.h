@@ -32,6 +32,7 @@ namespace Halley {
 		
 		IDataInterpolator* tryGetInterpolator(const EntitySerializationContext& context, std::string_view componentName, std::string_view fieldName) const override;
 		IDataInterpolator* tryGetInterpolator(EntityId entityId, std::string_view componentName, std::string_view fieldName) const;
+		IDataInterpolator* tryGetInterpolator(const UUID& instanceUUID, std::string_view componentName, std::string_view fieldName) const; // Requires collectUUIDs
 		ConfigNode createComponentDelta(const UUID& instanceUUID, const String& componentName, const ConfigNode& from, const ConfigNode& to) const override;
 	
 	private:
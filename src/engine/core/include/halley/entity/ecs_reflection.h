@@ -1,5 +1,7 @@
 #pragma once
+#include <memory>
 #include "halley/data_structures/config_node.h"
+#include "halley/bytes/bit_serializer.h"
 
 namespace Halley {
 	class EntityFactoryContext;
@@ -9,6 +11,7 @@ namespace Halley {
 	class EntityRef;
 	class Component;
 	class EntitySerializationContext;
+	class Serializer;
 
 	class CreateComponentFunctionResult {
 	public:
@@ -23,7 +26,13 @@ namespace Halley {
     	virtual const char* getName() const = 0;
 		virtual int getIndex() const = 0;
     	virtual ConfigNode serialize(const EntitySerializationContext& context, const Component& component) const = 0;
+		virtual void serializeNetworkState(const EntitySerializationContext& context, const Component& component, Serializer& s) const = 0;
+		virtual gsl::span<const NetworkQuantizedField> getNetworkQuantizedFields() const = 0;
 		virtual CreateComponentFunctionResult createComponent(const EntityFactoryContext& context, EntityRef& e, const ConfigNode& node) const = 0;
+
+		// Prototypes are deserialized once, then copied into each entity. Returns null if the component can't be copied.
+		virtual std::shared_ptr<const Component> createPrototype(const EntitySerializationContext& context, const ConfigNode& node) const = 0;
+		virtual void addComponentFromPrototype(EntityRef& e, const Component& prototype) const = 0;
     };
 
 	class MessageReflector {
@@ -4,6 +4,12 @@
 #include "halley/entity/entity_factory.h"
 
 namespace Halley {
+	namespace Detail {
+		template<class T> using HasNetworkQuantizedFields = decltype(T::networkQuantizedFields);
+		template<class T> using HasSerializeNetworkState = decltype(std::declval<const T&>().serializeNetworkState(std::declval<const EntitySerializationContext&>(), std::declval<Serializer&>()));
+		template<class T> using HasWriteVersion = decltype(std::declval<const T&>().getWriteVersion());
+	}
+
 	template <typename T>
 	class ComponentReflectorImpl : public ComponentReflector {
 	public:
@@ -22,10 +28,50 @@ namespace Halley {
 			return static_cast<const T&>(component).serialize(context);
 		}
 
+		void serializeNetworkState(const EntitySerializationContext& context, const Component& component, Serializer& s) const override
+		{
+			if constexpr (is_detected<Detail::HasWriteVersion, T>::value) {
+				// Components that version their own writes don't need their fields serialized to tell if they changed
+				s << static_cast<uint64_t>(static_cast<const T&>(component).getWriteVersion());
+			} else if constexpr (is_detected<Detail::HasSerializeNetworkState, T>::value) {
+				static_cast<const T&>(component).serializeNetworkState(context, s);
+			} else {
+				// Components generated by an older codegen
+				s << static_cast<const T&>(component).serialize(context);
+			}
+		}
+
+		gsl::span<const NetworkQuantizedField> getNetworkQuantizedFields() const override
+		{
+			if constexpr (is_detected<Detail::HasNetworkQuantizedFields, T>::value) {
+				return T::networkQuantizedFields;
+			} else {
+				return {};
+			}
+		}
+
 		CreateComponentFunctionResult createComponent(const EntityFactoryContext& context, EntityRef& e, const ConfigNode& node) const override
 		{
 			return context.createComponent<T>(e, node);
 		}
+
+		std::shared_ptr<const Component> createPrototype(const EntitySerializationContext& context, const ConfigNode& node) const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>) {
+				auto component = std::make_shared<T>();
+				component->deserialize(context, node);
+				return component;
+			} else {
+				return {};
+			}
+		}
+
+		void addComponentFromPrototype(EntityRef& e, const Component& prototype) const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>) {
+				e.addComponent<T>(T(static_cast<const T&>(prototype)));
+			}
+		}
 	};
 
 	template <typename T>
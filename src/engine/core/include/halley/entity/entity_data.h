@@ -76,6 +76,11 @@ namespace Halley {
     	void serialize(Serializer& s) const;
     	void deserialize(Deserializer& s);
 
+    	// Compiled form of imported prefabs and scenes: every entity in one depth-first table, with all strings (including the ones in component data) interned.
+    	// Unlike deserialize, it doesn't go through EntityDataDelta, so no ConfigNode gets built twice and children don't have to be matched by UUID.
+    	void serializeTable(Serializer& s) const;
+    	void deserializeTable(Deserializer& s);
+
     	const String& getName() const override { return name; }
     	const String& getPrefab() const override { return prefab; }
     	const String& getIcon() const { return icon; }
@@ -156,5 +161,7 @@ namespace Halley {
     	void parseUUID(UUID& dst, const ConfigNode& node);
     	void generateChildUUID(const UUID& root);
     	void instantiateData(const EntityData& instance);
+    	void writeTableEntry(Serializer& s) const;
+    	void readTableEntry(Deserializer& s);
 	};
 }
@@ -46,7 +46,9 @@ namespace Halley {
 		const Vector<std::pair<String, ConfigNode>>& getComponentsChanged() const { return componentsChanged; }
 		const Vector<String>& getComponentsRemoved() const { return componentsRemoved; }
 		
+		Vector<EntityData>& getChildrenAdded() { return childrenAdded; }
 		const Vector<EntityData>& getChildrenAdded() const { return childrenAdded; }
+		Vector<std::pair<UUID, EntityDataDelta>>& getChildrenChanged() { return childrenChanged; }
 		const Vector<std::pair<UUID, EntityDataDelta>>& getChildrenChanged() const { return childrenChanged; }
 		const Vector<UUID>& getChildrenRemoved() const { return childrenRemoved; }
 
@@ -40,6 +40,7 @@ namespace Halley {
 		
 		EntityRef createEntity(const String& prefabName, EntityRef parent = EntityRef(), EntityScene* scene = nullptr);
 		EntityRef createEntity(const EntityData& data, int mask, EntityRef parent = EntityRef(), EntityScene* scene = nullptr);
+		Vector<EntityRef> createEntities(const String& prefabName, size_t count, const std::function<void(EntityRef, size_t)>& initFn = {}, EntityRef parent = EntityRef(), EntityScene* scene = nullptr); // initFn is called on each root as soon as it's created
 		EntityScene createScene(const std::shared_ptr<const Prefab>& scene, bool allowReload, uint8_t worldPartition = 0);
 
 		void updateEntity(EntityRef& entity, const IEntityData& data, int serializationMask, EntityScene* scene = nullptr, IDataInterpolatorSetRetriever* interpolators = nullptr);
@@ -50,6 +51,7 @@ namespace Halley {
 		EntityData serializeEntity(EntityRef entity, const SerializationOptions& options, bool canStoreParent = true);
 		EntityDataDelta serializeEntityAsDelta(EntityRef entity, const SerializationOptions& options, const EntityDataDelta::Options& deltaOptions, bool canStoreParent = true);
 		EntityDataDelta entityDataToPrefabDelta(EntityData data, std::shared_ptr<const Prefab> prefab, const EntityDataDelta::Options& deltaOptions);
+		void serializeEntityState(EntityRef entity, const SerializationOptions& options, Serializer& s, bool canStoreParent = true); // Compact binary form of what serializeEntity would output, only meant for change detection
 		
 		std::shared_ptr<EntityFactoryContext> makeStandaloneContext();
 
@@ -68,6 +70,7 @@ namespace Halley {
 		std::optional<ConfigNode> getComponentsWithPrefabDefaults(EntityRef entity, const EntityFactoryContext& context, const ConfigNode& componentData, const String& componentName);
 
 		EntityData doSerializeEntity(EntityRef entity, const SerializationOptions& options, bool canStoreParent, const String& lastPrefab);
+		void doSerializeEntityState(EntityRef entity, const SerializationOptions& options, const EntityFactoryContext& context, Serializer& s, bool canStoreParent);
 
 		EntityRef tryGetEntity(const UUID& instanceUUID, EntityFactoryContext& context, bool allowWorldLookup);
 		EntityRef getEntity(const UUID& instanceUUID, EntityFactoryContext& context, bool allowWorldLookup);
@@ -78,6 +81,10 @@ namespace Halley {
 		void preInstantiateEntities(const IEntityData& data, EntityFactoryContext& context, int depth);
 		void collectExistingEntities(EntityRef entity, EntityFactoryContext& context);
 
+		std::shared_ptr<const PrefabTemplate> getPrefabTemplate(const Prefab& prefab);
+		std::shared_ptr<const PrefabTemplate> compilePrefabTemplate(const Prefab& prefab);
+		EntityRef instantiatePrefabTemplate(const PrefabTemplate& prefabTemplate, const std::shared_ptr<const Prefab>& prefab, EntityRef parent, EntityScene* scene);
+
 		[[nodiscard]] std::shared_ptr<const Prefab> getPrefab(const String& id) const;
 		[[nodiscard]] std::shared_ptr<const Prefab> getPrefab(std::optional<EntityRef> entity, const IEntityData& data) const;
 	};
@@ -35,6 +35,15 @@ namespace Halley {
 		ConfigNode serialize(EntityId id, const EntitySerializationContext& context);
 		EntityId deserialize(const EntitySerializationContext& context, const ConfigNode& node);
     };
+
+	template <>
+	class EntityNetworkStateSerializer<EntityId> {
+	public:
+		static void serialize(EntityId value, const EntitySerializationContext& context, Serializer& s)
+		{
+			s << value.value;
+		}
+	};
 }
 
 
@@ -2,6 +2,7 @@
 
 #include "halley/file_formats/config_file.h"
 #include "entity_data_delta.h"
+#include "prefab_template.h"
 
 namespace Halley {	
 	class Prefab : public AsyncResource {
@@ -48,12 +49,20 @@ namespace Halley {
 		virtual std::shared_ptr<Prefab> clone() const;
 
 		void preloadDependencies(Resources& resources) const;
+		HashSet<String> getPrefabDependencies() const; // Names of the prefabs instanced by this one
 
 		ResourceMemoryUsage getMemoryUsage() const override;
+		void releaseCaches() override;
 
 		void generateUUIDs();
 
+		// Used by EntityFactory, dropped whenever the entity data might change
+		std::shared_ptr<const PrefabTemplate> getCompiledTemplate() const;
+		void setCompiledTemplate(std::shared_ptr<const PrefabTemplate> value) const;
+
 	protected:
+		constexpr static uint16_t entityTableMarker = 0xFFFF;
+
 		struct Deltas {
 			std::map<UUID, EntityDataDelta> entitiesModified;
 			std::set<UUID> entitiesAdded;
@@ -68,8 +77,9 @@ namespace Halley {
 		ConfigFile gameData;
 
 		Deltas deltas;
+		mutable PrefabTemplateCache compiledTemplate;
 
-		void doPreloadDependencies(const EntityData& entityData, Resources& resources) const;
+		void collectPrefabDependencies(const EntityData& entityData, HashSet<String>& result) const;
 	};
 
 	class Scene final : public Prefab {
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include "halley/data_structures/config_node.h"
+#include "halley/data_structures/vector.h"
+#include "halley/text/halleystring.h"
+#include "halley/maths/uuid.h"
+
+namespace Halley {
+	class Component;
+	class WorldReflection;
+
+	// A prefab compiled against one world's reflection, so it can be instanced by copying components that were deserialized once,
+	// instead of going through its ConfigNodes for every instance.
+	// Built by EntityFactory the first time it instances the prefab, and cached on it.
+	// Note that prototypes hold on to whatever resources their components reference (e.g. sprite materials and their textures),
+	// so those stay in use while the template is cached. Prefab::releaseCaches() drops it when Resources can't otherwise get under budget.
+	class PrefabTemplate {
+	public:
+		struct ComponentEntry {
+			String name;
+			int componentId = -1;
+			std::shared_ptr<const Component> prototype; // Null if it has to be deserialized for each instance, e.g. if it references other entities
+			ConfigNode data; // Only kept when there's no prototype
+		};
+
+		struct Node {
+			String name;
+			UUID prefabUUID;
+			uint8_t flags = 0;
+			int parentIdx = -1;
+			Vector<ComponentEntry> components;
+		};
+
+		const WorldReflection* reflection = nullptr;
+		uint64_t resourcesGeneration = 0;
+		bool instantiable = true; // False if the prefab nests other prefabs, which are left to the regular path
+		bool needsContext = false; // True if any component has no prototype
+		Vector<Node> nodes; // Depth first, so parents always come before their children
+	};
+
+	// Holds the template compiled from a Prefab. Copies start out empty, as they're usually made to be edited.
+	class PrefabTemplateCache {
+	public:
+		PrefabTemplateCache() = default;
+		PrefabTemplateCache(const PrefabTemplateCache& other) {}
+		PrefabTemplateCache(PrefabTemplateCache&& other) noexcept {}
+
+		PrefabTemplateCache& operator=(const PrefabTemplateCache& other)
+		{
+			clear();
+			return *this;
+		}
+
+		PrefabTemplateCache& operator=(PrefabTemplateCache&& other) noexcept
+		{
+			clear();
+			return *this;
+		}
+
+		std::shared_ptr<const PrefabTemplate> get() const
+		{
+			return std::atomic_load(&value);
+		}
+
+		void set(std::shared_ptr<const PrefabTemplate> newValue)
+		{
+			std::atomic_store(&value, std::move(newValue));
+		}
+
+		void clear()
+		{
+			set({});
+		}
+
+	private:
+		std::shared_ptr<const PrefabTemplate> value;
+	};
+}
@@ -17,6 +17,8 @@ namespace Halley {
 		std::unique_ptr<SystemMessage> createSystemMessage(int id) const;
 		std::unique_ptr<SystemMessage> createSystemMessage(const String& name) const;
 		ComponentReflector& getComponentReflector(int id) const;
+		std::optional<int> tryGetComponentId(const String& name) const;
+		const Vector<std::unique_ptr<ComponentReflector>>& getComponentReflectors() const;
 
 	private:
 		Vector<SystemReflector> systemReflectors;
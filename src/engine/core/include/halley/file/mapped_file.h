@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <gsl/gsl>
+
+#include "path.h"
+
+namespace Halley
+{
+	// Read-only mapping of a whole file into memory
+	// Hold it through a shared_ptr, so data handed out from it can keep it alive with an aliasing pointer
+	class MappedFile
+	{
+	public:
+		// Returns null if the file can't be opened or mapped
+		static std::shared_ptr<MappedFile> open(const Path& path);
+
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) = delete;
+		~MappedFile();
+
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile& operator=(MappedFile&& other) = delete;
+
+		gsl::span<const gsl::byte> getSpan() const;
+		size_t getSize() const;
+
+	private:
+		MappedFile() = default;
+
+		const gsl::byte* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+	};
+}
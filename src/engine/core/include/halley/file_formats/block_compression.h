@@ -0,0 +1,23 @@
+#pragma once
+
+#include "halley/graphics/texture_descriptor.h"
+#include "halley/utils/utils.h"
+
+namespace Halley {
+	class Image;
+
+	// CPU encoders for the GPU block compressed texture formats, so textures can stay compressed all the way to VRAM.
+	// They aim for reasonable quality at import time rather than the best possible quality: BC7 only uses mode 6, and ETC2 only uses the ETC1 compatible individual and differential modes.
+	class BlockCompression {
+	public:
+		// Only RGB(A) images with both dimensions a multiple of 4 can be encoded, as D3D requires it of block compressed textures
+		static bool canEncode(const Image& image, TextureFormat format);
+
+		// Returns the blocks in rows, top to bottom and left to right
+		static Bytes encode(const Image& image, TextureFormat format);
+
+		// Decodes blocks written by encode() back to an RGBA image, for when the GPU can't sample the format.
+		// ETC2 blocks must use the ETC1 compatible modes, as encode() does.
+		static std::unique_ptr<Image> decode(gsl::span<const gsl::byte> blocks, Vector2i size, TextureFormat format);
+	};
+}
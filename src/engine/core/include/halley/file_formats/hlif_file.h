@@ -2,6 +2,7 @@
 
 #include "halley/data_structures/vector.h"
 #include "halley/file_formats/image.h"
+#include "halley/graphics/texture_descriptor.h"
 #include <gsl/span>
 
 namespace Halley {
@@ -12,10 +13,15 @@ namespace Halley {
     	struct Info {
             Vector2i size;
         	Image::Format format;
+        	std::optional<TextureFormat> blockFormat;
         };
 
         static void decode(Image& dst, gsl::span<const gsl::byte> data);
         static Bytes encode(const Image& image, std::string_view name = {}, bool lz4hc = true);
+
+        // Block compressed HLIF files hold GPU ready blocks (see BlockCompression), which decode to the raw blocks rather than an Image
+        static Bytes decodeBlocks(gsl::span<const gsl::byte> data);
+        static Bytes encodeBlocks(const Image& image, TextureFormat format, bool lz4hc = true);
         static Info getInfo(gsl::span<const gsl::byte> data);
         static bool isHLIF(gsl::span<const gsl::byte> data);
 
@@ -25,13 +31,23 @@ namespace Halley {
     	enum class Format : uint8_t {
 			RGBA,
 			SingleChannel,
-			Indexed
+			Indexed,
+			BC1,
+			BC3,
+			BC7,
+			ETC2,
+			ETC2Alpha
 		};
 
         enum class Flags {
-	        Premultiplied = 1
+	        Premultiplied = 1,
+	        Banded = 2
         };
 
+        // Large images are split into bands of rows which are compressed independently, so they can be decoded in parallel
+        constexpr static size_t targetBandSize = 256 * 1024;
+        constexpr static int minBandHeight = 16;
+
 		struct Header {
 			uint8_t id[8];
 			uint16_t width = 0;
@@ -69,10 +85,16 @@ namespace Halley {
         static void encodeLine(LineEncoding lineEncoding, gsl::span<uint8_t> curLine, gsl::span<const uint8_t> prevLine, int bpp);
         static void decodeLine(LineEncoding lineEncoding, gsl::span<uint8_t> curLine, gsl::span<const uint8_t> prevLine, int bpp);
         static int getBPP(Format format);
+        static std::optional<TextureFormat> getBlockFormat(Format format);
+        static Header readHeader(gsl::span<const gsl::byte> data);
+
+        static int getBandHeight(Vector2i size, int bpp);
+        static Bytes encodeBands(Header header, gsl::span<const Palette> palettes, gsl::span<const uint8_t> pixels, int bpp, int bandHeight, bool lz4hc);
+        static void decodeBands(Image& dst, const Header& header, gsl::span<const gsl::byte> data, int bpp);
 
         static std::optional<std::pair<Vector<Palette>, Bytes>> makePalettes(gsl::span<const int> pixels, std::string_view name = {});
         static void optimizePalettes(gsl::span<Palette> palettes, gsl::span<uint8_t> pixels);
-        static void applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst);
+        static void applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst, size_t firstPixel = 0);
         static void deltaEncodePalettes(gsl::span<Palette> palettes);
         static void deltaDecodePalettes(gsl::span<Palette> palettes);
     };
@@ -17,12 +17,17 @@ namespace Halley
 		BGRA5551,
 		BGRX,
 		SRGBA,
-		RGBAFloat16
+		RGBAFloat16,
+		BC1,
+		BC3,
+		BC7,
+		ETC2,
+		ETC2Alpha
 	};
 
 	template <>
 	struct EnumNames<TextureFormat> {
-		constexpr std::array<const char*, 10> operator()() const {
+		constexpr std::array<const char*, 15> operator()() const {
 			return{{
 				"indexed",
 				"rgb",
@@ -33,7 +38,12 @@ namespace Halley
 				"rgba5551",
 				"xrgb",
 				"srgba",
-				"rgbaFloat16"
+				"rgbaFloat16",
+				"bc1",
+				"bc3",
+				"bc7",
+				"etc2",
+				"etc2Alpha"
 			}};
 		}
 	};
@@ -126,6 +136,12 @@ namespace Halley
 
 		static int getBytesPerPixel(TextureFormat format);
 
+		// Block compressed formats store 4x4 pixel blocks of getBlockBytes() each, so use getImageByteSize() rather than getBytesPerPixel() to size their data
+		static bool isBlockCompressed(TextureFormat format);
+		static int getBlockBytes(TextureFormat format);
+		static size_t getImageByteSize(TextureFormat format, Vector2i size);
+		static size_t getVRamUsage(TextureFormat format, Vector2i size, bool useMipMap); // Includes every mip level, if any
+
 		size_t getMemoryUsage() const;
 	};
 }
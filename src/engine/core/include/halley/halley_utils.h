@@ -10,8 +10,10 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "concurrency/task_anchor.h"
 #include "concurrency/task_set.h"
 
+#include "bytes/bit_serializer.h"
 #include "bytes/byte_serializer.h"
 #include "bytes/compression.h"
+#include "bytes/lz4_stream.h"
 #include "bytes/config_node_serializer.h"
 #include "bytes/fuzzer.h"
 
@@ -34,6 +36,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "data_structures/vector.h"
 
 #include "file/directory_monitor.h"
+#include "file/mapped_file.h"
 #include "file/path.h"
 
 #include "file_formats/binary_file.h"
@@ -75,6 +78,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "os/os.h"
 
 #include "navigation/navmesh.h"
+#include "navigation/navmesh_flow_field.h"
 #include "navigation/navmesh_generator.h"
 #include "navigation/navmesh_set.h"
 #include "navigation/navigation_query.h"
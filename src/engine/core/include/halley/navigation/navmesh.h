@@ -2,6 +2,7 @@
 
 #include "navigation_path.h"
 #include "navigation_query.h"
+#include "navmesh_packed_polygons.h"
 #include "halley/maths/polygon.h"
 #include "halley/maths/base_transform.h"
 
@@ -162,6 +163,7 @@ namespace Halley {
 
 		Vector<Node> nodes;
 		Vector<Polygon> polygons;
+		NavmeshPackedPolygons packedPolygons;
 		Vector<Portal> portals;
 		Vector<float> weights;
 		Vector<std::pair<uint16_t, LineSegment>> openEdges;
@@ -188,6 +190,9 @@ namespace Halley {
 		void addPolygonsToGrid();
 		void addPolygonToGrid(const Polygon& poly, NodeId idx);
 		gsl::span<const NodeId> getPolygonsAt(Vector2f pos, bool allowOutside) const;
+		bool isPointInsidePolygon(NodeId idx, Vector2f pos) const;
+		float getSquaredDistanceToPolygon(NodeId idx, Vector2f pos) const;
+		std::optional<size_t> getPolygonExitEdge(NodeId idx, const Ray& ray, size_t startFromEdge = 0) const;
 
 		void addToPortals(NodeAndConn nodeAndConn, int id);
 		Portal& getPortals(int id);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "navmesh.h"
+#include "halley/concurrency/future.h"
+#include "halley/data_structures/hash_map.h"
+
+namespace Halley {
+	// A flow field is the result of a single reverse Dijkstra from a goal node.
+	// It stores, for every node in the navmesh, which connection to take to get closer to the goal,
+	// so any number of agents sharing the same destination can query their next step in O(1).
+	class NavmeshFlowField {
+	public:
+		NavmeshFlowField() = default;
+		NavmeshFlowField(const Navmesh& navmesh, Navmesh::NodeId goal);
+
+		[[nodiscard]] Navmesh::NodeId getGoal() const { return goal; }
+		[[nodiscard]] size_t getNumNodes() const { return costToGoal.size(); }
+
+		[[nodiscard]] bool isReachable(Navmesh::NodeId node) const;
+		[[nodiscard]] float getCostToGoal(Navmesh::NodeId node) const;
+
+		// Returns the node and connection to follow from this node, or empty if at goal or unreachable
+		[[nodiscard]] std::optional<Navmesh::NodeAndConn> getNextHop(Navmesh::NodeId node) const;
+		[[nodiscard]] std::optional<Navmesh::NodeId> getNextNode(Navmesh::NodeId node) const;
+
+		// Returns the midpoint of the edge to cross next, or empty if at goal or unreachable
+		[[nodiscard]] std::optional<Vector2f> getNextWaypoint(Navmesh::NodeId node) const;
+
+	private:
+		constexpr static uint8_t noConnection = std::numeric_limits<uint8_t>::max();
+
+		Navmesh::NodeId goal = 0;
+		Vector<float> costToGoal;
+		Vector<uint8_t> nextConnection;
+		Vector<Navmesh::NodeId> nextNode;
+		Vector<Vector2f> nextWaypoint;
+	};
+
+	// Computes flow fields asynchronously and keeps them around per goal node.
+	// The navmesh must outlive the cache and must not be changed (or moved) while it holds any fields; call clear() if it does.
+	// Not thread-safe, meant to be owned and called from a single thread (e.g. a system).
+	class NavmeshFlowFieldCache {
+	public:
+		explicit NavmeshFlowFieldCache(const Navmesh& navmesh, size_t maxEntries = 32);
+		~NavmeshFlowFieldCache();
+
+		NavmeshFlowFieldCache(const NavmeshFlowFieldCache& other) = delete;
+		NavmeshFlowFieldCache(NavmeshFlowFieldCache&& other) = delete;
+		NavmeshFlowFieldCache& operator=(const NavmeshFlowFieldCache& other) = delete;
+		NavmeshFlowFieldCache& operator=(NavmeshFlowFieldCache&& other) = delete;
+
+		// Starts computing the field for the goal if it's not already cached or in flight
+		Future<std::shared_ptr<const NavmeshFlowField>> request(Navmesh::NodeId goal);
+
+		// Returns the field if it's ready, otherwise requests it and returns null
+		std::shared_ptr<const NavmeshFlowField> tryGet(Navmesh::NodeId goal);
+
+		void clear();
+		[[nodiscard]] size_t size() const { return entries.size(); }
+
+	private:
+		struct Entry {
+			Future<std::shared_ptr<const NavmeshFlowField>> field;
+			uint64_t lastUsed = 0;
+		};
+
+		const Navmesh& navmesh;
+		size_t maxEntries;
+		uint64_t useCounter = 0;
+		HashMap<Navmesh::NodeId, Entry> entries;
+
+		void evictIfNeeded();
+		void waitForPending();
+	};
+}
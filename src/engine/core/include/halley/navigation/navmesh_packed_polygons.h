@@ -0,0 +1,45 @@
+#pragma once
+
+#include "halley/maths/polygon.h"
+#include "halley/maths/ray.h"
+
+namespace Halley {
+	// Structure-of-arrays copy of the navmesh polygons' edges, laid out so the geometric tests in the inner loop of
+	// navigation queries (point containment, distance to polygon, ray exit edge) can run on all edges at once with SIMD.
+	// Polygons that can't be packed (concave, or with more than MaxSides sides) are flagged, and the caller must fall back to Polygon.
+	class NavmeshPackedPolygons {
+	public:
+		constexpr static size_t MaxSides = 8;
+
+		NavmeshPackedPolygons() = default;
+		explicit NavmeshPackedPolygons(gsl::span<const Polygon> polygons);
+
+		[[nodiscard]] size_t size() const { return entries.size(); }
+		[[nodiscard]] bool isPacked(size_t idx) const { return entries[idx].packed; }
+
+		// All of the below require isPacked(idx)
+		[[nodiscard]] bool isPointInside(size_t idx, Vector2f point) const;
+		[[nodiscard]] float getSquaredDistanceTo(size_t idx, Vector2f point) const;
+		[[nodiscard]] std::optional<size_t> getExitEdge(size_t idx, const Ray& ray, size_t startFromEdge = 0) const;
+
+	private:
+		// Each edge i goes from a[i] to b[i], with e[i] = b[i] - a[i]. Lanes past nSides replicate edge 0.
+		struct alignas(16) Entry {
+			std::array<float, MaxSides> ax;
+			std::array<float, MaxSides> ay;
+			std::array<float, MaxSides> bx;
+			std::array<float, MaxSides> by;
+			std::array<float, MaxSides> ex;
+			std::array<float, MaxSides> ey;
+			std::array<float, MaxSides> invLenSq;
+			Vector2f circleCentre;
+			float circleRadiusSq = 0;
+			float sign = 1;
+			Rect4f aabb;
+			uint8_t nSides = 0;
+			bool packed = false;
+		};
+
+		Vector<Entry> entries;
+	};
+}
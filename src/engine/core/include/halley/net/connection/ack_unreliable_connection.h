@@ -5,6 +5,7 @@
 #include <memory>
 #include "halley/data_structures/vector.h"
 #include <chrono>
+#include <functional>
 #include <deque>
 #include <limits>
 #include <cstdint>
@@ -60,8 +61,11 @@ namespace Halley
 
 	class AckUnreliableConnection : public IConnection
 	{
+	public:
 		using Clock = std::chrono::steady_clock;
+		using TimeSource = std::function<Clock::time_point()>;
 
+	private:
 		struct SentPacketData
 		{
 			std::vector<int> tags;
@@ -90,6 +94,10 @@ namespace Halley
 
 		void setStatsListener(IAckUnreliableConnectionStatsListener* listener);
 
+		// Replaces the wall clock for everything timed by this connection, and by the message queue using it, e.g. so tests can step time
+		void setTimeSource(TimeSource source);
+		[[nodiscard]] Clock::time_point now() const;
+
 	private:
 		std::shared_ptr<IConnection> parent;
 
@@ -102,6 +110,7 @@ namespace Halley
 
 		Vector<IAckUnreliableConnectionListener*> ackListeners;
 		IAckUnreliableConnectionStatsListener* statsListener = nullptr;
+		TimeSource timeSource;
 
 		float lag = 1; // Start at 1 second
 		float curLag = 0;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "network_service.h"
+#include "network_packet.h"
+#include "halley/data_structures/hash_map.h"
+#include "halley/data_structures/vector.h"
+#include "halley/maths/random.h"
+#include <deque>
+#include <memory>
+
+namespace Halley
+{
+	class LoopbackNetworkService;
+
+	// In-memory network shared by LoopbackNetworkServices in the same process.
+	// Delivery is deterministic: every packet arrives, in order, as soon as it's sent, unless packet loss is set. Wrap connections in InstabilitySimulator to add lag.
+	class LoopbackNetwork
+	{
+	public:
+		String listen(LoopbackNetworkService& service);
+		void stopListening(LoopbackNetworkService& service);
+		LoopbackNetworkService* getListener(const String& address) const;
+
+		const std::shared_ptr<NetworkBufferPool>& getBufferPool() const { return bufferPool; }
+
+		// Drops this fraction of the packets sent over established connections, picked by a generator with the given seed
+		void setPacketLoss(float probability, uint32_t seed = 0);
+		bool shouldDropPacket();
+
+	private:
+		std::shared_ptr<NetworkBufferPool> bufferPool = std::make_shared<NetworkBufferPool>();
+		float packetLoss = 0;
+		Random lossRng;
+		HashMap<String, LoopbackNetworkService*> listeners;
+		int nextAddress = 1;
+	};
+
+	class LoopbackConnection : public IConnection
+	{
+	public:
+		LoopbackConnection(INetworkServiceStatsListener& stats, std::shared_ptr<LoopbackNetwork> network);
+
+		void close() override;
+		ConnectionStatus getStatus() const override;
+		bool isSupported(TransmissionType type) const override;
+		void send(TransmissionType type, OutboundNetworkPacket packet) override;
+		bool receive(InboundNetworkPacket& packet) override;
+
+		void connectTo(const std::shared_ptr<LoopbackConnection>& remote);
+		void onRemoteClosed();
+
+	private:
+		INetworkServiceStatsListener& stats;
+		std::shared_ptr<LoopbackNetwork> network;
+		std::weak_ptr<LoopbackConnection> remote;
+		ConnectionStatus status = ConnectionStatus::Connecting;
+		std::deque<InboundNetworkPacket> pendingSend;
+		std::deque<InboundNetworkPacket> pendingReceive;
+
+		void deliver(InboundNetworkPacket packet);
+	};
+
+	class LoopbackNetworkService : public NetworkServiceWithStats
+	{
+	public:
+		explicit LoopbackNetworkService(std::shared_ptr<LoopbackNetwork> network);
+		~LoopbackNetworkService() override;
+
+		void update(Time t) override;
+
+		String startListening(AcceptCallback callback) override;
+		void stopListening() override;
+		std::shared_ptr<IConnection> connect(const String& address) override;
+
+		void onSendData(size_t size, size_t nPackets) override;
+		void onReceiveData(size_t size, size_t nPackets) override;
+
+		// Unlike the per second stats, these are never reset
+		size_t getTotalBytesSent() const;
+		size_t getTotalPacketsSent() const;
+		size_t getTotalBytesReceived() const;
+		size_t getTotalPacketsReceived() const;
+
+	private:
+		class LoopbackAcceptor : public Acceptor {
+		public:
+			LoopbackAcceptor(LoopbackNetworkService& service, std::shared_ptr<LoopbackConnection> remote);
+			std::shared_ptr<IConnection> doAccept() override;
+			void doReject() override;
+
+		private:
+			LoopbackNetworkService& service;
+			std::shared_ptr<LoopbackConnection> remote;
+		};
+
+		std::shared_ptr<LoopbackNetwork> network;
+		AcceptCallback acceptCallback;
+		String address;
+		Vector<std::shared_ptr<LoopbackConnection>> pendingConnections;
+		size_t totalBytesSent = 0;
+		size_t totalPacketsSent = 0;
+		size_t totalBytesReceived = 0;
+		size_t totalPacketsReceived = 0;
+
+		void onConnectionRequest(std::shared_ptr<LoopbackConnection> remote);
+	};
+}
@@ -9,6 +9,7 @@
 #include <chrono>
 #include "message_queue.h"
 #include <cstdint>
+#include <optional>
 
 namespace Halley
 {
@@ -20,12 +21,15 @@ namespace Halley
 			OutboundNetworkPacket packet;
 			uint16_t seq = 0;
 			uint8_t channel = 0;
+			bool fragment = false;
+			bool moreFragments = false;
 		};
 
 		struct Inbound {
 			InboundNetworkPacket packet;
 			uint16_t seq = 0;
 			uint8_t channel = 0;
+			bool moreFragments = false;
 		};
 
 		struct PendingPacket
@@ -45,11 +49,15 @@ namespace Halley
 			uint16_t lastReceivedSeq = 0;
 			ChannelSettings settings;
 			bool initialized = false;
+			Bytes fragmentData;
 
 			void getReadyMessages(Vector<InboundNetworkPacket>& out);
 		};
 
 	public:
+		// Messages larger than this on reliable ordered channels are split into fragments, which are reassembled before being received
+		constexpr static size_t maxFragmentSize = 1300;
+
 		MessageQueueUDP(std::shared_ptr<AckUnreliableConnection> connection);
 		~MessageQueueUDP();
 		
@@ -66,7 +74,13 @@ namespace Halley
 
 		float getLatency() const;
 
+		// Fragments are paced to this rate, minus whatever the unfragmented messages sent in the meantime used, so large transfers don't delay realtime traffic.
+		// That only holds for traffic on other channels: a channel is delivered in order, so its messages still wait for any large message queued before them on it.
+		void setFragmentBandwidth(size_t bytesPerSecond);
+
 	private:
+		constexpr static size_t maxPacketSize = 1350;
+
 		std::shared_ptr<AckUnreliableConnection> connection;
 		Vector<Channel> channels;
 
@@ -74,10 +88,15 @@ namespace Halley
 		std::map<int, PendingPacket> pendingPackets;
 		int nextPacketId = 0;
 
+		size_t fragmentBandwidth = 256 * 1024;
+		float sendBudget = 0;
+		std::optional<std::chrono::steady_clock::time_point> lastSendTime;
+
 		void onPacketAcked(int tag) override;
 		void checkReSend(Vector<AckUnreliableSubPacket>& collect);
 
-		AckUnreliableSubPacket createPacket();
+		void updateSendBudget();
+		std::optional<AckUnreliableSubPacket> createPacket();
 		AckUnreliableSubPacket makeTaggedPacket(Vector<Outbound>& msgs, size_t size, bool resends = false, uint16_t resendSeq = 0);
 		Vector<gsl::byte> serializeMessages(const Vector<Outbound>& msgs, size_t size) const;
 
@@ -1,10 +1,74 @@
 #pragma once
 #include "halley/data_structures/vector.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <gsl/gsl>
 #include "halley/utils/utils.h"
 
 namespace Halley
 {
+	class NetworkBufferPool;
+
+	// Reference counted storage for inbound network data
+	// Every packet and sub-packet read from the same datagram points into one of these, instead of copying it
+	class NetworkBuffer
+	{
+	public:
+		Bytes data;
+
+	private:
+		friend class NetworkBufferRef;
+		friend class NetworkBufferPool;
+
+		std::atomic<uint32_t> refCount = 0;
+		std::shared_ptr<NetworkBufferPool> pool;
+	};
+
+	class NetworkBufferRef
+	{
+	public:
+		NetworkBufferRef() = default;
+		explicit NetworkBufferRef(NetworkBuffer* buffer);
+		NetworkBufferRef(const NetworkBufferRef& other);
+		NetworkBufferRef(NetworkBufferRef&& other) noexcept;
+		~NetworkBufferRef();
+
+		NetworkBufferRef& operator=(const NetworkBufferRef& other);
+		NetworkBufferRef& operator=(NetworkBufferRef&& other) noexcept;
+
+		static NetworkBufferRef makeUnpooled(gsl::span<const gsl::byte> data);
+
+		Bytes& getData() const;
+		bool isValid() const { return buffer != nullptr; }
+
+	private:
+		NetworkBuffer* buffer = nullptr;
+
+		void release();
+	};
+
+	// Recycles NetworkBuffers once every reference to them is gone, so receiving doesn't allocate in steady state
+	// Buffers keep their pool alive, so the pool can be destroyed while packets are still in flight
+	class NetworkBufferPool : public std::enable_shared_from_this<NetworkBufferPool>
+	{
+	public:
+		explicit NetworkBufferPool(size_t maxFreeBuffers = 1024);
+		~NetworkBufferPool();
+
+		// Returns a buffer of the given size, contents are undefined
+		NetworkBufferRef acquire(size_t size);
+
+	private:
+		friend class NetworkBufferRef;
+
+		std::mutex mutex;
+		Vector<NetworkBuffer*> freeBuffers;
+		size_t maxFreeBuffers;
+
+		void recycle(NetworkBuffer* buffer);
+	};
+
 	class NetworkPacketBase
 	{
 	public:
@@ -42,12 +106,19 @@ namespace Halley
 		OutboundNetworkPacket& operator=(OutboundNetworkPacket&& other) noexcept;
 	};
 
-	class InboundNetworkPacket : public NetworkPacketBase
+	// A view into a NetworkBuffer, sub-packets share the buffer of the packet they were read from
+	class InboundNetworkPacket
 	{
 	public:
 		InboundNetworkPacket();
 		InboundNetworkPacket(InboundNetworkPacket&& other) noexcept;
 		explicit InboundNetworkPacket(gsl::span<const gsl::byte> data);
+		InboundNetworkPacket(NetworkBufferRef buffer, size_t size);
+
+		size_t copyTo(gsl::span<gsl::byte> dst) const;
+		size_t getSize() const;
+		gsl::span<const gsl::byte> getBytes() const;
+
 		void extractHeader(gsl::span<gsl::byte> dst);
 
 		template <typename T>
@@ -56,6 +127,13 @@ namespace Halley
 			extractHeader(gsl::as_writable_bytes(gsl::span<T>(&h, 1)));
 		}
 
+		InboundNetworkPacket subPacket(size_t offset, size_t size) const;
+
 		InboundNetworkPacket& operator=(InboundNetworkPacket&& other) noexcept;
+
+	private:
+		NetworkBufferRef buffer;
+		size_t dataStart = 0;
+		size_t dataEnd = 0;
 	};
 }
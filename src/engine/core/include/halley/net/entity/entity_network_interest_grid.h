@@ -0,0 +1,33 @@
+#pragma once
+
+#include "halley/data_structures/hash_map.h"
+#include "halley/data_structures/vector.h"
+#include "halley/maths/rect.h"
+#include "halley/maths/vector2.h"
+
+namespace Halley {
+	// Uniform grid over the positions of replicated entities, rebuilt by EntityNetworkSession on every send.
+	// Each peer gathers its candidate entities from the cells overlapping its interest area, instead of testing every entity.
+	// Entries are indices into the list of entities being sent; entities without a position are always candidates.
+	class EntityNetworkInterestGrid {
+	public:
+		explicit EntityNetworkInterestGrid(float cellSize = 512.0f);
+
+		void clear();
+		void add(uint32_t idx, std::optional<Vector2f> position);
+
+		// Writes the sorted indices of every entity that might be inside area, or of all entities if area is not set
+		void query(std::optional<Rect4f> area, Vector<uint32_t>& result) const;
+
+		[[nodiscard]] size_t size() const;
+		[[nodiscard]] float getCellSize() const;
+
+	private:
+		float cellSize;
+		HashMap<Vector2i, Vector<uint32_t>> cells;
+		Vector<uint32_t> unpositioned;
+		size_t count = 0;
+
+		Vector2i getCell(Vector2f position) const;
+	};
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
 #include "halley/entity/system_message.h"
 #include "halley/maths/uuid.h"
+#include "halley/time/halleytime.h"
 
 namespace Halley {
     using EntityNetworkId = uint16_t;
@@ -16,7 +18,9 @@ namespace Halley {
     	EntityMsg,
     	SystemMsg,
     	SystemMsgResponse,
-    	KeepAlive
+    	KeepAlive,
+    	Snapshot,
+    	SnapshotAck
     };
 
     class IEntityNetworkMessage {
@@ -33,8 +37,13 @@ namespace Halley {
         EntityNetworkId entityId;
         Bytes bytes;
 
+        std::shared_ptr<const Bytes> sharedBytes; // If set, serialized instead of bytes. Allows the same payload to be sent to several peers without copying.
+
         EntityNetworkMessageCreate() = default;
 		EntityNetworkMessageCreate(EntityNetworkId id, Bytes bytes) : entityId(id), bytes(std::move(bytes)) {}
+		EntityNetworkMessageCreate(EntityNetworkId id, std::shared_ptr<const Bytes> bytes) : entityId(id), sharedBytes(std::move(bytes)) {}
+
+		const Bytes& getBytes() const { return sharedBytes ? *sharedBytes : bytes; }
 
         EntityNetworkHeaderType getType() const override { return EntityNetworkHeaderType::Create; }
         void serialize(Serializer& s) const override;
@@ -46,8 +55,13 @@ namespace Halley {
         EntityNetworkId entityId;
         Bytes bytes;
 
+        std::shared_ptr<const Bytes> sharedBytes; // If set, serialized instead of bytes. Allows the same payload to be sent to several peers without copying.
+
         EntityNetworkMessageUpdate() = default;
 		EntityNetworkMessageUpdate(EntityNetworkId id, Bytes bytes) : entityId(id), bytes(std::move(bytes)) {}
+		EntityNetworkMessageUpdate(EntityNetworkId id, std::shared_ptr<const Bytes> bytes) : entityId(id), sharedBytes(std::move(bytes)) {}
+
+		const Bytes& getBytes() const { return sharedBytes ? *sharedBytes : bytes; }
 
 		EntityNetworkHeaderType getType() const override { return EntityNetworkHeaderType::Update; }
 		void serialize(Serializer& s) const override;
@@ -135,6 +149,34 @@ namespace Halley {
         void deserialize(Deserializer& s) override;
 	};
     
+	// All entities a peer can see at one point in time, as a delta against an earlier snapshot the peer has acknowledged
+	// Entities in the baseline that aren't created, updated or destroyed here are unchanged
+	class EntityNetworkMessageSnapshot final : public IEntityNetworkMessage {
+	public:
+        uint32_t snapshotId = 0;
+        uint32_t baselineId = 0; // 0 if this is a full snapshot
+        Time time = 0;
+        Vector<EntityNetworkMessageCreate> creates;
+        Vector<EntityNetworkMessageUpdate> updates;
+        Vector<EntityNetworkId> destroys;
+
+		EntityNetworkHeaderType getType() const override { return EntityNetworkHeaderType::Snapshot; }
+		void serialize(Serializer& s) const override;
+        void deserialize(Deserializer& s) override;
+	};
+
+	class EntityNetworkMessageSnapshotAck final : public IEntityNetworkMessage {
+	public:
+        uint32_t snapshotId = 0;
+
+        EntityNetworkMessageSnapshotAck() = default;
+		EntityNetworkMessageSnapshotAck(uint32_t snapshotId) : snapshotId(snapshotId) {}
+
+		EntityNetworkHeaderType getType() const override { return EntityNetworkHeaderType::SnapshotAck; }
+		void serialize(Serializer& s) const override;
+        void deserialize(Deserializer& s) override;
+	};
+    
     class EntityNetworkMessage {
     public:
         EntityNetworkMessage() = default;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "halley/bytes/bit_serializer.h"
+#include "halley/data_structures/hash_map.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley {
+	class ConfigNode;
+	class EntityData;
+	class EntityDataDelta;
+	class WorldReflection;
+
+	// Replaces the fields of networked components that have quantization annotations in their ECS definition with a single
+	// bit-packed entry before sending, and restores them after receiving. Fields the packer doesn't recognise (e.g. deleted) are left as they are.
+	class EntityNetworkQuantizer {
+	public:
+		constexpr static std::string_view packedFieldsKey = "_quantized";
+
+		EntityNetworkQuantizer() = default;
+		explicit EntityNetworkQuantizer(const WorldReflection& reflection);
+
+		void pack(EntityDataDelta& delta);
+		void unpack(EntityDataDelta& delta) const;
+
+		bool isEmpty() const;
+
+	private:
+		HashMap<String, gsl::span<const NetworkQuantizedField>> components;
+		Bytes scratch;
+
+		void pack(EntityData& data);
+		void unpack(EntityData& data) const;
+		void packComponent(const String& componentName, ConfigNode& node);
+		void unpackComponent(const String& componentName, ConfigNode& node) const;
+	};
+}
@@ -12,6 +12,7 @@ namespace Halley {
 	class EntityNetworkSession;
 	struct EntityId;
     class EntityData;
+    class Prefab;
 
     struct EntityNetworkUpdateInfo {
 		EntityId entityId;
@@ -20,6 +21,9 @@ namespace Halley {
 
     class EntityNetworkRemotePeer {
         constexpr static Time maxSendInterval = 1.0;
+        constexpr static size_t maxUnackedSnapshots = 64;
+        constexpr static size_t maxSnapshotBytes = 1100; // Keeps snapshots within one unfragmented packet, as they're sent unreliably
+        constexpr static size_t snapshotEntityOverhead = 4; // Network id and size
     	
     public:
         EntityNetworkRemotePeer(EntityNetworkSession& parent, NetworkSession::PeerId peerId);
@@ -30,6 +34,7 @@ namespace Halley {
 
     	void sendEntities(Time t, gsl::span<const EntityNetworkUpdateInfo> entityIds, const EntityClientSharedData& clientData);
         void receiveNetworkMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
+        void updateSnapshotPlayback(Time t);
 
     private:
         class OutboundEntity {
@@ -37,13 +42,39 @@ namespace Halley {
             bool alive = true;
             Time timeSinceSend = 0;
             EntityNetworkId networkId = 0;
-            EntityData data;
+            std::shared_ptr<const EntityData> data; // Baseline last sent to this peer, shared with other peers that received the same one
         };
 
         class InboundEntity {
         public:
             EntityId worldId;
             EntityData data;
+            std::shared_ptr<const EntityData> snapshotData; // Snapshot this was last updated to, in snapshot mode. Null while it's between two.
+        };
+
+        class SentSnapshotEntity {
+        public:
+            EntityNetworkId networkId = 0;
+            std::shared_ptr<const EntityData> data;
+        };
+
+        class SentSnapshot {
+        public:
+            uint32_t id = 0;
+            HashMap<EntityId, SentSnapshotEntity> entities;
+        };
+
+        class ReceivedSnapshotEntity {
+        public:
+            std::shared_ptr<const EntityData> data;
+            std::shared_ptr<const Prefab> prefab;
+        };
+
+        class ReceivedSnapshot {
+        public:
+            uint32_t id = 0;
+            Time time = 0;
+            HashMap<EntityNetworkId, ReceivedSnapshotEntity> entities;
         };
 
         EntityNetworkSession* parent = nullptr;
@@ -58,17 +89,46 @@ namespace Halley {
         uint16_t nextId = 0;
 
         Time timeSinceSend = 0;
+        Vector<uint32_t> candidates;
+
+        // Snapshot mode, sending
+        Time snapshotClock = 0;
+        Time timeSinceSnapshot = 0;
+        uint32_t nextSnapshotId = 1;
+        std::optional<SentSnapshot> ackedSnapshot;
+        Vector<SentSnapshot> unackedSnapshots;
+        HashMap<EntityId, EntityNetworkId> snapshotNetworkIds;
+        size_t snapshotStartIdx = 0; // Entities that didn't fit in the last snapshot go first in the next one
+        Vector<std::pair<uint32_t, EntityNetworkId>> snapshotIdsToFree; // Freed once a snapshot without them is acknowledged
+        HashSet<EntityId> oversizedSnapshotEntities; // Reported once, and left out of snapshots
+
+        // Snapshot mode, receiving
+        Vector<ReceivedSnapshot> receivedSnapshots;
+        uint32_t lastAppliedSnapshot = 0;
+        std::optional<Time> playbackTime;
 
         uint16_t assignId();
         void sendCreateEntity(EntityRef entity);
-        void sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity);
+        void sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity, const EntityClientSharedData& clientData);
         void sendDestroyEntity(OutboundEntity& remote);
         void sendKeepAlive();
-        void send(EntityNetworkMessage message);
+        void send(EntityNetworkMessage message, bool reliable = true);
+        void gatherEntitiesToSend(gsl::span<const EntityNetworkUpdateInfo> entityIds, const EntityClientSharedData& clientData, Vector<EntityRef>& result);
+
+        void sendSnapshot(Time t, gsl::span<const EntityNetworkUpdateInfo> entityIds, const EntityClientSharedData& clientData);
+        const SentSnapshotEntity* findSnapshotBase(EntityId entityId, EntityNetworkId networkId) const;
+        bool isOversizedForSnapshot(EntityRef entity, size_t size);
+        void receiveSnapshotAck(const EntityNetworkMessageSnapshotAck& msg);
 
         void receiveCreateEntity(const EntityNetworkMessageCreate& msg);
         void receiveUpdateEntity(const EntityNetworkMessageUpdate& msg);
         void receiveDestroyEntity(const EntityNetworkMessageDestroy& msg);
+        void receiveSnapshot(EntityNetworkMessageSnapshot& msg);
+        void applySnapshot(const ReceivedSnapshot& snapshot);
+        void interpolateSnapshot(const ReceivedSnapshot& from, const ReceivedSnapshot& to, float alpha);
+
+        InboundEntity& createRemoteEntity(EntityNetworkId id, const EntityDataDelta& delta);
+        void updateRemoteEntity(EntityNetworkId id, InboundEntity& remote, const EntityDataDelta& delta, bool useInterpolators = true);
 
         void destroyRemoteEntity(EntityId id);
 
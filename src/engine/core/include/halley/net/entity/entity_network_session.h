@@ -1,11 +1,16 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <gsl/span>
 
 #include "halley/time/halleytime.h"
 #include "../session/network_session.h"
+#include "entity_network_interest_grid.h"
+#include "entity_network_quantizer.h"
 #include "entity_network_remote_peer.h"
+#include "halley/bytes/compression.h"
+#include "halley/bytes/lz4_stream.h"
 #include "halley/bytes/serialization_dictionary.h"
 #include "halley/entity/system.h"
 #include "halley/entity/world.h"
@@ -24,11 +29,17 @@ namespace Halley {
 	class EntityClientSharedData : public SharedData {
 	public:
 		std::optional<Rect4i> viewRect;
+		uint64_t compressionDictionaryHash = 0;
 
 		void serialize(Serializer& s) const override;
 		void deserialize(Deserializer& s) override;
 	};
 
+	enum class EntityNetworkReplicationMode {
+		Messages, // Each entity is created, updated and destroyed with its own message, sent to every peer at its own priority
+		Snapshots // The host periodically sends each client an unreliable snapshot of the entities in view, delta encoded against the last one the client acknowledged
+	};
+
 	class EntityNetworkSession : NetworkSession::IListener, NetworkSession::ISharedDataHandler, public IWorldNetworkInterface {
     public:
 		class IEntityNetworkSessionListener {
@@ -38,6 +49,13 @@ namespace Halley {
 			virtual void onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId) {}
 			virtual void setupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote) = 0;
 			virtual bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) = 0;
+
+			// Area outside of which isEntityInView() is always false for entities with a Transform2DComponent. Entities are only tested if they're inside it.
+			// Return empty to test every entity.
+			virtual std::optional<Rect4f> getInterestArea(const EntityClientSharedData& clientData) { return {}; }
+
+			// Scales how often updates to an entity are sent to this client, 1 being every getMinSendInterval()
+			virtual float getEntityUpdatePriority(EntityRef entity, const EntityClientSharedData& clientData) { return 1.0f; }
 		};
 		
 		EntityNetworkSession(std::shared_ptr<NetworkSession> session, Resources& resources, std::set<String> ignoreComponents, IEntityNetworkSessionListener* listener);
@@ -60,12 +78,35 @@ namespace Halley {
 
 		Time getMinSendInterval() const;
 
+		// Only the host's mode matters, as it decides how entities are sent to clients. Clients always send their own entities with messages.
+		// In snapshot mode, clients play back snapshots interpolationDelay behind the newest one they received, set by calling this on the client.
+		// Fields with an enabled interpolator are blended between the two snapshots around that time, instead of going through the interpolator.
+		void setReplicationMode(EntityNetworkReplicationMode mode, Time interpolationDelay = 0.1);
+		EntityNetworkReplicationMode getReplicationMode() const;
+		Time getSnapshotInterpolationDelay() const;
+
+		// Packets to peers which set the same dictionary are compressed with LZ4 instead of deflate, streaming across packets on direct connections.
+		// Peers advertise their dictionary on the next sendUpdates(). The dictionary can be trained with "halley-cmd netDictionary" from samples gathered with setPacketCaptureCallback().
+		void setCompressionDictionary(std::shared_ptr<const Bytes> dictionary);
+
+		// Called with every batch of messages before compression, as [uint32 size][bytes] records can be appended to a file for netDictionary
+		void setPacketCaptureCallback(std::function<void(gsl::span<const gsl::byte>)> callback);
+
+		// These are cached for the duration of a sendUpdates() call, so each entity is only serialized once regardless of how many peers it's sent to
+		// Entities whose networked state hasn't changed since the last call keep returning the same snapshot, which peers recognise as unchanged
+		std::shared_ptr<const EntityData> getEntitySnapshot(EntityRef entity);
+		std::shared_ptr<const Bytes> getEntityCreateBytes(EntityRef entity);
+		std::shared_ptr<const Bytes> getEntityUpdateBytes(EntityRef entity, const std::shared_ptr<const EntityData>& baseline); // Returns null if there are no changes
+		EntityDataDelta deserializeEntityDelta(const Bytes& bytes) const;
+
 		void onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId);
 		void requestSetupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote);
 		void setupOutboundInterpolators(EntityRef entity);
 
 		bool isReadyToStart() const;
 		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) const;
+		void getInterestCandidates(const EntityClientSharedData& clientData, Vector<uint32_t>& result) const; // Indices into the entities passed to sendUpdates()
+		float getEntityUpdatePriority(EntityRef entity, const EntityClientSharedData& clientData) const;
 
 		Vector<Rect4i> getRemoteViewPorts() const;
 
@@ -75,7 +116,7 @@ namespace Halley {
 		void sendSystemMessage(String targetSystem, int messageType, Bytes messageData, SystemMessageDestination destination, SystemMessageCallback callback) override;
 
 		void sendToAll(EntityNetworkMessage msg);
-		void sendToPeer(EntityNetworkMessage msg, NetworkSession::PeerId peerId);
+		void sendToPeer(EntityNetworkMessage msg, NetworkSession::PeerId peerId, bool reliable = true); // Unreliable messages are sent in their own packets, which can be lost
 
 	protected:
 		void onStartSession(NetworkSession::PeerId myPeerId) override;
@@ -93,6 +134,19 @@ namespace Halley {
 		struct PendingSysMsgResponse {
 			SystemMessageCallback callback;
 		};
+
+		struct EntityDeltaCache {
+			std::shared_ptr<const EntityData> baseline;
+			std::shared_ptr<const Bytes> bytes;
+		};
+
+		struct EntitySnapshotCache {
+			Bytes state;
+			uint32_t stateUpdate = 0;
+			std::shared_ptr<const EntityData> data;
+			std::shared_ptr<const Bytes> createBytes;
+			Vector<EntityDeltaCache> deltas;
+		};
 		
 		Resources& resources;
 		std::shared_ptr<EntityFactory> factory;
@@ -105,6 +159,7 @@ namespace Halley {
 		EntityDataDelta::Options deltaOptions;
 		SerializerOptions byteSerializationOptions;
 		SerializationDictionary serializationDictionary;
+		EntityNetworkQuantizer quantizer;
 
 		std::shared_ptr<NetworkSession> session;
 		Vector<EntityNetworkRemotePeer> peers;
@@ -112,11 +167,27 @@ namespace Halley {
 		Vector<QueuedMessage> queuedPackets;
 
 		HashMap<int, Vector<EntityNetworkMessage>> outbox;
+		HashMap<NetworkSession::PeerId, Vector<EntityNetworkMessage>> unreliableOutbox;
+		Bytes sendBuffer;
+		Bytes receiveBuffer;
+		ZlibInflater inflater;
+
+		std::shared_ptr<const Bytes> compressionDictionary;
+		uint64_t compressionDictionaryHash = 0;
+		HashMap<NetworkSession::PeerId, LZ4StreamCompressor> packetCompressors;
+		HashMap<NetworkSession::PeerId, LZ4StreamDecompressor> packetDecompressors;
+		std::function<void(gsl::span<const gsl::byte>)> packetCaptureCallback;
+		HashMap<EntityId, EntitySnapshotCache> entitySnapshots;
+		EntityNetworkInterestGrid interestGrid;
+		uint32_t snapshotUpdate = 0;
+		EntityNetworkReplicationMode replicationMode = EntityNetworkReplicationMode::Messages;
+		Time snapshotInterpolationDelay = 0.1;
 
 		bool readyToStart = false;
 
 		bool canProcessMessage(const EntityNetworkMessage& msg) const;
 		void processMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
+		void updateInterestGrid(gsl::span<const EntityNetworkUpdateInfo> entityIds);
 		void onReceiveEntityUpdate(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg);
 		void onReceiveReady(NetworkSession::PeerId fromPeerId, const EntityNetworkMessageReadyToStart& msg);
 		void onReceiveMessageToEntity(NetworkSession::PeerId fromPeerId, const EntityNetworkMessageEntityMsg& msg);
@@ -124,6 +195,9 @@ namespace Halley {
 		void onReceiveSystemMessageResponse(NetworkSession::PeerId fromPeerId, const EntityNetworkMessageSystemMsgResponse& msg);
 
 		void sendMessages();
+		OutboundNetworkPacket makePacket(gsl::span<const gsl::byte> bytes, std::optional<NetworkSession::PeerId> peerId, bool ordered);
+		void readPacket(NetworkSession::PeerId fromPeerId, gsl::span<const gsl::byte> bytes, Bytes& dst);
+		bool canUseCompressionDictionary(NetworkSession::PeerId peerId) const;
 		
 		void setupDictionary();
 	};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "halley/data_structures/vector.h"
+#include "halley/utils/utils.h"
+
+namespace Halley
+{
+	// Builds a dictionary for LZ4StreamCompressor out of sample packets.
+	// The samples are split into one epoch per segment, and each epoch contributes the segment whose 8-byte sequences appear in the most samples.
+	// Sequences already covered by a chosen segment stop counting, so the dictionary doesn't repeat itself.
+	class NetworkDictionaryTrainer
+	{
+	public:
+		constexpr static size_t maxDictionarySize = 64 * 1024;
+
+		explicit NetworkDictionaryTrainer(size_t segmentSize = 64);
+
+		void addSample(gsl::span<const gsl::byte> sample);
+		void addCapture(gsl::span<const gsl::byte> capture); // Sequence of [uint32 size][bytes] records, as written from EntityNetworkSession::setPacketCaptureCallback()
+
+		size_t getNumSamples() const;
+		Bytes train(size_t dictionarySize) const;
+
+	private:
+		size_t segmentSize;
+		Bytes data;
+		Vector<size_t> sampleEnds;
+	};
+}
@@ -7,13 +7,17 @@ namespace Halley {}
 #include "halley/net/connection/iconnection.h"
 #include "halley/net/connection/imessage_stream.h"
 #include "halley/net/connection/instability_simulator.h"
+#include "halley/net/connection/loopback_network_service.h"
 #include "halley/net/connection/message_queue.h"
 #include "halley/net/connection/network_message.h"
 #include "halley/net/connection/network_packet.h"
 #include "halley/net/connection/network_service.h"
 #include "halley/net/connection/standard_message_stream.h"
 
+#include "halley/net/entity/entity_network_interest_grid.h"
+#include "halley/net/entity/entity_network_quantizer.h"
 #include "halley/net/entity/entity_network_session.h"
+#include "halley/net/entity/network_dictionary_trainer.h"
 
 #include "halley/net/session/network_session.h"
 #include "halley/net/session/session.h"
@@ -52,7 +52,7 @@ namespace Halley {
 		NetworkSessionType getType() const;
 
 		void sendToPeers(OutboundNetworkPacket packet, std::optional<PeerId> except = {});
-		void sendToPeer(OutboundNetworkPacket packet, PeerId peerId);
+		bool sendToPeer(OutboundNetworkPacket packet, PeerId peerId, bool reliable = true); // Returns false if there's no connection to send it through. Unreliable packets can be lost or arrive out of order.
 		std::optional<std::pair<PeerId, InboundNetworkPacket>> receive();
 
 		void addListener(IListener* listener);
@@ -107,6 +107,9 @@ namespace Halley {
 		std::unique_ptr<SharedData> makePeerSharedData();
 
 	private:
+		constexpr static uint8_t reliableChannel = 0;
+		constexpr static uint8_t unreliableChannel = 1;
+
 		struct Peer {
 			PeerId peerId = -1;
 			bool alive = true;
@@ -137,7 +140,7 @@ namespace Halley {
 
 		OutboundNetworkPacket makeOutbound(gsl::span<const gsl::byte> data, NetworkSessionMessageHeader header);
 		void doSendToAll(OutboundNetworkPacket packet, std::optional<PeerId> except);
-		void doSendToPeer(const Peer& peer, OutboundNetworkPacket packet);
+		void doSendToPeer(const Peer& peer, OutboundNetworkPacket packet, bool reliable = true);
 		
 		void closeConnection(PeerId peerId, const String& reason);
 		void processReceive();
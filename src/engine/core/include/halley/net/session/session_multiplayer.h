@@ -54,8 +54,12 @@ namespace Halley {
 		void onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId) override;
 		void setupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote) override;
 		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) override;
+		std::optional<Rect4f> getInterestArea(const EntityClientSharedData& clientData) override;
+		float getEntityUpdatePriority(EntityRef entity, const EntityClientSharedData& clientData) override;
 
 	private:
+		constexpr static int viewRectMargin = 256;
+
 		bool host = false;
 		bool waitingForViewPort = false;
 		String playerName;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <optional>
 #include "halley/text/halleystring.h"
 #include "halley/data_structures/tree_map.h"
 #include "halley/data_structures/hash_map.h"
@@ -8,6 +11,7 @@
 namespace Halley
 {
 	enum class AssetType;
+	class AssetPackIndex;
 
 	class AssetDatabase
 	{
@@ -30,6 +34,9 @@ namespace Halley
 		public:
 			TypedDB();
 			explicit TypedDB(AssetType type);
+
+			// Backed by a pack index, entries are only decoded the first time they're requested
+			TypedDB(AssetType type, std::shared_ptr<const AssetPackIndex> index);
 			
 			void add(const String& name, Entry&& asset);
 			const Entry& get(const String& name) const;
@@ -38,19 +45,33 @@ namespace Halley
 			void serialize(Serializer& s) const;
 			void deserialize(Deserializer& s);
 
+			// On indexed databases, this decodes every entry
 			const HashMap<String, Entry>& getAssets() const;
+			Vector<String> getNames() const;
 			AssetType getType() const;
 
 		private:
+			struct IndexCache {
+				std::mutex mutex;
+				HashMap<String, std::unique_ptr<Entry>> entries;
+				std::optional<HashMap<String, Entry>> allEntries;
+			};
+
 			AssetType type;
 			HashMap<String, Entry> assets;
+			std::shared_ptr<const AssetPackIndex> index;
+			std::shared_ptr<IndexCache> indexCache;
 		};
 
 		void addAsset(const String& name, AssetType type, Entry&& entry);
 		const TypedDB& getDatabase(AssetType type) const;
+		const TreeMap<int, TypedDB>& getDatabases() const;
 		bool hasDatabase(AssetType type) const;
 		Vector<String> getAssets() const;
 
+		// Replaces the contents with the assets in the index
+		void setIndex(std::shared_ptr<const AssetPackIndex> index);
+
 		void serialize(Serializer& s) const;
 		void deserialize(Deserializer& s);
 		Vector<String> enumerate(AssetType type) const;
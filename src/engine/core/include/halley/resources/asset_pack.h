@@ -2,6 +2,8 @@
 #include "halley/utils/utils.h"
 #include "halley/text/halleystring.h"
 #include <memory>
+#include <optional>
+#include <shared_mutex>
 #include <gsl/span>
 #include "halley/resources/resource_data.h"
 
@@ -10,9 +12,14 @@ namespace Halley {
 	class Deserializer;
 	class Serializer;
 	class AssetDatabase;
+	class AssetPackIndex;
 	class ResourceData;
 	class ResourceDataReader;
+	class MappedFile;
+	class Path;
 
+	// Packs written with the "HALLEYPK" identifier store a compressed, serialized AssetDatabase between the header and the data.
+	// "HALLEYPI" packs store an AssetPackIndex there instead, which is used as is.
 	struct AssetPackHeader {
 		std::array<char, 8> identifier;
 		std::array<char, 16> iv;
@@ -20,6 +27,7 @@ namespace Halley {
 		uint64_t dataStartPos;
 
 		void init(size_t assetDbSize);
+		bool isIndexed() const;
 	};
 
     class AssetPack {
@@ -43,6 +51,11 @@ namespace Halley {
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream);
 
 		void readToMemory();
+
+		// Serves all reads from a memory mapping of the pack file from then on, without copying non-streamed assets. Not available for encrypted or preloaded packs.
+		// Returns false if the pack is not read from a reader, or the file can't be mapped.
+		bool mapToMemory(const Path& path);
+		bool isMapped() const;
 		void encrypt(const String& key);
 		void decrypt(const String& key);
 	    
@@ -54,13 +67,19 @@ namespace Halley {
 
     private:
 		std::unique_ptr<AssetDatabase> assetDb;
+		std::shared_ptr<const AssetPackIndex> index;
 		std::unique_ptr<ResourceDataReader> reader;
 		std::atomic<bool> hasReader;
-		std::mutex readerMutex;
+		bool readerSupportsReadAt = false;
+		std::shared_mutex readerMutex; // Exclusive for seek and read, shared for positional reads
+		std::shared_ptr<MappedFile> mapping;
 		size_t dataOffset = 0;
 		Bytes data;
 		std::array<char, 16> iv;
 		mutable std::shared_ptr<bool> aliveToken;
+
+		std::optional<std::pair<size_t, size_t>> findAsset(const String& asset, AssetType type) const;
+		Bytes makeIndex() const;
     };
 
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <gsl/gsl>
+
+#include "halley/data_structures/vector.h"
+#include "halley/text/halleystring.h"
+#include "halley/utils/utils.h"
+
+namespace Halley {
+	enum class AssetType;
+	class Metadata;
+
+	// Fixed layout table of the assets in a pack, used directly from its bytes without deserializing anything.
+	// Entries are sorted by the 64-bit hash of their type and name, so lookups are a binary search. Names and metadata live in blobs after the table, and are only read on demand.
+	class AssetPackIndex {
+	public:
+		struct Header {
+			std::array<char, 8> identifier;
+			uint32_t version;
+			uint32_t numEntries;
+			uint64_t namesStart;
+			uint64_t metaStart;
+			uint64_t totalSize;
+		};
+
+		struct Entry {
+			uint64_t hash;
+			uint64_t pos; // Relative to the start of the pack data
+			uint64_t size;
+			uint64_t nameOffset;
+			uint64_t metaOffset;
+			uint32_t metaSize;
+			uint32_t nameLength;
+			int32_t type;
+			uint32_t padding;
+		};
+
+		struct Source {
+			AssetType type;
+			String name;
+			uint64_t pos;
+			uint64_t size;
+			const Metadata* meta;
+		};
+
+		constexpr static uint32_t currentVersion = 1;
+
+		// Keeps owner alive for as long as the index is, so data can point into a memory mapping or any other buffer
+		AssetPackIndex(std::shared_ptr<const void> owner, gsl::span<const gsl::byte> data);
+		explicit AssetPackIndex(Bytes data);
+
+		static Bytes build(Vector<Source> assets);
+		static uint64_t hashAsset(AssetType type, std::string_view name);
+
+		const Entry* find(AssetType type, std::string_view name) const;
+		gsl::span<const Entry> getEntries() const;
+
+		std::string_view getName(const Entry& entry) const;
+		Metadata getMetadata(const Entry& entry) const;
+
+		gsl::span<const gsl::byte> getBytes() const;
+
+	private:
+		std::shared_ptr<const void> owner;
+		gsl::span<const gsl::byte> data;
+		gsl::span<const Entry> entries;
+
+		void validate();
+	};
+}
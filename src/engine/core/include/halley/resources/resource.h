@@ -184,6 +184,10 @@ namespace Halley
 
 		virtual ResourceMemoryUsage getMemoryUsage() const;
 
+		// Called when resources are still over the memory budget after evicting everything that's unused.
+		// Should drop anything that can be rebuilt on demand, in case it's keeping other resources in use.
+		virtual void releaseCaches();
+
 		void increaseAge(float time);
 		void resetAge();
 		float getAge() const;
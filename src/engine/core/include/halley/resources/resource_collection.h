@@ -3,11 +3,15 @@
 #include <utility>
 #include <memory>
 #include <functional>
+#include <future>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <halley/concurrency/shared_recursive_mutex.h>
 #include <halley/text/halleystring.h>
 #include <halley/resources/resource_data.h>
 #include <halley/data_structures/hash_map.h>
+#include <halley/resources/resource.h>
 
 namespace Halley
 {
@@ -15,26 +19,43 @@ namespace Halley
 	class Resource;
 	class Resources;
 	class ResourceLoader;
-	struct ResourceMemoryUsage;
 
 	class ResourceCollectionBase
 	{
 		class Wrapper
 		{
 		public:
-			Wrapper(std::shared_ptr<Resource> resource, int loadDepth)
-				: res(std::move(resource))
-				, depth(loadDepth)
-			{}
+			Wrapper(std::shared_ptr<Resource> resource, int loadDepth, ResourceLoadPriority priority, uint64_t lastUsed);
+			Wrapper(Wrapper&& other) noexcept;
+			Wrapper& operator=(Wrapper&& other) noexcept;
 
 			std::shared_ptr<Resource> res;
 			int depth;
+			ResourceLoadPriority priority;
+			ResourceMemoryUsage memoryUsage; // As accounted in Resources
+			bool memoryUsageStale = false; // Still loading when accounted, so it has to be measured again
+			mutable std::atomic<uint64_t> lastUsed; // Updated on lookups, under the shared lock
+		};
+
+		class PendingLoad
+		{
+		public:
+			std::shared_future<std::shared_ptr<Resource>> result;
+			std::thread::id thread;
 		};
 
 	public:
 		using ResourceLoaderFunc = std::function<std::shared_ptr<Resource>(std::string_view, ResourceLoadPriority)>;
 		using ResourceEnumeratorFunc = std::function<Vector<String>()>;
 
+		struct EvictionCandidate {
+			ResourceCollectionBase* collection;
+			String assetId;
+			ResourceLoadPriority priority;
+			uint64_t lastUsed;
+			ResourceMemoryUsage memoryUsage;
+		};
+
 		explicit ResourceCollectionBase(Resources& parent, AssetType type);
 		virtual ~ResourceCollectionBase() {}
 
@@ -53,6 +74,9 @@ namespace Halley
 
 		std::shared_ptr<Resource> getUntyped(std::string_view name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
 
+		// Loads on the CPU pool if it's not loaded yet, sharing the load with any other request for the same asset
+		std::shared_future<std::shared_ptr<Resource>> getUntypedAsync(std::string_view name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
+
 		Vector<String> enumerate() const;
 
 		AssetType getAssetType() const;
@@ -64,20 +88,47 @@ namespace Halley
 		/// <returns>How much memory was freed</returns>
 		ResourceMemoryUsage clearOldResources(float maxAge);
 
+		// Pinned assets are never evicted to meet the memory budget. Can be set before the asset is loaded.
+		void setPinned(std::string_view assetId, bool pinned);
+		bool isPinned(std::string_view assetId) const;
+
+		// Collections with lower priority are evicted first when over the memory budget
+		void setEvictionPriority(int priority);
+		int getEvictionPriority() const;
+
+		// Resources that can be evicted, i.e. not pinned and not referenced from outside Resources
+		void getEvictionCandidates(Vector<EvictionCandidate>& candidates);
+
+		/// <returns>How much memory was freed</returns>
+		ResourceMemoryUsage evict(std::string_view assetId);
+
+		void releaseCaches();
+
 	protected:
 		virtual std::shared_ptr<Resource> loadResource(ResourceLoader& loader) = 0;
 
 		std::shared_ptr<Resource> doGet(std::string_view name, ResourceLoadPriority priority, bool allowFallback);
+		std::shared_ptr<Resource> doLoad(std::string_view assetId, ResourceLoadPriority priority, bool allowFallback, std::optional<std::promise<std::shared_ptr<Resource>>> promise);
 		std::pair<std::shared_ptr<Resource>, bool> loadAsset(std::string_view assetId, ResourceLoadPriority priority, bool allowFallback);
 
 	private:
 		Resources& parent;
 		HashMap<String, Wrapper> resources;
+		HashMap<String, PendingLoad> pendingLoads;
+		HashSet<String> pinned;
+		int evictionPriority = 0;
+		size_t staleMemoryUsages = 0;
 		String fallback;
 		AssetType type;
 		ResourceLoaderFunc resourceLoader;
 		ResourceEnumeratorFunc resourceEnumerator;
 		mutable SharedRecursiveMutex mutex;
+
+		void onRequested(std::string_view assetId);
+		Wrapper makeWrapper(std::shared_ptr<Resource> resource, int loadDepth, ResourceLoadPriority priority);
+		void releaseWrapper(const Wrapper& wrapper);
+		bool isInUse(const Wrapper& wrapper) const;
+		void refreshMemoryUsage();
 	};
 
 	template <typename T>
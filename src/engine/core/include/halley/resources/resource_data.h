@@ -24,10 +24,12 @@ This file is subject to the terms of halley_license.txt.
 #include "halley/text/halleystring.h"
 #include "halley/file/path.h"
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <halley/concurrency/future.h>
 #include <gsl/gsl>
 #include "metadata.h"
+#include "halley/bytes/compression.h"
 
 namespace Halley {
 	enum class AssetType;
@@ -42,6 +44,10 @@ namespace Halley {
 		virtual void close() = 0;
 		virtual bool isAvailable() const { return true; }
 
+		// Positional reads don't move the read position, and can be made from several threads at once if supported
+		virtual bool supportsReadAt() const { return false; }
+		virtual int readAt(size_t pos, gsl::span<gsl::byte> dst);
+
 		Bytes readAll();
 	};
 
@@ -54,12 +60,44 @@ namespace Halley {
 		void seek(int64_t pos, int whence) override;
 		size_t tell() const override;
 		void close() override;
+		bool supportsReadAt() const override;
+		int readAt(size_t pos, gsl::span<gsl::byte> dst) override;
 
 	private:
 		void* fp = nullptr;
 		size_t fileSize = 0;
 	};
 
+	// Reads a chunked LZ4 file (see Compression::lz4CompressChunked) through another reader, presenting the decompressed data.
+	// Only the chunks that are actually read get decompressed, so it can be seeked freely and never holds more than one chunk in memory.
+	class ResourceDataReaderLZ4Chunked : public ResourceDataReader {
+	public:
+		explicit ResourceDataReaderLZ4Chunked(std::unique_ptr<ResourceDataReader> source);
+		size_t size() const override;
+		int read(gsl::span<gsl::byte> dst) override;
+		void seek(int64_t pos, int whence) override;
+		size_t tell() const override;
+		void close() override;
+		bool isAvailable() const override;
+		bool supportsReadAt() const override;
+		int readAt(size_t pos, gsl::span<gsl::byte> dst) override;
+
+	private:
+		std::unique_ptr<ResourceDataReader> source;
+		Compression::LZ4ChunkedHeader header;
+		Vector<uint64_t> offsets;
+
+		mutable std::mutex mutex;
+		size_t curPos = 0;
+		std::optional<size_t> curChunk;
+		Bytes compressed;
+		Bytes decompressed;
+
+		void readSource(size_t pos, gsl::span<gsl::byte> dst);
+		int doReadAt(size_t pos, gsl::span<gsl::byte> dst);
+		void loadChunk(size_t idx);
+	};
+
 	class ResourceData {
 	public:
 		ResourceData(String path);
@@ -75,6 +113,7 @@ namespace Halley {
 	public:
 		ResourceDataStatic(String path);
 		ResourceDataStatic(const void* data, size_t size, String path, bool owning = true);
+		ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path); // e.g. an aliasing pointer that keeps the memory it points into alive
 
 		void set(const void* data, size_t size, bool owning = true);
 		bool isLoaded() const;
@@ -85,6 +124,7 @@ namespace Halley {
 		String getString() const;
 		void inflate();
 		void lz4Decompress();
+		void lz4DecompressChunked();
 
 		static std::unique_ptr<ResourceDataStatic> loadFromFileSystem(Path path);
 		void writeToFileSystem(String path) const;
@@ -132,12 +172,17 @@ namespace Halley {
 	public:
 		const String& getName() const { return name; }
 		ResourceLoadPriority getPriority() const { return priority; }
+		ExecutionPriority getExecutionPriority() const;
+		static ExecutionPriority getExecutionPriority(ResourceLoadPriority priority);
 		const HalleyAPI& getAPI() const { return *api; }
 		const Metadata& getMeta() const { return *metadata; }
 
 		std::unique_ptr<ResourceDataStatic> getStatic(bool throwOnFail = true);
 		std::unique_ptr<ResourceDataStream> getStream(bool throwOnFail = true);
-		Future<std::unique_ptr<ResourceDataStatic>> getAsync(bool throwOnFail = true) const;
+
+		// Reads the raw data on the disk I/O thread, then decompresses it on the CPU pool, both at this loader's priority
+		// If owner is set and expires before the read starts (e.g. the resource was unloaded), nothing is read and the result is null
+		Future<std::unique_ptr<ResourceDataStatic>> getAsync(bool throwOnFail = true, std::weak_ptr<const void> owner = {}) const;
 		Resources& getResources() const;
 
 	private:
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <mutex>
+#include "halley/data_structures/config_node.h"
+#include "halley/data_structures/hash_map.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley
+{
+	enum class AssetType;
+
+	// Which assets depend on which others, so reloading an asset can also reload exactly the ones built from it.
+	// Assets are identified in "type:name" format, same as Resources::reloadAssets.
+	// Edges are recorded by Resources whenever an asset requests another while loading, and from the "dependencies" list in its metadata,
+	// which importers fill in for dependencies that are only resolved later (e.g. prefabs instanced by other prefabs).
+	class ResourceDependencyGraph
+	{
+	public:
+		static String makeAssetId(AssetType type, std::string_view name);
+		static ConfigNode makeDependencyList(const HashSet<String>& assetIds);
+
+		void addDependency(const String& dependent, const String& dependency);
+		void addDependencies(const String& dependent, const ConfigNode& dependencyList);
+
+		// Called before an asset is (re)loaded, as loading it records its dependencies again
+		void clearDependencies(const String& dependent);
+
+		Vector<String> getDependencies(const String& assetId) const;
+		Vector<String> getDependents(const String& assetId) const;
+
+		// Returns the changed assets and everything that depends on them, split in stages.
+		// Every asset comes after all of its dependencies, and the assets in one stage don't depend on each other.
+		Vector<Vector<String>> getReloadOrder(const Vector<String>& changed) const;
+
+	private:
+		mutable std::mutex mutex;
+		HashMap<String, HashSet<String>> dependencies;
+		HashMap<String, HashSet<String>> dependents;
+	};
+}
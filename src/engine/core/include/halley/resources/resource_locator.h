@@ -49,7 +49,8 @@ namespace Halley {
 	public:
 		explicit ResourceLocator(SystemAPI& system);
 		void addFileSystem(const Path& path);
-		void addPack(const Path& path, const String& encryptionKey = "", bool preLoad = false, bool allowFailure = false, std::optional<int> priority = {});
+		// memoryMapped packs serve assets straight from a mapping of the file, if the platform supports it and the pack isn't encrypted or preloaded
+		void addPack(const Path& path, const String& encryptionKey = "", bool preLoad = false, bool allowFailure = false, std::optional<int> priority = {}, bool memoryMapped = false);
 		Vector<String> getAssetsFromPack(const Path& path, const String& encryptionKey = "") const;
 		void removePack(const Path& path);
 
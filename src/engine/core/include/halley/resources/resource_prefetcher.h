@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include "halley/data_structures/config_node.h"
+#include "halley/data_structures/hash_map.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley
+{
+	enum class AssetType;
+	class Resource;
+	class Resources;
+
+	// Which assets each stage requested, in the order and at the time (since the stage started) they were first requested
+	class ResourcePrefetchManifest
+	{
+	public:
+		struct Entry {
+			AssetType type;
+			String name;
+			float time;
+		};
+
+		ResourcePrefetchManifest() = default;
+		explicit ResourcePrefetchManifest(const ConfigNode& node);
+		ConfigNode toConfigNode() const;
+
+		void setStage(const String& stageId, Vector<Entry> entries);
+		// Adds entries to the ones the stage already has, keeping the earliest time for assets in both, and sorting them by time
+		void mergeStage(const String& stageId, Vector<Entry> entries);
+		const Vector<Entry>* tryGetStage(const String& stageId) const;
+		Vector<String> getStages() const;
+
+	private:
+		HashMap<String, Vector<Entry>> stages;
+	};
+
+	// Records which assets are requested from Resources on each stage, and plays those recordings back by loading them in the background when the stage starts.
+	// Each asset starts loading prefetchLead seconds before the time it was first requested at when recorded, with at most maxLoadsInFlight loading at once.
+	// Call setStage whenever the game moves to a new stage/scene, so requests are grouped by it. Revisiting a stage while recording adds to what it already had.
+	class ResourcePrefetcher
+	{
+	public:
+		enum class Mode {
+			Disabled,
+			Recording,
+			Playback
+		};
+
+		struct Stats {
+			size_t prefetched = 0; // Made ready by the prefetcher, including ones that were already loaded
+			size_t hits = 0; // Requested after being prefetched
+			size_t late = 0; // In the manifest, but requested before the prefetcher got to it
+			size_t unlisted = 0; // Not in the manifest
+		};
+
+		explicit ResourcePrefetcher(Resources& resources);
+		~ResourcePrefetcher();
+
+		void startRecording();
+		ResourcePrefetchManifest stopRecording();
+
+		void startPlayback(ResourcePrefetchManifest manifest);
+		void stopPlayback();
+
+		Mode getMode() const;
+		void setStage(const String& stageId);
+
+		// Covers every stage since playback started
+		Stats getStats() const;
+
+		void onRequested(AssetType type, std::string_view name);
+
+		constexpr static float prefetchLead = 2.0f;
+		constexpr static size_t maxLoadsInFlight = 4;
+
+	private:
+		struct PrefetchState {
+			std::mutex mutex;
+			std::condition_variable idle;
+			std::condition_variable cancel;
+			bool cancelled = false;
+			bool busy = false;
+			bool done = false;
+		};
+
+		Resources& resources;
+		std::atomic<Mode> mode = Mode::Disabled;
+
+		mutable std::mutex mutex;
+		String stageId;
+		std::chrono::steady_clock::time_point stageStart;
+
+		ResourcePrefetchManifest manifest;
+		Vector<ResourcePrefetchManifest::Entry> recordedEntries;
+		HashSet<String> requested;
+
+		HashSet<String> expected;
+		HashSet<String> prefetched;
+		Stats stats;
+		Vector<std::shared_ptr<PrefetchState>> prefetchStates; // Every prefetch that might still be running, including cancelled ones
+
+		void flushRecording();
+		void startPrefetch(const Vector<ResourcePrefetchManifest::Entry>& entries);
+		void stopPrefetch(bool wait);
+		std::shared_future<std::shared_ptr<Resource>> startLoad(const ResourcePrefetchManifest::Entry& entry);
+		void finishLoad(const ResourcePrefetchManifest::Entry& entry, const std::shared_future<std::shared_ptr<Resource>>& load);
+	};
+}
@@ -23,9 +23,14 @@
 
 #include <ctime>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <halley/support/exception.h>
 #include "halley/resources/resource.h"
 #include "resource_collection.h"
+#include "resource_dependency_graph.h"
+#include "resource_prefetcher.h"
 #include "halley/text/enum_names.h"
 
 namespace Halley {
@@ -92,6 +97,26 @@ namespace Halley {
 			of<T>().unload(res->getAssetId());
 		}
 
+		// Pinned assets are kept loaded even when over the memory budget
+		template <typename T>
+		void pin(std::string_view name)
+		{
+			of<T>().setPinned(name, true);
+		}
+
+		template <typename T>
+		void unpin(std::string_view name)
+		{
+			of<T>().setPinned(name, false);
+		}
+
+		// Asset types with lower priority are evicted first when over the memory budget
+		template <typename T>
+		void setEvictionPriority(int priority)
+		{
+			of<T>().setEvictionPriority(priority);
+		}
+
 		template <typename T>
 		void setFallback(std::string_view name)
 		{
@@ -115,17 +140,69 @@ namespace Halley {
 			return *locator;
 		}
 
+		ResourcePrefetcher& getPrefetcher()
+		{
+			return *prefetcher;
+		}
+
+		ResourceDependencyGraph& getDependencyGraph()
+		{
+			return dependencyGraph;
+		}
+
+		// Also reloads every loaded asset that depends on the ones listed, after their dependencies
 		void reloadAssets(const Vector<String>& assetIds, const Vector<String>& packIds); // assetIds are in "type:name" format
 		void reloadAssets(const std::map<AssetType, Vector<String>>& byType);
 
+		// Changes every time assets are reloaded, so anything built from them can tell when it might be stale
+		uint64_t getReloadGeneration() const
+		{
+			return reloadGeneration;
+		}
+
 		const ResourceOptions& getOptions() const { return options; }
 
 		void generateMemoryReport();
 
+		// Once loaded resources go over the budget, the least recently used ones that aren't pinned or referenced anywhere else are evicted.
+		// Zero means no limit. RAM and VRAM are budgeted separately.
+		void setMemoryBudget(ResourceMemoryUsage budget);
+		ResourceMemoryUsage getMemoryBudget() const;
+
+		// Kept up to date as resources are loaded and unloaded
+		ResourceMemoryUsage getMemoryUsage() const;
+
+		// Runs automatically after loads that go over budget, at most every minEvictionInterval
+		/// <returns>How much memory was freed</returns>
+		ResourceMemoryUsage enforceMemoryBudget();
+
 	private:
+		constexpr static std::chrono::milliseconds minEvictionInterval = std::chrono::milliseconds(250);
+
 		const std::unique_ptr<ResourceLocator> locator;
 		Vector<std::unique_ptr<ResourceCollectionBase>> resources;
 		const HalleyAPI* const api;
 		ResourceOptions options;
+		ResourceDependencyGraph dependencyGraph;
+
+		std::atomic<size_t> ramUsage = 0;
+		std::atomic<size_t> vramUsage = 0;
+		std::atomic<size_t> ramBudget = 0;
+		std::atomic<size_t> vramBudget = 0;
+		std::atomic<uint64_t> resourceAccessClock = 0;
+		std::atomic<uint64_t> reloadGeneration = 0;
+		std::mutex evictionMutex;
+		std::chrono::steady_clock::time_point lastEviction;
+
+		std::unique_ptr<ResourcePrefetcher> prefetcher; // Declared last, so it stops before the collections go away
+
+		void addMemoryUsage(const ResourceMemoryUsage& usage);
+		void removeMemoryUsage(const ResourceMemoryUsage& usage);
+		bool isOverBudget() const;
+		uint64_t nextResourceAccess();
+		void onResourceAdded();
+		ResourceMemoryUsage doEnforceMemoryBudget();
+		ResourceMemoryUsage evictUnusedResources();
+		static bool canReloadInParallel(AssetType type);
 	};
 }
@@ -0,0 +1,137 @@
+#include "halley/bytes/bit_serializer.h"
+
+#include <cmath>
+#include "halley/support/exception.h"
+#include "halley/utils/utils.h"
+using namespace Halley;
+
+uint64_t BitQuantization::quantize(double value) const
+{
+	const uint64_t maxValue = bits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << bits) - 1;
+
+	switch (type) {
+	case Type::Angle:
+		{
+			const double steps = static_cast<double>(uint64_t(1) << bits);
+			double deg = std::fmod(value, 360.0);
+			if (deg < 0) {
+				deg += 360.0;
+			}
+			return static_cast<uint64_t>(std::llround(deg / 360.0 * steps)) & maxValue;
+		}
+
+	case Type::Int:
+		return std::min(static_cast<uint64_t>(std::llround(clamp(value, min, max) - min)), maxValue);
+
+	default:
+		return std::min(static_cast<uint64_t>(std::llround((clamp(value, min, max) - min) / precision)), maxValue);
+	}
+}
+
+double BitQuantization::dequantize(uint64_t value) const
+{
+	switch (type) {
+	case Type::Angle:
+		return static_cast<double>(value) * precision;
+
+	case Type::Int:
+		return min + static_cast<double>(value);
+
+	default:
+		return std::min(min + static_cast<double>(value) * precision, max);
+	}
+}
+
+
+BitSerializer::BitSerializer(Bytes& dst)
+	: dst(dst)
+{
+	dst.clear();
+}
+
+void BitSerializer::writeBits(uint64_t value, int nBits)
+{
+	Expects(nBits >= 0 && nBits <= 64);
+
+	while (nBits > 0) {
+		const int bitInByte = static_cast<int>(bitPos & 7);
+		if (bitInByte == 0) {
+			dst.push_back(0);
+		}
+		const int n = std::min(nBits, 8 - bitInByte);
+		dst.back() |= static_cast<Byte>((value & ((1u << n) - 1)) << bitInByte);
+
+		value >>= n;
+		nBits -= n;
+		bitPos += n;
+	}
+}
+
+void BitSerializer::writeBool(bool value)
+{
+	writeBits(value ? 1 : 0, 1);
+}
+
+void BitSerializer::writeVarUInt(uint64_t value)
+{
+	// Groups of 7 bits, each followed by a continuation bit
+	do {
+		writeBits(value & 0x7F, 7);
+		value >>= 7;
+		writeBool(value != 0);
+	} while (value != 0);
+}
+
+void BitSerializer::writeQuantized(double value, const BitQuantization& quantization)
+{
+	writeBits(quantization.quantize(value), quantization.bits);
+}
+
+
+BitDeserializer::BitDeserializer(gsl::span<const gsl::byte> src)
+	: src(src)
+{
+}
+
+uint64_t BitDeserializer::readBits(int nBits)
+{
+	Expects(nBits >= 0 && nBits <= 64);
+	if (bitPos + nBits > src.size() * 8) {
+		throw Exception("Insufficient data to deserialize bits.", HalleyExceptions::Utils);
+	}
+
+	uint64_t result = 0;
+	int written = 0;
+	while (written < nBits) {
+		const int bitInByte = static_cast<int>(bitPos & 7);
+		const int n = std::min(nBits - written, 8 - bitInByte);
+		const auto byte = static_cast<uint64_t>(src[bitPos >> 3]);
+		result |= ((byte >> bitInByte) & ((1u << n) - 1)) << written;
+
+		written += n;
+		bitPos += n;
+	}
+	return result;
+}
+
+bool BitDeserializer::readBool()
+{
+	return readBits(1) != 0;
+}
+
+uint64_t BitDeserializer::readVarUInt()
+{
+	uint64_t result = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		result |= readBits(7) << shift;
+		if (!readBool()) {
+			return result;
+		}
+	}
+	throw Exception("Invalid variable length integer.", HalleyExceptions::Utils);
+}
+
+double BitDeserializer::readQuantized(const BitQuantization& quantization)
+{
+	return quantization.dequantize(readBits(quantization.bits));
+}
@@ -15,15 +15,32 @@ SerializerState* ByteSerializationBase::setState(SerializerState* s)
 
 Serializer::Serializer(SerializerOptions options)
 	: ByteSerializationBase(std::move(options))
-	, dryRun(true)
+	, mode(Mode::DryRun)
 {}
 
 Serializer::Serializer(gsl::span<gsl::byte> dst, SerializerOptions options)
 	: ByteSerializationBase(std::move(options))
 	, dst(dst)
-	, dryRun(false)
+	, mode(Mode::Span)
 {}
 
+Serializer::Serializer(Bytes& dst, SerializerOptions options)
+	: ByteSerializationBase(std::move(options))
+	, growableDst(&dst)
+	, mode(Mode::Growable)
+{
+	dst.clear();
+}
+
+Serializer::Serializer(Vector<Bytes>& dstChunks, size_t chunkSize, SerializerOptions options)
+	: ByteSerializationBase(std::move(options))
+	, chunkedDst(&dstChunks)
+	, chunkSize(chunkSize)
+	, mode(Mode::Chunked)
+{
+	Expects(chunkSize > 0);
+}
+
 Serializer& Serializer::operator<<(const std::string& str)
 {
 	return *this << String(str);
@@ -145,11 +162,40 @@ void Serializer::serializeVariableInteger(uint64_t val, std::optional<bool> sign
 
 void Serializer::copyBytes(const void* src, size_t srcSize)
 {
-	if (!dryRun) {
+	switch (mode) {
+	case Mode::DryRun:
+		break;
+
+	case Mode::Span:
 		if (dst.size() - size < srcSize) {
 			throw Exception("Insufficient bytes to serialize data.", HalleyExceptions::Utils);
 		}
 		memcpy(dst.data() + size, src, srcSize);
+		break;
+
+	case Mode::Growable:
+		// reserve() grows geometrically, so this is amortised constant
+		growableDst->reserve(size + srcSize);
+		growableDst->resize_no_init(size + srcSize);
+		memcpy(growableDst->data() + size, src, srcSize);
+		break;
+
+	case Mode::Chunked:
+		{
+			const auto* srcBytes = static_cast<const Byte*>(src);
+			size_t left = srcSize;
+			while (left > 0) {
+				if (chunkedDst->empty() || chunkedDst->back().size() == chunkSize) {
+					chunkedDst->emplace_back().reserve(chunkSize);
+				}
+				auto& chunk = chunkedDst->back();
+				const size_t n = std::min(left, chunkSize - chunk.size());
+				chunk.insert(chunk.end(), srcBytes, srcBytes + n);
+				srcBytes += n;
+				left -= n;
+			}
+		}
+		break;
 	}
 	size += srcSize;
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
 #include "halley/bytes/compression.h"
@@ -180,6 +181,54 @@ Bytes Compression::decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSiz
 	}
 }
 
+ZlibInflater::ZlibInflater()
+	: stream(std::make_unique<z_stream_s>())
+{
+	stream->zalloc = &zlibAlloc;
+	stream->zfree = &zlibFree;
+	stream->opaque = nullptr;
+	stream->avail_in = 0;
+	stream->next_in = nullptr;
+	if (inflateInit(stream.get()) != Z_OK) {
+		throw Exception("Unable to initialise zlib", HalleyExceptions::Compression);
+	}
+}
+
+ZlibInflater::~ZlibInflater()
+{
+	inflateEnd(stream.get());
+}
+
+void ZlibInflater::decompressRaw(gsl::span<const gsl::byte> bytes, size_t maxSize, Bytes& dst)
+{
+	constexpr size_t minBlockSize = 4 * 1024;
+
+	inflateReset(stream.get());
+	stream->avail_in = uInt(bytes.size_bytes());
+	stream->next_in = reinterpret_cast<unsigned char*>(const_cast<gsl::byte*>(bytes.data()));
+
+	dst.resize_no_init(std::min(std::max({ dst.capacity(), alignUp(bytes.size_bytes() * 2, minBlockSize), minBlockSize }), maxSize));
+
+	int res = 0;
+	do {
+		// Expand if needed
+		if (dst.size() == size_t(stream->total_out)) {
+			if (dst.size() >= maxSize) {
+				throw Exception("Unable to inflate stream, maximum size has been exceeded.", HalleyExceptions::Compression);
+			}
+			dst.resize_no_init(std::min(std::max(dst.size() * 2, minBlockSize), maxSize));
+		}
+		stream->avail_out = uInt(dst.size() - size_t(stream->total_out));
+		stream->next_out = dst.data() + size_t(stream->total_out);
+		res = inflate(stream.get(), Z_NO_FLUSH);
+	} while (res == Z_OK);
+
+	if (res != Z_STREAM_END) {
+		throw Exception("Unable to inflate stream.", HalleyExceptions::Compression);
+	}
+	dst.resize(size_t(stream->total_out));
+}
+
 Bytes Compression::lz4Compress(gsl::span<const gsl::byte> src, LZ4Options options)
 {
 	const auto size = LZ4_compressBound(static_cast<int>(src.size()));
@@ -270,6 +319,117 @@ std::shared_ptr<const char> Compression::lz4DecompressFileToSharedPtr(gsl::span<
 	return output;
 }
 
+namespace {
+	constexpr const char* lz4ChunkedIdentifier = "LZ4CHUNK";
+}
+
+Bytes Compression::lz4CompressChunked(gsl::span<const gsl::byte> src, size_t chunkSize, LZ4Options options)
+{
+	Expects(chunkSize > 0);
+
+	LZ4ChunkedHeader header;
+	memcpy(header.id.data(), lz4ChunkedIdentifier, header.id.size());
+	header.chunkSize = static_cast<uint32_t>(chunkSize);
+	header.numChunks = static_cast<uint32_t>((src.size() + chunkSize - 1) / chunkSize);
+	header.size = src.size();
+
+	const size_t tableSize = lz4GetChunkedTableSize(header);
+	Vector<uint64_t> offsets;
+	offsets.reserve(header.numChunks + 1);
+
+	Bytes result;
+	result.resize_no_init(tableSize + LZ4_compressBound(static_cast<int>(chunkSize)));
+	size_t pos = tableSize;
+
+	for (size_t i = 0; i < header.numChunks; ++i) {
+		const auto chunk = src.subspan(i * chunkSize, std::min(chunkSize, src.size() - i * chunkSize));
+		const size_t bound = LZ4_compressBound(static_cast<int>(chunk.size()));
+		if (result.size() < pos + bound) {
+			result.resize(std::max(pos + bound, result.size() * 2));
+		}
+
+		offsets.push_back(pos);
+		const auto outSize = lz4Compress(chunk, result.byte_span().subspan(pos, bound), options);
+		if (outSize > 0 && outSize < chunk.size()) {
+			pos += outSize;
+		} else {
+			memcpy(result.data() + pos, chunk.data(), chunk.size());
+			pos += chunk.size();
+		}
+	}
+	offsets.push_back(pos);
+	result.resize(pos);
+
+	memcpy(result.data(), &header, sizeof(header));
+	memcpy(result.data() + sizeof(header), offsets.data(), offsets.size() * sizeof(uint64_t));
+	return result;
+}
+
+std::shared_ptr<const char> Compression::lz4DecompressChunkedToSharedPtr(gsl::span<const gsl::byte> src, size_t& outSize)
+{
+	const auto header = lz4ReadChunkedHeader(src);
+	const size_t tableSize = lz4GetChunkedTableSize(header);
+	if (src.size() < tableSize) {
+		throw Exception("Chunked LZ4 file is truncated", HalleyExceptions::Utils);
+	}
+
+	Vector<uint64_t> offsets(header.numChunks + 1);
+	memcpy(offsets.data(), src.data() + sizeof(header), offsets.size() * sizeof(uint64_t));
+
+	auto output = std::shared_ptr<char>(new char[header.size], deleter);
+	const auto dst = gsl::as_writable_bytes(gsl::span<char>(output.get(), header.size));
+	for (size_t i = 0; i < header.numChunks; ++i) {
+		if (offsets[i] > offsets[i + 1] || offsets[i + 1] > src.size()) {
+			throw Exception("Chunked LZ4 file has an invalid chunk table", HalleyExceptions::Utils);
+		}
+		const size_t start = i * header.chunkSize;
+		lz4DecompressChunk(header, i, src.subspan(offsets[i], offsets[i + 1] - offsets[i]), dst.subspan(start, std::min(size_t(header.chunkSize), header.size - start)));
+	}
+
+	outSize = header.size;
+	return output;
+}
+
+Compression::LZ4ChunkedHeader Compression::lz4ReadChunkedHeader(gsl::span<const gsl::byte> src)
+{
+	LZ4ChunkedHeader header;
+	if (src.size() < sizeof(header)) {
+		throw Exception("File too small to be chunked LZ4 file", HalleyExceptions::Utils);
+	}
+	memcpy(&header, src.data(), sizeof(header));
+
+	if (memcmp(header.id.data(), lz4ChunkedIdentifier, header.id.size()) != 0) {
+		throw Exception("Not chunked LZ4 header file", HalleyExceptions::Utils);
+	}
+	if (header.chunkSize == 0 || header.numChunks != (header.size + header.chunkSize - 1) / header.chunkSize) {
+		throw Exception("Chunked LZ4 file has an invalid header", HalleyExceptions::Utils);
+	}
+	return header;
+}
+
+size_t Compression::lz4GetChunkedTableSize(const LZ4ChunkedHeader& header)
+{
+	return sizeof(LZ4ChunkedHeader) + (size_t(header.numChunks) + 1) * sizeof(uint64_t);
+}
+
+void Compression::lz4DecompressChunk(const LZ4ChunkedHeader& header, size_t chunkIdx, gsl::span<const gsl::byte> src, gsl::span<gsl::byte> dst)
+{
+	const size_t expectedSize = std::min(size_t(header.chunkSize), size_t(header.size - chunkIdx * header.chunkSize));
+	if (dst.size() < expectedSize) {
+		throw Exception("Buffer too small for chunked LZ4 chunk", HalleyExceptions::Utils);
+	}
+
+	if (src.size() == expectedSize) {
+		// Stored uncompressed
+		memcpy(dst.data(), src.data(), expectedSize);
+	} else {
+		const auto sz = lz4Decompress(src, dst.subspan(0, expectedSize));
+		if (sz != expectedSize) {
+			throw Exception("Failed to decompress chunked LZ4 chunk " + toString(chunkIdx), HalleyExceptions::Utils);
+		}
+	}
+}
+
 size_t Compression::lz4Compress(gsl::span<const gsl::byte> src, gsl::span<gsl::byte> dst, LZ4Options options)
 {
 	if (options.mode == LZ4Mode::Normal) {
@@ -0,0 +1,218 @@
+#include "halley/bytes/lz4_stream.h"
+
+#include <cstring>
+#include "halley/support/exception.h"
+#include "lz4/lz4.h"
+using namespace Halley;
+
+namespace {
+	// LZ4 can't reference anything further back than 64 KB
+	constexpr size_t historySize = 64 * 1024;
+	constexpr size_t windowSize = 4 * historySize;
+
+	// Moves the last historySize bytes to the start of the window, returns the new amount in use
+	size_t slideWindow(Bytes& window, size_t windowUsed)
+	{
+		const size_t keep = std::min(windowUsed, historySize);
+		memmove(window.data(), window.data() + windowUsed - keep, keep);
+		return keep;
+	}
+
+	size_t loadDictionary(Bytes& window, const std::shared_ptr<const Bytes>& dictionary)
+	{
+		if (!dictionary) {
+			return 0;
+		}
+		const size_t size = std::min(dictionary->size(), historySize);
+		memcpy(window.data(), dictionary->data() + dictionary->size() - size, size);
+		return size;
+	}
+
+	gsl::span<const gsl::byte> getDictionaryHistory(const std::shared_ptr<const Bytes>& dictionary)
+	{
+		if (!dictionary) {
+			return {};
+		}
+		const size_t size = std::min(dictionary->size(), historySize);
+		return gsl::as_bytes(gsl::span<const Byte>(*dictionary)).subspan(dictionary->size() - size, size);
+	}
+
+	void checkBlockSize(size_t size)
+	{
+		if (size > LZ4StreamCompressor::getMaxBlockSize()) {
+			throw Exception("Block is too large for LZ4 stream.", HalleyExceptions::Utils);
+		}
+	}
+}
+
+LZ4StreamCompressor::LZ4StreamCompressor(std::shared_ptr<const Bytes> dictionary)
+	: dictionary(std::move(dictionary))
+	, stream(LZ4_createStream())
+{
+	window.resize_no_init(windowSize);
+	reset();
+}
+
+LZ4StreamCompressor::~LZ4StreamCompressor()
+{
+	if (stream) {
+		LZ4_freeStream(stream);
+	}
+	if (dictionaryStream) {
+		LZ4_freeStream(dictionaryStream);
+	}
+}
+
+LZ4StreamCompressor::LZ4StreamCompressor(LZ4StreamCompressor&& other) noexcept
+	: dictionary(std::move(other.dictionary))
+	, stream(other.stream)
+	, dictionaryStream(other.dictionaryStream)
+	, window(std::move(other.window))
+	, windowUsed(other.windowUsed)
+	, atStart(other.atStart)
+{
+	// The streams point into the window's and the dictionary's heap buffers, which are unchanged by the move
+	other.stream = nullptr;
+	other.dictionaryStream = nullptr;
+	other.windowUsed = 0;
+}
+
+LZ4StreamCompressor& LZ4StreamCompressor::operator=(LZ4StreamCompressor&& other) noexcept
+{
+	if (this != &other) {
+		if (stream) {
+			LZ4_freeStream(stream);
+		}
+		if (dictionaryStream) {
+			LZ4_freeStream(dictionaryStream);
+		}
+		dictionary = std::move(other.dictionary);
+		stream = other.stream;
+		dictionaryStream = other.dictionaryStream;
+		window = std::move(other.window);
+		windowUsed = other.windowUsed;
+		atStart = other.atStart;
+		other.stream = nullptr;
+		other.dictionaryStream = nullptr;
+		other.windowUsed = 0;
+	}
+	return *this;
+}
+
+void LZ4StreamCompressor::reset()
+{
+	windowUsed = loadDictionary(window, dictionary);
+	LZ4_loadDict(stream, reinterpret_cast<const char*>(window.data()), static_cast<int>(windowUsed));
+	atStart = true;
+}
+
+bool LZ4StreamCompressor::isAtStart() const
+{
+	return atStart;
+}
+
+size_t LZ4StreamCompressor::getMaxBlockSize()
+{
+	return windowSize - historySize;
+}
+
+size_t LZ4StreamCompressor::compress(gsl::span<const gsl::byte> src, Bytes& dst, int acceleration)
+{
+	Expects(stream);
+	const size_t size = src.size_bytes();
+	checkBlockSize(size);
+
+	if (windowUsed + size > windowSize) {
+		windowUsed = slideWindow(window, windowUsed);
+		LZ4_loadDict(stream, reinterpret_cast<const char*>(window.data()), static_cast<int>(windowUsed));
+	}
+
+	// Compressing from the window keeps the block contiguous with the history before it
+	auto* block = window.data() + windowUsed;
+	memcpy(block, src.data(), size);
+
+	const size_t dstStart = dst.size();
+	const int bound = LZ4_compressBound(static_cast<int>(size));
+	dst.resize_no_init(dstStart + bound);
+	const int result = LZ4_compress_fast_continue(stream, reinterpret_cast<const char*>(block), reinterpret_cast<char*>(dst.data() + dstStart), static_cast<int>(size), bound, acceleration);
+	if (result <= 0 && size > 0) {
+		throw Exception("Failed to compress LZ4 stream block.", HalleyExceptions::Utils);
+	}
+	dst.resize(dstStart + result);
+	windowUsed += size;
+	atStart = false;
+
+	return static_cast<size_t>(result);
+}
+
+size_t LZ4StreamCompressor::compressIndependent(gsl::span<const gsl::byte> src, Bytes& dst, int acceleration)
+{
+	const size_t size = src.size_bytes();
+	checkBlockSize(size);
+
+	// Hashing the dictionary is the expensive part, so do it once and start every block from a copy of that state
+	if (!dictionaryStream) {
+		dictionaryStream = LZ4_createStream();
+		const auto history = getDictionaryHistory(dictionary);
+		LZ4_loadDict(dictionaryStream, reinterpret_cast<const char*>(history.data()), static_cast<int>(history.size_bytes()));
+	}
+	LZ4_stream_t blockStream;
+	memcpy(&blockStream, dictionaryStream, sizeof(blockStream));
+
+	const size_t dstStart = dst.size();
+	const int bound = LZ4_compressBound(static_cast<int>(size));
+	dst.resize_no_init(dstStart + bound);
+	const int result = LZ4_compress_fast_continue(&blockStream, reinterpret_cast<const char*>(src.data()), reinterpret_cast<char*>(dst.data() + dstStart), static_cast<int>(size), bound, acceleration);
+	if (result <= 0 && size > 0) {
+		throw Exception("Failed to compress LZ4 block.", HalleyExceptions::Utils);
+	}
+	dst.resize(dstStart + result);
+
+	return static_cast<size_t>(result);
+}
+
+
+LZ4StreamDecompressor::LZ4StreamDecompressor(std::shared_ptr<const Bytes> dictionary)
+	: dictionary(std::move(dictionary))
+{
+	window.resize_no_init(windowSize);
+	reset();
+}
+
+void LZ4StreamDecompressor::reset()
+{
+	windowUsed = loadDictionary(window, dictionary);
+}
+
+void LZ4StreamDecompressor::decompress(gsl::span<const gsl::byte> src, size_t originalSize, Bytes& dst)
+{
+	checkBlockSize(originalSize);
+
+	// Mirrors the compressor, so the history it referenced is still in the window
+	if (windowUsed + originalSize > windowSize) {
+		windowUsed = slideWindow(window, windowUsed);
+	}
+
+	auto* block = reinterpret_cast<char*>(window.data() + windowUsed);
+	const int result = LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(src.data()), block, static_cast<int>(src.size_bytes()), static_cast<int>(originalSize), reinterpret_cast<const char*>(window.data()), static_cast<int>(windowUsed));
+	if (result < 0 || static_cast<size_t>(result) != originalSize) {
+		throw Exception("Failed to decompress LZ4 stream block.", HalleyExceptions::Utils);
+	}
+
+	dst.insert(dst.end(), window.begin() + windowUsed, window.begin() + windowUsed + originalSize);
+	windowUsed += originalSize;
+}
+
+void LZ4StreamDecompressor::decompressIndependent(gsl::span<const gsl::byte> src, size_t originalSize, Bytes& dst) const
+{
+	checkBlockSize(originalSize);
+
+	const auto history = getDictionaryHistory(dictionary);
+	const size_t dstStart = dst.size();
+	dst.resize_no_init(dstStart + originalSize);
+	const int result = LZ4_decompress_safe_usingDict(reinterpret_cast<const char*>(src.data()), reinterpret_cast<char*>(dst.data() + dstStart), static_cast<int>(src.size_bytes()), static_cast<int>(originalSize), reinterpret_cast<const char*>(history.data()), static_cast<int>(history.size_bytes()));
+	if (result < 0 || static_cast<size_t>(result) != originalSize) {
+		dst.resize(dstStart);
+		throw Exception("Failed to decompress LZ4 block.", HalleyExceptions::Utils);
+	}
+}
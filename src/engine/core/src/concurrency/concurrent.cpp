@@ -22,6 +22,9 @@
 #include "halley/concurrency/concurrent.h"
 #include <thread>
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 using namespace Halley;
 
@@ -30,3 +33,61 @@ using namespace Halley;
 static thread_local String threadName;
 #endif
 
+namespace {
+	struct ParallelForState {
+		ParallelForState(size_t n, const std::function<void(size_t)>& f)
+			: n(n)
+			, f(f)
+		{}
+
+		const size_t n;
+		const std::function<void(size_t)>& f;
+		std::atomic<size_t> next = 0;
+
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t completed = 0;
+		std::exception_ptr exception;
+
+		void run()
+		{
+			// f is only touched after claiming an index, which can't happen once the caller has returned
+			for (size_t i = next++; i < n; i = next++) {
+				try {
+					f(i);
+				} catch (...) {
+					std::unique_lock lock(mutex);
+					if (!exception) {
+						exception = std::current_exception();
+					}
+				}
+
+				std::unique_lock lock(mutex);
+				if (++completed == n) {
+					done.notify_all();
+				}
+			}
+		}
+	};
+}
+
+void Concurrent::parallelFor(ExecutionQueue& e, size_t n, const std::function<void(size_t)>& f)
+{
+	if (n == 0) {
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>(n, f);
+	const size_t nHelpers = std::min(n - 1, e.threadCount());
+	for (size_t i = 0; i < nHelpers; ++i) {
+		execute(e, [state] () { state->run(); });
+	}
+
+	state->run();
+
+	std::unique_lock lock(state->mutex);
+	state->done.wait(lock, [&] () { return state->completed == n; });
+	if (state->exception) {
+		std::rethrow_exception(state->exception);
+	}
+}
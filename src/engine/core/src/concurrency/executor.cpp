@@ -17,43 +17,63 @@ ExecutionQueue::ExecutionQueue()
 TaskBase ExecutionQueue::getNext()
 {
 	std::unique_lock<std::mutex> lock(mutex);
-	while (queue.empty()) {
+	while (isEmpty()) {
 		if (!aborted) {
 			condition.wait(lock);
 		}
 		if (aborted) {
-			queue.clear();
+			for (auto& queue: queues) {
+				queue.clear();
+			}
 			return TaskBase([] () {});
 		}
 	}
 
-	TaskBase value = queue.front();
-	queue.pop_front();
-	return value;
+	for (auto iter = queues.rbegin(); iter != queues.rend(); ++iter) {
+		if (!iter->empty()) {
+			TaskBase value = std::move(iter->front());
+			iter->pop_front();
+			return value;
+		}
+	}
+	return TaskBase([] () {});
 }
 
 Vector<TaskBase> ExecutionQueue::getAll()
 {
 	std::unique_lock<std::mutex> lock(mutex);
 	hasTasks.store(false);
-	Vector<TaskBase> tasks(queue.begin(), queue.end());
-	queue.clear();
+	Vector<TaskBase> tasks;
+	for (auto iter = queues.rbegin(); iter != queues.rend(); ++iter) {
+		tasks.insert(tasks.end(), std::make_move_iterator(iter->begin()), std::make_move_iterator(iter->end()));
+		iter->clear();
+	}
 	return tasks;
 }
 
-void ExecutionQueue::addToQueue(TaskBase task)
+void ExecutionQueue::addToQueue(TaskBase task, ExecutionPriority priority)
 {
 	if (immediate) {
 		task();
 	} else {
 		std::unique_lock<std::mutex> lock(mutex);
-		queue.emplace_back(task);
+		queues[static_cast<size_t>(priority)].emplace_back(std::move(task));
 		hasTasks.store(true);
 
 		condition.notify_one();
 	}
 }
 
+bool ExecutionQueue::isEmpty() const
+{
+	for (const auto& queue: queues) {
+		if (!queue.empty()) {
+			return false;
+		}
+	}
+	return true;
+}
+
 Executors::Executors()
 {
 	immediate.setImmediate(true);
@@ -72,6 +92,11 @@ void Executors::setInstance(Executors& e)
 	instance = &e;
 }
 
+bool Executors::hasInstance()
+{
+	return instance != nullptr;
+}
+
 size_t ExecutionQueue::threadCount() const
 {
 	return attachedCount.load();
@@ -1,3 +1,4 @@
+#include <atomic>
 #include "halley/support/logger.h"
 #include "halley/entity/components/transform_2d_component.h"
 
@@ -8,16 +9,29 @@
 
 using namespace Halley;
 
-Transform2DComponent::Transform2DComponent() = default;
+namespace {
+	std::atomic<uint64_t> nextWriteVersion{ 0 };
 
+	uint64_t makeWriteVersion()
+	{
+		return nextWriteVersion.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+Transform2DComponent::Transform2DComponent()
+	: writeVersion(makeWriteVersion())
+{
+}
 
 Transform2DComponent::Transform2DComponent(Vector2f localPosition, Angle1f localRotation, Vector2f localScale, int subWorld, float height)
 	: Transform2DComponentBase(localPosition, localScale, localRotation, height, subWorld)
+	, writeVersion(makeWriteVersion())
 {
 }
 
 Transform2DComponent::Transform2DComponent(WorldPosition localPosition, Angle1f localRotation, Vector2f localScale, float height)
 	: Transform2DComponentBase(localPosition.pos, localScale, localRotation, height, localPosition.subWorld)
+	, writeVersion(makeWriteVersion())
 {
 }
 
@@ -251,6 +265,7 @@ void Transform2DComponent::deserialize(const EntitySerializationContext& context
 
 void Transform2DComponent::markDirty()
 {
+	writeVersion = makeWriteVersion();
 	markDirty(DirtyPropagationMode::Changed);
 }
 
@@ -114,6 +114,12 @@ IDataInterpolator* DataInterpolatorSetRetriever::tryGetInterpolator(EntityId ent
 	}
 }
 
+IDataInterpolator* DataInterpolatorSetRetriever::tryGetInterpolator(const UUID& instanceUUID, std::string_view componentName, std::string_view fieldName) const
+{
+	const auto iter = uuids.find(instanceUUID);
+	return tryGetInterpolator(iter != uuids.end() ? iter->second : EntityId(), componentName, fieldName);
+}
+
 ConfigNode DataInterpolatorSetRetriever::createComponentDelta(const UUID& instanceUUID, const String& componentName, const ConfigNode& from, const ConfigNode& origTo) const
 {
 	const auto iter = uuids.find(instanceUUID);
@@ -2,11 +2,44 @@
 #include "halley/entity/entity_data_delta.h"
 
 #include "halley/bytes/byte_serializer.h"
+#include "halley/bytes/iserialization_dictionary.h"
 #include "halley/file_formats/yaml_convert.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
 using namespace Halley;
 
+namespace {
+	constexpr uint32_t entityTableVersion = 1;
+
+	// Indices are handed out as strings are first serialized
+	class EntityTableStrings final : public ISerializationDictionary {
+	public:
+		Vector<String> strings;
+
+		std::optional<size_t> stringToIndex(const String& string) override
+		{
+			const auto iter = indices.find(string);
+			if (iter != indices.end()) {
+				return iter->second;
+			}
+			const size_t idx = strings.size();
+			strings.push_back(string);
+			indices[string] = idx;
+			return idx;
+		}
+
+		const String& indexToString(size_t index) override
+		{
+			return strings.at(index);
+		}
+
+		void notifyMissingString(const String& string) override {}
+
+	private:
+		HashMap<String, size_t> indices;
+	};
+}
+
 EntityChangeOperation EntityChangeOperation::clone() const
 {
 	EntityChangeOperation result;
@@ -173,6 +206,100 @@ void EntityData::deserialize(Deserializer& s)
 	applyDelta(delta);
 }
 
+void EntityData::serializeTable(Serializer& s) const
+{
+	EntityTableStrings strings;
+	SerializerOptions options(SerializerOptions::maxVersion);
+	options.dictionary = &strings;
+	options.exhaustiveDictionary = true;
+
+	Bytes entities;
+	{
+		Serializer entitySerializer(entities, options);
+		writeTableEntry(entitySerializer);
+	}
+
+	s << entityTableVersion;
+	s << strings.strings;
+	s << entities;
+}
+
+void EntityData::deserializeTable(Deserializer& s)
+{
+	uint32_t version;
+	s >> version;
+	if (version != entityTableVersion) {
+		throw Exception("Unsupported entity table version: " + toString(version), HalleyExceptions::Entity);
+	}
+
+	EntityTableStrings strings;
+	s >> strings.strings;
+	Bytes entities;
+	s >> entities;
+
+	SerializerOptions options(SerializerOptions::maxVersion);
+	options.dictionary = &strings;
+	options.exhaustiveDictionary = true;
+	Deserializer entityDeserializer(entities, options);
+	readTableEntry(entityDeserializer);
+}
+
+void EntityData::writeTableEntry(Serializer& s) const
+{
+	s << name;
+	s << prefab;
+	s << icon;
+	s << flags;
+	s << instanceUUID;
+	s << prefabUUID;
+	s << parentUUID;
+
+	s << static_cast<uint32_t>(components.size());
+	for (const auto& [componentName, componentData]: components) {
+		s << componentName;
+		s << componentData;
+	}
+
+	s << static_cast<uint32_t>(children.size());
+	for (const auto& child: children) {
+		child.writeTableEntry(s);
+	}
+}
+
+void EntityData::readTableEntry(Deserializer& s)
+{
+	s >> name;
+	s >> prefab;
+	s >> icon;
+	s >> flags;
+	s >> instanceUUID;
+	s >> prefabUUID;
+	s >> parentUUID;
+
+	uint32_t nComponents;
+	s >> nComponents;
+	if (nComponents > s.getBytesLeft()) {
+		throw Exception("Invalid component count in entity table", HalleyExceptions::Entity);
+	}
+	components.clear();
+	components.resize(nComponents);
+	for (auto& [componentName, componentData]: components) {
+		s >> componentName;
+		s >> componentData;
+	}
+
+	uint32_t nChildren;
+	s >> nChildren;
+	if (nChildren > s.getBytesLeft()) {
+		throw Exception("Invalid child count in entity table", HalleyExceptions::Entity);
+	}
+	children.clear();
+	children.resize(nChildren);
+	for (auto& child: children) {
+		child.readTableEntry(s);
+	}
+}
+
 bool EntityData::getFlag(Flag flag) const
 {
 	return (flags & static_cast<uint8_t>(flag)) != 0;
@@ -15,6 +15,32 @@
 
 using namespace Halley;
 
+namespace {
+	// Stands in for the real context while deserializing prototypes, to find out which components depend on the entities they end up in
+	class PrototypeContext final : public IEntityFactoryContext {
+	public:
+		mutable bool instanceDependent = false;
+
+		EntityId getEntityIdFromUUID(const UUID& uuid) const override
+		{
+			instanceDependent = true;
+			return EntityId();
+		}
+
+		UUID getUUIDFromEntityId(EntityId id) const override
+		{
+			instanceDependent = true;
+			return UUID();
+		}
+
+		EntityId getCurrentEntityId() const override
+		{
+			instanceDependent = true;
+			return EntityId();
+		}
+	};
+}
+
 EntityFactory::EntityFactory(World& world, Resources& resources)
 	: world(world)
 	, resources(resources)
@@ -92,6 +118,49 @@ EntityData EntityFactory::doSerializeEntity(EntityRef entity, const Serializatio
 	return result;
 }
 
+void EntityFactory::serializeEntityState(EntityRef entity, const SerializationOptions& options, Serializer& s, bool canStoreParent)
+{
+	const auto serializeContext = std::make_shared<EntityFactoryContext>(world, resources, EntitySerialization::makeMask(options.type), false);
+	doSerializeEntityState(entity, options, *serializeContext, s, canStoreParent);
+}
+
+void EntityFactory::doSerializeEntityState(EntityRef entity, const SerializationOptions& options, const EntityFactoryContext& context, Serializer& s, bool canStoreParent)
+{
+	// Properties
+	s << entity.getName();
+	s << entity.isSelectable();
+	s << entity.isSerializable();
+	s << entity.isEnabled();
+	s << entity.getInstanceUUID();
+	s << entity.getPrefabUUID();
+	s << entity.getPrefabAssetId().value_or("");
+
+	// Components
+	for (auto [componentId, component]: entity) {
+		const auto& reflector = world.getReflection().getComponentReflector(componentId);
+		s << componentId;
+		reflector.serializeNetworkState(context.getEntitySerializationContext(), *component, s);
+	}
+	s << -1;
+
+	// Children
+	for (const auto& child: entity.getChildren()) {
+		if (child.isSerializable()) {
+			if (options.serializeAsStub && options.serializeAsStub(child)) {
+				s << true;
+				s << child.getInstanceUUID();
+			} else {
+				s << false;
+				doSerializeEntityState(child, options, context, s, false);
+			}
+		}
+	}
+
+	// Parent
+	const auto parent = canStoreParent ? entity.tryGetParent() : std::optional<EntityRef>();
+	s << (parent ? parent->getInstanceUUID() : UUID());
+}
+
 EntityDataDelta EntityFactory::serializeEntityAsDelta(EntityRef entity, const SerializationOptions& options, const EntityDataDelta::Options& deltaOptions, bool canStoreParent)
 {
 	auto entityData = serializeEntity(entity, options, canStoreParent);
@@ -290,12 +359,188 @@ void EntityFactoryContext::notifyEntity(const EntityRef& entity) const
 
 EntityRef EntityFactory::createEntity(const String& prefabName, EntityRef parent, EntityScene* scene)
 {
+	if (!prefabName.isEmpty() && resources.exists<Prefab>(prefabName)) {
+		const auto prefab = resources.get<Prefab>(prefabName);
+		if (const auto prefabTemplate = getPrefabTemplate(*prefab); prefabTemplate->instantiable) {
+			return instantiatePrefabTemplate(*prefabTemplate, prefab, parent, scene);
+		}
+	}
+
 	EntityData data(UUID::generate());
 	data.setPrefab(prefabName);
 	const int mask = makeMask(EntitySerialization::Type::Prefab);
 	return createEntity(data, mask, parent, scene);
 }
 
+Vector<EntityRef> EntityFactory::createEntities(const String& prefabName, size_t count, const std::function<void(EntityRef, size_t)>& initFn, EntityRef parent, EntityScene* scene)
+{
+	Vector<EntityRef> result;
+	result.reserve(count);
+
+	std::shared_ptr<const Prefab> prefab;
+	std::shared_ptr<const PrefabTemplate> prefabTemplate;
+	if (!prefabName.isEmpty() && resources.exists<Prefab>(prefabName)) {
+		prefab = resources.get<Prefab>(prefabName);
+		prefabTemplate = getPrefabTemplate(*prefab);
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		auto entity = prefabTemplate && prefabTemplate->instantiable ? instantiatePrefabTemplate(*prefabTemplate, prefab, parent, scene) : createEntity(prefabName, parent, scene);
+		if (initFn) {
+			initFn(entity, i);
+		}
+		result.push_back(entity);
+	}
+
+	return result;
+}
+
+std::shared_ptr<const PrefabTemplate> EntityFactory::getPrefabTemplate(const Prefab& prefab)
+{
+	auto result = prefab.getCompiledTemplate();
+	if (!result || result->reflection != &world.getReflection() || result->resourcesGeneration != resources.getReloadGeneration()) {
+		result = compilePrefabTemplate(prefab);
+		prefab.setCompiledTemplate(result);
+	}
+	return result;
+}
+
+std::shared_ptr<const PrefabTemplate> EntityFactory::compilePrefabTemplate(const Prefab& prefab)
+{
+	auto result = std::make_shared<PrefabTemplate>();
+	result->reflection = &world.getReflection();
+	result->resourcesGeneration = resources.getReloadGeneration();
+
+	PrototypeContext prototypeContext;
+	EntitySerializationContext context;
+	context.resources = &resources;
+	context.entityContext = &prototypeContext;
+	context.entitySerializationTypeMask = makeMask(EntitySerialization::Type::Prefab);
+
+	// Depth first, same order the regular path creates components in
+	Vector<std::pair<const EntityData*, int>> toVisit;
+	toVisit.emplace_back(&prefab.getEntityData(), -1);
+	while (!toVisit.empty()) {
+		const auto [data, parentIdx] = toVisit.back();
+		toVisit.pop_back();
+
+		if (!data->getPrefab().isEmpty() || !data->getPrefabUUID().isValid()) {
+			// Nested prefabs and abandoned prefab entities get their own context in the regular path
+			result->instantiable = false;
+			result->nodes.clear();
+			return result;
+		}
+
+		auto& node = result->nodes.emplace_back();
+		node.name = data->getName();
+		node.prefabUUID = data->getPrefabUUID();
+		node.flags = data->getFlags();
+		node.parentIdx = parentIdx;
+
+		for (const auto& [componentName, componentData]: data->getComponents()) {
+			auto& component = node.components.emplace_back();
+			component.name = componentName;
+
+			if (const auto id = result->reflection->tryGetComponentId(componentName)) {
+				component.componentId = *id;
+				try {
+					prototypeContext.instanceDependent = false;
+					auto prototype = result->reflection->getComponentReflector(*id).createPrototype(context, componentData);
+					if (!prototypeContext.instanceDependent) {
+						component.prototype = std::move(prototype);
+					}
+				} catch (...) {
+					// Left to the regular path, which will report it
+				}
+			}
+
+			if (!component.prototype) {
+				component.data = componentData;
+				result->needsContext = true;
+			}
+		}
+
+		const auto idx = static_cast<int>(result->nodes.size()) - 1;
+		const auto& children = data->getChildren();
+		for (auto iter = children.rbegin(); iter != children.rend(); ++iter) {
+			toVisit.emplace_back(&*iter, idx);
+		}
+	}
+
+	return result;
+}
+
+EntityRef EntityFactory::instantiatePrefabTemplate(const PrefabTemplate& prefabTemplate, const std::shared_ptr<const Prefab>& prefab, EntityRef parent, EntityScene* scene)
+{
+	const auto& nodes = prefabTemplate.nodes;
+	const auto rootUUID = UUID::generate();
+	const uint8_t worldPartition = scene ? scene->getWorldPartition() : 0;
+
+	Vector<EntityRef> entities;
+	entities.reserve(nodes.size());
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const auto& node = nodes[i];
+		const auto uuid = i == 0 ? rootUUID : UUID::generateFromUUIDs(node.prefabUUID, rootUUID);
+		auto entity = world.createEntity(uuid, node.name, std::optional<EntityRef>(), worldPartition);
+		if (networkFactory) {
+			entity.setFromNetwork(true);
+		}
+		entity.setPrefab(prefab, node.prefabUUID);
+		entities.push_back(entity);
+	}
+	if (scene) {
+		scene->addPrefabReference(prefab, entities[0]);
+	}
+
+	// Components without a prototype are deserialized as usual, which needs a context that knows about all the entities
+	EntityData rootData(rootUUID);
+	std::shared_ptr<EntityFactoryContext> context;
+	if (prefabTemplate.needsContext) {
+		rootData.setPrefab(prefab->getAssetId());
+		context = std::make_shared<EntityFactoryContext>(world, resources, makeMask(EntitySerialization::Type::Prefab), false, prefab, &rootData, scene);
+		for (const auto& entity: entities) {
+			context->addEntity(entity);
+		}
+	}
+
+	const auto& reflection = world.getReflection();
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const auto& node = nodes[i];
+		auto& entity = entities[i];
+
+		entity.setParent(node.parentIdx >= 0 ? entities[node.parentIdx] : parent);
+		entity.setSelectable((node.flags & static_cast<uint8_t>(EntityData::Flag::NotSelectable)) == 0);
+		entity.setSerializable((node.flags & static_cast<uint8_t>(EntityData::Flag::NotSerializable)) == 0);
+		entity.setEnabled((node.flags & static_cast<uint8_t>(EntityData::Flag::Disabled)) == 0);
+
+		if (context) {
+			context->setCurrentEntity(entity.getEntityId());
+		}
+
+		for (const auto& component: node.components) {
+			try {
+				if (component.prototype) {
+					reflection.getComponentReflector(component.componentId).addComponentFromPrototype(entity, *component.prototype);
+				} else {
+					reflection.createComponent(*context, component.name, entity, component.data);
+				}
+			} catch (const std::exception& e) {
+				Logger::logError("Unable to create component \"" + component.name + "\":");
+				Logger::logException(e);
+			} catch (...) {
+				Logger::logError("Unable to create component \"" + component.name + "\".");
+			}
+		}
+	}
+
+	// Don't keep a lingering reference
+	if (context) {
+		context->setCurrentEntity(EntityId());
+	}
+
+	return entities[0];
+}
+
 EntityRef EntityFactory::createEntity(const EntityData& data, int mask, EntityRef parent, EntityScene* scene)
 {
 	const auto context = makeContext(data, {}, scene, false, mask);
@@ -61,13 +61,24 @@ void Prefab::makeDefault()
 void Prefab::serialize(Serializer& s) const
 {
 	waitForLoad(true);
-	s << entityData;
+	s << entityTableMarker;
+	entityData.serializeTable(s);
 	s << gameData;
 }
 
 void Prefab::deserialize(Deserializer& s)
 {
-	s >> entityData;
+	compiledTemplate.clear();
+
+	// Assets imported before entity tables start with the field mask of an EntityDataDelta, which can never match the marker
+	uint16_t marker;
+	s.peek(marker);
+	if (marker == entityTableMarker) {
+		s >> marker;
+		entityData.deserializeTable(s);
+	} else {
+		s >> entityData;
+	}
 	s >> gameData;
 	entityData.setSceneRoot(isScene());
 }
@@ -89,6 +100,7 @@ String Prefab::toYAML() const
 
 void Prefab::parseConfigNode(const ConfigNode& node)
 {
+	compiledTemplate.clear();
 	if (node.getType() == ConfigNodeType::Map && node.hasKey("entity")) {
 		entityData = makeEntityData(node["entity"]);
 		gameData.getRoot() = std::move(node["game"]);
@@ -124,6 +136,7 @@ bool Prefab::isScene() const
 EntityData& Prefab::getEntityData()
 {
 	waitForLoad(true);
+	compiledTemplate.clear();
 	return entityData;
 }
 
@@ -142,6 +155,7 @@ gsl::span<const EntityData> Prefab::getEntityDatas() const
 gsl::span<EntityData> Prefab::getEntityDatas()
 {
 	waitForLoad(true);
+	compiledTemplate.clear();
 	return gsl::span<EntityData>(&entityData, 1);
 }
 
@@ -238,6 +252,7 @@ String Prefab::getPrefabIcon() const
 EntityData* Prefab::findEntityData(const UUID& uuid)
 {
 	waitForLoad(true);
+	compiledTemplate.clear();
 	if (!uuid.isValid()) {
 		if (isScene()) {
 			return &entityData;
@@ -256,9 +271,18 @@ std::shared_ptr<Prefab> Prefab::clone() const
 
 void Prefab::preloadDependencies(Resources& resources) const
 {
+	for (const auto& name: getPrefabDependencies()) {
+		resources.preload<Prefab>(name);
+	}
+}
+
+HashSet<String> Prefab::getPrefabDependencies() const
+{
+	HashSet<String> result;
 	for (const auto& data: getEntityDatas()) {
-		doPreloadDependencies(data, resources);
+		collectPrefabDependencies(data, result);
 	}
+	return result;
 }
 
 ResourceMemoryUsage Prefab::getMemoryUsage() const
@@ -273,15 +297,32 @@ void Prefab::generateUUIDs()
 	HashMap<UUID, UUID> changes;
 	entityData.generateUUIDs(changes);
 	entityData.updateComponentUUIDs(changes);
+	compiledTemplate.clear();
+}
+
+void Prefab::releaseCaches()
+{
+	// The template pins the resources its components reference, and is rebuilt the next time the prefab is instanced
+	compiledTemplate.clear();
+}
+
+std::shared_ptr<const PrefabTemplate> Prefab::getCompiledTemplate() const
+{
+	return compiledTemplate.get();
+}
+
+void Prefab::setCompiledTemplate(std::shared_ptr<const PrefabTemplate> value) const
+{
+	compiledTemplate.set(std::move(value));
 }
 
-void Prefab::doPreloadDependencies(const EntityData& data, Resources& resources) const
+void Prefab::collectPrefabDependencies(const EntityData& data, HashSet<String>& result) const
 {
 	if (!data.getPrefab().isEmpty()) {
-		resources.preload<Prefab>(data.getPrefab());
+		result.insert(data.getPrefab());
 	}
-	for (auto c: data.getChildren()) {
-		doPreloadDependencies(c, resources);
+	for (const auto& c: data.getChildren()) {
+		collectPrefabDependencies(c, result);
 	}
 }
 
@@ -58,3 +58,17 @@ ComponentReflector& WorldReflection::getComponentReflector(int id) const
 {
 	return *componentReflectors.at(id);
 }
+
+std::optional<int> WorldReflection::tryGetComponentId(const String& name) const
+{
+	const auto iter = componentMap.find(name);
+	if (iter != componentMap.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+const Vector<std::unique_ptr<ComponentReflector>>& WorldReflection::getComponentReflectors() const
+{
+	return componentReflectors;
+}
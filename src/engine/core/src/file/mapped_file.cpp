@@ -0,0 +1,96 @@
+#include "halley/file/mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Halley;
+
+std::shared_ptr<MappedFile> MappedFile::open(const Path& path)
+{
+	auto result = std::shared_ptr<MappedFile>(new MappedFile());
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.getNativeString().getUTF16().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return {};
+	}
+	result->fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		return {};
+	}
+	result->size = static_cast<size_t>(fileSize.QuadPart);
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		return {};
+	}
+	result->mappingHandle = mapping;
+
+	result->data = static_cast<const gsl::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!result->data) {
+		return {};
+	}
+#else
+	const int fd = ::open(path.getNativeString().c_str(), O_RDONLY);
+	if (fd < 0) {
+		return {};
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return {};
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (ptr == MAP_FAILED) {
+		return {};
+	}
+	result->data = static_cast<const gsl::byte*>(ptr);
+	result->size = static_cast<size_t>(st.st_size);
+#endif
+
+	return result;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle) {
+		CloseHandle(fileHandle);
+	}
+#else
+	if (data) {
+		munmap(const_cast<gsl::byte*>(data), size);
+	}
+#endif
+}
+
+gsl::span<const gsl::byte> MappedFile::getSpan() const
+{
+	return gsl::span<const gsl::byte>(data, size);
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
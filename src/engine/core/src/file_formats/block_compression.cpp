@@ -0,0 +1,917 @@
+#include "halley/file_formats/block_compression.h"
+#include "halley/file_formats/image.h"
+#include "halley/support/exception.h"
+#include "halley/text/string_converter.h"
+#include <array>
+#include <climits>
+#include <cmath>
+
+using namespace Halley;
+
+namespace {
+	using Pixel = std::array<uint8_t, 4>;
+	using Block = std::array<Pixel, 16>; // Pixel (x, y) is at y * 4 + x
+	using BlockMask = std::array<bool, 16>;
+
+	template <size_t N>
+	using Colour = std::array<float, N>;
+
+	template <size_t N>
+	struct Endpoints {
+		Colour<N> a = {};
+		Colour<N> b = {};
+	};
+
+	int clampByte(int value)
+	{
+		return std::clamp(value, 0, 255);
+	}
+
+	void readBlock(const Image& image, int bx, int by, Block& dst)
+	{
+		const auto bytes = image.getPixelBytes();
+		const size_t bpp = image.getBytesPerPixel();
+		const size_t width = image.getWidth();
+
+		for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				const auto* src = bytes.data() + ((by * 4 + y) * width + (bx * 4 + x)) * bpp;
+				auto& px = dst[y * 4 + x];
+				px[0] = src[0];
+				px[1] = src[1];
+				px[2] = src[2];
+				px[3] = bpp == 4 ? src[3] : 255;
+			}
+		}
+	}
+
+	// Fits a line through the pixels in use, and returns the extremes of their projections onto it
+	template <size_t N>
+	Endpoints<N> findEndpoints(const Block& block, const BlockMask& use)
+	{
+		Colour<N> mean = {};
+		int count = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			if (use[i]) {
+				for (size_t c = 0; c < N; ++c) {
+					mean[c] += block[i][c];
+				}
+				++count;
+			}
+		}
+		if (count == 0) {
+			return {};
+		}
+		for (auto& m: mean) {
+			m /= static_cast<float>(count);
+		}
+
+		std::array<Colour<N>, N> covariance = {};
+		for (size_t i = 0; i < 16; ++i) {
+			if (use[i]) {
+				for (size_t j = 0; j < N; ++j) {
+					for (size_t k = 0; k < N; ++k) {
+						covariance[j][k] += (block[i][j] - mean[j]) * (block[i][k] - mean[k]);
+					}
+				}
+			}
+		}
+
+		// Power iteration for the principal axis, starting from the channel with the most variance
+		size_t startChannel = 0;
+		for (size_t c = 1; c < N; ++c) {
+			if (covariance[c][c] > covariance[startChannel][startChannel]) {
+				startChannel = c;
+			}
+		}
+		Colour<N> axis = {};
+		axis[startChannel] = 1.0f;
+		for (int iteration = 0; iteration < 8; ++iteration) {
+			Colour<N> next = {};
+			float length = 0;
+			for (size_t j = 0; j < N; ++j) {
+				for (size_t k = 0; k < N; ++k) {
+					next[j] += covariance[j][k] * axis[k];
+				}
+				length += next[j] * next[j];
+			}
+			length = std::sqrt(length);
+			if (length < 0.0001f) {
+				axis = {};
+				break;
+			}
+			for (size_t j = 0; j < N; ++j) {
+				axis[j] = next[j] / length;
+			}
+		}
+
+		float tMin = std::numeric_limits<float>::max();
+		float tMax = std::numeric_limits<float>::lowest();
+		for (size_t i = 0; i < 16; ++i) {
+			if (use[i]) {
+				float t = 0;
+				for (size_t c = 0; c < N; ++c) {
+					t += (block[i][c] - mean[c]) * axis[c];
+				}
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+		}
+
+		Endpoints<N> result;
+		for (size_t c = 0; c < N; ++c) {
+			result.a[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+			result.b[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+		}
+		return result;
+	}
+
+	template <size_t N, typename T>
+	int getDistance(const Pixel& px, const std::array<T, N>& colour)
+	{
+		int result = 0;
+		for (size_t c = 0; c < N; ++c) {
+			const int d = int(px[c]) - int(colour[c]);
+			result += d * d;
+		}
+		return result;
+	}
+
+	void writeLittleEndian(uint8_t* dst, uint64_t value, int numBytes)
+	{
+		for (int i = 0; i < numBytes; ++i) {
+			dst[i] = static_cast<uint8_t>(value >> (8 * i));
+		}
+	}
+
+	void writeBigEndian(uint8_t* dst, uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i) {
+			dst[i] = static_cast<uint8_t>(value >> (56 - 8 * i));
+		}
+	}
+
+
+	// BC1 colour block, also used by BC3
+	uint16_t toRGB565(const Colour<3>& colour)
+	{
+		const int r = std::clamp(int(std::lround(colour[0] * 31.0f / 255.0f)), 0, 31);
+		const int g = std::clamp(int(std::lround(colour[1] * 63.0f / 255.0f)), 0, 63);
+		const int b = std::clamp(int(std::lround(colour[2] * 31.0f / 255.0f)), 0, 31);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	std::array<int, 3> fromRGB565(uint16_t value)
+	{
+		const int r = value >> 11;
+		const int g = (value >> 5) & 63;
+		const int b = value & 31;
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+
+	void encodeColourBlock(const Block& block, uint8_t* dst, bool allowTransparent)
+	{
+		BlockMask opaque;
+		bool hasTransparent = false;
+		for (size_t i = 0; i < 16; ++i) {
+			opaque[i] = !allowTransparent || block[i][3] >= 128;
+			hasTransparent = hasTransparent || !opaque[i];
+		}
+
+		const auto endpoints = findEndpoints<3>(block, opaque);
+		uint16_t c0 = toRGB565(endpoints.b);
+		uint16_t c1 = toRGB565(endpoints.a);
+
+		// The order of the endpoints selects the mode: c0 > c1 has four colours, otherwise there are three and index 3 is transparent
+		if (hasTransparent ? c0 > c1 : c0 < c1) {
+			std::swap(c0, c1);
+		}
+
+		std::array<std::array<int, 3>, 4> palette;
+		palette[0] = fromRGB565(c0);
+		palette[1] = fromRGB565(c1);
+		for (size_t c = 0; c < 3; ++c) {
+			if (hasTransparent) {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			} else {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+		}
+		const int numColours = hasTransparent ? 3 : 4;
+
+		uint32_t indices = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			int best = 3;
+			if (opaque[i]) {
+				int bestDistance = INT_MAX;
+				for (int j = 0; j < numColours; ++j) {
+					const int distance = getDistance<3>(block[i], palette[j]);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = j;
+					}
+				}
+			}
+			indices |= uint32_t(best) << (2 * i);
+		}
+
+		writeLittleEndian(dst, c0, 2);
+		writeLittleEndian(dst + 2, c1, 2);
+		writeLittleEndian(dst + 4, indices, 4);
+	}
+
+
+	// BC3 alpha block
+	void encodeAlphaBlock(const Block& block, uint8_t* dst)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		for (const auto& px: block) {
+			minAlpha = std::min(minAlpha, int(px[3]));
+			maxAlpha = std::max(maxAlpha, int(px[3]));
+		}
+
+		uint64_t indices = 0;
+		if (maxAlpha > minAlpha) {
+			// a0 > a1 selects the mode with six interpolated values
+			std::array<int, 8> palette;
+			palette[0] = maxAlpha;
+			palette[1] = minAlpha;
+			for (int i = 2; i < 8; ++i) {
+				palette[i] = ((8 - i) * maxAlpha + (i - 1) * minAlpha) / 7;
+			}
+
+			for (size_t i = 0; i < 16; ++i) {
+				int best = 0;
+				int bestDistance = INT_MAX;
+				for (int j = 0; j < 8; ++j) {
+					const int distance = std::abs(palette[j] - int(block[i][3]));
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = j;
+					}
+				}
+				indices |= uint64_t(best) << (3 * i);
+			}
+		}
+
+		dst[0] = static_cast<uint8_t>(maxAlpha);
+		dst[1] = static_cast<uint8_t>(minAlpha);
+		writeLittleEndian(dst + 2, indices, 6);
+	}
+
+
+	// BC7, mode 6: a single RGBA line with 7 bit endpoints, a p-bit each, and 4 bit indices
+	constexpr std::array<int, 16> bc7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Endpoint {
+		std::array<int, 4> value; // 7 bits
+		int pBit;
+
+		std::array<int, 4> expand() const
+		{
+			return { value[0] * 2 + pBit, value[1] * 2 + pBit, value[2] * 2 + pBit, value[3] * 2 + pBit };
+		}
+	};
+
+	BC7Endpoint quantizeBC7(const Colour<4>& colour)
+	{
+		BC7Endpoint best;
+		float bestError = std::numeric_limits<float>::max();
+		for (int p = 0; p < 2; ++p) {
+			BC7Endpoint candidate;
+			candidate.pBit = p;
+			float error = 0;
+			for (size_t c = 0; c < 4; ++c) {
+				candidate.value[c] = std::clamp(int(std::lround((colour[c] - p) * 0.5f)), 0, 127);
+				const float d = float(candidate.value[c] * 2 + p) - colour[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	int findBC7Indices(const Block& block, const BC7Endpoint& e0, const BC7Endpoint& e1, std::array<uint8_t, 16>& indices)
+	{
+		const auto c0 = e0.expand();
+		const auto c1 = e1.expand();
+		std::array<std::array<int, 4>, 16> palette;
+		for (size_t i = 0; i < 16; ++i) {
+			for (size_t c = 0; c < 4; ++c) {
+				palette[i][c] = ((64 - bc7Weights[i]) * c0[c] + bc7Weights[i] * c1[c] + 32) >> 6;
+			}
+		}
+
+		int totalError = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			int bestDistance = INT_MAX;
+			for (size_t j = 0; j < 16; ++j) {
+				const int distance = getDistance<4>(block[i], palette[j]);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					indices[i] = static_cast<uint8_t>(j);
+				}
+			}
+			totalError += bestDistance;
+		}
+		return totalError;
+	}
+
+	class BitWriter {
+	public:
+		explicit BitWriter(uint8_t* dst)
+			: dst(dst)
+		{}
+
+		void write(uint32_t value, int numBits)
+		{
+			for (int i = 0; i < numBits; ++i) {
+				if ((value >> i) & 1) {
+					dst[pos >> 3] |= static_cast<uint8_t>(1 << (pos & 7));
+				}
+				++pos;
+			}
+		}
+
+	private:
+		uint8_t* dst;
+		size_t pos = 0;
+	};
+
+	void encodeBC7(const Block& block, uint8_t* dst)
+	{
+		BlockMask all;
+		all.fill(true);
+		const auto endpoints = findEndpoints<4>(block, all);
+
+		BC7Endpoint e0 = quantizeBC7(endpoints.a);
+		BC7Endpoint e1 = quantizeBC7(endpoints.b);
+		std::array<uint8_t, 16> indices;
+		int error = findBC7Indices(block, e0, e1, indices);
+
+		// Refine the endpoints with a least squares fit to the chosen weights
+		float s00 = 0;
+		float s01 = 0;
+		float s11 = 0;
+		Colour<4> r0 = {};
+		Colour<4> r1 = {};
+		for (size_t i = 0; i < 16; ++i) {
+			const float w = bc7Weights[indices[i]] / 64.0f;
+			s00 += (1 - w) * (1 - w);
+			s01 += (1 - w) * w;
+			s11 += w * w;
+			for (size_t c = 0; c < 4; ++c) {
+				r0[c] += (1 - w) * block[i][c];
+				r1[c] += w * block[i][c];
+			}
+		}
+		const float det = s00 * s11 - s01 * s01;
+		if (std::abs(det) > 0.0001f) {
+			Colour<4> a;
+			Colour<4> b;
+			for (size_t c = 0; c < 4; ++c) {
+				a[c] = std::clamp((s11 * r0[c] - s01 * r1[c]) / det, 0.0f, 255.0f);
+				b[c] = std::clamp((s00 * r1[c] - s01 * r0[c]) / det, 0.0f, 255.0f);
+			}
+
+			const auto refined0 = quantizeBC7(a);
+			const auto refined1 = quantizeBC7(b);
+			std::array<uint8_t, 16> refinedIndices;
+			if (const int refinedError = findBC7Indices(block, refined0, refined1, refinedIndices); refinedError < error) {
+				e0 = refined0;
+				e1 = refined1;
+				indices = refinedIndices;
+				error = refinedError;
+			}
+		}
+
+		// The first index is stored without its top bit, so it must be in the lower half
+		if (indices[0] >= 8) {
+			std::swap(e0, e1);
+			for (auto& index: indices) {
+				index = static_cast<uint8_t>(15 - index);
+			}
+		}
+
+		memset(dst, 0, 16);
+		BitWriter bits(dst);
+		bits.write(1 << 6, 7);
+		for (size_t c = 0; c < 4; ++c) {
+			bits.write(e0.value[c], 7);
+			bits.write(e1.value[c], 7);
+		}
+		bits.write(e0.pBit, 1);
+		bits.write(e1.pBit, 1);
+		for (size_t i = 0; i < 16; ++i) {
+			bits.write(indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+
+	// ETC2 colour block, using the ETC1 compatible modes
+	constexpr int etcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+	// ETC stores pixels by column, so (x, y) is at x * 4 + y
+	int getETCPixelIndex(size_t i)
+	{
+		return int((i % 4) * 4 + i / 4);
+	}
+
+	struct ETCSubblock {
+		int table = 0;
+		int error = INT_MAX;
+		std::array<uint8_t, 16> indices = {};
+	};
+
+	ETCSubblock fitETCSubblock(const Block& block, const BlockMask& member, const std::array<int, 3>& base)
+	{
+		ETCSubblock best;
+		for (int table = 0; table < 8; ++table) {
+			ETCSubblock candidate;
+			candidate.table = table;
+			candidate.error = 0;
+
+			for (size_t i = 0; i < 16 && candidate.error < best.error; ++i) {
+				if (!member[i]) {
+					continue;
+				}
+
+				int bestDistance = INT_MAX;
+				for (int m = 0; m < 4; ++m) {
+					// Index bits are 00 = +a, 01 = +b, 10 = -a, 11 = -b
+					const int modifier = etcModifiers[table][m & 1] * ((m & 2) ? -1 : 1);
+					const std::array<int, 3> colour = { clampByte(base[0] + modifier), clampByte(base[1] + modifier), clampByte(base[2] + modifier) };
+					const int distance = getDistance<3>(block[i], colour);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						candidate.indices[i] = static_cast<uint8_t>(m);
+					}
+				}
+				candidate.error += bestDistance;
+			}
+
+			if (candidate.error < best.error) {
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	void encodeETC2(const Block& block, uint8_t* dst)
+	{
+		uint64_t bestWord = 0;
+		int bestError = INT_MAX;
+
+		for (int flip = 0; flip < 2; ++flip) {
+			// Unflipped blocks are split into left and right halves, flipped ones into top and bottom
+			BlockMask first;
+			BlockMask second;
+			Colour<3> average0 = {};
+			Colour<3> average1 = {};
+			for (size_t i = 0; i < 16; ++i) {
+				first[i] = flip ? i / 4 < 2 : i % 4 < 2;
+				second[i] = !first[i];
+				auto& average = first[i] ? average0 : average1;
+				for (size_t c = 0; c < 3; ++c) {
+					average[c] += block[i][c] / 8.0f;
+				}
+			}
+
+			const auto tryMode = [&] (bool differential, const std::array<int, 3>& q0, const std::array<int, 3>& q1)
+			{
+				std::array<int, 3> base0;
+				std::array<int, 3> base1;
+				for (size_t c = 0; c < 3; ++c) {
+					base0[c] = differential ? (q0[c] << 3) | (q0[c] >> 2) : (q0[c] << 4) | q0[c];
+					base1[c] = differential ? (q1[c] << 3) | (q1[c] >> 2) : (q1[c] << 4) | q1[c];
+				}
+
+				const auto sub0 = fitETCSubblock(block, first, base0);
+				const auto sub1 = fitETCSubblock(block, second, base1);
+				const int error = sub0.error + sub1.error;
+				if (error >= bestError) {
+					return;
+				}
+
+				uint64_t word = 0;
+				if (differential) {
+					// Both bases are valid 5 bit values, so base + delta never overflows into the ETC2-only modes
+					for (size_t c = 0; c < 3; ++c) {
+						word |= uint64_t(q0[c]) << (59 - 8 * c);
+						word |= uint64_t((q1[c] - q0[c]) & 7) << (56 - 8 * c);
+					}
+				} else {
+					for (size_t c = 0; c < 3; ++c) {
+						word |= uint64_t(q0[c]) << (60 - 8 * c);
+						word |= uint64_t(q1[c]) << (56 - 8 * c);
+					}
+				}
+				word |= uint64_t(sub0.table) << 37;
+				word |= uint64_t(sub1.table) << 34;
+				word |= uint64_t(differential ? 1 : 0) << 33;
+				word |= uint64_t(flip) << 32;
+
+				for (size_t i = 0; i < 16; ++i) {
+					const int index = first[i] ? sub0.indices[i] : sub1.indices[i];
+					const int bit = getETCPixelIndex(i);
+					word |= uint64_t(index >> 1) << (16 + bit);
+					word |= uint64_t(index & 1) << bit;
+				}
+
+				bestError = error;
+				bestWord = word;
+			};
+
+			std::array<int, 3> q0;
+			std::array<int, 3> q1;
+			bool fitsDifferential = true;
+			for (size_t c = 0; c < 3; ++c) {
+				q0[c] = std::clamp(int(std::lround(average0[c] * 31.0f / 255.0f)), 0, 31);
+				q1[c] = std::clamp(int(std::lround(average1[c] * 31.0f / 255.0f)), 0, 31);
+				const int delta = q1[c] - q0[c];
+				fitsDifferential = fitsDifferential && delta >= -4 && delta <= 3;
+			}
+			if (fitsDifferential) {
+				tryMode(true, q0, q1);
+			}
+
+			for (size_t c = 0; c < 3; ++c) {
+				q0[c] = std::clamp(int(std::lround(average0[c] * 15.0f / 255.0f)), 0, 15);
+				q1[c] = std::clamp(int(std::lround(average1[c] * 15.0f / 255.0f)), 0, 15);
+			}
+			tryMode(false, q0, q1);
+		}
+
+		writeBigEndian(dst, bestWord);
+	}
+
+
+	// EAC alpha block, used by ETC2 RGBA
+	constexpr int eacModifiers[16][8] = {
+		{ -3, -6, -9, -15, 2, 5, 8, 14 },
+		{ -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 },
+		{ -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 },
+		{ -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 },
+		{ -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 },
+		{ -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 },
+		{ -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 },
+		{ -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 },
+		{ -3, -5, -7, -9, 2, 4, 6, 8 }
+	};
+
+	void encodeEACAlpha(const Block& block, uint8_t* dst)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		for (const auto& px: block) {
+			minAlpha = std::min(minAlpha, int(px[3]));
+			maxAlpha = std::max(maxAlpha, int(px[3]));
+		}
+
+		int bestBase = minAlpha;
+		int bestMultiplier = 1;
+		int bestTable = 0;
+		int bestError = INT_MAX;
+		std::array<uint8_t, 16> bestIndices = {};
+
+		const auto tryParameters = [&] (int base, int multiplier, int table)
+		{
+			std::array<uint8_t, 16> indices;
+			int error = 0;
+			for (size_t i = 0; i < 16 && error < bestError; ++i) {
+				int bestDistance = INT_MAX;
+				for (int m = 0; m < 8; ++m) {
+					const int d = clampByte(base + eacModifiers[table][m] * multiplier) - int(block[i][3]);
+					if (d * d < bestDistance) {
+						bestDistance = d * d;
+						indices[i] = static_cast<uint8_t>(m);
+					}
+				}
+				error += bestDistance;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				bestBase = base;
+				bestMultiplier = multiplier;
+				bestTable = table;
+				bestIndices = indices;
+			}
+		};
+
+		if (minAlpha == maxAlpha) {
+			// Table 13 has a zero modifier, so this is exact
+			tryParameters(minAlpha, 1, 13);
+		} else {
+			// Scale each table so its range covers the block's, and search around that
+			for (int table = 0; table < 16 && bestError > 0; ++table) {
+				const int low = eacModifiers[table][3];
+				const int high = eacModifiers[table][7];
+				const float idealMultiplier = float(maxAlpha - minAlpha) / float(high - low);
+				const int firstMultiplier = std::clamp(int(std::floor(idealMultiplier)), 1, 15);
+				const int lastMultiplier = std::clamp(int(std::ceil(idealMultiplier)) + 1, 1, 15);
+
+				for (int multiplier = firstMultiplier; multiplier <= lastMultiplier; ++multiplier) {
+					const int base = int(std::lround((minAlpha + maxAlpha) * 0.5f - (low + high) * multiplier * 0.5f));
+					for (int offset = -1; offset <= 1; ++offset) {
+						tryParameters(clampByte(base + offset), multiplier, table);
+					}
+				}
+			}
+		}
+
+		uint64_t word = uint64_t(bestBase) << 56 | uint64_t(bestMultiplier) << 52 | uint64_t(bestTable) << 48;
+		for (size_t i = 0; i < 16; ++i) {
+			word |= uint64_t(bestIndices[i]) << (45 - 3 * getETCPixelIndex(i));
+		}
+		writeBigEndian(dst, word);
+	}
+
+
+	// Decoders, which follow the format specifications rather than mirroring the encoders above
+	uint64_t readLittleEndian(const uint8_t* src, int numBytes)
+	{
+		uint64_t result = 0;
+		for (int i = 0; i < numBytes; ++i) {
+			result |= uint64_t(src[i]) << (8 * i);
+		}
+		return result;
+	}
+
+	uint64_t readBigEndian(const uint8_t* src)
+	{
+		uint64_t result = 0;
+		for (int i = 0; i < 8; ++i) {
+			result = (result << 8) | src[i];
+		}
+		return result;
+	}
+
+	void decodeColourBlock(const uint8_t* src, Block& dst, bool alwaysFourColours)
+	{
+		const auto c0 = static_cast<uint16_t>(readLittleEndian(src, 2));
+		const auto c1 = static_cast<uint16_t>(readLittleEndian(src + 2, 2));
+		const auto indices = static_cast<uint32_t>(readLittleEndian(src + 4, 4));
+
+		std::array<Pixel, 4> palette;
+		const auto rgb0 = fromRGB565(c0);
+		const auto rgb1 = fromRGB565(c1);
+		const bool fourColours = alwaysFourColours || c0 > c1;
+		for (size_t c = 0; c < 3; ++c) {
+			palette[0][c] = static_cast<uint8_t>(rgb0[c]);
+			palette[1][c] = static_cast<uint8_t>(rgb1[c]);
+			palette[2][c] = static_cast<uint8_t>(fourColours ? (2 * rgb0[c] + rgb1[c]) / 3 : (rgb0[c] + rgb1[c]) / 2);
+			palette[3][c] = static_cast<uint8_t>(fourColours ? (rgb0[c] + 2 * rgb1[c]) / 3 : 0);
+		}
+		for (size_t i = 0; i < 4; ++i) {
+			palette[i][3] = fourColours || i < 3 ? 255 : 0;
+		}
+
+		for (size_t i = 0; i < 16; ++i) {
+			dst[i] = palette[(indices >> (2 * i)) & 3];
+		}
+	}
+
+	void decodeAlphaBlock(const uint8_t* src, Block& dst)
+	{
+		const int a0 = src[0];
+		const int a1 = src[1];
+		const uint64_t indices = readLittleEndian(src + 2, 6);
+
+		std::array<int, 8> palette;
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1) {
+			for (int i = 2; i < 8; ++i) {
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+			}
+		} else {
+			for (int i = 2; i < 6; ++i) {
+				palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for (size_t i = 0; i < 16; ++i) {
+			dst[i][3] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	class BitReader {
+	public:
+		explicit BitReader(const uint8_t* src)
+			: src(src)
+		{}
+
+		uint32_t read(int numBits)
+		{
+			uint32_t result = 0;
+			for (int i = 0; i < numBits; ++i) {
+				result |= uint32_t((src[pos >> 3] >> (pos & 7)) & 1) << i;
+				++pos;
+			}
+			return result;
+		}
+
+	private:
+		const uint8_t* src;
+		size_t pos = 0;
+	};
+
+	void decodeBC7(const uint8_t* src, Block& dst)
+	{
+		BitReader bits(src);
+		if (bits.read(7) != 1 << 6) {
+			throw Exception("Only BC7 mode 6 blocks can be decoded", HalleyExceptions::Utils);
+		}
+
+		std::array<int, 4> e0;
+		std::array<int, 4> e1;
+		for (size_t c = 0; c < 4; ++c) {
+			e0[c] = int(bits.read(7));
+			e1[c] = int(bits.read(7));
+		}
+		const int p0 = int(bits.read(1));
+		const int p1 = int(bits.read(1));
+		for (size_t c = 0; c < 4; ++c) {
+			e0[c] = e0[c] << 1 | p0;
+			e1[c] = e1[c] << 1 | p1;
+		}
+
+		for (size_t i = 0; i < 16; ++i) {
+			const int weight = bc7Weights[bits.read(i == 0 ? 3 : 4)];
+			for (size_t c = 0; c < 4; ++c) {
+				dst[i][c] = static_cast<uint8_t>(((64 - weight) * e0[c] + weight * e1[c] + 32) >> 6);
+			}
+		}
+	}
+
+	void decodeETC2(const uint8_t* src, Block& dst)
+	{
+		const uint64_t word = readBigEndian(src);
+		const bool differential = (word >> 33) & 1;
+		const bool flip = (word >> 32) & 1;
+
+		std::array<std::array<int, 3>, 2> bases;
+		for (size_t c = 0; c < 3; ++c) {
+			if (differential) {
+				const int base = int((word >> (59 - 8 * c)) & 31);
+				const int delta = int((word >> (56 - 8 * c)) & 7);
+				const int other = base + (delta >= 4 ? delta - 8 : delta);
+				if (other < 0 || other > 31) {
+					throw Exception("Only the ETC1 compatible modes of ETC2 can be decoded", HalleyExceptions::Utils);
+				}
+				bases[0][c] = (base << 3) | (base >> 2);
+				bases[1][c] = (other << 3) | (other >> 2);
+			} else {
+				bases[0][c] = int((word >> (60 - 8 * c)) & 15) * 17;
+				bases[1][c] = int((word >> (56 - 8 * c)) & 15) * 17;
+			}
+		}
+		const std::array<int, 2> tables = { int((word >> 37) & 7), int((word >> 34) & 7) };
+
+		for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				const int subblock = (flip ? y : x) < 2 ? 0 : 1;
+				const int bit = x * 4 + y;
+				const int index = int(((word >> (16 + bit)) & 1) << 1 | ((word >> bit) & 1));
+				const int modifier = etcModifiers[tables[subblock]][index & 1] * ((index & 2) ? -1 : 1);
+
+				auto& px = dst[y * 4 + x];
+				for (size_t c = 0; c < 3; ++c) {
+					px[c] = static_cast<uint8_t>(clampByte(bases[subblock][c] + modifier));
+				}
+				px[3] = 255;
+			}
+		}
+	}
+
+	void decodeEACAlpha(const uint8_t* src, Block& dst)
+	{
+		const uint64_t word = readBigEndian(src);
+		const int base = int(word >> 56);
+		const int multiplier = int((word >> 52) & 15);
+		const int table = int((word >> 48) & 15);
+
+		for (int y = 0; y < 4; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				const int index = int((word >> (45 - 3 * (x * 4 + y))) & 7);
+				dst[y * 4 + x][3] = static_cast<uint8_t>(clampByte(base + eacModifiers[table][index] * multiplier));
+			}
+		}
+	}
+}
+
+bool BlockCompression::canEncode(const Image& image, TextureFormat format)
+{
+	const auto imgFormat = image.getFormat();
+	const bool isColour = imgFormat == Image::Format::RGBA || imgFormat == Image::Format::RGBAPremultiplied || imgFormat == Image::Format::RGB;
+	const auto size = image.getSize();
+	return isColour && TextureDescriptor::isBlockCompressed(format) && size.x > 0 && size.y > 0 && size.x % 4 == 0 && size.y % 4 == 0;
+}
+
+Bytes BlockCompression::encode(const Image& image, TextureFormat format)
+{
+	if (!canEncode(image, format)) {
+		throw Exception("Unable to encode " + toString(image.getSize()) + " " + toString(image.getFormat()) + " image as " + toString(format), HalleyExceptions::Utils);
+	}
+
+	const int blockBytes = TextureDescriptor::getBlockBytes(format);
+	const int blocksX = image.getSize().x / 4;
+	const int blocksY = image.getSize().y / 4;
+	Bytes result(size_t(blocksX) * size_t(blocksY) * size_t(blockBytes));
+
+	Block block;
+	for (int by = 0; by < blocksY; ++by) {
+		for (int bx = 0; bx < blocksX; ++bx) {
+			readBlock(image, bx, by, block);
+			auto* dst = result.data() + (size_t(by) * blocksX + bx) * blockBytes;
+
+			switch (format) {
+			case TextureFormat::BC1:
+				encodeColourBlock(block, dst, true);
+				break;
+			case TextureFormat::BC3:
+				encodeAlphaBlock(block, dst);
+				encodeColourBlock(block, dst + 8, false);
+				break;
+			case TextureFormat::BC7:
+				encodeBC7(block, dst);
+				break;
+			case TextureFormat::ETC2:
+				encodeETC2(block, dst);
+				break;
+			case TextureFormat::ETC2Alpha:
+				encodeEACAlpha(block, dst);
+				encodeETC2(block, dst + 8);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::unique_ptr<Image> BlockCompression::decode(gsl::span<const gsl::byte> blocks, Vector2i size, TextureFormat format)
+{
+	const int blockBytes = TextureDescriptor::getBlockBytes(format);
+	if (blockBytes == 0 || size.x % 4 != 0 || size.y % 4 != 0 || blocks.size() < TextureDescriptor::getImageByteSize(format, size)) {
+		throw Exception("Unable to decode " + toString(size) + " " + toString(format) + " blocks", HalleyExceptions::Utils);
+	}
+
+	auto image = std::make_unique<Image>(Image::Format::RGBA, size, false);
+	const auto dstBytes = image->getPixelBytes();
+	const int blocksX = size.x / 4;
+	const int blocksY = size.y / 4;
+
+	Block block;
+	for (int by = 0; by < blocksY; ++by) {
+		for (int bx = 0; bx < blocksX; ++bx) {
+			const auto* src = reinterpret_cast<const uint8_t*>(blocks.data()) + (size_t(by) * blocksX + bx) * blockBytes;
+
+			switch (format) {
+			case TextureFormat::BC1:
+				decodeColourBlock(src, block, false);
+				break;
+			case TextureFormat::BC3:
+				decodeColourBlock(src + 8, block, true);
+				decodeAlphaBlock(src, block);
+				break;
+			case TextureFormat::BC7:
+				decodeBC7(src, block);
+				break;
+			case TextureFormat::ETC2:
+				decodeETC2(src, block);
+				break;
+			case TextureFormat::ETC2Alpha:
+				decodeETC2(src + 8, block);
+				decodeEACAlpha(src, block);
+				break;
+			default:
+				break;
+			}
+
+			for (int y = 0; y < 4; ++y) {
+				memcpy(dstBytes.data() + (size_t(by * 4 + y) * size.x + bx * 4) * 4, block[y * 4].data(), 16);
+			}
+		}
+	}
+
+	return image;
+}
@@ -1,25 +1,36 @@
 #include "halley/file_formats/hlif_file.h"
 
 #include "halley/bytes/compression.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/file_formats/block_compression.h"
 
 using namespace Halley;
 
 void HLIFFile::decode(Image& dst, gsl::span<const gsl::byte> bytes)
 {
-	if (!isHLIF(bytes)) {
-		throw Exception("Not an HLIF file.", HalleyExceptions::Utils);
-	}
-
-	Header header;
-	if (bytes.size() < sizeof(header)) {
-		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
+	const auto header = readHeader(bytes);
+	if (getBlockFormat(header.format)) {
+		throw Exception("HLIF file is block compressed, and can't be decoded to an image.", HalleyExceptions::Utils);
 	}
-	memcpy(&header, bytes.data(), sizeof(header));
 
 	const int bpp = header.numPalettes > 0 ? 1 : getBPP(header.format);
 	if (header.uncompressedSize != static_cast<uint32_t>(header.width * header.height * bpp + header.height + header.numPalettes * sizeof(Palette))) {
 		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
 	}
+	if (bytes.size() < sizeof(header) + header.compressedSize) {
+		throw Exception("HLIF file is truncated.", HalleyExceptions::Utils);
+	}
+
+	const auto imgFormat = header.format == Format::RGBA ?
+		((header.flags & static_cast<uint8_t>(Flags::Premultiplied)) ? Image::Format::RGBAPremultiplied : Image::Format::RGBA) :
+		(header.format == Format::SingleChannel ? Image::Format::SingleChannel : Image::Format::Indexed);
+	const auto imgSize = Vector2i(header.width, header.height);
+
+	if (header.flags & static_cast<uint8_t>(Flags::Banded)) {
+		dst = Image(imgFormat, imgSize, false);
+		decodeBands(dst, header, bytes.subspan(sizeof(header), header.compressedSize), bpp);
+		return;
+	}
 
 	Bytes decompressedData;
 	decompressedData.resize_no_init(header.uncompressedSize);
@@ -33,10 +44,6 @@ void HLIFFile::decode(Image& dst, gsl::span<const gsl::byte> bytes)
 	const auto paletteData = dataSpan.subspan(0, header.numPalettes * sizeof(Palette));
 	const auto lineData = dataSpan.subspan(paletteData.size(), header.height);
 	const auto pixelData = dataSpan.subspan(paletteData.size() + lineData.size());
-	const auto imgFormat = header.format == Format::RGBA ?
-		((header.flags & static_cast<uint8_t>(Flags::Premultiplied)) ? Image::Format::RGBAPremultiplied : Image::Format::RGBA) :
-		(header.format == Format::SingleChannel ? Image::Format::SingleChannel : Image::Format::Indexed);
-	const auto imgSize = Vector2i(header.width, header.height);
 
 	decodeLines(imgSize, lineData, pixelData, bpp);
 
@@ -93,6 +100,11 @@ Bytes HLIFFile::encode(const Image& image, std::string_view name, bool lz4hc)
 	const int bpp = palettedImage.empty() ? getBPP(header.format) : 1;
 	header.uncompressedSize = header.width * header.height * bpp + header.height + static_cast<uint32_t>(palettes.size() * sizeof(Palette));
 
+	if (const int bandHeight = getBandHeight(image.getSize(), bpp); bandHeight > 0) {
+		const auto pixels = palettes.empty() ? image.getPixelBytes() : gsl::span<const uint8_t>(palettedImage);
+		return encodeBands(header, palettes, pixels, bpp, bandHeight, lz4hc);
+	}
+
 	// Prepare uncompressed data
 	Bytes uncompressed;
 	uncompressed.resize_no_init(header.uncompressedSize);
@@ -132,7 +144,80 @@ Bytes HLIFFile::encode(const Image& image, std::string_view name, bool lz4hc)
 	return finalData;
 }
 
+Bytes HLIFFile::decodeBlocks(gsl::span<const gsl::byte> bytes)
+{
+	const auto header = readHeader(bytes);
+	const auto blockFormat = getBlockFormat(header.format);
+	if (!blockFormat) {
+		throw Exception("HLIF file is not block compressed.", HalleyExceptions::Utils);
+	}
+	if (header.uncompressedSize != TextureDescriptor::getImageByteSize(*blockFormat, Vector2i(header.width, header.height))) {
+		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+	}
+
+	// Blocks aren't line filtered, so they're ready to upload as soon as they're decompressed
+	Bytes result;
+	result.resize_no_init(header.uncompressedSize);
+	const auto decompressedSize = Compression::lz4Decompress(bytes.subspan(sizeof(header), header.compressedSize), result.byte_span());
+	if (decompressedSize != header.uncompressedSize) {
+		throw Exception("Error decoding HLIF file.", HalleyExceptions::Utils);
+	}
+	return result;
+}
+
+Bytes HLIFFile::encodeBlocks(const Image& image, TextureFormat format, bool lz4hc)
+{
+	Header header;
+	memcpy(header.id, hlifId, 8);
+	switch (format) {
+	case TextureFormat::BC1:
+		header.format = Format::BC1;
+		break;
+	case TextureFormat::BC3:
+		header.format = Format::BC3;
+		break;
+	case TextureFormat::BC7:
+		header.format = Format::BC7;
+		break;
+	case TextureFormat::ETC2:
+		header.format = Format::ETC2;
+		break;
+	case TextureFormat::ETC2Alpha:
+		header.format = Format::ETC2Alpha;
+		break;
+	default:
+		throw Exception("Not a block compressed format: " + toString(format), HalleyExceptions::Utils);
+	}
+	if (image.getFormat() == Image::Format::RGBAPremultiplied) {
+		header.flags |= static_cast<uint8_t>(Flags::Premultiplied);
+	}
+	header.width = static_cast<uint16_t>(image.getWidth());
+	header.height = static_cast<uint16_t>(image.getHeight());
+
+	const auto blocks = BlockCompression::encode(image, format);
+	header.uncompressedSize = static_cast<uint32_t>(blocks.size());
+
+	Compression::LZ4Options options;
+	options.mode = lz4hc ? Compression::LZ4Mode::HC : Compression::LZ4Mode::Normal;
+	const auto compressed = Compression::lz4Compress(blocks.byte_span(), options);
+	header.compressedSize = static_cast<uint32_t>(compressed.size());
+
+	Bytes finalData(sizeof(header) + compressed.size());
+	memcpy(finalData.data(), &header, sizeof(header));
+	memcpy(finalData.data() + sizeof(header), compressed.data(), compressed.size());
+	return finalData;
+}
+
 HLIFFile::Info HLIFFile::getInfo(gsl::span<const gsl::byte> bytes)
+{
+	const auto header = readHeader(bytes);
+	const auto blockFormat = getBlockFormat(header.format);
+	const auto imgFormat = header.format == Format::RGBA || blockFormat ? Image::Format::RGBA : (header.format == Format::SingleChannel ? Image::Format::SingleChannel : Image::Format::Indexed);
+	const auto imgSize = Vector2i(header.width, header.height);
+	return Info{ imgSize, imgFormat, blockFormat };
+}
+
+HLIFFile::Header HLIFFile::readHeader(gsl::span<const gsl::byte> bytes)
 {
 	if (!isHLIF(bytes)) {
 		throw Exception("Not an HLIF file.", HalleyExceptions::Utils);
@@ -142,12 +227,164 @@ HLIFFile::Info HLIFFile::getInfo(gsl::span<const gsl::byte> bytes)
 	if (bytes.size() < sizeof(header)) {
 		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
 	}
-
 	memcpy(&header, bytes.data(), sizeof(header));
-	
-	const auto imgFormat = header.format == Format::RGBA ? Image::Format::RGBA : (header.format == Format::SingleChannel ? Image::Format::SingleChannel : Image::Format::Indexed);
-	const auto imgSize = Vector2i(header.width, header.height);
-	return Info{ imgSize, imgFormat };
+	return header;
+}
+
+int HLIFFile::getBandHeight(Vector2i size, int bpp)
+{
+	const size_t stride = static_cast<size_t>(size.x) * bpp;
+	const int bandHeight = std::max(minBandHeight, static_cast<int>((targetBandSize + stride - 1) / std::max(stride, size_t(1))));
+	return size.y >= 2 * bandHeight ? bandHeight : 0;
+}
+
+namespace {
+	void forEachBand(size_t numBands, const std::function<void(size_t)>& f)
+	{
+		if (Executors::hasInstance()) {
+			Concurrent::parallelFor(Executors::getCPU(), numBands, f);
+		} else {
+			for (size_t i = 0; i < numBands; ++i) {
+				f(i);
+			}
+		}
+	}
+}
+
+Bytes HLIFFile::encodeBands(Header header, gsl::span<const Palette> palettes, gsl::span<const uint8_t> pixels, int bpp, int bandHeight, bool lz4hc)
+{
+	// Layout after the header: band height, number of bands, compressed size of each chunk, then the chunks themselves
+	// The first chunk holds the palettes and the encoding of every line, and each of the others holds the pixels of one band
+	header.flags |= static_cast<uint8_t>(Flags::Banded);
+	const int width = header.width;
+	const int height = header.height;
+	const size_t stride = static_cast<size_t>(width) * bpp;
+	const size_t numBands = static_cast<size_t>((height + bandHeight - 1) / bandHeight);
+
+	Compression::LZ4Options options;
+	options.mode = lz4hc ? Compression::LZ4Mode::HC : Compression::LZ4Mode::Normal;
+
+	const size_t paletteSize = palettes.size() * sizeof(Palette);
+	Bytes prefix(paletteSize + height, 0);
+	if (paletteSize > 0) {
+		memcpy(prefix.data(), palettes.data(), paletteSize);
+	}
+	const auto lineData = gsl::span<uint8_t>(prefix).subspan(paletteSize);
+
+	Vector<Bytes> chunks(numBands + 1);
+	forEachBand(numBands, [&] (size_t band)
+	{
+		const int y0 = static_cast<int>(band) * bandHeight;
+		const int rows = std::min(bandHeight, height - y0);
+		const auto src = pixels.subspan(y0 * stride, rows * stride);
+		Bytes bandPixels(src.begin(), src.end());
+		const auto bandLines = lineData.subspan(y0, rows);
+
+		// Each band picks between filtered and unfiltered on its own, filtering its first line against a blank one
+		auto compressedUnfiltered = Compression::lz4Compress(bandPixels.byte_span(), options);
+		encodeLines(Vector2i(width, rows), bandLines, bandPixels, bpp);
+		auto compressedFiltered = Compression::lz4Compress(bandPixels.byte_span(), options);
+		if (compressedUnfiltered.size() < compressedFiltered.size()) {
+			memset(bandLines.data(), 0, bandLines.size());
+			chunks[band + 1] = std::move(compressedUnfiltered);
+		} else {
+			chunks[band + 1] = std::move(compressedFiltered);
+		}
+	});
+	chunks[0] = Compression::lz4Compress(prefix.byte_span(), options);
+
+	const size_t tableSize = (numBands + 3) * sizeof(uint32_t);
+	size_t totalSize = tableSize;
+	for (const auto& chunk: chunks) {
+		totalSize += chunk.size();
+	}
+	header.compressedSize = static_cast<uint32_t>(totalSize);
+
+	Bytes finalData(sizeof(header) + totalSize);
+	memcpy(finalData.data(), &header, sizeof(header));
+	auto* table = finalData.data() + sizeof(header);
+	const std::array<uint32_t, 2> bandInfo = { static_cast<uint32_t>(bandHeight), static_cast<uint32_t>(numBands) };
+	memcpy(table, bandInfo.data(), sizeof(bandInfo));
+	size_t pos = sizeof(header) + tableSize;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		const auto chunkSize = static_cast<uint32_t>(chunks[i].size());
+		memcpy(table + sizeof(bandInfo) + i * sizeof(uint32_t), &chunkSize, sizeof(chunkSize));
+		memcpy(finalData.data() + pos, chunks[i].data(), chunks[i].size());
+		pos += chunks[i].size();
+	}
+	return finalData;
+}
+
+void HLIFFile::decodeBands(Image& dst, const Header& header, gsl::span<const gsl::byte> data, int bpp)
+{
+	const int width = header.width;
+	const int height = header.height;
+	const size_t stride = static_cast<size_t>(width) * bpp;
+
+	std::array<uint32_t, 2> bandInfo;
+	if (data.size() < sizeof(bandInfo)) {
+		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+	}
+	memcpy(bandInfo.data(), data.data(), sizeof(bandInfo));
+	const int bandHeight = static_cast<int>(bandInfo[0]);
+	const size_t numBands = bandInfo[1];
+	const size_t tableSize = (numBands + 3) * sizeof(uint32_t);
+	if (bandHeight <= 0 || numBands != static_cast<size_t>((height + bandHeight - 1) / bandHeight) || data.size() < tableSize) {
+		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+	}
+
+	Vector<gsl::span<const gsl::byte>> chunks(numBands + 1);
+	size_t pos = tableSize;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		uint32_t chunkSize;
+		memcpy(&chunkSize, data.data() + sizeof(bandInfo) + i * sizeof(uint32_t), sizeof(chunkSize));
+		if (pos + chunkSize > data.size()) {
+			throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+		}
+		chunks[i] = data.subspan(pos, chunkSize);
+		pos += chunkSize;
+	}
+
+	const size_t paletteSize = header.numPalettes * sizeof(Palette);
+	Bytes prefix;
+	prefix.resize_no_init(paletteSize + height);
+	if (Compression::lz4Decompress(chunks[0], prefix.byte_span()) != prefix.size()) {
+		throw Exception("Error decoding HLIF file.", HalleyExceptions::Utils);
+	}
+	const auto lineData = gsl::span<const uint8_t>(prefix).subspan(paletteSize);
+
+	Vector<Palette> palettes(header.numPalettes);
+	if (paletteSize > 0) {
+		memcpy(palettes.data(), prefix.data(), paletteSize);
+		deltaDecodePalettes(palettes);
+	}
+
+	forEachBand(numBands, [&] (size_t band)
+	{
+		const int y0 = static_cast<int>(band) * bandHeight;
+		const int rows = std::min(bandHeight, height - y0);
+		const size_t bandSize = rows * stride;
+
+		// Unpaletted bands decompress straight into the image
+		Bytes palettedPixels;
+		gsl::span<uint8_t> bandPixels;
+		if (palettes.empty()) {
+			bandPixels = dst.getPixelBytes().subspan(y0 * stride, bandSize);
+		} else {
+			palettedPixels.resize_no_init(bandSize);
+			bandPixels = palettedPixels;
+		}
+
+		if (Compression::lz4Decompress(chunks[band + 1], gsl::as_writable_bytes(bandPixels)) != bandSize) {
+			throw Exception("Error decoding HLIF file.", HalleyExceptions::Utils);
+		}
+		decodeLines(Vector2i(width, rows), lineData.subspan(y0, rows), bandPixels, bpp);
+
+		if (!palettes.empty()) {
+			const size_t firstPixel = static_cast<size_t>(y0) * width;
+			applyPalettes(bandPixels, palettes, dst.getPixels4BPP().subspan(firstPixel, static_cast<size_t>(rows) * width), firstPixel);
+		}
+	});
 }
 
 bool HLIFFile::isHLIF(gsl::span<const gsl::byte> bytes)
@@ -329,6 +566,24 @@ int HLIFFile::getBPP(Format format)
 	return format == Format::RGBA ? 4 : 1;
 }
 
+std::optional<TextureFormat> HLIFFile::getBlockFormat(Format format)
+{
+	switch (format) {
+	case Format::BC1:
+		return TextureFormat::BC1;
+	case Format::BC3:
+		return TextureFormat::BC3;
+	case Format::BC7:
+		return TextureFormat::BC7;
+	case Format::ETC2:
+		return TextureFormat::ETC2;
+	case Format::ETC2Alpha:
+		return TextureFormat::ETC2Alpha;
+	default:
+		return std::nullopt;
+	}
+}
+
 std::optional<std::pair<Vector<HLIFFile::Palette>, Bytes>> HLIFFile::makePalettes(gsl::span<const int> pixels, std::string_view name)
 {
 	HashMap<int, uint8_t> paletteEntries;
@@ -418,15 +673,17 @@ void HLIFFile::optimizePalettes(gsl::span<Palette> palettes, gsl::span<uint8_t>
 	}
 }
 
-void HLIFFile::applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst)
+void HLIFFile::applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst, size_t firstPixel)
 {
 	assert(palettedImage.size() == dst.size());
 
+	// Palette ranges are in whole image pixels, and this might only be covering part of the image, starting at firstPixel
+	const size_t lastPixel = firstPixel + dst.size();
 	size_t startPos = 0;
 	for (const auto& palette: palettes) {
 		const size_t endPos = palette.endPixel;
-		for (size_t i = startPos; i < endPos; ++i) {
-			dst[i] = palette.entries[palettedImage[i]];
+		for (size_t i = std::max(startPos, firstPixel); i < std::min(endPos, lastPixel); ++i) {
+			dst[i - firstPixel] = palette.entries[palettedImage[i - firstPixel]];
 		}
 		startPos = endPos;
 	}
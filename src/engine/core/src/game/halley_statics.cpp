@@ -75,7 +75,8 @@ void HalleyStatics::resume(SystemAPI* system, size_t maxThreads)
 
 	sharedData->cpuThreadPool = std::make_unique<ThreadPool>("CPU", sharedData->executors->getCPU(), maxThreads, makeThread);
 	sharedData->cpuAuxThreadPool = std::make_unique<ThreadPool>("CPUAux", sharedData->executors->getCPUAux(), maxThreads, makeThread);
-	sharedData->diskIOThreadPool = std::make_unique<ThreadPool>("IO", sharedData->executors->getDiskIO(), 1, makeThread);
+	// The I/O pool only does raw reads (decoding happens on the CPU pool), and packs can be read concurrently, so a second thread lets urgent reads start while a large one is in flight
+	sharedData->diskIOThreadPool = std::make_unique<ThreadPool>("IO", sharedData->executors->getDiskIO(), 2, makeThread);
 #endif
 }
 
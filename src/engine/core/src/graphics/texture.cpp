@@ -2,6 +2,7 @@
 #include "halley/api/halley_api.h"
 #include "halley/graphics/texture_descriptor.h"
 #include <halley/file_formats/image.h>
+#include "halley/file_formats/hlif_file.h"
 #include <halley/resources/metadata.h>
 #include "halley/concurrency/concurrent.h"
 #include "halley/support/logger.h"
@@ -159,22 +160,45 @@ std::shared_ptr<Texture> Texture::loadResource(ResourceLoader& loader)
 		return {};
 	}
 
-	std::shared_ptr<Texture> texture = loader.getAPI().video->createTexture(size);
+	// The loading stages only hold weak references, so a texture that is released before it finishes loading skips the remaining work.
+	// Nothing can complete its load once it's gone, so it's marked as failed rather than having its destructor wait for it.
+	std::shared_ptr<Texture> texture(loader.getAPI().video->createTexture(size).release(), [] (Texture* texture)
+	{
+		if (!texture->isLoaded()) {
+			texture->loadingFailed();
+		}
+		delete texture;
+	});
 	texture->setMeta(meta);
 	bool retain = loader.getResources().getOptions().retainPixelData;
+	const auto priority = loader.getExecutionPriority();
+	std::weak_ptr<Texture> weakTexture = texture;
 
-	loader.getAsync(true)
-	.then([texture](std::unique_ptr<ResourceDataStatic> data) -> TextureDescriptorImageData
+	loader.getAsync(true, texture)
+	.then(Executors::getCPU(), priority, [weakTexture](std::unique_ptr<ResourceDataStatic> data) -> std::optional<TextureDescriptorImageData>
 	{
+		const auto texture = weakTexture.lock();
+		if (!texture || !data) {
+			return std::nullopt;
+		}
+
 		auto& meta = texture->getMeta();
-		if (const auto& compression = meta.getString("compression"); compression == "png" || compression == "qoi" || compression == "hlif") {
+		if (meta.hasKey("blockCompression")) {
+			// Already in the GPU's format, so this only needs to undo the LZ4
+			return TextureDescriptorImageData(HLIFFile::decodeBlocks(data->getSpan()));
+		} else if (const auto& compression = meta.getString("compression"); compression == "png" || compression == "qoi" || compression == "hlif") {
 			return TextureDescriptorImageData(std::make_unique<Image>(*data, meta));
 		} else {
 			return TextureDescriptorImageData(data->getSpan());
 		}
 	})
-	.then(Executors::getVideoAux(), [texture, retain](TextureDescriptorImageData img)
+	.then(Executors::getVideoAux(), priority, [weakTexture, retain](std::optional<TextureDescriptorImageData> img)
 	{
+		const auto texture = weakTexture.lock();
+		if (!texture || !img) {
+			return;
+		}
+
 		auto& meta = texture->getMeta();
 
 		const auto imgFormat = fromString<Image::Format>(meta.getString("format", "rgba"));
@@ -205,9 +229,18 @@ std::shared_ptr<Texture> Texture::loadResource(ResourceLoader& loader)
 		descriptor.useMipMap = meta.getBool("mipmap", false);
 		descriptor.addressMode = fromString<TextureAddressMode>(meta.getString("addressMode", "clamp"));
 		descriptor.format = format;
-		descriptor.pixelData = std::move(img);
+		descriptor.pixelData = std::move(*img);
 		descriptor.pixelFormat = compression == "png" || compression == "qoi" || compression == "hlif" ? PixelDataFormat::Image : PixelDataFormat::Precompiled;
 		descriptor.retainPixelData = retain;
+		if (meta.hasKey("blockCompression")) {
+			// GPUs can't render into block compressed textures, so they can't generate mipmaps for them either. The importer turns them off too.
+			if (descriptor.useMipMap) {
+				Logger::logWarning("Mipmaps are not supported on block compressed texture \"" + texture->getAssetId() + "\", disabling them.");
+				descriptor.useMipMap = false;
+			}
+			descriptor.format = fromString<TextureFormat>(meta.getString("blockCompression"));
+			descriptor.pixelFormat = PixelDataFormat::Precompiled;
+		}
 		texture->load(std::move(descriptor));
 	});
 
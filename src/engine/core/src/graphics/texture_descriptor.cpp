@@ -167,10 +167,58 @@ int TextureDescriptor::getBytesPerPixel(TextureFormat format)
 		return 1;
 	case TextureFormat::RGBAFloat16:
 		return 8;
+	case TextureFormat::BC1:
+	case TextureFormat::BC3:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC2:
+	case TextureFormat::ETC2Alpha:
+		// Sampled as RGBA, even though they're stored in blocks
+		return 4;
 	}
 	throw Exception("Unknown image format: " + toString(format), HalleyExceptions::Graphics);
 }
 
+bool TextureDescriptor::isBlockCompressed(TextureFormat format)
+{
+	return getBlockBytes(format) != 0;
+}
+
+int TextureDescriptor::getBlockBytes(TextureFormat format)
+{
+	switch (format) {
+	case TextureFormat::BC1:
+	case TextureFormat::ETC2:
+		return 8;
+	case TextureFormat::BC3:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC2Alpha:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t TextureDescriptor::getImageByteSize(TextureFormat format, Vector2i size)
+{
+	if (const int blockBytes = getBlockBytes(format); blockBytes != 0) {
+		return size_t((size.x + 3) / 4) * size_t((size.y + 3) / 4) * size_t(blockBytes);
+	} else {
+		return size_t(size.x) * size_t(size.y) * size_t(getBytesPerPixel(format));
+	}
+}
+
+size_t TextureDescriptor::getVRamUsage(TextureFormat format, Vector2i size, bool useMipMap)
+{
+	size_t total = getImageByteSize(format, size);
+	if (useMipMap) {
+		while (size.x > 1 || size.y > 1) {
+			size = Vector2i(std::max(size.x / 2, 1), std::max(size.y / 2, 1));
+			total += getImageByteSize(format, size);
+		}
+	}
+	return total;
+}
+
 size_t TextureDescriptor::getMemoryUsage() const
 {
 	return pixelData.getMemoryUsage();
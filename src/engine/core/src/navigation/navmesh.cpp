@@ -131,7 +131,7 @@ std::optional<Navmesh::NodeId> Navmesh::getNodeAt(Vector2f position) const
 	const auto& polyIndices = getPolygonsAt(position, true);
 	
 	for (auto i: polyIndices) {
-		if (polygons[i].isPointInside(position)) {
+		if (isPointInsidePolygon(i, position)) {
 			return i;
 		}
 	}
@@ -143,8 +143,7 @@ std::optional<Navmesh::NodeId> Navmesh::getNodeAt(Vector2f position) const
 		float bestDist = std::numeric_limits<float>::infinity();
 		int bestNode = -1;
 		for (auto i: polyIndices) {
-			const auto p = polygons[i].getClosestPoint(position);
-			const float distSquared = (p - position).squaredLength();
+			const float distSquared = getSquaredDistanceToPolygon(i, position);
 			if (distSquared < bestDist && std::sqrt(distSquared) < maxDistanceToPolygon) {
 				bestDist = distSquared;
 				bestNode = i;
@@ -180,7 +179,7 @@ bool Navmesh::containsPoint(Vector2f position) const
 	const auto& polyIndices = getPolygonsAt(position, false);
 	
 	for (auto i: polyIndices) {
-		if (polygons[i].isPointInside(position)) {
+		if (isPointInsidePolygon(i, position)) {
 			return true;
 		}
 	}
@@ -588,7 +587,7 @@ std::pair<std::optional<Vector2f>, float> Navmesh::findRayCollision(Ray ray, flo
 	std::optional<NodeId> prevPoly;
 	while (distanceLeft > 0) {
 		const auto& poly = polygons.at(curPoly);
-		std::optional<size_t> edgeIdx = poly.getExitEdge(ray);
+		std::optional<size_t> edgeIdx = getPolygonExitEdge(curPoly, ray);
 		if (!edgeIdx) {
 			// Something went wrong
 			return { ray.p, weightedDistance };
@@ -600,7 +599,7 @@ std::pair<std::optional<Vector2f>, float> Navmesh::findRayCollision(Ray ray, flo
 
 			// Try again, from the next edge
 			//edgeIdx = poly.getExitEdge(ray, edgeIdx.value() + 1);
-			edgeIdx = poly.getExitEdge(ray, edgeIdx.value() + 1);
+			edgeIdx = getPolygonExitEdge(curPoly, ray, edgeIdx.value() + 1);
 			if (!edgeIdx) {
 				//Logger::logError("Could not recover from navmesh ping-pong, aborting.");
 				return { ray.p, weightedDistance };
@@ -681,6 +680,7 @@ void Navmesh::setWorldPosition(Vector2f newOffset, Vector2i gridPos)
 		edge.second.b += delta;
 	}
 	origin += delta;
+	packedPolygons = NavmeshPackedPolygons(polygons);
 }
 
 void Navmesh::markPortalConnected(size_t idx)
@@ -697,6 +697,7 @@ void Navmesh::markPortalsDisconnected()
 
 void Navmesh::processPolygons()
 {
+	packedPolygons = NavmeshPackedPolygons(polygons);
 	addPolygonsToGrid();
 	computeArea();
 }
@@ -747,6 +748,21 @@ gsl::span<const Navmesh::NodeId> Navmesh::getPolygonsAt(Vector2f pos, bool allow
 	return polyGrid[x + y * gridSize.x];
 }
 
+bool Navmesh::isPointInsidePolygon(NodeId idx, Vector2f pos) const
+{
+	return packedPolygons.isPacked(idx) ? packedPolygons.isPointInside(idx, pos) : polygons[idx].isPointInside(pos);
+}
+
+float Navmesh::getSquaredDistanceToPolygon(NodeId idx, Vector2f pos) const
+{
+	return packedPolygons.isPacked(idx) ? packedPolygons.getSquaredDistanceTo(idx, pos) : (polygons[idx].getClosestPoint(pos) - pos).squaredLength();
+}
+
+std::optional<size_t> Navmesh::getPolygonExitEdge(NodeId idx, const Ray& ray, size_t startFromEdge) const
+{
+	return packedPolygons.isPacked(idx) ? packedPolygons.getExitEdge(idx, ray, startFromEdge) : polygons[idx].getExitEdge(ray, startFromEdge);
+}
+
 float Navmesh::getArea() const
 {
 	return totalArea;
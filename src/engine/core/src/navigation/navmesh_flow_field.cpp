@@ -0,0 +1,187 @@
+#include "halley/navigation/navmesh_flow_field.h"
+
+#include "halley/concurrency/concurrent.h"
+#include "halley/data_structures/priority_queue.h"
+using namespace Halley;
+
+namespace {
+	// Entries are pushed with the cost they had at the time, so lowering a node's cost never reorders entries already in the heap
+	using OpenEntry = std::pair<float, Navmesh::NodeId>;
+
+	class CostComparator {
+	public:
+		bool operator()(const OpenEntry& a, const OpenEntry& b) const
+		{
+			return a.first > b.first;
+		}
+	};
+}
+
+NavmeshFlowField::NavmeshFlowField(const Navmesh& navmesh, Navmesh::NodeId goal)
+	: goal(goal)
+{
+	const auto& nodes = navmesh.getNodes();
+	const size_t n = nodes.size();
+	Expects(goal < n);
+
+	costToGoal.resize(n, std::numeric_limits<float>::infinity());
+	nextConnection.resize(n, noConnection);
+	nextNode.resize(n, 0);
+	nextWaypoint.resize(n, Vector2f());
+	Vector<bool> closed(n, false);
+
+	auto openSet = PriorityQueue<OpenEntry, CostComparator>(CostComparator());
+	openSet.reserve(std::min(static_cast<size_t>(100), n));
+
+	costToGoal[goal] = 0;
+	openSet.push(OpenEntry(0.0f, goal));
+
+	// Reverse Dijkstra: when a node is settled, relax every node that has a connection leading into it, using that node's own cost
+	while (!openSet.empty()) {
+		const auto [entryCost, curId] = openSet.top();
+		openSet.pop();
+		if (closed[curId] || entryCost > costToGoal[curId]) {
+			// Stale entry, this node was pushed again with a lower cost
+			continue;
+		}
+		closed[curId] = true;
+
+		const float curCost = costToGoal[curId];
+		const auto& curNode = nodes[curId];
+		for (size_t i = 0; i < curNode.nConnections; ++i) {
+			if (!curNode.connections[i]) {
+				continue;
+			}
+			const auto neighId = curNode.connections[i].value();
+			if (closed[neighId]) {
+				continue;
+			}
+
+			const auto& neighNode = nodes[neighId];
+			for (size_t j = 0; j < neighNode.nConnections; ++j) {
+				if (neighNode.connections[j] == curId) {
+					const float cost = curCost + neighNode.costs[j];
+					if (cost < costToGoal[neighId]) {
+						costToGoal[neighId] = cost;
+						nextConnection[neighId] = static_cast<uint8_t>(j);
+						nextNode[neighId] = curId;
+
+						// Duplicate entries are cheaper than PriorityQueue::update's linear search, and the stale ones are skipped when popped
+						openSet.push(OpenEntry(cost, neighId));
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		if (nextConnection[i] != noConnection) {
+			const auto edge = navmesh.getPolygon(static_cast<int>(i)).getEdge(nextConnection[i]);
+			nextWaypoint[i] = 0.5f * (edge.a + edge.b);
+		}
+	}
+}
+
+bool NavmeshFlowField::isReachable(Navmesh::NodeId node) const
+{
+	return node < costToGoal.size() && std::isfinite(costToGoal[node]);
+}
+
+float NavmeshFlowField::getCostToGoal(Navmesh::NodeId node) const
+{
+	return node < costToGoal.size() ? costToGoal[node] : std::numeric_limits<float>::infinity();
+}
+
+std::optional<Navmesh::NodeAndConn> NavmeshFlowField::getNextHop(Navmesh::NodeId node) const
+{
+	if (node >= nextConnection.size() || nextConnection[node] == noConnection) {
+		return {};
+	}
+	return Navmesh::NodeAndConn(node, nextConnection[node]);
+}
+
+std::optional<Navmesh::NodeId> NavmeshFlowField::getNextNode(Navmesh::NodeId node) const
+{
+	if (node >= nextConnection.size() || nextConnection[node] == noConnection) {
+		return {};
+	}
+	return nextNode[node];
+}
+
+std::optional<Vector2f> NavmeshFlowField::getNextWaypoint(Navmesh::NodeId node) const
+{
+	if (node >= nextConnection.size() || nextConnection[node] == noConnection) {
+		return {};
+	}
+	return nextWaypoint[node];
+}
+
+
+NavmeshFlowFieldCache::NavmeshFlowFieldCache(const Navmesh& navmesh, size_t maxEntries)
+	: navmesh(navmesh)
+	, maxEntries(std::max(maxEntries, static_cast<size_t>(1)))
+{
+}
+
+NavmeshFlowFieldCache::~NavmeshFlowFieldCache()
+{
+	waitForPending();
+}
+
+Future<std::shared_ptr<const NavmeshFlowField>> NavmeshFlowFieldCache::request(Navmesh::NodeId goal)
+{
+	const auto iter = entries.find(goal);
+	if (iter != entries.end()) {
+		iter->second.lastUsed = ++useCounter;
+		return iter->second.field;
+	}
+
+	evictIfNeeded();
+
+	auto& entry = entries[goal];
+	entry.lastUsed = ++useCounter;
+	entry.field = Concurrent::execute([&navmesh = navmesh, goal] () -> std::shared_ptr<const NavmeshFlowField>
+	{
+		return std::make_shared<NavmeshFlowField>(navmesh, goal);
+	});
+	return entry.field;
+}
+
+std::shared_ptr<const NavmeshFlowField> NavmeshFlowFieldCache::tryGet(Navmesh::NodeId goal)
+{
+	auto field = request(goal);
+	if (field.isReady()) {
+		return field.get();
+	}
+	return {};
+}
+
+void NavmeshFlowFieldCache::clear()
+{
+	waitForPending();
+	entries.clear();
+}
+
+void NavmeshFlowFieldCache::evictIfNeeded()
+{
+	while (entries.size() >= maxEntries) {
+		// Only evict fields that are done computing, as pending ones still reference the navmesh
+		auto oldest = entries.end();
+		for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+			if (iter->second.field.isReady() && (oldest == entries.end() || iter->second.lastUsed < oldest->second.lastUsed)) {
+				oldest = iter;
+			}
+		}
+		if (oldest == entries.end()) {
+			return;
+		}
+		entries.erase(oldest);
+	}
+}
+
+void NavmeshFlowFieldCache::waitForPending()
+{
+	for (auto& [goal, entry]: entries) {
+		entry.field.wait();
+	}
+}
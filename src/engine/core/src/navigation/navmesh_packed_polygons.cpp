@@ -0,0 +1,156 @@
+#include "halley/navigation/navmesh_packed_polygons.h"
+
+#include "halley/maths/simd.h"
+using namespace Halley;
+
+NavmeshPackedPolygons::NavmeshPackedPolygons(gsl::span<const Polygon> polygons)
+{
+	entries.resize(polygons.size());
+
+	for (size_t i = 0; i < polygons.size(); ++i) {
+		const auto& poly = polygons[i];
+		const auto& vs = poly.getVertices();
+		auto& entry = entries[i];
+
+		const size_t n = vs.size();
+		entry.packed = poly.isConvex() && n >= 3 && n <= MaxSides;
+		if (!entry.packed) {
+			continue;
+		}
+
+		entry.nSides = static_cast<uint8_t>(n);
+		entry.sign = poly.isClockwise() ? 1.0f : -1.0f;
+		entry.circleCentre = poly.getBoundingCircle().getCentre();
+		entry.circleRadiusSq = poly.getBoundingCircle().getRadius() * poly.getBoundingCircle().getRadius();
+		entry.aabb = poly.getAABB();
+
+		for (size_t j = 0; j < MaxSides; ++j) {
+			const size_t edgeIdx = j < n ? j : 0;
+			const auto a = vs[edgeIdx];
+			const auto b = vs[(edgeIdx + 1) % n];
+			const auto e = b - a;
+			const float lenSq = e.squaredLength();
+			entry.ax[j] = a.x;
+			entry.ay[j] = a.y;
+			entry.bx[j] = b.x;
+			entry.by[j] = b.y;
+			entry.ex[j] = e.x;
+			entry.ey[j] = e.y;
+			entry.invLenSq[j] = lenSq > 0.00001f ? 1.0f / lenSq : 0.0f;
+		}
+	}
+}
+
+bool NavmeshPackedPolygons::isPointInside(size_t idx, Vector2f point) const
+{
+	const auto& entry = entries[idx];
+
+	// Same fast fail as Polygon::isPointInside
+	if ((point - entry.circleCentre).squaredLength() > entry.circleRadiusSq) {
+		return false;
+	}
+	if (!entry.aabb.contains(point)) {
+		return false;
+	}
+
+	// Outside if the point is on the outer side of any edge
+#ifdef HAS_SSE
+	const __m128 px = _mm_set1_ps(point.x);
+	const __m128 py = _mm_set1_ps(point.y);
+	const __m128 sign = _mm_set1_ps(entry.sign);
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < entry.nSides; i += 4) {
+		const __m128 ux = _mm_sub_ps(px, _mm_load_ps(&entry.ax[i]));
+		const __m128 uy = _mm_sub_ps(py, _mm_load_ps(&entry.ay[i]));
+		const __m128 cross = _mm_sub_ps(_mm_mul_ps(ux, _mm_load_ps(&entry.ey[i])), _mm_mul_ps(uy, _mm_load_ps(&entry.ex[i])));
+		if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_mul_ps(cross, sign), zero)) != 0) {
+			return false;
+		}
+	}
+#else
+	for (size_t i = 0; i < entry.nSides; ++i) {
+		const float cross = (point.x - entry.ax[i]) * entry.ey[i] - (point.y - entry.ay[i]) * entry.ex[i];
+		if (cross * entry.sign > 0) {
+			return false;
+		}
+	}
+#endif
+
+	return true;
+}
+
+float NavmeshPackedPolygons::getSquaredDistanceTo(size_t idx, Vector2f point) const
+{
+	const auto& entry = entries[idx];
+
+#ifdef HAS_SSE
+	const __m128 px = _mm_set1_ps(point.x);
+	const __m128 py = _mm_set1_ps(point.y);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 best = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	for (size_t i = 0; i < entry.nSides; i += 4) {
+		const __m128 ax = _mm_load_ps(&entry.ax[i]);
+		const __m128 ay = _mm_load_ps(&entry.ay[i]);
+		const __m128 ex = _mm_load_ps(&entry.ex[i]);
+		const __m128 ey = _mm_load_ps(&entry.ey[i]);
+		const __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(px, ax), ex), _mm_mul_ps(_mm_sub_ps(py, ay), ey));
+		const __m128 t = _mm_min_ps(one, _mm_max_ps(zero, _mm_mul_ps(dot, _mm_load_ps(&entry.invLenSq[i]))));
+		const __m128 dx = _mm_sub_ps(_mm_add_ps(ax, _mm_mul_ps(ex, t)), px);
+		const __m128 dy = _mm_sub_ps(_mm_add_ps(ay, _mm_mul_ps(ey, t)), py);
+		best = _mm_min_ps(best, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+	}
+	best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+	best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(best);
+#else
+	float best = std::numeric_limits<float>::infinity();
+	for (size_t i = 0; i < entry.nSides; ++i) {
+		const float dot = (point.x - entry.ax[i]) * entry.ex[i] + (point.y - entry.ay[i]) * entry.ey[i];
+		const float t = clamp(dot * entry.invLenSq[i], 0.0f, 1.0f);
+		const float dx = entry.ax[i] + entry.ex[i] * t - point.x;
+		const float dy = entry.ay[i] + entry.ey[i] * t - point.y;
+		best = std::min(best, dx * dx + dy * dy);
+	}
+	return best;
+#endif
+}
+
+std::optional<size_t> NavmeshPackedPolygons::getExitEdge(size_t idx, const Ray& ray, size_t startFromEdge) const
+{
+	const auto& entry = entries[idx];
+
+	// Same test as Polygon::getExitEdge: look for a on the left and b on the right
+	uint32_t mask = 0;
+#ifdef HAS_SSE
+	const __m128 px = _mm_set1_ps(ray.p.x);
+	const __m128 py = _mm_set1_ps(ray.p.y);
+	const __m128 dirX = _mm_set1_ps(ray.dir.x);
+	const __m128 dirY = _mm_set1_ps(ray.dir.y);
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < entry.nSides; i += 4) {
+		const __m128 ca = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(&entry.ax[i]), px), dirY), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&entry.ay[i]), py), dirX));
+		const __m128 cb = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(&entry.bx[i]), px), dirY), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&entry.by[i]), py), dirX));
+		const __m128 bothZero = _mm_and_ps(_mm_cmpeq_ps(ca, zero), _mm_cmpeq_ps(cb, zero));
+		const __m128 isExit = _mm_andnot_ps(bothZero, _mm_and_ps(_mm_cmpge_ps(ca, zero), _mm_cmple_ps(cb, zero)));
+		mask |= static_cast<uint32_t>(_mm_movemask_ps(isExit)) << i;
+	}
+#else
+	for (size_t i = 0; i < entry.nSides; ++i) {
+		const float ca = (entry.ax[i] - ray.p.x) * ray.dir.y - (entry.ay[i] - ray.p.y) * ray.dir.x;
+		const float cb = (entry.bx[i] - ray.p.x) * ray.dir.y - (entry.by[i] - ray.p.y) * ray.dir.x;
+		if (ca >= 0 && cb <= 0 && (ca != 0 || cb != 0)) {
+			mask |= 1u << i;
+		}
+	}
+#endif
+
+	mask &= (1u << entry.nSides) - 1;
+	mask &= ~((1u << std::min(startFromEdge, MaxSides)) - 1);
+	for (size_t i = 0; i < entry.nSides; ++i) {
+		if (mask & (1u << i)) {
+			return i;
+		}
+	}
+	return {};
+}
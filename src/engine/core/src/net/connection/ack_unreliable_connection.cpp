@@ -41,7 +41,7 @@ AckUnreliableConnection::AckUnreliableConnection(std::shared_ptr<IConnection> pa
 	, receivedSeqs(BUFFER_SIZE)
 	, sentPackets(BUFFER_SIZE)
 {
-	lastSend = lastReceive = Clock::now();
+	lastSend = lastReceive = now();
 }
 
 void AckUnreliableConnection::close()
@@ -76,7 +76,7 @@ bool AckUnreliableConnection::receive(InboundNetworkPacket& packet)
 	try {
 		InboundNetworkPacket tmp;
 		while (parent->receive(tmp)) {
-			lastReceive = Clock::now();
+			lastReceive = now();
 			processReceivedPacket(tmp);
 		}
 	} catch (std::exception& e) {
@@ -99,7 +99,8 @@ Vector<uint16_t> AckUnreliableConnection::sendTagged(gsl::span<const AckUnreliab
 	Vector<uint16_t> result;
 	auto subPacketsLeft = subPackets;
 
-	while (!subPacketsLeft.empty()) {
+	// Always sends at least one packet, so an empty span sends just the acks
+	do {
 		std::array<gsl::byte, 4096> buffer;
 		const auto dst = gsl::span<gsl::byte>(buffer);
 
@@ -116,20 +117,15 @@ Vector<uint16_t> AckUnreliableConnection::sendTagged(gsl::span<const AckUnreliab
 		auto& sent = sentPackets[seq % BUFFER_SIZE];
 		sent = SentPacketData{};
 
-		// Add subpackets
-		bool first = true;
-		while (!subPacketsLeft.empty()) {
+		// Add one subpacket, as re-sends are de-duplicated by the sequence of the packet they were first sent in
+		if (!subPacketsLeft.empty()) {
 			const auto& subPacket = subPacketsLeft.front();
 
 			const size_t sizeNeeded = 2 + (subPacket.resends ? 2 : 0) + subPacket.data.size();
 			const size_t sizeLeft = buffer.size() - s.getPosition();
 			if (sizeNeeded > sizeLeft) {
-				if (first) {
-					throw Exception("Attempting to send packet that's too large for the network: " + String::prettySize(sizeNeeded), HalleyExceptions::Network);
-				}
-				break;
+				throw Exception("Attempting to send packet that's too large for the network: " + String::prettySize(sizeNeeded), HalleyExceptions::Network);
 			}
-			first = false;
 
 			const uint16_t sizeAndResend = static_cast<uint16_t>(subPacket.data.size() << 1) | static_cast<uint16_t>(subPacket.resends ? 1 : 0);
 			s << sizeAndResend;
@@ -151,13 +147,13 @@ Vector<uint16_t> AckUnreliableConnection::sendTagged(gsl::span<const AckUnreliab
 
 		// Mark waiting
 		sent.waiting = true;
-		lastSend = sent.timestamp = Clock::now();
+		lastSend = sent.timestamp = now();
 
 		// Send
 		parent->send(TransmissionType::Unreliable, OutboundNetworkPacket(dst.subspan(0, s.getSize())));
 		notifySend(header.sequence, s.getSize());
 		earliestUnackedMsg = {};
-	}
+	} while (!subPacketsLeft.empty());
 
 	return result;
 }
@@ -166,7 +162,7 @@ void AckUnreliableConnection::sendAckPacketsIfNeeded()
 {
 	if (earliestUnackedMsg) {
 		constexpr float maxAckTime = 0.02f;
-		const float deltaTime = std::chrono::duration<float>(Clock::now() - earliestUnackedMsg.value()).count();
+		const float deltaTime = std::chrono::duration<float>(now() - earliestUnackedMsg.value()).count();
 		if (deltaTime > maxAckTime) {
 			// Send empty
 			sendTagged(gsl::span<AckUnreliableSubPacket>());
@@ -201,16 +197,15 @@ void AckUnreliableConnection::processReceivedPacket(InboundNetworkPacket& packet
 				s >> resendOf;
 			}
 
-			// Extract data
-			std::array<char, 4096> buffer;
-			if (size > buffer.size() || size > s.getBytesLeft()) {
+			// Extract data, as a view into the received packet
+			if (size > s.getBytesLeft()) {
 				throw Exception("Unexpected sub-packet size: " + toString(size) + " bytes, " + toString(s.getBytesLeft()) + " bytes remaining.", HalleyExceptions::Network);
 			}
-			auto subPacketData = gsl::as_writable_bytes(gsl::span<char>(buffer).subspan(0, size));
-			s >> subPacketData;
+			const size_t subPacketStart = s.getPosition();
+			s.skipBytes(size);
 			
 			if (!resend || onSeqReceived(resendOf, true)) {
-				pendingPackets.emplace_back(subPacketData);
+				pendingPackets.emplace_back(packet.subPacket(subPacketStart, size));
 			}
 
 			notifyReceive(seq, size, resend);
@@ -276,7 +271,7 @@ bool AckUnreliableConnection::onSeqReceived(uint16_t seq, bool hasSubPacket)
 		// Mark this packet as received
 		receivedSeqs[bufferPos] = 1;
 		if (hasSubPacket && !earliestUnackedMsg) {
-			earliestUnackedMsg = Clock::now();
+			earliestUnackedMsg = now();
 		}
 
 		return true;
@@ -287,7 +282,7 @@ void AckUnreliableConnection::onAckReceived(uint16_t sequence)
 {
 	auto& data = sentPackets[sequence % BUFFER_SIZE];
 	if (data.waiting) {
-		const float msgLag = std::chrono::duration<float>(Clock::now() - data.timestamp).count();
+		const float msgLag = std::chrono::duration<float>(now() - data.timestamp).count();
 
 		data.waiting = false;
 		for (int tag: data.tags) {
@@ -313,14 +308,26 @@ unsigned int AckUnreliableConnection::generateAckBits()
 	return result;
 }
 
+void AckUnreliableConnection::setTimeSource(TimeSource source)
+{
+	timeSource = std::move(source);
+	lastSend = lastReceive = now();
+	earliestUnackedMsg = {};
+}
+
+AckUnreliableConnection::Clock::time_point AckUnreliableConnection::now() const
+{
+	return timeSource ? timeSource() : Clock::now();
+}
+
 float AckUnreliableConnection::getTimeSinceLastSend() const
 {
-	return std::chrono::duration<float>(Clock::now() - lastSend).count();
+	return std::chrono::duration<float>(now() - lastSend).count();
 }
 
 float AckUnreliableConnection::getTimeSinceLastReceive() const
 {
-	return std::chrono::duration<float>(Clock::now() - lastReceive).count();
+	return std::chrono::duration<float>(now() - lastReceive).count();
 }
 
 void AckUnreliableConnection::setStatsListener(IAckUnreliableConnectionStatsListener* listener)
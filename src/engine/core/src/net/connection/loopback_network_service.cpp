@@ -0,0 +1,238 @@
+#include "halley/net/connection/loopback_network_service.h"
+
+#include "halley/support/exception.h"
+#include "halley/utils/algorithm.h"
+using namespace Halley;
+
+String LoopbackNetwork::listen(LoopbackNetworkService& service)
+{
+	auto address = "loopback:" + toString(nextAddress++);
+	listeners[address] = &service;
+	return address;
+}
+
+void LoopbackNetwork::stopListening(LoopbackNetworkService& service)
+{
+	std_ex::erase_if_value(listeners, [&] (const LoopbackNetworkService* s) { return s == &service; });
+}
+
+LoopbackNetworkService* LoopbackNetwork::getListener(const String& address) const
+{
+	const auto iter = listeners.find(address);
+	return iter != listeners.end() ? iter->second : nullptr;
+}
+
+void LoopbackNetwork::setPacketLoss(float probability, uint32_t seed)
+{
+	packetLoss = probability;
+	lossRng.setSeed(seed);
+}
+
+bool LoopbackNetwork::shouldDropPacket()
+{
+	return packetLoss > 0 && lossRng.getFloat(0.0f, 1.0f) < packetLoss;
+}
+
+
+LoopbackConnection::LoopbackConnection(INetworkServiceStatsListener& stats, std::shared_ptr<LoopbackNetwork> network)
+	: stats(stats)
+	, network(std::move(network))
+{
+}
+
+void LoopbackConnection::close()
+{
+	if (status == ConnectionStatus::Closed) {
+		return;
+	}
+	status = ConnectionStatus::Closed;
+	if (auto r = remote.lock()) {
+		r->onRemoteClosed();
+	}
+	remote.reset();
+}
+
+ConnectionStatus LoopbackConnection::getStatus() const
+{
+	return status;
+}
+
+bool LoopbackConnection::isSupported(TransmissionType type) const
+{
+	return type == TransmissionType::Unreliable;
+}
+
+void LoopbackConnection::send(TransmissionType type, OutboundNetworkPacket packet)
+{
+	Expects(type == TransmissionType::Unreliable);
+
+	// This copy stands in for the wire, the receiving end reads straight from the pooled buffer
+	const size_t size = packet.getSize();
+	auto buffer = network->getBufferPool()->acquire(size);
+	packet.copyTo(gsl::as_writable_bytes(gsl::span<Byte>(buffer.getData())));
+	auto inbound = InboundNetworkPacket(std::move(buffer), size);
+
+	if (status == ConnectionStatus::Connecting) {
+		// Held until the other side accepts, like a handshake would be
+		pendingSend.push_back(std::move(inbound));
+	} else if (status == ConnectionStatus::Connected) {
+		stats.onSendData(size, 1);
+		if (network->shouldDropPacket()) {
+			return;
+		}
+		if (auto r = remote.lock()) {
+			r->deliver(std::move(inbound));
+		}
+	}
+}
+
+bool LoopbackConnection::receive(InboundNetworkPacket& packet)
+{
+	if (pendingReceive.empty()) {
+		return false;
+	}
+
+	packet = std::move(pendingReceive.front());
+	pendingReceive.pop_front();
+	stats.onReceiveData(packet.getSize(), 1);
+	return true;
+}
+
+void LoopbackConnection::connectTo(const std::shared_ptr<LoopbackConnection>& r)
+{
+	remote = r;
+	status = ConnectionStatus::Connected;
+
+	while (!pendingSend.empty()) {
+		auto packet = std::move(pendingSend.front());
+		pendingSend.pop_front();
+		stats.onSendData(packet.getSize(), 1);
+		r->deliver(std::move(packet));
+	}
+}
+
+void LoopbackConnection::onRemoteClosed()
+{
+	status = ConnectionStatus::Closed;
+	remote.reset();
+}
+
+void LoopbackConnection::deliver(InboundNetworkPacket packet)
+{
+	if (status == ConnectionStatus::Connected) {
+		pendingReceive.push_back(std::move(packet));
+	}
+}
+
+
+LoopbackNetworkService::LoopbackNetworkService(std::shared_ptr<LoopbackNetwork> network)
+	: network(std::move(network))
+{
+	Expects(this->network);
+}
+
+LoopbackNetworkService::~LoopbackNetworkService()
+{
+	network->stopListening(*this);
+}
+
+void LoopbackNetworkService::update(Time t)
+{
+	NetworkServiceWithStats::update(t);
+
+	// Connections are accepted on update, same as with real sockets
+	auto pending = std::move(pendingConnections);
+	pendingConnections.clear();
+	for (auto& remote: pending) {
+		auto acceptor = LoopbackAcceptor(*this, remote);
+		if (acceptCallback) {
+			acceptCallback(acceptor);
+		}
+		acceptor.ensureChoiceMade();
+	}
+}
+
+String LoopbackNetworkService::startListening(AcceptCallback callback)
+{
+	acceptCallback = std::move(callback);
+	if (address.isEmpty()) {
+		address = network->listen(*this);
+	}
+	return address;
+}
+
+void LoopbackNetworkService::stopListening()
+{
+	acceptCallback = {};
+	network->stopListening(*this);
+	address = "";
+}
+
+std::shared_ptr<IConnection> LoopbackNetworkService::connect(const String& address)
+{
+	auto conn = std::make_shared<LoopbackConnection>(*this, network);
+	if (auto* listener = network->getListener(address)) {
+		listener->onConnectionRequest(conn);
+	} else {
+		conn->close();
+	}
+	return conn;
+}
+
+void LoopbackNetworkService::onSendData(size_t size, size_t nPackets)
+{
+	NetworkServiceWithStats::onSendData(size, nPackets);
+	totalBytesSent += size;
+	totalPacketsSent += nPackets;
+}
+
+void LoopbackNetworkService::onReceiveData(size_t size, size_t nPackets)
+{
+	NetworkServiceWithStats::onReceiveData(size, nPackets);
+	totalBytesReceived += size;
+	totalPacketsReceived += nPackets;
+}
+
+size_t LoopbackNetworkService::getTotalBytesSent() const
+{
+	return totalBytesSent;
+}
+
+size_t LoopbackNetworkService::getTotalPacketsSent() const
+{
+	return totalPacketsSent;
+}
+
+size_t LoopbackNetworkService::getTotalBytesReceived() const
+{
+	return totalBytesReceived;
+}
+
+size_t LoopbackNetworkService::getTotalPacketsReceived() const
+{
+	return totalPacketsReceived;
+}
+
+void LoopbackNetworkService::onConnectionRequest(std::shared_ptr<LoopbackConnection> remote)
+{
+	pendingConnections.push_back(std::move(remote));
+}
+
+LoopbackNetworkService::LoopbackAcceptor::LoopbackAcceptor(LoopbackNetworkService& service, std::shared_ptr<LoopbackConnection> remote)
+	: service(service)
+	, remote(std::move(remote))
+{
+}
+
+std::shared_ptr<IConnection> LoopbackNetworkService::LoopbackAcceptor::doAccept()
+{
+	auto conn = std::make_shared<LoopbackConnection>(service, service.network);
+	conn->connectTo(remote);
+	remote->connectTo(conn);
+	return conn;
+}
+
+void LoopbackNetworkService::LoopbackAcceptor::doReject()
+{
+	remote->close();
+}
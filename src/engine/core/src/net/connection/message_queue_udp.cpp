@@ -2,9 +2,18 @@
 #include <iostream>
 #include <utility>
 
+#include "halley/utils/utils.h"
+
 #include "halley/support/logger.h"
 using namespace Halley;
 
+namespace {
+	// Set on the channel byte of every fragment but the last one of a message
+	constexpr uint8_t moreFragmentsFlag = 0x80;
+
+	constexpr size_t maxReassembledSize = 16 * 1024 * 1024;
+}
+
 void MessageQueueUDP::Channel::getReadyMessages(Vector<InboundNetworkPacket>& out)
 {
 	if (settings.ordered) {
@@ -18,7 +27,21 @@ void MessageQueueUDP::Channel::getReadyMessages(Vector<InboundNetworkPacket>& ou
 					const uint16_t expected = lastReceivedSeq + 1;
 					if (m.seq == expected) {
 						trying = true;
-						out.push_back(std::move(m.packet));
+						if (m.moreFragments || !fragmentData.empty()) {
+							// Fragments have consecutive sequence numbers, so they come out of here back to back
+							const auto bytes = m.packet.getBytes();
+							if (fragmentData.size() + bytes.size() > maxReassembledSize) {
+								throw Exception("Fragmented message is too large.", HalleyExceptions::Network);
+							}
+							const auto* src = reinterpret_cast<const Byte*>(bytes.data());
+							fragmentData.insert(fragmentData.end(), src, src + bytes.size());
+							if (!m.moreFragments) {
+								out.emplace_back(gsl::as_bytes(gsl::span<const Byte>(fragmentData)));
+								fragmentData.clear();
+							}
+						} else {
+							out.push_back(std::move(m.packet));
+						}
 						if (receiveQueue.size() > 1) {
 							std::swap(receiveQueue[i], receiveQueue[receiveQueue.size() - 1]);
 						}
@@ -72,6 +95,9 @@ MessageQueueUDP::~MessageQueueUDP()
 
 void MessageQueueUDP::setChannel(uint8_t channel, ChannelSettings settings)
 {
+	if (channel >= moreFragmentsFlag) {
+		throw Exception("Invalid channel " + toString(channel), HalleyExceptions::Network);
+	}
 	if (channels.size() <= static_cast<size_t>(channel)) {
 		channels.resize(static_cast<size_t>(channel) + 1);
 	}
@@ -94,7 +120,7 @@ Vector<gsl::byte> MessageQueueUDP::serializeMessages(const Vector<Outbound>& msg
 		const uint8_t channelN = msg.channel;
 		const auto& channel = channels[channelN];
 
-		s << channelN;
+		s << static_cast<uint8_t>(channelN | (msg.moreFragments ? moreFragmentsFlag : 0));
 		if (channel.settings.ordered) {
 			s << msg.seq;
 		}
@@ -120,16 +146,30 @@ void MessageQueueUDP::receiveMessages()
 				uint16_t sequence = 0;
 
 				s >> channelN;
+				const bool moreFragments = (channelN & moreFragmentsFlag) != 0;
+				channelN &= ~moreFragmentsFlag;
 				auto& channel = channels.at(channelN);
 				if (channel.settings.ordered) {
 					s >> sequence;
 				}
+				if (moreFragments && !(channel.settings.reliable && channel.settings.ordered)) {
+					throw Exception("Received fragment on channel " + toString(channelN) + ", which is not reliable and ordered.", HalleyExceptions::Network);
+				}
 
-				Bytes msgData;
-				s >> msgData;
+				// Serialized as a vector, read it as a view into the packet
+				uint32_t size = 0;
+				s >> size;
+				if (size > s.getBytesLeft()) {
+					throw Exception("Message size is larger than its packet.", HalleyExceptions::Network);
+				}
+				const size_t msgStart = s.getPosition();
+				s.skipBytes(size);
 
-				// Read message
-				channel.receiveQueue.emplace_back(Inbound{ InboundNetworkPacket(gsl::as_bytes(gsl::span<const Byte>(msgData))), sequence, channelN });
+				// Drop copies of messages that were already received, they'd never be ready again
+				const bool alreadyReceived = channel.settings.reliable && channel.settings.ordered && static_cast<uint16_t>(sequence - channel.lastReceivedSeq - 1) >= 0x8000;
+				if (!alreadyReceived) {
+					channel.receiveQueue.emplace_back(Inbound{ packet.subPacket(msgStart, size), sequence, channelN, moreFragments });
+				}
 			}
 		}
 	} catch (std::exception& e) {
@@ -160,7 +200,15 @@ void MessageQueueUDP::enqueue(OutboundNetworkPacket packet, uint8_t channelNumbe
 	}
 	auto& channel = channels[channelNumber];
 
-	outboundQueued.emplace_back(Outbound{ std::move(packet), ++channel.lastSentSeq, channelNumber });
+	if (packet.getSize() > maxFragmentSize && channel.settings.reliable && channel.settings.ordered) {
+		const auto bytes = packet.getBytes();
+		for (size_t pos = 0; pos < bytes.size(); pos += maxFragmentSize) {
+			const size_t size = std::min(maxFragmentSize, bytes.size() - pos);
+			outboundQueued.emplace_back(Outbound{ OutboundNetworkPacket(bytes.subspan(pos, size)), ++channel.lastSentSeq, channelNumber, true, pos + size < bytes.size() });
+		}
+	} else {
+		outboundQueued.emplace_back(Outbound{ std::move(packet), ++channel.lastSentSeq, channelNumber });
+	}
 }
 
 void MessageQueueUDP::sendAll()
@@ -168,12 +216,17 @@ void MessageQueueUDP::sendAll()
 	//int firstTag = nextPacketId;
 	Vector<AckUnreliableSubPacket> toSend;
 
+	updateSendBudget();
+
 	// Add packets which need to be re-sent
 	checkReSend(toSend);
+	for (const auto& packet: toSend) {
+		sendBudget -= static_cast<float>(packet.data.size());
+	}
 
 	// Create packets of pending messages
-	while (!outboundQueued.empty()) {
-		toSend.emplace_back(createPacket());
+	while (auto packet = createPacket()) {
+		toSend.push_back(std::move(*packet));
 	}
 
 	// Send and update sequences
@@ -181,7 +234,8 @@ void MessageQueueUDP::sendAll()
 		const auto seqs = connection->sendTagged(toSend);
 		for (size_t i = 0; i < toSend.size(); ++i) {
 			auto& packet = toSend[i];
-			if (packet.tag != -1) {
+			// Re-sends keep the sequence they were first sent with, which is what the other end de-duplicates them by
+			if (packet.tag != -1 && !packet.resends) {
 				pendingPackets[packet.tag].seq = seqs[i];
 			}
 		}
@@ -210,6 +264,26 @@ float MessageQueueUDP::getLatency() const
 	return connection->getLatency();
 }
 
+void MessageQueueUDP::setFragmentBandwidth(size_t bytesPerSecond)
+{
+	fragmentBandwidth = bytesPerSecond;
+}
+
+void MessageQueueUDP::updateSendBudget()
+{
+	// Allow up to 100 ms worth of data in a burst, and don't let a burst of unfragmented messages hold fragments back for longer than that either
+	// Never less than a full packet though, or fragments would never fit at low bandwidths
+	const auto now = connection->now();
+	const float maxBudget = std::max(static_cast<float>(fragmentBandwidth) * 0.1f, static_cast<float>(maxPacketSize));
+	if (lastSendTime) {
+		const float elapsed = std::chrono::duration<float>(now - *lastSendTime).count();
+		sendBudget = clamp(sendBudget + elapsed * static_cast<float>(fragmentBandwidth), -maxBudget, maxBudget);
+	} else {
+		sendBudget = maxBudget;
+	}
+	lastSendTime = now;
+}
+
 void MessageQueueUDP::onPacketAcked(int tag)
 {
 	auto i = pendingPackets.find(tag);
@@ -240,7 +314,7 @@ void MessageQueueUDP::checkReSend(Vector<AckUnreliableSubPacket>& collect)
 		auto& pending = iter->second;
 
 		// Check how long it's been waiting
-		const float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - pending.timeSent).count();
+		const float elapsed = std::chrono::duration<float>(connection->now() - pending.timeSent).count();
 		if (elapsed > 0.01f && elapsed > connection->getLatency() * 1.8f) {
 			// Re-send if it's reliable
 			if (pending.reliable) {
@@ -252,10 +326,10 @@ void MessageQueueUDP::checkReSend(Vector<AckUnreliableSubPacket>& collect)
 	}
 }
 
-AckUnreliableSubPacket MessageQueueUDP::createPacket()
+std::optional<AckUnreliableSubPacket> MessageQueueUDP::createPacket()
 {
 	Vector<Outbound> sentMsgs;
-	const size_t maxSize = 1350;
+	const size_t maxSize = maxPacketSize;
 	size_t size = 0;
 	bool first = true;
 	bool packetReliable = false;
@@ -277,6 +351,11 @@ AckUnreliableSubPacket MessageQueueUDP::createPacket()
 			const size_t headerSize = 8; // Max header size
 			const size_t totalSize = msgSize + headerSize;
 
+			// Fragments wait if they'd go over the bandwidth budget, everything else is sent straight away
+			if (msg.fragment && static_cast<float>(size + totalSize) > sendBudget) {
+				continue;
+			}
+
 			if (size + totalSize <= maxSize || (first && allowMaxSizeViolation)) {
 				if (size > maxSize) {
 					Logger::logWarning("Sending " + toString(size) + " bytes in a message, max is " + toString(maxSize) + " bytes.");
@@ -295,9 +374,10 @@ AckUnreliableSubPacket MessageQueueUDP::createPacket()
 	}
 
 	if (sentMsgs.empty()) {
-		throw Exception("Was not able to fit any messages into packet!", HalleyExceptions::Network);
+		return {};
 	}
 
+	sendBudget -= static_cast<float>(size);
 	return makeTaggedPacket(sentMsgs, size);
 }
 
@@ -312,7 +392,8 @@ AckUnreliableSubPacket MessageQueueUDP::makeTaggedPacket(Vector<Outbound>& msgs,
 	pendingData.msgs = std::move(msgs);
 	pendingData.size = size;
 	pendingData.reliable = reliable;
-	pendingData.timeSent = std::chrono::steady_clock::now();
+	pendingData.seq = resendSeq;
+	pendingData.timeSent = connection->now();
 
 	auto result = AckUnreliableSubPacket(std::move(data));
 	result.tag = tag;
@@ -78,34 +78,203 @@ OutboundNetworkPacket& OutboundNetworkPacket::operator=(OutboundNetworkPacket&&
 	return *this;
 }
 
-InboundNetworkPacket::InboundNetworkPacket()
-	: NetworkPacketBase()
-{}
+InboundNetworkPacket::InboundNetworkPacket() = default;
 
 InboundNetworkPacket::InboundNetworkPacket(InboundNetworkPacket&& other) noexcept
-	: NetworkPacketBase()
+	: buffer(std::move(other.buffer))
+	, dataStart(other.dataStart)
+	, dataEnd(other.dataEnd)
 {
-	data = std::move(other.data);
-	dataStart = other.dataStart;
 	other.dataStart = 0;
+	other.dataEnd = 0;
 }
 
 InboundNetworkPacket::InboundNetworkPacket(gsl::span<const gsl::byte> data)
-	: NetworkPacketBase(data, 0)
+	: buffer(NetworkBufferRef::makeUnpooled(data))
+	, dataStart(0)
+	, dataEnd(data.size_bytes())
 {}
 
+InboundNetworkPacket::InboundNetworkPacket(NetworkBufferRef buf, size_t size)
+	: buffer(std::move(buf))
+	, dataStart(0)
+	, dataEnd(size)
+{
+	Expects(buffer.isValid());
+	Expects(size <= buffer.getData().size());
+}
+
+size_t InboundNetworkPacket::copyTo(gsl::span<gsl::byte> dst) const
+{
+	const auto bytes = getBytes();
+	if (bytes.empty()) {
+		return 0;
+	}
+
+	if (dst.size_bytes() < bytes.size_bytes()) {
+		throw Exception("Destination buffer is too small for network packet.", HalleyExceptions::Network);
+	}
+	memcpy(dst.data(), bytes.data(), bytes.size_bytes());
+	return bytes.size_bytes();
+}
+
+size_t InboundNetworkPacket::getSize() const
+{
+	return dataEnd - dataStart;
+}
+
+gsl::span<const gsl::byte> InboundNetworkPacket::getBytes() const
+{
+	if (!buffer.isValid()) {
+		return {};
+	}
+	return gsl::as_bytes(gsl::span<const Byte>(buffer.getData())).subspan(dataStart, getSize());
+}
+
 void InboundNetworkPacket::extractHeader(gsl::span<gsl::byte> dst)
 {
-	Expects(dst.size_bytes() <= signed(data.size()));
+	Expects(dst.size_bytes() <= getSize());
 
-	memcpy(dst.data(), data.data() + dataStart, dst.size_bytes());
+	memcpy(dst.data(), buffer.getData().data() + dataStart, dst.size_bytes());
 	dataStart += dst.size_bytes();
 }
 
+InboundNetworkPacket InboundNetworkPacket::subPacket(size_t offset, size_t size) const
+{
+	if (offset + size > getSize()) {
+		throw Exception("Sub-packet is out of the bounds of its packet.", HalleyExceptions::Network);
+	}
+
+	InboundNetworkPacket result;
+	result.buffer = buffer;
+	result.dataStart = dataStart + offset;
+	result.dataEnd = result.dataStart + size;
+	return result;
+}
+
 InboundNetworkPacket& InboundNetworkPacket::operator=(InboundNetworkPacket&& other) noexcept
 {
-	data = other.data;
+	buffer = std::move(other.buffer);
 	dataStart = other.dataStart;
+	dataEnd = other.dataEnd;
 	other.dataStart = 0;
+	other.dataEnd = 0;
+	return *this;
+}
+
+
+NetworkBufferRef::NetworkBufferRef(NetworkBuffer* buffer)
+	: buffer(buffer)
+{
+	if (buffer) {
+		++buffer->refCount;
+	}
+}
+
+NetworkBufferRef::NetworkBufferRef(const NetworkBufferRef& other)
+	: NetworkBufferRef(other.buffer)
+{}
+
+NetworkBufferRef::NetworkBufferRef(NetworkBufferRef&& other) noexcept
+	: buffer(other.buffer)
+{
+	other.buffer = nullptr;
+}
+
+NetworkBufferRef::~NetworkBufferRef()
+{
+	release();
+}
+
+NetworkBufferRef& NetworkBufferRef::operator=(const NetworkBufferRef& other)
+{
+	if (buffer != other.buffer) {
+		release();
+		buffer = other.buffer;
+		if (buffer) {
+			++buffer->refCount;
+		}
+	}
+	return *this;
+}
+
+NetworkBufferRef& NetworkBufferRef::operator=(NetworkBufferRef&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		buffer = other.buffer;
+		other.buffer = nullptr;
+	}
 	return *this;
 }
+
+NetworkBufferRef NetworkBufferRef::makeUnpooled(gsl::span<const gsl::byte> data)
+{
+	auto* buffer = new NetworkBuffer();
+	buffer->data.resize_no_init(data.size_bytes());
+	if (!data.empty()) {
+		memcpy(buffer->data.data(), data.data(), data.size_bytes());
+	}
+	return NetworkBufferRef(buffer);
+}
+
+Bytes& NetworkBufferRef::getData() const
+{
+	Expects(buffer);
+	return buffer->data;
+}
+
+void NetworkBufferRef::release()
+{
+	if (buffer && --buffer->refCount == 0) {
+		// Holding the pool here keeps it alive until the buffer is back in it
+		if (auto pool = std::move(buffer->pool)) {
+			pool->recycle(buffer);
+		} else {
+			delete buffer;
+		}
+	}
+	buffer = nullptr;
+}
+
+
+NetworkBufferPool::NetworkBufferPool(size_t maxFreeBuffers)
+	: maxFreeBuffers(maxFreeBuffers)
+{}
+
+NetworkBufferPool::~NetworkBufferPool()
+{
+	for (auto* buffer: freeBuffers) {
+		delete buffer;
+	}
+}
+
+NetworkBufferRef NetworkBufferPool::acquire(size_t size)
+{
+	NetworkBuffer* buffer = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!freeBuffers.empty()) {
+			buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+	}
+	if (!buffer) {
+		buffer = new NetworkBuffer();
+	}
+
+	buffer->data.resize_no_init(size);
+	buffer->pool = shared_from_this();
+	return NetworkBufferRef(buffer);
+}
+
+void NetworkBufferPool::recycle(NetworkBuffer* buffer)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (freeBuffers.size() < maxFreeBuffers) {
+		freeBuffers.push_back(buffer);
+	} else {
+		lock.unlock();
+		delete buffer;
+	}
+}
@@ -0,0 +1,82 @@
+#include "halley/net/entity/entity_network_interest_grid.h"
+
+#include "halley/utils/algorithm.h"
+using namespace Halley;
+
+EntityNetworkInterestGrid::EntityNetworkInterestGrid(float cellSize)
+	: cellSize(cellSize)
+{
+	Expects(cellSize > 0);
+}
+
+void EntityNetworkInterestGrid::clear()
+{
+	// Keep the allocations of cells that were in use, as entities usually stay around the same area between sends
+	std_ex::erase_if_value(cells, [] (const Vector<uint32_t>& cell) { return cell.empty(); });
+	for (auto& [pos, cell]: cells) {
+		cell.clear();
+	}
+	unpositioned.clear();
+	count = 0;
+}
+
+void EntityNetworkInterestGrid::add(uint32_t idx, std::optional<Vector2f> position)
+{
+	if (position) {
+		cells[getCell(*position)].push_back(idx);
+	} else {
+		unpositioned.push_back(idx);
+	}
+	++count;
+}
+
+void EntityNetworkInterestGrid::query(std::optional<Rect4f> area, Vector<uint32_t>& result) const
+{
+	result.clear();
+	result.insert(result.end(), unpositioned.begin(), unpositioned.end());
+
+	if (!area) {
+		for (const auto& [pos, cell]: cells) {
+			result.insert(result.end(), cell.begin(), cell.end());
+		}
+	} else {
+		const auto p0 = getCell(area->getTopLeft());
+		const auto p1 = getCell(area->getBottomRight());
+		const auto nCells = static_cast<int64_t>(p1.x - p0.x + 1) * static_cast<int64_t>(p1.y - p0.y + 1);
+
+		if (nCells > static_cast<int64_t>(cells.size())) {
+			// Area covers more cells than are occupied, cheaper to go through the occupied ones
+			for (const auto& [pos, cell]: cells) {
+				if (pos.x >= p0.x && pos.x <= p1.x && pos.y >= p0.y && pos.y <= p1.y) {
+					result.insert(result.end(), cell.begin(), cell.end());
+				}
+			}
+		} else {
+			for (int y = p0.y; y <= p1.y; ++y) {
+				for (int x = p0.x; x <= p1.x; ++x) {
+					if (const auto iter = cells.find(Vector2i(x, y)); iter != cells.end()) {
+						result.insert(result.end(), iter->second.begin(), iter->second.end());
+					}
+				}
+			}
+		}
+	}
+
+	// Callers rely on the original send order
+	std::sort(result.begin(), result.end());
+}
+
+size_t EntityNetworkInterestGrid::size() const
+{
+	return count;
+}
+
+float EntityNetworkInterestGrid::getCellSize() const
+{
+	return cellSize;
+}
+
+Vector2i EntityNetworkInterestGrid::getCell(Vector2f position) const
+{
+	return Vector2i((position / cellSize).floor());
+}
@@ -3,13 +3,14 @@
 #include <cassert>
 
 #include "halley/bytes/byte_serializer.h"
+#include "halley/support/exception.h"
 
 using namespace Halley;
 
 void EntityNetworkMessageCreate::serialize(Serializer& s) const
 {
 	s << entityId;
-	s << bytes;
+	s << getBytes();
 }
 
 void EntityNetworkMessageCreate::deserialize(Deserializer& s)
@@ -21,7 +22,7 @@ void EntityNetworkMessageCreate::deserialize(Deserializer& s)
 void EntityNetworkMessageUpdate::serialize(Serializer& s) const
 {
 	s << entityId;
-	s << bytes;
+	s << getBytes();
 }
 
 void EntityNetworkMessageUpdate::deserialize(Deserializer& s)
@@ -117,6 +118,62 @@ bool EntityNetworkMessage::needsInitialization() const
 	return message->needsInitialization();
 }
 
+void EntityNetworkMessageSnapshot::serialize(Serializer& s) const
+{
+	s << snapshotId;
+	s << baselineId;
+	s << time;
+
+	s << static_cast<uint32_t>(creates.size());
+	for (const auto& create: creates) {
+		create.serialize(s);
+	}
+	s << static_cast<uint32_t>(updates.size());
+	for (const auto& update: updates) {
+		update.serialize(s);
+	}
+	s << destroys;
+}
+
+void EntityNetworkMessageSnapshot::deserialize(Deserializer& s)
+{
+	s >> snapshotId;
+	s >> baselineId;
+	s >> time;
+
+	uint32_t nCreates = 0;
+	s >> nCreates;
+	if (nCreates > s.getBytesLeft()) {
+		throw Exception("Invalid entity network snapshot.", HalleyExceptions::Network);
+	}
+	creates.resize(nCreates);
+	for (auto& create: creates) {
+		create.deserialize(s);
+	}
+
+	uint32_t nUpdates = 0;
+	s >> nUpdates;
+	if (nUpdates > s.getBytesLeft()) {
+		throw Exception("Invalid entity network snapshot.", HalleyExceptions::Network);
+	}
+	updates.resize(nUpdates);
+	for (auto& update: updates) {
+		update.deserialize(s);
+	}
+
+	s >> destroys;
+}
+
+void EntityNetworkMessageSnapshotAck::serialize(Serializer& s) const
+{
+	s << snapshotId;
+}
+
+void EntityNetworkMessageSnapshotAck::deserialize(Deserializer& s)
+{
+	s >> snapshotId;
+}
+
 void EntityNetworkMessage::serialize(Serializer& s) const
 {
 	s << static_cast<int>(getType());
@@ -154,6 +211,12 @@ void EntityNetworkMessage::deserialize(Deserializer& s)
 	case EntityNetworkHeaderType::KeepAlive:
 		message = std::make_unique<EntityNetworkMessageKeepAlive>();
 		break;
+	case EntityNetworkHeaderType::Snapshot:
+		message = std::make_unique<EntityNetworkMessageSnapshot>();
+		break;
+	case EntityNetworkHeaderType::SnapshotAck:
+		message = std::make_unique<EntityNetworkMessageSnapshotAck>();
+		break;
 	}
 
 	assert(message && message->getType() == type);
@@ -0,0 +1,151 @@
+#include "halley/net/entity/entity_network_quantizer.h"
+
+#include "halley/entity/ecs_reflection.h"
+#include "halley/entity/entity_data_delta.h"
+#include "halley/entity/world_reflection.h"
+using namespace Halley;
+
+namespace {
+	bool canPack(const ConfigNode& node, BitQuantization::Type type)
+	{
+		const auto nodeType = node.getType();
+		if (type == BitQuantization::Type::Float2) {
+			return nodeType == ConfigNodeType::Float2 || nodeType == ConfigNodeType::Int2;
+		} else {
+			return nodeType == ConfigNodeType::Float || nodeType == ConfigNodeType::Int || nodeType == ConfigNodeType::Int64;
+		}
+	}
+}
+
+EntityNetworkQuantizer::EntityNetworkQuantizer(const WorldReflection& reflection)
+{
+	for (const auto& reflector: reflection.getComponentReflectors()) {
+		const auto fields = reflector->getNetworkQuantizedFields();
+		if (!fields.empty()) {
+			components[reflector->getName()] = fields;
+		}
+	}
+}
+
+void EntityNetworkQuantizer::pack(EntityDataDelta& delta)
+{
+	for (auto& [name, node]: delta.getComponentsChanged()) {
+		packComponent(name, node);
+	}
+	for (auto& child: delta.getChildrenAdded()) {
+		pack(child);
+	}
+	for (auto& [uuid, child]: delta.getChildrenChanged()) {
+		pack(child);
+	}
+}
+
+void EntityNetworkQuantizer::unpack(EntityDataDelta& delta) const
+{
+	for (auto& [name, node]: delta.getComponentsChanged()) {
+		unpackComponent(name, node);
+	}
+	for (auto& child: delta.getChildrenAdded()) {
+		unpack(child);
+	}
+	for (auto& [uuid, child]: delta.getChildrenChanged()) {
+		unpack(child);
+	}
+}
+
+bool EntityNetworkQuantizer::isEmpty() const
+{
+	return components.empty();
+}
+
+void EntityNetworkQuantizer::pack(EntityData& data)
+{
+	for (auto& [name, node]: data.getComponents()) {
+		packComponent(name, node);
+	}
+	for (auto& child: data.getChildren()) {
+		pack(child);
+	}
+}
+
+void EntityNetworkQuantizer::unpack(EntityData& data) const
+{
+	for (auto& [name, node]: data.getComponents()) {
+		unpackComponent(name, node);
+	}
+	for (auto& child: data.getChildren()) {
+		unpack(child);
+	}
+}
+
+void EntityNetworkQuantizer::packComponent(const String& componentName, ConfigNode& node)
+{
+	if (node.getType() != ConfigNodeType::Map && node.getType() != ConfigNodeType::DeltaMap) {
+		return;
+	}
+	const auto iter = components.find(componentName);
+	if (iter == components.end()) {
+		return;
+	}
+
+	// One presence bit per field, followed by its value
+	auto s = BitSerializer(scratch);
+	bool any = false;
+	for (const auto& field: iter->second) {
+		const bool present = node.hasKey(field.name) && canPack(node[field.name], field.quantization.type);
+		s.writeBool(present);
+		if (present) {
+			const auto& fieldNode = node[field.name];
+			if (field.quantization.type == BitQuantization::Type::Float2) {
+				const auto v = fieldNode.asVector2f();
+				s.writeQuantized(v.x, field.quantization);
+				s.writeQuantized(v.y, field.quantization);
+			} else if (field.quantization.type == BitQuantization::Type::Int) {
+				s.writeQuantized(static_cast<double>(fieldNode.asInt64()), field.quantization);
+			} else {
+				s.writeQuantized(fieldNode.asFloat(), field.quantization);
+			}
+			node.removeKey(field.name);
+			any = true;
+		}
+	}
+
+	if (any) {
+		node[packedFieldsKey] = ConfigNode(Bytes(scratch));
+	}
+}
+
+void EntityNetworkQuantizer::unpackComponent(const String& componentName, ConfigNode& node) const
+{
+	if ((node.getType() != ConfigNodeType::Map && node.getType() != ConfigNodeType::DeltaMap) || !node.hasKey(packedFieldsKey)) {
+		return;
+	}
+	const auto iter = components.find(componentName);
+	if (iter == components.end()) {
+		throw Exception("Received quantized fields for component " + componentName + ", which has none.", HalleyExceptions::Network);
+	}
+
+	const auto bytes = node[packedFieldsKey].asBytes();
+	node.removeKey(packedFieldsKey);
+
+	auto s = BitDeserializer(gsl::as_bytes(gsl::span<const Byte>(bytes)));
+	for (const auto& field: iter->second) {
+		if (s.readBool()) {
+			auto& fieldNode = node[field.name];
+			if (field.quantization.type == BitQuantization::Type::Float2) {
+				const auto x = static_cast<float>(s.readQuantized(field.quantization));
+				const auto y = static_cast<float>(s.readQuantized(field.quantization));
+				fieldNode = ConfigNode(Vector2f(x, y));
+			} else if (field.quantization.type == BitQuantization::Type::Int) {
+				const auto value = static_cast<int64_t>(s.readQuantized(field.quantization));
+				if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+					fieldNode = ConfigNode(static_cast<int>(value));
+				} else {
+					fieldNode = ConfigNode(value);
+				}
+			} else {
+				fieldNode = ConfigNode(static_cast<float>(s.readQuantized(field.quantization)));
+			}
+		}
+	}
+}
@@ -9,6 +9,50 @@
 
 using namespace Halley;
 
+namespace {
+	// Fields with an enabled interpolator are blended towards the next snapshot, everything else changes when that snapshot is reached
+	bool interpolateEntityData(EntityData& data, const EntityData& to, float alpha, const DataInterpolatorSetRetriever& interpolators)
+	{
+		if (data.getInstanceUUID() != to.getInstanceUUID()) {
+			return false;
+		}
+
+		bool interpolated = false;
+		for (auto& [componentName, component]: data.getComponents()) {
+			const auto toComponent = std::find_if(to.getComponents().begin(), to.getComponents().end(), [&] (const auto& c) { return c.first == componentName; });
+			if (toComponent == to.getComponents().end() || component.getType() != ConfigNodeType::Map || toComponent->second.getType() != ConfigNodeType::Map) {
+				continue;
+			}
+
+			const auto& toFields = toComponent->second.asMap();
+			for (auto& [fieldName, value]: component.asMap()) {
+				const auto* interpolator = interpolators.tryGetInterpolator(data.getInstanceUUID(), componentName, fieldName);
+				const auto toValue = toFields.find(fieldName);
+				if (!interpolator || !interpolator->isEnabled() || toValue == toFields.end() || toValue->second.getType() != value.getType()) {
+					continue;
+				}
+
+				if (value.getType() == ConfigNodeType::Float) {
+					value = ConfigNode(lerp(value.asFloat(), toValue->second.asFloat(), alpha));
+					interpolated = true;
+				} else if (value.getType() == ConfigNodeType::Float2) {
+					value = ConfigNode(lerp(value.asVector2f(), toValue->second.asVector2f(), alpha));
+					interpolated = true;
+				}
+			}
+		}
+
+		for (auto& child: data.getChildren()) {
+			const auto toChild = std::find_if(to.getChildren().begin(), to.getChildren().end(), [&] (const EntityData& c) { return c.getInstanceUUID() == child.getInstanceUUID(); });
+			if (toChild != to.getChildren().end()) {
+				interpolated = interpolateEntityData(child, *toChild, alpha, interpolators) || interpolated;
+			}
+		}
+
+		return interpolated;
+	}
+}
+
 EntityNetworkRemotePeer::EntityNetworkRemotePeer(EntityNetworkSession& parent, NetworkSession::PeerId peerId)
 	: parent(&parent)
 	, peerId(peerId)
@@ -28,16 +72,79 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const EntityNetwork
 	}
 
 	timeSinceSend += t;
+
+	if (parent->getReplicationMode() == EntityNetworkReplicationMode::Snapshots && parent->getSession().getType() == NetworkSessionType::Host) {
+		sendSnapshot(t, entityIds, clientData);
+	} else {
+		// Mark all as not alive
+		for (auto& e: outboundEntities) {
+			e.second.alive = false;
+		}
+
+		Vector<EntityRef> toCreate;
+		Vector<std::pair<EntityRef, OutboundEntity*>> toUpdate;
+
+		Vector<EntityRef> entities;
+		gatherEntitiesToSend(entityIds, clientData, entities);
+		for (auto& entity: entities) {
+			if (const auto iter = outboundEntities.find(entity.getEntityId()); iter == outboundEntities.end()) {
+				parent->setupOutboundInterpolators(entity);
+				toCreate.push_back(entity);
+			} else {
+				iter->second.alive = true;
+				toUpdate.emplace_back(entity, &iter->second);
+			}
+		}
+
+		// Order is important here, we need to first destroy, then update, then create
+		// This is so we don't run into an issue where an entity is moved inside another and we attempt to create/update the new one while the old one is still present
+
+		// Destroy dead entities
+		for (auto& e: outboundEntities) {
+			if (!e.second.alive) {
+				sendDestroyEntity(e.second);
+			}
+		}
+
+		// Update existing entities
+		for (auto& [e, oe] : toUpdate) {
+			sendUpdateEntity(t, *oe, e, clientData);
+		}
+
+		// Create new entities
+		for (auto& e: toCreate) {
+			sendCreateEntity(e);
+		}
+
+		std_ex::erase_if_value(outboundEntities, [](const OutboundEntity& e) { return !e.alive; });
+	}
+
+	if (timeSinceSend > maxSendInterval) {
+		sendKeepAlive();
+	}
 	
-	// Mark all as not alive
-	for (auto& e: outboundEntities) {
-		e.second.alive = false;
+	if (!hasSentData) {
+		hasSentData = true;
+		onFirstDataBatchSent();
 	}
+}
+
+void EntityNetworkRemotePeer::gatherEntitiesToSend(gsl::span<const EntityNetworkUpdateInfo> entityIds, const EntityClientSharedData& clientData, Vector<EntityRef>& result)
+{
+	result.clear();
 
-	Vector<EntityRef> toCreate;
-	Vector<std::pair<EntityRef, OutboundEntity*>> toUpdate;
+	// Only entities near this peer's view are tested, host gets everything
+	if (peerId == 0) {
+		candidates.resize(entityIds.size());
+		for (size_t i = 0; i < entityIds.size(); ++i) {
+			candidates[i] = static_cast<uint32_t>(i);
+		}
+	} else {
+		parent->getInterestCandidates(clientData, candidates);
+	}
 
-	for (auto entry: entityIds) {
+	for (const auto idx: candidates) {
+		const auto& entry = entityIds[idx];
 		if (entry.ownerId == peerId) {
 			// Don't send updates back to the owner
 			continue;
@@ -45,46 +152,185 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const EntityNetwork
 
 		const auto entity = parent->getWorld().getEntity(entry.entityId);
 		if (peerId == 0 || parent->isEntityInView(entity, clientData)) { // Always send to host
-			if (const auto iter = outboundEntities.find(entry.entityId); iter == outboundEntities.end()) {
-				parent->setupOutboundInterpolators(entity);
-				toCreate.push_back(entity);
+			result.push_back(entity);
+		}
+	}
+}
+
+void EntityNetworkRemotePeer::sendSnapshot(Time t, gsl::span<const EntityNetworkUpdateInfo> entityIds, const EntityClientSharedData& clientData)
+{
+	snapshotClock += t;
+	timeSinceSnapshot += t;
+	if (nextSnapshotId != 1 && timeSinceSnapshot < parent->getMinSendInterval()) {
+		return;
+	}
+	timeSinceSnapshot = 0;
+
+	Vector<EntityRef> entities;
+	gatherEntitiesToSend(entityIds, clientData, entities);
+
+	SentSnapshot snapshot;
+	snapshot.id = nextSnapshotId++;
+
+	EntityNetworkMessageSnapshot msg;
+	msg.snapshotId = snapshot.id;
+	msg.baselineId = ackedSnapshot ? ackedSnapshot->id : 0;
+	msg.time = snapshotClock;
+
+	// Snapshots are sent unreliably, so they're capped to fit in one packet, starting from whatever didn't fit in the last one
+	size_t snapshotBytes = 0;
+	std::optional<size_t> firstLeftOut;
+	auto fits = [&] (size_t size)
+	{
+		return snapshotBytes + size + snapshotEntityOverhead <= maxSnapshotBytes;
+	};
+
+	// Entities created by a snapshot that isn't acknowledged yet might already exist on the peer, and leaving them out would destroy them there,
+	// so they're created again by every snapshot until one with them is acknowledged. New entities are only created while there's room for that.
+	Vector<bool> sent(entities.size(), false);
+	for (size_t i = 0; i < entities.size(); ++i) {
+		auto& entity = entities[i];
+		const auto entityId = entity.getEntityId();
+		const auto idIter = snapshotNetworkIds.find(entityId);
+		if (idIter == snapshotNetworkIds.end() || findSnapshotBase(entityId, idIter->second)) {
+			continue;
+		}
+
+		sent[i] = true;
+		auto bytes = parent->getEntityCreateBytes(entity);
+		if (isOversizedForSnapshot(entity, bytes->size())) {
+			continue;
+		}
+		snapshotBytes += bytes->size() + snapshotEntityOverhead;
+		msg.creates.emplace_back(idIter->second, std::move(bytes));
+		snapshot.entities[entityId] = SentSnapshotEntity{ idIter->second, parent->getEntitySnapshot(entity) };
+	}
+
+	const size_t start = entities.empty() ? 0 : snapshotStartIdx % entities.size();
+	for (size_t i = 0; i < entities.size(); ++i) {
+		const size_t idx = (start + i) % entities.size();
+		if (sent[idx]) {
+			continue;
+		}
+		auto& entity = entities[idx];
+		const auto entityId = entity.getEntityId();
+
+		// Deltas are against what the peer is known to have, so lost or late snapshots never need to be re-sent
+		const auto idIter = snapshotNetworkIds.find(entityId);
+		if (idIter == snapshotNetworkIds.end()) {
+			// Entities that don't fit are left out of this snapshot, and will be created by a later one
+			auto bytes = parent->getEntityCreateBytes(entity);
+			if (!fits(bytes->size())) {
+				if (!isOversizedForSnapshot(entity, bytes->size())) {
+					firstLeftOut = firstLeftOut.value_or(idx);
+				}
+				continue;
+			}
+			snapshotBytes += bytes->size() + snapshotEntityOverhead;
+
+			parent->setupOutboundInterpolators(entity);
+			const auto networkId = snapshotNetworkIds.emplace(entityId, assignId()).first->second;
+			msg.creates.emplace_back(networkId, std::move(bytes));
+			snapshot.entities[entityId] = SentSnapshotEntity{ networkId, parent->getEntitySnapshot(entity) };
+			continue;
+		}
+
+		const auto networkId = idIter->second;
+		const auto* base = findSnapshotBase(entityId, networkId);
+		auto data = parent->getEntitySnapshot(entity);
+		if (auto bytes = parent->getEntityUpdateBytes(entity, base->data)) {
+			if (fits(bytes->size())) {
+				snapshotBytes += bytes->size() + snapshotEntityOverhead;
+				msg.updates.emplace_back(networkId, std::move(bytes));
 			} else {
-				iter->second.alive = true;
-				toUpdate.emplace_back(entity, &iter->second);
+				// Stays as the peer has it, and will be updated by a later one
+				data = base->data;
+				if (!isOversizedForSnapshot(entity, bytes->size())) {
+					firstLeftOut = firstLeftOut.value_or(idx);
+				}
 			}
 		}
+		snapshot.entities[entityId] = SentSnapshotEntity{ networkId, std::move(data) };
 	}
+	snapshotStartIdx = firstLeftOut.value_or(0);
 
-	// Order is important here, we need to first destroy, then update, then create
-	// This is so we don't run into an issue where an entity is moved inside another and we attempt to create/update the new one while the old one is still present
+	// Entities that left are reported again if they come back
+	for (auto iter = oversizedSnapshotEntities.begin(); iter != oversizedSnapshotEntities.end(); ) {
+		if (!std_ex::contains_if(entities, [&] (const EntityRef& e) { return e.getEntityId() == *iter; })) {
+			iter = oversizedSnapshotEntities.erase(iter);
+		} else {
+			++iter;
+		}
+	}
 
-	// Destroy dead entities
-	for (auto& e: outboundEntities) {
-		if (!e.second.alive) {
-			sendDestroyEntity(e.second);
+	if (ackedSnapshot) {
+		for (const auto& [entityId, base]: ackedSnapshot->entities) {
+			const auto iter = snapshot.entities.find(entityId);
+			if (iter == snapshot.entities.end() || iter->second.networkId != base.networkId) {
+				msg.destroys.push_back(base.networkId);
+			}
 		}
 	}
 
-	// Update existing entities
-	for (auto& [e, oe] : toUpdate) {
-		sendUpdateEntity(t, *oe, e);
+	// Ids of entities that left can only be reused once the peer has a baseline without them
+	for (auto iter = snapshotNetworkIds.begin(); iter != snapshotNetworkIds.end(); ) {
+		if (!snapshot.entities.contains(iter->first)) {
+			snapshotIdsToFree.emplace_back(snapshot.id, iter->second);
+			iter = snapshotNetworkIds.erase(iter);
+		} else {
+			++iter;
+		}
 	}
 
-	// Create new entities
-	for (auto& e: toCreate) {
-		sendCreateEntity(e);
+	unackedSnapshots.push_back(std::move(snapshot));
+	if (unackedSnapshots.size() > maxUnackedSnapshots) {
+		unackedSnapshots.erase(unackedSnapshots.begin());
 	}
 
-	std_ex::erase_if_value(outboundEntities, [](const OutboundEntity& e) { return !e.alive; });
+	send(std::move(msg), false);
+}
 
-	if (timeSinceSend > maxSendInterval) {
-		sendKeepAlive();
+const EntityNetworkRemotePeer::SentSnapshotEntity* EntityNetworkRemotePeer::findSnapshotBase(EntityId entityId, EntityNetworkId networkId) const
+{
+	if (ackedSnapshot) {
+		const auto iter = ackedSnapshot->entities.find(entityId);
+		if (iter != ackedSnapshot->entities.end() && iter->second.networkId == networkId) {
+			return &iter->second;
+		}
 	}
-	
-	if (!hasSentData) {
-		hasSentData = true;
-		onFirstDataBatchSent();
+	return nullptr;
+}
+
+bool EntityNetworkRemotePeer::isOversizedForSnapshot(EntityRef entity, size_t size)
+{
+	// A snapshot can't be split across packets, so an entity that doesn't fit in one by itself can't be replicated
+	if (size + snapshotEntityOverhead <= maxSnapshotBytes) {
+		return false;
+	}
+	if (oversizedSnapshotEntities.insert(entity.getEntityId()).second) {
+		Logger::logError("Entity \"" + entity.getName() + "\" (" + toString(entity.getInstanceUUID()) + ") needs " + toString(size) + " bytes, which is more than fits in a snapshot ("
+			+ toString(maxSnapshotBytes) + " bytes). It won't be replicated to peer " + toString(static_cast<int>(peerId)) + ".");
 	}
+	return true;
+}
+
+void EntityNetworkRemotePeer::receiveSnapshotAck(const EntityNetworkMessageSnapshotAck& msg)
+{
+	const auto iter = std::find_if(unackedSnapshots.begin(), unackedSnapshots.end(), [&] (const SentSnapshot& snapshot) { return snapshot.id == msg.snapshotId; });
+	if (iter == unackedSnapshots.end()) {
+		// Older than the current baseline, or dropped from the history
+		return;
+	}
+
+	ackedSnapshot = std::move(*iter);
+	unackedSnapshots.erase(unackedSnapshots.begin(), iter + 1);
+
+	for (const auto& [snapshotId, networkId]: snapshotIdsToFree) {
+		if (snapshotId <= msg.snapshotId) {
+			allocatedOutboundIds.erase(networkId);
+		}
+	}
+	std_ex::erase_if(snapshotIdsToFree, [&] (const std::pair<uint32_t, EntityNetworkId>& e) { return e.first <= msg.snapshotId; });
 }
 
 void EntityNetworkRemotePeer::receiveNetworkMessage(NetworkSession::PeerId fromPeerId, EntityNetworkMessage msg)
@@ -97,6 +343,56 @@ void EntityNetworkRemotePeer::receiveNetworkMessage(NetworkSession::PeerId fromP
 		receiveUpdateEntity(msg.getMessage<EntityNetworkMessageUpdate>());
 	} else if (msg.getType() == EntityNetworkHeaderType::Destroy) {
 		receiveDestroyEntity(msg.getMessage<EntityNetworkMessageDestroy>());
+	} else if (msg.getType() == EntityNetworkHeaderType::Snapshot) {
+		receiveSnapshot(msg.getMessage<EntityNetworkMessageSnapshot>());
+	} else if (msg.getType() == EntityNetworkHeaderType::SnapshotAck) {
+		receiveSnapshotAck(msg.getMessage<EntityNetworkMessageSnapshotAck>());
+	}
+}
+
+void EntityNetworkRemotePeer::updateSnapshotPlayback(Time t)
+{
+	if (receivedSnapshots.empty() || !parent->hasWorld()) {
+		return;
+	}
+
+	// Play back snapshots a fixed delay behind the newest one, so there's always a later one to interpolate towards
+	const Time delay = parent->getSnapshotInterpolationDelay();
+	const Time target = receivedSnapshots.back().time - delay;
+	const Time next = playbackTime ? *playbackTime + t : target;
+	if (std::abs(next - target) > std::max(delay, parent->getMinSendInterval())) {
+		// Just started, or fell too far behind or ahead (e.g. after a stall), so jump straight to the target
+		playbackTime = target;
+	} else {
+		// Drift towards the target, so the buffer stays about the same length
+		playbackTime = next + (target - next) * 0.05;
+	}
+
+	// Interpolate from the newest snapshot that's due towards the one after it
+	const ReceivedSnapshot* from = nullptr;
+	const ReceivedSnapshot* to = nullptr;
+	for (const auto& snapshot: receivedSnapshots) {
+		if (snapshot.id < lastAppliedSnapshot) {
+			continue;
+		}
+		if (snapshot.time <= *playbackTime) {
+			from = &snapshot;
+		} else {
+			to = &snapshot;
+			break;
+		}
+	}
+	if (!from) {
+		return;
+	}
+
+	// Skip straight to the newest snapshot that's due, applySnapshot() works out the changes from what's in the world
+	if (from->id != lastAppliedSnapshot) {
+		applySnapshot(*from);
+		lastAppliedSnapshot = from->id;
+	}
+	if (to && to->time > from->time) {
+		interpolateSnapshot(*from, *to, static_cast<float>((*playbackTime - from->time) / (to->time - from->time)));
 	}
 }
 
@@ -138,39 +434,29 @@ void EntityNetworkRemotePeer::sendCreateEntity(EntityRef entity)
 	OutboundEntity result;
 
 	result.networkId = assignId();
-	result.data = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
+	result.data = parent->getEntitySnapshot(entity);
 
-	auto deltaData = parent->getFactory().entityDataToPrefabDelta(result.data, entity.getPrefab(), parent->getEntityDeltaOptions());
-	auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
-	//Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + EntityData(deltaData).toYAML() + "\n");
-	Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B)");
+	auto bytes = parent->getEntityCreateBytes(entity);
+	Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes->size()) + " B)");
 
 	send(EntityNetworkMessageCreate(result.networkId, std::move(bytes)));
 	
 	outboundEntities[entity.getEntityId()] = std::move(result);
 }
 
-void EntityNetworkRemotePeer::sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity)
+void EntityNetworkRemotePeer::sendUpdateEntity(Time t, OutboundEntity& remote, EntityRef entity, const EntityClientSharedData& clientData)
 {
-	remote.timeSinceSend += t;
+	// Lower priority entities accumulate time slower, so they get sent less often
+	remote.timeSinceSend += peerId == 0 ? t : t * parent->getEntityUpdatePriority(entity, clientData);
 	if (remote.timeSinceSend < parent->getMinSendInterval()) {
 		return;
 	}
 
-	// Encode delta using interpolators
-	auto newData = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
-	auto retriever = DataInterpolatorSetRetriever(entity, true);
-	auto options = parent->getEntityDeltaOptions();
-	options.interpolatorSet = &retriever;
-	auto deltaData = EntityDataDelta(remote.data, newData, options);
-	
-	if (deltaData.hasChange()) {
-		remote.data = std::move(newData);
+	if (auto bytes = parent->getEntityUpdateBytes(entity, remote.data)) {
+		remote.data = parent->getEntitySnapshot(entity);
 		remote.timeSinceSend = 0;
 
-		auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
-		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + deltaData.toYAML() + "\n");
-		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B)");
+		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes->size()) + " B)");
 		
 		send(EntityNetworkMessageUpdate(remote.networkId, std::move(bytes)));
 	}
@@ -190,9 +476,9 @@ void EntityNetworkRemotePeer::sendKeepAlive()
 	send(EntityNetworkMessageKeepAlive());
 }
 
-void EntityNetworkRemotePeer::send(EntityNetworkMessage message)
+void EntityNetworkRemotePeer::send(EntityNetworkMessage message, bool reliable)
 {
-	parent->sendToPeer(std::move(message), peerId);
+	parent->sendToPeer(std::move(message), peerId, reliable);
 	timeSinceSend = 0;
 }
 
@@ -204,13 +490,145 @@ void EntityNetworkRemotePeer::receiveCreateEntity(const EntityNetworkMessageCrea
 		return;
 	}
 
-	const auto delta = Deserializer::fromBytes<EntityDataDelta>(msg.bytes, parent->getByteSerializationOptions());
+	createRemoteEntity(msg.entityId, parent->deserializeEntityDelta(msg.bytes));
+}
+
+void EntityNetworkRemotePeer::receiveUpdateEntity(const EntityNetworkMessageUpdate& msg)
+{
+	const auto iter = inboundEntities.find(msg.entityId);
+	if (iter == inboundEntities.end()) {
+		Logger::logWarning("Entity with network id " + toString(static_cast<int>(msg.entityId)) + " not found from peer " + toString(static_cast<int>(peerId)));
+		return;
+	}
+
+	updateRemoteEntity(msg.entityId, iter->second, parent->deserializeEntityDelta(msg.bytes));
+}
+
+void EntityNetworkRemotePeer::receiveDestroyEntity(const EntityNetworkMessageDestroy& msg)
+{
+	const auto iter = inboundEntities.find(msg.entityId);
+	if (iter == inboundEntities.end()) {
+		Logger::logWarning("Entity with network id " + toString(static_cast<int>(msg.entityId)) + " not found from peer " + toString(static_cast<int>(peerId)));
+		return;
+	}
+	auto& remote = iter->second;
+
+	//const auto entityRef = parent->getWorld().getEntity(remote.worldId);
+	//Logger::logDev("Destroying from network: " + entityRef.getName() + " UUID " + toString(entityRef.getInstanceUUID()) + " NetworkEntityId (" + toString(static_cast<int>(msg.entityId)) + ") and EntityId(" + toString(remote.worldId) + ")");
+
+	destroyRemoteEntity(remote.worldId);
+
+	inboundEntities.erase(msg.entityId);
+}
+
+void EntityNetworkRemotePeer::receiveSnapshot(EntityNetworkMessageSnapshot& msg)
+{
+	// Snapshots can arrive out of order. Ones that are too late to be played back aren't acknowledged, so the host won't use them as a baseline.
+	if (msg.snapshotId <= lastAppliedSnapshot || std_ex::contains_if(receivedSnapshots, [&] (const ReceivedSnapshot& s) { return s.id == msg.snapshotId; })) {
+		return;
+	}
+
+	// Rebuild the full snapshot from the baseline it was encoded against
+	ReceivedSnapshot snapshot;
+	snapshot.id = msg.snapshotId;
+	snapshot.time = msg.time;
+	if (msg.baselineId != 0) {
+		const auto base = std::find_if(receivedSnapshots.begin(), receivedSnapshots.end(), [&] (const ReceivedSnapshot& s) { return s.id == msg.baselineId; });
+		if (base == receivedSnapshots.end()) {
+			// Can happen if it arrived after a later snapshot, whose baseline replaced this one's
+			Logger::logWarning("Snapshot " + toString(msg.snapshotId) + " from peer " + toString(static_cast<int>(peerId)) + " is based on unknown snapshot " + toString(msg.baselineId));
+			return;
+		}
+		snapshot.entities = base->entities;
+	}
+
+	for (const auto id: msg.destroys) {
+		snapshot.entities.erase(id);
+	}
+
+	for (const auto& update: msg.updates) {
+		const auto iter = snapshot.entities.find(update.entityId);
+		if (iter == snapshot.entities.end()) {
+			Logger::logWarning("Entity with network id " + toString(static_cast<int>(update.entityId)) + " not found in snapshot from peer " + toString(static_cast<int>(peerId)));
+			continue;
+		}
+		auto data = std::make_shared<EntityData>(*iter->second.data);
+		data->applyDelta(parent->deserializeEntityDelta(update.getBytes()));
+		iter->second.data = std::move(data);
+	}
 
+	for (const auto& create: msg.creates) {
+		const auto delta = parent->deserializeEntityDelta(create.getBytes());
+		auto [entityData, prefab, prefabUUID] = parent->getFactory().prefabDeltaToEntityData(delta, *delta.getInstanceUUID());
+		snapshot.entities[create.entityId] = ReceivedSnapshotEntity{ std::make_shared<EntityData>(std::move(entityData)), std::move(prefab) };
+	}
+
+	// The host only encodes against this baseline or later ones from now on, and the last applied snapshot is kept to interpolate from
+	const auto snapshotId = snapshot.id;
+	receivedSnapshots.insert(std::find_if(receivedSnapshots.begin(), receivedSnapshots.end(), [&] (const ReceivedSnapshot& s) { return s.id > snapshotId; }), std::move(snapshot));
+	std_ex::erase_if(receivedSnapshots, [&] (const ReceivedSnapshot& s) { return s.id < msg.baselineId && s.id < lastAppliedSnapshot; });
+
+	send(EntityNetworkMessageSnapshotAck(msg.snapshotId), false);
+}
+
+void EntityNetworkRemotePeer::applySnapshot(const ReceivedSnapshot& snapshot)
+{
+	// Destroy entities that are gone, or whose network id now belongs to a different entity
+	Vector<EntityNetworkId> toDestroy;
+	for (const auto& [id, remote]: inboundEntities) {
+		const auto iter = snapshot.entities.find(id);
+		if (iter == snapshot.entities.end() || iter->second.data->getInstanceUUID() != remote.data.getInstanceUUID()) {
+			toDestroy.push_back(id);
+		}
+	}
+	for (const auto id: toDestroy) {
+		destroyRemoteEntity(inboundEntities.at(id).worldId);
+		inboundEntities.erase(id);
+	}
+
+	for (const auto& [id, state]: snapshot.entities) {
+		if (const auto iter = inboundEntities.find(id); iter == inboundEntities.end()) {
+			const auto delta = parent->getFactory().entityDataToPrefabDelta(*state.data, state.prefab, parent->getEntityDeltaOptions());
+			createRemoteEntity(id, delta).snapshotData = state.data;
+		} else if (iter->second.snapshotData != state.data) {
+			// Interpolation between snapshots is done by interpolateSnapshot(), so the entity's interpolators are bypassed
+			updateRemoteEntity(id, iter->second, EntityDataDelta(iter->second.data, *state.data, parent->getEntityDeltaOptions()), false);
+			iter->second.snapshotData = state.data;
+		}
+	}
+}
+
+void EntityNetworkRemotePeer::interpolateSnapshot(const ReceivedSnapshot& from, const ReceivedSnapshot& to, float alpha)
+{
+	for (const auto& [id, state]: from.entities) {
+		const auto toIter = to.entities.find(id);
+		const auto remoteIter = inboundEntities.find(id);
+		if (toIter == to.entities.end() || toIter->second.data == state.data || remoteIter == inboundEntities.end()) {
+			continue;
+		}
+		auto entity = parent->getWorld().tryGetEntity(remoteIter->second.worldId);
+		if (!entity.isValid()) {
+			continue;
+		}
+
+		auto data = *state.data;
+		if (interpolateEntityData(data, *toIter->second.data, alpha, DataInterpolatorSetRetriever(entity, true))) {
+			const auto delta = EntityDataDelta(remoteIter->second.data, data, parent->getEntityDeltaOptions());
+			if (delta.hasChange()) {
+				updateRemoteEntity(id, remoteIter->second, delta, false);
+			}
+			remoteIter->second.snapshotData = {};
+		}
+	}
+}
+
+EntityNetworkRemotePeer::InboundEntity& EntityNetworkRemotePeer::createRemoteEntity(EntityNetworkId id, const EntityDataDelta& delta)
+{
 	auto [entityData, prefab, prefabUUID] = parent->getFactory().prefabDeltaToEntityData(delta, *delta.getInstanceUUID());
 	auto [entity, parentUUID] = parent->getFactory().loadEntityDelta(delta, delta.getInstanceUUID(), EntitySerialization::makeMask(EntitySerialization::Type::SaveData, EntitySerialization::Type::Prefab, EntitySerialization::Type::Network));
 	stripNestedNetworkComponents(entity);
-	//Logger::logDev("Created entity " + entity.getName() + " with EntityNetworkId (" + toString(msg.entityId) + ") and EntityId (" + toString(entity.getEntityId()) + ") from network:\n\n" + EntityData(delta).toYAML());
-	//Logger::logDev("Created entity " + entity.getName() + " with EntityNetworkId (" + toString(msg.entityId) + ") and EntityId (" + toString(entity.getEntityId()) + ") Instance UUID " + toString(entity.getInstanceUUID()));
+	//Logger::logDev("Created entity " + entity.getName() + " with EntityNetworkId (" + toString(id) + ") and EntityId (" + toString(entity.getEntityId()) + ") from network:\n\n" + EntityData(delta).toYAML());
+	//Logger::logDev("Created entity " + entity.getName() + " with EntityNetworkId (" + toString(id) + ") and EntityId (" + toString(entity.getEntityId()) + ") Instance UUID " + toString(entity.getInstanceUUID()));
 	//if (entity.getParent().isValid()) {
 	//	Logger::logDev("with parent " + entity.getParent().getName());
 	//}
@@ -226,38 +644,29 @@ void EntityNetworkRemotePeer::receiveCreateEntity(const EntityNetworkMessageCrea
 	InboundEntity remote;
 	remote.data = std::move(entityData);
 	remote.worldId = entity.getEntityId();
-	inboundEntities[msg.entityId] = std::move(remote);
+	inboundEntities[id] = std::move(remote);
 
 	auto& interpolatorSet = entity.setupNetwork(peerId);
 	parent->onRemoteEntityCreated(entity, peerId);
 	parent->requestSetupInterpolators(interpolatorSet, entity, true);
+
+	return inboundEntities.at(id);
 }
 
-void EntityNetworkRemotePeer::receiveUpdateEntity(const EntityNetworkMessageUpdate& msg)
+void EntityNetworkRemotePeer::updateRemoteEntity(EntityNetworkId id, InboundEntity& remote, const EntityDataDelta& delta, bool useInterpolators)
 {
-	const auto iter = inboundEntities.find(msg.entityId);
-	if (iter == inboundEntities.end()) {
-		Logger::logWarning("Entity with network id " + toString(static_cast<int>(msg.entityId)) + " not found from peer " + toString(static_cast<int>(peerId)));
-		return;
-	}
-	auto& remote = iter->second;
-
 	auto entity = parent->getWorld().tryGetEntity(remote.worldId);
 	if (!entity.isValid()) {
-		Logger::logWarning("Entity with network id (" + toString(static_cast<int>(msg.entityId)) + ") and EntityId (" + toString(remote.worldId) + ") not alive in the world from peer " + toString(static_cast<int>(peerId)));
-		const auto delta = Deserializer::fromBytes<EntityDataDelta>(msg.bytes, parent->getByteSerializationOptions());
+		Logger::logWarning("Entity with network id (" + toString(static_cast<int>(id)) + ") and EntityId (" + toString(remote.worldId) + ") not alive in the world from peer " + toString(static_cast<int>(peerId)));
 		Logger::logWarning("Caused by trying to update entity:\n" + delta.toYAML());
 		return;
 	}
-	
-	const auto delta = Deserializer::fromBytes<EntityDataDelta>(msg.bytes, parent->getByteSerializationOptions());
 
 	auto retriever = DataInterpolatorSetRetriever(entity, false);
-	//Logger::logDev("Receive Update " + entity.getName() + " (" + toString(msg.bytes.size()) + " B)");
 	//Logger::logDev("Updating entity " + entity.getName() + ":\n" + delta.toYAML());
 
 	try {
-		parent->getFactory().updateEntity(entity, delta, EntitySerialization::makeMask(EntitySerialization::Type::Network), nullptr, &retriever);
+		parent->getFactory().updateEntity(entity, delta, EntitySerialization::makeMask(EntitySerialization::Type::Network), nullptr, useInterpolators ? &retriever : nullptr);
 		stripNestedNetworkComponents(entity);
 	} catch (const std::exception& e) {
 		Logger::logError("Exception while processing update entity from network:\n" + delta.toYAML());
@@ -266,23 +675,6 @@ void EntityNetworkRemotePeer::receiveUpdateEntity(const EntityNetworkMessageUpda
 	remote.data.applyDelta(delta);
 }
 
-void EntityNetworkRemotePeer::receiveDestroyEntity(const EntityNetworkMessageDestroy& msg)
-{
-	const auto iter = inboundEntities.find(msg.entityId);
-	if (iter == inboundEntities.end()) {
-		Logger::logWarning("Entity with network id " + toString(static_cast<int>(msg.entityId)) + " not found from peer " + toString(static_cast<int>(peerId)));
-		return;
-	}
-	auto& remote = iter->second;
-
-	//const auto entityRef = parent->getWorld().getEntity(remote.worldId);
-	//Logger::logDev("Destroying from network: " + entityRef.getName() + " UUID " + toString(entityRef.getInstanceUUID()) + " NetworkEntityId (" + toString(static_cast<int>(msg.entityId)) + ") and EntityId(" + toString(remote.worldId) + ")");
-
-	destroyRemoteEntity(remote.worldId);
-
-	inboundEntities.erase(msg.entityId);
-}
-
 void EntityNetworkRemotePeer::destroyRemoteEntity(EntityId id)
 {
 	auto entity = parent->getWorld().tryGetEntity(id);
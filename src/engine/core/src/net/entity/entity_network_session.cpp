@@ -4,15 +4,29 @@
 
 #include "halley/bytes/compression.h"
 #include "halley/entity/data_interpolator.h"
+#include "halley/entity/components/transform_2d_component.h"
 #include "halley/entity/entity_factory.h"
 #include "halley/entity/system.h"
 #include "halley/entity/world.h"
 #include "halley/support/logger.h"
+#include "halley/utils/hash.h"
 #include "halley/utils/algorithm.h"
 
 class NetworkComponent;
 using namespace Halley;
 
+namespace {
+	// First byte of every packet sent by EntityNetworkSession
+	enum class EntityNetworkPacketEncoding : uint8_t {
+		Deflate,
+		LZ4StreamStart, // Resets the receiver's stream from this peer back to the dictionary
+		LZ4Stream,
+		LZ4Block // Only references the dictionary, and leaves the stream alone
+	};
+
+	constexpr size_t maxPacketSize = 256 * 1024;
+}
+
 EntityNetworkSession::EntityNetworkSession(std::shared_ptr<NetworkSession> session, Resources& resources, std::set<String> ignoreComponents, IEntityNetworkSessionListener* listener)
 	: resources(resources)
 	, listener(listener)
@@ -46,6 +60,7 @@ void EntityNetworkSession::setWorld(World& world, SystemMessageBridge bridge)
 {
 	factory = std::make_shared<EntityFactory>(world, resources);
 	factory->setNetworkFactory(true);
+	quantizer = EntityNetworkQuantizer(world.getReflection());
 	messageBridge = bridge;
 
 	// Clear queue
@@ -68,11 +83,29 @@ void EntityNetworkSession::sendUpdates(Time t, Rect4i viewRect, gsl::span<const
 			data.markModified();
 		}
 	}
+	if (data.compressionDictionaryHash != compressionDictionaryHash) {
+		data.compressionDictionaryHash = compressionDictionaryHash;
+		data.markModified();
+	}
 
 	// Update entities
+	++snapshotUpdate;
+	updateInterestGrid(entityIds);
 	for (auto& peer: peers) {
+		peer.updateSnapshotPlayback(t);
 		peer.sendEntities(t, entityIds, session->getClientSharedData<EntityClientSharedData>(peer.getPeerId()));
 	}
+	if (replicationMode == EntityNetworkReplicationMode::Snapshots) {
+		// Snapshots aren't taken on every update, so keep the cache of anything still networked, otherwise its next delta can't be shared
+		HashSet<EntityId> networked;
+		networked.reserve(entityIds.size());
+		for (const auto& entry: entityIds) {
+			networked.insert(entry.entityId);
+		}
+		std_ex::erase_if_key(entitySnapshots, [&] (const EntityId& id) { return !networked.contains(id); });
+	} else {
+		std_ex::erase_if_value(entitySnapshots, [&] (const EntitySnapshotCache& cache) { return cache.stateUpdate != snapshotUpdate; });
+	}
 
 	sendMessages();
 	session->update(t);
@@ -83,25 +116,159 @@ void EntityNetworkSession::sendToAll(EntityNetworkMessage msg)
 	outbox[-1].push_back(std::move(msg));
 }
 
-void EntityNetworkSession::sendToPeer(EntityNetworkMessage msg, NetworkSession::PeerId peerId)
+void EntityNetworkSession::sendToPeer(EntityNetworkMessage msg, NetworkSession::PeerId peerId, bool reliable)
 {
-	outbox[peerId].push_back(std::move(msg));
+	if (reliable) {
+		outbox[peerId].push_back(std::move(msg));
+	} else {
+		unreliableOutbox[peerId].push_back(std::move(msg));
+	}
 }
 
 void EntityNetworkSession::sendMessages()
 {
 	for (const auto& [peerId, msgs]: outbox) {
-		auto data = Serializer::toBytes(msgs, byteSerializationOptions);
-		auto compressed = Compression::compressRaw(gsl::as_bytes(gsl::span<const Byte>(data)), false);
-		auto packet = OutboundNetworkPacket(std::move(compressed));
+		Serializer::toBytesInto(msgs, sendBuffer, byteSerializationOptions);
+		const auto bytes = gsl::as_bytes(gsl::span<const Byte>(sendBuffer));
+		if (packetCaptureCallback) {
+			packetCaptureCallback(bytes);
+		}
 
 		if (peerId == -1) {
-			session->sendToPeers(std::move(packet));
+			session->sendToPeers(makePacket(bytes, std::nullopt, true));
 		} else {
-			session->sendToPeer(std::move(packet), static_cast<NetworkSession::PeerId>(peerId));
+			const auto dstPeerId = static_cast<NetworkSession::PeerId>(peerId);
+			if (!session->sendToPeer(makePacket(bytes, dstPeerId, true), dstPeerId)) {
+				// The stream already includes this packet, so start over rather than have the next one reference it
+				packetCompressors.erase(dstPeerId);
+			}
 		}
 	}
 	outbox.clear();
+
+	// These can't be part of the stream, as it can't skip packets
+	for (const auto& [peerId, msgs]: unreliableOutbox) {
+		Serializer::toBytesInto(msgs, sendBuffer, byteSerializationOptions);
+		const auto bytes = gsl::as_bytes(gsl::span<const Byte>(sendBuffer));
+		if (packetCaptureCallback) {
+			packetCaptureCallback(bytes);
+		}
+		session->sendToPeer(makePacket(bytes, peerId, false), peerId, false);
+	}
+	unreliableOutbox.clear();
+}
+
+OutboundNetworkPacket EntityNetworkSession::makePacket(gsl::span<const gsl::byte> bytes, std::optional<NetworkSession::PeerId> peerId, bool ordered)
+{
+	Bytes result;
+	if (peerId && bytes.size_bytes() <= LZ4StreamCompressor::getMaxBlockSize() && canUseCompressionDictionary(*peerId)) {
+		// Peers we're directly connected to can keep a stream going across packets that are delivered reliably and in order
+		// Packets relayed via the host start from the dictionary every time, as we won't be told if that peer reconnects
+		const auto directPeers = session->getRemotePeers();
+		const bool direct = std::find(directPeers.begin(), directPeers.end(), *peerId) != directPeers.end();
+
+		auto iter = packetCompressors.find(*peerId);
+		if (iter == packetCompressors.end()) {
+			iter = packetCompressors.emplace(*peerId, LZ4StreamCompressor(compressionDictionary)).first;
+		}
+
+		EntityNetworkPacketEncoding encoding;
+		if (!ordered) {
+			encoding = EntityNetworkPacketEncoding::LZ4Block;
+		} else if (!direct || iter->second.isAtStart()) {
+			encoding = EntityNetworkPacketEncoding::LZ4StreamStart;
+			iter->second.reset();
+		} else {
+			encoding = EntityNetworkPacketEncoding::LZ4Stream;
+		}
+
+		const auto size = static_cast<uint32_t>(bytes.size_bytes());
+		result.resize(1 + sizeof(size));
+		result[0] = static_cast<Byte>(encoding);
+		memcpy(result.data() + 1, &size, sizeof(size));
+		if (encoding == EntityNetworkPacketEncoding::LZ4Block) {
+			iter->second.compressIndependent(bytes, result);
+		} else {
+			iter->second.compress(bytes, result);
+		}
+	} else {
+		result.push_back(static_cast<Byte>(EntityNetworkPacketEncoding::Deflate));
+		const auto compressed = Compression::compressRaw(bytes, false);
+		result.insert(result.end(), compressed.begin(), compressed.end());
+	}
+	return OutboundNetworkPacket(std::move(result));
+}
+
+void EntityNetworkSession::readPacket(NetworkSession::PeerId fromPeerId, gsl::span<const gsl::byte> bytes, Bytes& dst)
+{
+	if (bytes.empty()) {
+		throw Exception("Received empty entity network packet.", HalleyExceptions::Network);
+	}
+
+	const auto encoding = static_cast<EntityNetworkPacketEncoding>(bytes[0]);
+	if (encoding == EntityNetworkPacketEncoding::Deflate) {
+		inflater.decompressRaw(bytes.subspan(1), maxPacketSize, dst);
+		return;
+	}
+
+	if (encoding != EntityNetworkPacketEncoding::LZ4StreamStart && encoding != EntityNetworkPacketEncoding::LZ4Stream && encoding != EntityNetworkPacketEncoding::LZ4Block) {
+		throw Exception("Unknown entity network packet encoding: " + toString(static_cast<int>(encoding)), HalleyExceptions::Network);
+	}
+	if (!compressionDictionary) {
+		throw Exception("Received LZ4 entity network packet, but no compression dictionary is set.", HalleyExceptions::Network);
+	}
+
+	uint32_t size = 0;
+	if (bytes.size_bytes() < 1 + sizeof(size)) {
+		throw Exception("Received truncated entity network packet.", HalleyExceptions::Network);
+	}
+	memcpy(&size, bytes.data() + 1, sizeof(size));
+
+	auto iter = packetDecompressors.find(fromPeerId);
+	if (encoding == EntityNetworkPacketEncoding::LZ4Block) {
+		// Doesn't depend on the stream, so it doesn't matter if it has started
+		if (iter == packetDecompressors.end()) {
+			iter = packetDecompressors.emplace(fromPeerId, LZ4StreamDecompressor(compressionDictionary)).first;
+		}
+		dst.clear();
+		iter->second.decompressIndependent(bytes.subspan(1 + sizeof(size)), size, dst);
+		return;
+	}
+
+	if (encoding == EntityNetworkPacketEncoding::LZ4StreamStart) {
+		if (iter == packetDecompressors.end()) {
+			iter = packetDecompressors.emplace(fromPeerId, LZ4StreamDecompressor(compressionDictionary)).first;
+		} else {
+			iter->second.reset();
+		}
+	} else if (iter == packetDecompressors.end()) {
+		throw Exception("Received LZ4 stream packet from peer " + toString(static_cast<int>(fromPeerId)) + " without the start of the stream.", HalleyExceptions::Network);
+	}
+
+	dst.clear();
+	iter->second.decompress(bytes.subspan(1 + sizeof(size)), size, dst);
+}
+
+bool EntityNetworkSession::canUseCompressionDictionary(NetworkSession::PeerId peerId) const
+{
+	if (!compressionDictionary) {
+		return false;
+	}
+	const auto* data = session->tryGetClientSharedData<EntityClientSharedData>(peerId);
+	return data && data->compressionDictionaryHash == compressionDictionaryHash;
+}
+
+void EntityNetworkSession::setCompressionDictionary(std::shared_ptr<const Bytes> dictionary)
+{
+	compressionDictionary = dictionary && !dictionary->empty() ? std::move(dictionary) : nullptr;
+	compressionDictionaryHash = compressionDictionary ? Hash::hash(*compressionDictionary) : 0;
+	packetCompressors.clear();
+	packetDecompressors.clear();
+}
+
+void EntityNetworkSession::setPacketCaptureCallback(std::function<void(gsl::span<const gsl::byte>)> callback)
+{
+	packetCaptureCallback = std::move(callback);
 }
 
 void EntityNetworkSession::receiveUpdates()
@@ -112,8 +279,8 @@ void EntityNetworkSession::receiveUpdates()
 		const auto fromPeerId = result->first;
 		auto& packet = result->second;
 
-		auto bytes = Compression::decompressRaw(packet.getBytes(), 256 * 1024);
-		auto msgs = Deserializer::fromBytes<Vector<EntityNetworkMessage>>(bytes, byteSerializationOptions);
+		readPacket(fromPeerId, packet.getBytes(), receiveBuffer);
+		auto msgs = Deserializer::fromBytes<Vector<EntityNetworkMessage>>(receiveBuffer, byteSerializationOptions);
 
 		for (auto& msg: msgs) {
 			if (canProcessMessage(msg)) {
@@ -136,6 +303,8 @@ void EntityNetworkSession::processMessage(NetworkSession::PeerId fromPeerId, Ent
 	case EntityNetworkHeaderType::Create:
 	case EntityNetworkHeaderType::Destroy:
 	case EntityNetworkHeaderType::Update:
+	case EntityNetworkHeaderType::Snapshot:
+	case EntityNetworkHeaderType::SnapshotAck:
 		onReceiveEntityUpdate(fromPeerId, std::move(msg));
 		break;
 	case EntityNetworkHeaderType::ReadyToStart:
@@ -260,6 +429,7 @@ void EntityNetworkSession::setupDictionary()
 	serializationDictionary.addEntry("children");
 	serializationDictionary.addEntry("Transform2D");
 	serializationDictionary.addEntry("position");
+	serializationDictionary.addEntry(String(EntityNetworkQuantizer::packedFieldsKey));
 }
 
 World& EntityNetworkSession::getWorld() const
@@ -300,6 +470,89 @@ Time EntityNetworkSession::getMinSendInterval() const
 	return 0.05;
 }
 
+void EntityNetworkSession::setReplicationMode(EntityNetworkReplicationMode mode, Time interpolationDelay)
+{
+	replicationMode = mode;
+	snapshotInterpolationDelay = interpolationDelay;
+}
+
+EntityNetworkReplicationMode EntityNetworkSession::getReplicationMode() const
+{
+	return replicationMode;
+}
+
+Time EntityNetworkSession::getSnapshotInterpolationDelay() const
+{
+	return snapshotInterpolationDelay;
+}
+
+std::shared_ptr<const EntityData> EntityNetworkSession::getEntitySnapshot(EntityRef entity)
+{
+	auto& cache = entitySnapshots[entity.getEntityId()];
+	if (cache.stateUpdate != snapshotUpdate) {
+		cache.stateUpdate = snapshotUpdate;
+
+		// Only do the full serialization if the binary network state of any component changed since the last update
+		auto state = Serializer::toBytes([&] (Serializer& s) { getFactory().serializeEntityState(entity, entitySerializationOptions, s); }, byteSerializationOptions);
+		if (!cache.data || state != cache.state) {
+			cache.state = std::move(state);
+			cache.data = std::make_shared<EntityData>(getFactory().serializeEntity(entity, entitySerializationOptions));
+			cache.createBytes.reset();
+			cache.deltas.clear();
+		}
+	}
+	return cache.data;
+}
+
+std::shared_ptr<const Bytes> EntityNetworkSession::getEntityCreateBytes(EntityRef entity)
+{
+	const auto data = getEntitySnapshot(entity);
+	auto& cache = entitySnapshots[entity.getEntityId()];
+	if (!cache.createBytes) {
+		auto deltaData = getFactory().entityDataToPrefabDelta(*data, entity.getPrefab(), deltaOptions);
+		quantizer.pack(deltaData);
+		cache.createBytes = std::make_shared<Bytes>(Serializer::toBytes(deltaData, byteSerializationOptions));
+	}
+	return cache.createBytes;
+}
+
+std::shared_ptr<const Bytes> EntityNetworkSession::getEntityUpdateBytes(EntityRef entity, const std::shared_ptr<const EntityData>& baseline)
+{
+	const auto data = getEntitySnapshot(entity);
+	auto& cache = entitySnapshots[entity.getEntityId()];
+	if (baseline == data) {
+		return {};
+	}
+
+	// Peers that last received the same baseline get the same delta
+	for (const auto& delta: cache.deltas) {
+		if (delta.baseline == baseline) {
+			return delta.bytes;
+		}
+	}
+
+	// Encode delta using interpolators
+	auto retriever = DataInterpolatorSetRetriever(entity, true);
+	auto options = deltaOptions;
+	options.interpolatorSet = &retriever;
+	auto deltaData = EntityDataDelta(*baseline, *data, options);
+
+	std::shared_ptr<const Bytes> bytes;
+	if (deltaData.hasChange()) {
+		quantizer.pack(deltaData);
+		bytes = std::make_shared<Bytes>(Serializer::toBytes(deltaData, byteSerializationOptions));
+	}
+	cache.deltas.push_back(EntityDeltaCache{ baseline, bytes });
+	return bytes;
+}
+
+EntityDataDelta EntityNetworkSession::deserializeEntityDelta(const Bytes& bytes) const
+{
+	auto delta = Deserializer::fromBytes<EntityDataDelta>(bytes, byteSerializationOptions);
+	quantizer.unpack(delta);
+	return delta;
+}
+
 void EntityNetworkSession::onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId)
 {
 	if (listener) {
@@ -351,6 +604,29 @@ bool EntityNetworkSession::isEntityInView(EntityRef entity, const EntityClientSh
 	return listener->isEntityInView(entity, clientData);
 }
 
+void EntityNetworkSession::getInterestCandidates(const EntityClientSharedData& clientData, Vector<uint32_t>& result) const
+{
+	Expects(listener);
+	interestGrid.query(listener->getInterestArea(clientData), result);
+}
+
+float EntityNetworkSession::getEntityUpdatePriority(EntityRef entity, const EntityClientSharedData& clientData) const
+{
+	Expects(listener);
+	return clamp(listener->getEntityUpdatePriority(entity, clientData), 0.05f, 1.0f);
+}
+
+void EntityNetworkSession::updateInterestGrid(gsl::span<const EntityNetworkUpdateInfo> entityIds)
+{
+	interestGrid.clear();
+	auto& world = getWorld();
+	for (size_t i = 0; i < entityIds.size(); ++i) {
+		const auto entity = world.getEntity(entityIds[i].entityId);
+		const auto* transform = entity.tryGetComponent<Transform2DComponent>();
+		interestGrid.add(static_cast<uint32_t>(i), transform ? transform->getGlobalPosition() : std::optional<Vector2f>());
+	}
+}
+
 Vector<Rect4i> EntityNetworkSession::getRemoteViewPorts() const
 {
 	Vector<Rect4i> result;
@@ -413,6 +689,8 @@ void EntityNetworkSession::onPeerDisconnected(NetworkSession::PeerId peerId)
 		}
 	}
 	std_ex::erase_if(peers, [](const EntityNetworkRemotePeer& p) { return !p.isAlive(); });
+	packetCompressors.erase(peerId);
+	packetDecompressors.erase(peerId);
 
 	Logger::logDev("Peer " + toString(static_cast<int>(peerId)) + " disconnected from EntityNetworkSession.");
 }
@@ -430,9 +708,11 @@ std::unique_ptr<SharedData> EntityNetworkSession::makePeerSharedData()
 void EntityClientSharedData::serialize(Serializer& s) const
 {
 	s << viewRect;
+	s << compressionDictionaryHash;
 }
 
 void EntityClientSharedData::deserialize(Deserializer& s)
 {
 	s >> viewRect;
+	s >> compressionDictionaryHash;
 }
@@ -0,0 +1,158 @@
+#include "halley/net/entity/network_dictionary_trainer.h"
+
+#include <cstring>
+#include "halley/data_structures/hash_map.h"
+#include "halley/support/exception.h"
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t dmerSize = 8;
+
+	struct DmerCount {
+		uint32_t samples = 0;
+		uint32_t lastSample = 0;
+	};
+
+	struct Segment {
+		size_t pos = 0;
+		size_t size = 0;
+		uint64_t score = 0;
+	};
+}
+
+NetworkDictionaryTrainer::NetworkDictionaryTrainer(size_t segmentSize)
+	: segmentSize(segmentSize)
+{
+	Expects(segmentSize >= dmerSize);
+}
+
+void NetworkDictionaryTrainer::addSample(gsl::span<const gsl::byte> sample)
+{
+	if (sample.empty()) {
+		return;
+	}
+	const auto* src = reinterpret_cast<const Byte*>(sample.data());
+	data.insert(data.end(), src, src + sample.size_bytes());
+	sampleEnds.push_back(data.size());
+}
+
+void NetworkDictionaryTrainer::addCapture(gsl::span<const gsl::byte> capture)
+{
+	size_t pos = 0;
+	while (pos < capture.size_bytes()) {
+		uint32_t size = 0;
+		if (pos + sizeof(size) > capture.size_bytes()) {
+			throw Exception("Truncated record in network capture.", HalleyExceptions::Network);
+		}
+		memcpy(&size, capture.data() + pos, sizeof(size));
+		pos += sizeof(size);
+
+		if (pos + size > capture.size_bytes()) {
+			throw Exception("Truncated record in network capture.", HalleyExceptions::Network);
+		}
+		addSample(capture.subspan(pos, size));
+		pos += size;
+	}
+}
+
+size_t NetworkDictionaryTrainer::getNumSamples() const
+{
+	return sampleEnds.size();
+}
+
+Bytes NetworkDictionaryTrainer::train(size_t dictionarySize) const
+{
+	dictionarySize = std::min(dictionarySize, maxDictionarySize);
+	if (data.size() < dmerSize || dictionarySize == 0) {
+		return {};
+	}
+
+	const auto readDmer = [&] (size_t pos) -> uint64_t
+	{
+		uint64_t value;
+		memcpy(&value, data.data() + pos, sizeof(value));
+		return value;
+	};
+
+	// Count how many samples each sequence appears in
+	HashMap<uint64_t, DmerCount> counts;
+	size_t sampleStart = 0;
+	for (size_t i = 0; i < sampleEnds.size(); ++i) {
+		const auto sampleId = static_cast<uint32_t>(i + 1);
+		for (size_t pos = sampleStart; pos + dmerSize <= sampleEnds[i]; ++pos) {
+			auto& count = counts[readDmer(pos)];
+			if (count.lastSample != sampleId) {
+				count.lastSample = sampleId;
+				++count.samples;
+			}
+		}
+		sampleStart = sampleEnds[i];
+	}
+
+	// Sequences only seen in one sample won't help compress other packets
+	const auto getScore = [&] (size_t pos) -> uint64_t
+	{
+		const auto samples = counts.at(readDmer(pos)).samples;
+		return samples >= 2 ? samples : 0;
+	};
+
+	const size_t nEpochs = std::max<size_t>(1, dictionarySize / segmentSize);
+	const size_t epochSize = std::max(data.size() / nEpochs, segmentSize);
+
+	Vector<Segment> segments;
+	size_t totalSize = 0;
+	for (size_t epochStart = 0; epochStart < data.size() && totalSize < dictionarySize; epochStart += epochSize) {
+		const size_t epochEnd = std::min(epochStart + epochSize, data.size());
+
+		// Slide a window over each part of a sample inside this epoch, windows never straddle samples
+		Segment best;
+		sampleStart = 0;
+		for (const size_t sampleEnd: sampleEnds) {
+			const size_t start = std::max(sampleStart, epochStart);
+			const size_t end = std::min(sampleEnd, epochEnd);
+			sampleStart = sampleEnd;
+			if (end <= start || end - start < dmerSize) {
+				continue;
+			}
+
+			const size_t windowSize = std::min(segmentSize, end - start);
+			const size_t nDmers = windowSize - dmerSize + 1;
+			uint64_t score = 0;
+			for (size_t pos = start; pos < start + nDmers; ++pos) {
+				score += getScore(pos);
+			}
+			for (size_t pos = start; ; ++pos) {
+				if (score > best.score) {
+					best = Segment{ pos, windowSize, score };
+				}
+				if (pos + windowSize >= end) {
+					break;
+				}
+				score -= getScore(pos);
+				score += getScore(pos + nDmers);
+			}
+		}
+
+		if (best.score > 0) {
+			for (size_t pos = best.pos; pos + dmerSize <= best.pos + best.size; ++pos) {
+				counts.at(readDmer(pos)).samples = 0;
+			}
+			segments.push_back(best);
+			totalSize += best.size;
+		}
+	}
+
+	// LZ4 only sees the end of the dictionary if it gets truncated, so the best segments go last
+	std::stable_sort(segments.begin(), segments.end(), [] (const Segment& a, const Segment& b) { return a.score < b.score; });
+
+	Bytes result;
+	result.reserve(totalSize);
+	for (const auto& segment: segments) {
+		result.insert(result.end(), data.begin() + segment.pos, data.begin() + segment.pos + segment.size);
+	}
+	if (result.size() > dictionarySize) {
+		result.erase(result.begin(), result.begin() + (result.size() - dictionarySize));
+	}
+	return result;
+}
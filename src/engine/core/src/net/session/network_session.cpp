@@ -274,7 +274,7 @@ void NetworkSession::sendToPeers(OutboundNetworkPacket packet, std::optional<Pee
 	doSendToAll(makeOutbound(packet.getBytes(), header), except);
 }
 
-void NetworkSession::sendToPeer(OutboundNetworkPacket packet, PeerId peerId)
+bool NetworkSession::sendToPeer(OutboundNetworkPacket packet, PeerId peerId, bool reliable)
 {
 	NetworkSessionMessageHeader header;
 	header.type = NetworkSessionMessageType::ToPeer;
@@ -284,20 +284,21 @@ void NetworkSession::sendToPeer(OutboundNetworkPacket packet, PeerId peerId)
 
 	for (const auto& peer: peers) {
 		if (peer.peerId == peerId) {
-			doSendToPeer(peer, OutboundNetworkPacket(packet));
-			return;
+			doSendToPeer(peer, OutboundNetworkPacket(packet), reliable);
+			return true;
 		}
 	}
 
 	// Redirect via host
 	for (const auto& peer: peers) {
 		if (peer.peerId == 0) {
-			doSendToPeer(peer, OutboundNetworkPacket(packet));
-			return;
+			doSendToPeer(peer, OutboundNetworkPacket(packet), reliable);
+			return true;
 		}
 	}
 	
 	Logger::logError("Unable to send message to peer " + toString(static_cast<int>(peerId)) + ": id not found.");
+	return false;
 }
 
 void NetworkSession::doSendToAll(OutboundNetworkPacket packet, std::optional<PeerId> except)
@@ -309,10 +310,10 @@ void NetworkSession::doSendToAll(OutboundNetworkPacket packet, std::optional<Pee
 	}
 }
 
-void NetworkSession::doSendToPeer(const Peer& peer, OutboundNetworkPacket packet)
+void NetworkSession::doSendToPeer(const Peer& peer, OutboundNetworkPacket packet, bool reliable)
 {
 	//peer.connection->send(IConnection::TransmissionType::Reliable, std::move(packet));
-	peer.connection->enqueue(std::move(packet), 0);
+	peer.connection->enqueue(std::move(packet), reliable ? reliableChannel : unreliableChannel);
 }
 
 std::optional<std::pair<NetworkSession::PeerId, InboundNetworkPacket>> NetworkSession::receive()
@@ -664,7 +665,8 @@ NetworkSession::Peer NetworkSession::makePeer(PeerId peerId, std::shared_ptr<ICo
 	ackConn->setStatsListener(stats.get());
 
 	auto messageQueue = std::make_shared<MessageQueueUDP>(ackConn);
-	messageQueue->setChannel(0, ChannelSettings(true, true));
+	messageQueue->setChannel(reliableChannel, ChannelSettings(true, true));
+	messageQueue->setChannel(unreliableChannel, ChannelSettings(false, false));
 
 	return Peer{ peerId, true, std::move(messageQueue), std::move(stats) };
 }
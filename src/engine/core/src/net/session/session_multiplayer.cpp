@@ -158,8 +158,31 @@ bool SessionMultiplayer::isEntityInView(EntityRef entity, const EntityClientShar
 	}
 
 	// Send if it's in an expanded rect
-	return clientData.viewRect->grow(256).contains(Vector2i(transform->getGlobalPosition()));
+	// Rounded down, like the cells of the interest grid that picks the candidates
+	return clientData.viewRect->grow(viewRectMargin).contains(Vector2i(transform->getGlobalPosition().floor()));
 }
+
+std::optional<Rect4f> SessionMultiplayer::getInterestArea(const EntityClientSharedData& clientData)
+{
+	if (!clientData.viewRect) {
+		return Rect4f();
+	}
+	return Rect4f(clientData.viewRect->grow(viewRectMargin));
+}
+
+float SessionMultiplayer::getEntityUpdatePriority(EntityRef entity, const EntityClientSharedData& clientData)
+{
+	const auto* transform = entity.tryGetComponent<Transform2DComponent>();
+	if (!transform || !clientData.viewRect) {
+		return 1.0f;
+	}
+
+	// Full rate on screen, dropping to a quarter at the edge of the expanded rect
+	const auto pos = transform->getGlobalPosition();
+	const float dist = (Rect4f(*clientData.viewRect).getClosestPoint(pos) - pos).length();
+	return lerp(1.0f, 0.25f, clamp(dist / static_cast<float>(viewRectMargin), 0.0f, 1.0f));
+}
+
 void SessionMultiplayer::setupDictionary(SerializationDictionary& dict, std::shared_ptr<const ConfigFile> serializationDict)
 {
 	dict = SerializationDictionary(serializationDict->getRoot());
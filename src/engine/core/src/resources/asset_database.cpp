@@ -1,4 +1,5 @@
 #include "halley/resources/asset_database.h"
+#include "halley/resources/asset_pack_index.h"
 #include "halley/bytes/byte_serializer.h"
 #include "halley/support/exception.h"
 #include "halley/resources/resource.h"
@@ -34,22 +35,46 @@ AssetDatabase::TypedDB::TypedDB(AssetType type)
 {
 }
 
+AssetDatabase::TypedDB::TypedDB(AssetType type, std::shared_ptr<const AssetPackIndex> index)
+	: type(type)
+	, index(std::move(index))
+	, indexCache(std::make_shared<IndexCache>())
+{
+}
+
 void AssetDatabase::TypedDB::add(const String& name, Entry&& asset)
 {
+	if (index) {
+		throw Exception("Can't add assets to an indexed asset database", HalleyExceptions::Resources);
+	}
 	assets[name] = std::move(asset);
 }
 
 const AssetDatabase::Entry& AssetDatabase::TypedDB::get(const String& name) const
 {
-	auto i = assets.find(name);
-	if (i == assets.end()) {
+	const auto* entry = tryGet(name);
+	if (!entry) {
 		throw Exception("Asset not found: " + toString(type) + ":" + name, HalleyExceptions::Resources);
 	}
-	return i->second;
+	return *entry;
 }
 
 const AssetDatabase::Entry* AssetDatabase::TypedDB::tryGet(const String& name) const
 {
+	if (index) {
+		const auto* indexEntry = index->find(type, name);
+		if (!indexEntry) {
+			return nullptr;
+		}
+
+		std::unique_lock lock(indexCache->mutex);
+		auto& entry = indexCache->entries[name];
+		if (!entry) {
+			entry = std::make_unique<Entry>(toString(indexEntry->pos) + ":" + toString(indexEntry->size), index->getMetadata(*indexEntry));
+		}
+		return entry.get();
+	}
+
 	auto i = assets.find(name);
 	if (i == assets.end()) {
 		return nullptr;
@@ -60,20 +85,52 @@ const AssetDatabase::Entry* AssetDatabase::TypedDB::tryGet(const String& name) c
 void AssetDatabase::TypedDB::serialize(Serializer& s) const
 {
 	s << type;
-	s << assets;
+	s << getAssets();
 }
 
 void AssetDatabase::TypedDB::deserialize(Deserializer& s)
 {
 	s >> type;
 	s >> assets;
+	index.reset();
+	indexCache.reset();
 }
 
 const HashMap<String, AssetDatabase::Entry>& AssetDatabase::TypedDB::getAssets() const
 {
+	if (index) {
+		std::unique_lock lock(indexCache->mutex);
+		if (!indexCache->allEntries) {
+			auto& result = indexCache->allEntries.emplace();
+			for (const auto& indexEntry: index->getEntries()) {
+				if (indexEntry.type == static_cast<int32_t>(type)) {
+					result[String(index->getName(indexEntry))] = Entry(toString(indexEntry.pos) + ":" + toString(indexEntry.size), index->getMetadata(indexEntry));
+				}
+			}
+		}
+		return *indexCache->allEntries;
+	}
 	return assets;
 }
 
+Vector<String> AssetDatabase::TypedDB::getNames() const
+{
+	Vector<String> result;
+	if (index) {
+		for (const auto& indexEntry: index->getEntries()) {
+			if (indexEntry.type == static_cast<int32_t>(type)) {
+				result.push_back(String(index->getName(indexEntry)));
+			}
+		}
+	} else {
+		result.reserve(assets.size());
+		for (const auto& asset: assets) {
+			result.push_back(asset.first);
+		}
+	}
+	return result;
+}
+
 AssetType AssetDatabase::TypedDB::getType() const
 {
 	return type;
@@ -102,6 +159,11 @@ const AssetDatabase::TypedDB& AssetDatabase::getDatabase(AssetType type) const
 	return iter->second;
 }
 
+const TreeMap<int, AssetDatabase::TypedDB>& AssetDatabase::getDatabases() const
+{
+	return dbs;
+}
+
 bool AssetDatabase::hasDatabase(AssetType type) const
 {
 	return dbs.find(static_cast<int>(type)) != dbs.end();
@@ -114,12 +176,12 @@ Vector<String> AssetDatabase::getAssets() const
 	for (auto& db: dbs) {
 		const String prefix = toString(static_cast<AssetType>(db.first)) + ":";
 
-		const auto nAssets = db.second.getAssets().size();
-		contains.reserve(contains.size() + nAssets);
-		result.reserve(result.size() + nAssets);
+		auto names = db.second.getNames();
+		contains.reserve(contains.size() + names.size());
+		result.reserve(result.size() + names.size());
 
-		for (const auto& asset: db.second.getAssets()) {
-			String name = prefix + asset.first;
+		for (const auto& asset: names) {
+			String name = prefix + asset;
 			if (!contains.contains(name)) {
 				contains.insert(name);
 				result.push_back(std::move(name));
@@ -130,6 +192,16 @@ Vector<String> AssetDatabase::getAssets() const
 	return result;
 }
 
+void AssetDatabase::setIndex(std::shared_ptr<const AssetPackIndex> index)
+{
+	dbs.clear();
+	for (const auto& entry: index->getEntries()) {
+		if (dbs.find(entry.type) == dbs.end()) {
+			dbs[entry.type] = TypedDB(static_cast<AssetType>(entry.type), index);
+		}
+	}
+}
+
 void AssetDatabase::serialize(Serializer& s) const
 {
 	s << dbs;
@@ -144,9 +216,7 @@ Vector<String> AssetDatabase::enumerate(AssetType type) const
 {
 	Vector<String> result;
 	if (hasDatabase(type)) {
-		for (auto& asset: getDatabase(type).getAssets()) {
-			result.push_back(asset.first);
-		}
+		result = getDatabase(type).getNames();
 	}
 	return result;
 }
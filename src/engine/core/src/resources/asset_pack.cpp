@@ -1,8 +1,10 @@
 #include "halley/resources/asset_pack.h"
 #include "halley/resources/asset_database.h"
+#include "halley/resources/asset_pack_index.h"
 #include "halley/resources/resource_data.h"
 #include "halley/bytes/byte_serializer.h"
 #include "halley/bytes/compression.h"
+#include "halley/file/mapped_file.h"
 #include "halley/maths/random.h"
 #include "halley/utils/encrypt.h"
 
@@ -10,12 +12,17 @@ using namespace Halley;
 
 void AssetPackHeader::init(size_t assetDbSize)
 {
-	memcpy(identifier.data(), "HALLEYPK", 8);
+	memcpy(identifier.data(), "HALLEYPI", 8);
 	assetDbStartPos = sizeof(AssetPackHeader);
 	dataStartPos = assetDbStartPos + assetDbSize;
 	memset(iv.data(), 0, iv.size());
 }
 
+bool AssetPackHeader::isIndexed() const
+{
+	return memcmp(identifier.data(), "HALLEYPI", 8) == 0;
+}
+
 AssetPack::AssetPack()
 	: assetDb(std::make_unique<AssetDatabase>())
 	, hasReader(false)
@@ -31,6 +38,7 @@ AssetPack::AssetPack(AssetPack&& other) noexcept
 AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String& encryptionKey, bool preLoad)
 	: reader(std::move(_reader))
 	, hasReader(true)
+	, readerSupportsReadAt(reader->supportsReadAt())
 {
 	// Read header
 	size_t totalSize = reader->size();
@@ -42,7 +50,7 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 	if (nRead != int(sizeof(header))) {
 		throw Exception("Unable to read header", HalleyExceptions::Resources);
 	}
-	if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0) {
+	if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0 && !header.isIndexed()) {
 		throw Exception("Asset pack is invalid (invalid identifier)", HalleyExceptions::Resources);
 	}
 	iv = header.iv;
@@ -57,7 +65,14 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 			throw Exception("Unable to read header", HalleyExceptions::Resources);
 		}
 		assetDb = std::make_unique<AssetDatabase>();
-		Deserializer::fromBytes<AssetDatabase>(*assetDb, Compression::decompress(assetDbBytes));
+		if (header.isIndexed()) {
+			index = std::make_shared<AssetPackIndex>(std::move(assetDbBytes));
+		} else {
+			// Older pack, convert its database so lookups work the same way
+			Deserializer::fromBytes<AssetDatabase>(*assetDb, Compression::decompress(assetDbBytes));
+			index = std::make_shared<AssetPackIndex>(makeIndex());
+		}
+		assetDb->setIndex(index);
 	}
 
 	std::array<char, 16> ivEmpty;
@@ -82,11 +97,14 @@ AssetPack::~AssetPack()
 
 AssetPack& AssetPack::operator=(AssetPack&& other) noexcept
 {
-	std::unique_lock<std::mutex> lock(other.readerMutex);
+	std::unique_lock lock(other.readerMutex);
 
 	assetDb = std::move(other.assetDb);
+	index = std::move(other.index);
 	dataOffset = other.dataOffset;
 	reader = std::move(other.reader);
+	readerSupportsReadAt = other.readerSupportsReadAt;
+	mapping = std::move(other.mapping);
 	data = std::move(other.data);
 	hasReader = !!reader;
 
@@ -118,7 +136,7 @@ const Bytes& AssetPack::getData() const
 
 Bytes AssetPack::writeOut() const
 {
-	auto assetDbBytes = Compression::compress(Serializer::toBytes(*assetDb));
+	auto assetDbBytes = makeIndex();
 	AssetPackHeader header;
 	header.init(assetDbBytes.size());
 	header.iv = iv;
@@ -133,20 +151,26 @@ Bytes AssetPack::writeOut() const
 std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType type, bool stream)
 {
 	auto path = asset;
-	const auto* assetInfo = assetDb->getDatabase(type).tryGet(asset);
-	if (!assetInfo) {
+	const auto location = findAsset(asset, type);
+	if (!location) {
 		return {};
 	}
-	auto ps = assetInfo->path.split(':');
-	size_t pos = size_t(ps.at(0).toInteger());
-	size_t size = size_t(ps.at(1).toInteger());
+	const auto [pos, size] = *location;
 
 	if (stream) {
 		return std::make_unique<ResourceDataStream>(path, [=] () -> std::unique_ptr<ResourceDataReader> {
 			return std::make_unique<PackDataReader>(*this, pos, size);
 		});
 	} else {
-		if (hasReader) {
+		if (mapping) {
+			if (dataOffset + pos + size > mapping->getSize()) {
+				throw Exception("Asset \"" + asset + "\" is out of pack bounds.", HalleyExceptions::Resources);
+			}
+
+			// Points straight into the mapping, and keeps it alive
+			const auto* start = reinterpret_cast<const char*>(mapping->getSpan().data()) + dataOffset + pos;
+			return std::make_unique<ResourceDataStatic>(std::shared_ptr<const char>(mapping, start), size, path);
+		} else if (hasReader) {
 			auto result = new char[size];
 			try {
 				readData(pos, gsl::as_writable_bytes(gsl::span<char>(result, size)));
@@ -168,13 +192,36 @@ std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType
 
 void AssetPack::readToMemory()
 {
-	std::unique_lock<std::mutex> lock(readerMutex);
+	std::unique_lock lock(readerMutex);
 	reader->seek(dataOffset, SEEK_SET);
 	data = reader->readAll();
 	hasReader = false;
 	reader.reset();
 }
 
+bool AssetPack::mapToMemory(const Path& path)
+{
+	std::unique_lock lock(readerMutex);
+	if (!reader) {
+		return false;
+	}
+
+	auto file = MappedFile::open(path);
+	if (!file || file->getSize() != reader->size()) {
+		return false;
+	}
+
+	mapping = std::move(file);
+	hasReader = false;
+	reader.reset();
+	return true;
+}
+
+bool AssetPack::isMapped() const
+{
+	return !!mapping;
+}
+
 void AssetPack::encrypt(const String& key)
 {
 	// Generate IV
@@ -196,14 +243,30 @@ void AssetPack::decrypt(const String& key)
 void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 {
 	if (hasReader) {
-		std::unique_lock<std::mutex> lock(readerMutex);
-		if (reader) {
-			reader->seek(pos + dataOffset, SEEK_SET);
-			reader->read(dst);
-			return;
+		if (readerSupportsReadAt) {
+			std::shared_lock lock(readerMutex);
+			if (reader) {
+				reader->readAt(pos + dataOffset, dst);
+				return;
+			}
+		} else {
+			std::unique_lock lock(readerMutex);
+			if (reader) {
+				reader->seek(pos + dataOffset, SEEK_SET);
+				reader->read(dst);
+				return;
+			}
 		}
 	}
 
+	if (mapping) {
+		if (dataOffset + pos + size_t(dst.size()) > mapping->getSize()) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		memcpy(dst.data(), mapping->getSpan().data() + dataOffset + pos, dst.size());
+		return;
+	}
+
 	// Didn't read with reader, read from data
 	if (pos + size_t(dst.size()) > data.size()) {
 		throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
@@ -213,7 +276,7 @@ void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 
 std::unique_ptr<ResourceDataReader> AssetPack::extractReader()
 {
-	std::unique_lock<std::mutex> lock(readerMutex);
+	std::unique_lock lock(readerMutex);
 	hasReader = false;
 	return std::move(reader);
 }
@@ -226,6 +289,36 @@ std::shared_ptr<bool> AssetPack::getAliveToken() const
 	return aliveToken;
 }
 
+std::optional<std::pair<size_t, size_t>> AssetPack::findAsset(const String& asset, AssetType type) const
+{
+	if (index) {
+		if (const auto* entry = index->find(type, asset)) {
+			return std::pair<size_t, size_t>(size_t(entry->pos), size_t(entry->size));
+		}
+		return std::nullopt;
+	}
+
+	// Pack being built, entries are still in the database as "pos:size"
+	const auto* assetInfo = assetDb->getDatabase(type).tryGet(asset);
+	if (!assetInfo) {
+		return std::nullopt;
+	}
+	auto ps = assetInfo->path.split(':');
+	return std::pair<size_t, size_t>(size_t(ps.at(0).toInteger64()), size_t(ps.at(1).toInteger64()));
+}
+
+Bytes AssetPack::makeIndex() const
+{
+	Vector<AssetPackIndex::Source> sources;
+	for (const auto& [typeId, db]: assetDb->getDatabases()) {
+		for (const auto& [name, entry]: db.getAssets()) {
+			auto ps = entry.path.split(':');
+			sources.push_back(AssetPackIndex::Source{ db.getType(), name, uint64_t(ps.at(0).toInteger64()), uint64_t(ps.at(1).toInteger64()), &entry.meta });
+		}
+	}
+	return AssetPackIndex::build(std::move(sources));
+}
+
 PackDataReader::PackDataReader(AssetPack& pack, size_t startPos, size_t fileSize)
 	: pack(pack)
 	, startPos(startPos)
@@ -0,0 +1,168 @@
+#include "halley/resources/asset_pack_index.h"
+#include "halley/resources/metadata.h"
+#include "halley/bytes/byte_serializer.h"
+#include "halley/support/exception.h"
+#include "halley/utils/hash.h"
+#include <algorithm>
+
+using namespace Halley;
+
+namespace {
+	constexpr const char* indexIdentifier = "HALLEYIX";
+}
+
+AssetPackIndex::AssetPackIndex(std::shared_ptr<const void> owner, gsl::span<const gsl::byte> data)
+	: owner(std::move(owner))
+	, data(data)
+{
+	validate();
+}
+
+AssetPackIndex::AssetPackIndex(Bytes bytes)
+{
+	auto buffer = std::make_shared<const Bytes>(std::move(bytes));
+	data = gsl::as_bytes(gsl::span<const Byte>(*buffer));
+	owner = std::move(buffer);
+	validate();
+}
+
+Bytes AssetPackIndex::build(Vector<Source> assets)
+{
+	Bytes names;
+	Bytes metas;
+	Vector<Entry> entries;
+	entries.reserve(assets.size());
+
+	for (const auto& asset: assets) {
+		Entry entry = {};
+		entry.hash = hashAsset(asset.type, asset.name);
+		entry.pos = asset.pos;
+		entry.size = asset.size;
+		entry.type = static_cast<int32_t>(asset.type);
+
+		entry.nameOffset = names.size();
+		entry.nameLength = static_cast<uint32_t>(asset.name.size());
+		names.insert(names.end(), asset.name.c_str(), asset.name.c_str() + asset.name.size());
+
+		// Each entry's metadata is serialized on its own, so it can be decoded without touching the others
+		entry.metaOffset = metas.size();
+		if (asset.meta) {
+			const auto bytes = Serializer::toBytes(*asset.meta);
+			metas.insert(metas.end(), bytes.begin(), bytes.end());
+			entry.metaSize = static_cast<uint32_t>(bytes.size());
+		}
+
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), [] (const Entry& a, const Entry& b)
+	{
+		return a.hash < b.hash;
+	});
+
+	Header header = {};
+	memcpy(header.identifier.data(), indexIdentifier, header.identifier.size());
+	header.version = currentVersion;
+	header.numEntries = static_cast<uint32_t>(entries.size());
+	header.namesStart = sizeof(Header) + entries.size() * sizeof(Entry);
+	header.metaStart = header.namesStart + alignUp(names.size(), size_t(8));
+	header.totalSize = header.metaStart + metas.size();
+
+	Bytes result(static_cast<size_t>(header.totalSize));
+	memcpy(result.data(), &header, sizeof(Header));
+	if (!entries.empty()) {
+		memcpy(result.data() + sizeof(Header), entries.data(), entries.size() * sizeof(Entry));
+	}
+	if (!names.empty()) {
+		memcpy(result.data() + header.namesStart, names.data(), names.size());
+	}
+	if (!metas.empty()) {
+		memcpy(result.data() + header.metaStart, metas.data(), metas.size());
+	}
+	return result;
+}
+
+uint64_t AssetPackIndex::hashAsset(AssetType type, std::string_view name)
+{
+	Hash::Hasher hasher;
+	hasher.feed(static_cast<int32_t>(type));
+	hasher.feed(name);
+	return hasher.digest();
+}
+
+const AssetPackIndex::Entry* AssetPackIndex::find(AssetType type, std::string_view name) const
+{
+	const uint64_t hash = hashAsset(type, name);
+	auto iter = std::lower_bound(entries.begin(), entries.end(), hash, [] (const Entry& entry, uint64_t hash)
+	{
+		return entry.hash < hash;
+	});
+
+	// Hashes can collide, so confirm against the stored type and name
+	for (; iter != entries.end() && iter->hash == hash; ++iter) {
+		if (iter->type == static_cast<int32_t>(type) && getName(*iter) == name) {
+			return &*iter;
+		}
+	}
+	return nullptr;
+}
+
+gsl::span<const AssetPackIndex::Entry> AssetPackIndex::getEntries() const
+{
+	return entries;
+}
+
+std::string_view AssetPackIndex::getName(const Entry& entry) const
+{
+	const auto& header = *reinterpret_cast<const Header*>(data.data());
+	return std::string_view(reinterpret_cast<const char*>(data.data() + header.namesStart + entry.nameOffset), entry.nameLength);
+}
+
+Metadata AssetPackIndex::getMetadata(const Entry& entry) const
+{
+	Metadata result;
+	if (entry.metaSize > 0) {
+		const auto& header = *reinterpret_cast<const Header*>(data.data());
+		Deserializer::fromBytes(result, data.subspan(static_cast<size_t>(header.metaStart + entry.metaOffset), entry.metaSize));
+	}
+	return result;
+}
+
+gsl::span<const gsl::byte> AssetPackIndex::getBytes() const
+{
+	return data;
+}
+
+void AssetPackIndex::validate()
+{
+	if (data.size() < sizeof(Header)) {
+		throw Exception("Asset pack index is invalid (too small)", HalleyExceptions::Resources);
+	}
+	if (reinterpret_cast<uintptr_t>(data.data()) % alignof(Entry) != 0) {
+		throw Exception("Asset pack index is not aligned", HalleyExceptions::Resources);
+	}
+
+	const auto& header = *reinterpret_cast<const Header*>(data.data());
+	if (memcmp(header.identifier.data(), indexIdentifier, header.identifier.size()) != 0) {
+		throw Exception("Asset pack index is invalid (invalid identifier)", HalleyExceptions::Resources);
+	}
+	if (header.version != currentVersion) {
+		throw Exception("Asset pack index has unsupported version " + toString(header.version), HalleyExceptions::Resources);
+	}
+
+	const uint64_t entriesEnd = sizeof(Header) + uint64_t(header.numEntries) * sizeof(Entry);
+	if (header.totalSize > data.size() || entriesEnd > header.namesStart || header.namesStart > header.metaStart || header.metaStart > header.totalSize) {
+		throw Exception("Asset pack index is invalid (bad layout)", HalleyExceptions::Resources);
+	}
+
+	entries = gsl::span<const Entry>(reinterpret_cast<const Entry*>(data.data() + sizeof(Header)), header.numEntries);
+
+	// Checked once here, so lookups can trust every offset
+	const uint64_t namesSize = header.metaStart - header.namesStart;
+	const uint64_t metaSize = header.totalSize - header.metaStart;
+	for (const auto& entry: entries) {
+		if (entry.nameOffset + entry.nameLength > namesSize || entry.metaOffset + entry.metaSize > metaSize) {
+			throw Exception("Asset pack index is invalid (entry out of bounds)", HalleyExceptions::Resources);
+		}
+	}
+}
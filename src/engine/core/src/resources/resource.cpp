@@ -41,6 +41,10 @@ ResourceMemoryUsage Resource::getMemoryUsage() const
 	return ResourceMemoryUsage{};
 }
 
+void Resource::releaseCaches()
+{
+}
+
 void Resource::increaseAge(float time)
 {
 	age += time;
@@ -6,9 +6,19 @@
 
 #include "halley/graphics/sprite/sprite.h"
 #include "halley/support/logger.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
+namespace {
+	// The assets this thread is in the middle of loading, innermost last, in "type:name" format
+	thread_local Vector<String> loadingAssets;
+
+	struct LoadingAssetGuard {
+		LoadingAssetGuard(String assetId) { loadingAssets.push_back(std::move(assetId)); }
+		~LoadingAssetGuard() { loadingAssets.pop_back(); }
+	};
+}
 
 
 #ifdef _WIN32
@@ -44,6 +54,33 @@ namespace {
 
 
 
+ResourceCollectionBase::Wrapper::Wrapper(std::shared_ptr<Resource> resource, int loadDepth, ResourceLoadPriority priority, uint64_t lastUsed)
+	: res(std::move(resource))
+	, depth(loadDepth)
+	, priority(priority)
+	, lastUsed(lastUsed)
+{}
+
+ResourceCollectionBase::Wrapper::Wrapper(Wrapper&& other) noexcept
+	: res(std::move(other.res))
+	, depth(other.depth)
+	, priority(other.priority)
+	, memoryUsage(other.memoryUsage)
+	, memoryUsageStale(other.memoryUsageStale)
+	, lastUsed(other.lastUsed.load(std::memory_order_relaxed))
+{}
+
+ResourceCollectionBase::Wrapper& ResourceCollectionBase::Wrapper::operator=(Wrapper&& other) noexcept
+{
+	res = std::move(other.res);
+	depth = other.depth;
+	priority = other.priority;
+	memoryUsage = other.memoryUsage;
+	memoryUsageStale = other.memoryUsageStale;
+	lastUsed = other.lastUsed.load(std::memory_order_relaxed);
+	return *this;
+}
+
 ResourceCollectionBase::ResourceCollectionBase(Resources& parent, AssetType type)
 	: parent(parent)
 	, type(type)
@@ -53,44 +90,70 @@ ResourceCollectionBase::ResourceCollectionBase(Resources& parent, AssetType type
 
 void ResourceCollectionBase::clear()
 {
+	std::unique_lock lock(mutex);
+	for (auto& r: resources) {
+		releaseWrapper(r.second);
+	}
 	resources.clear();
 }
 
 void ResourceCollectionBase::unload(std::string_view assetId)
 {
-	resources.erase(assetId);
+	std::unique_lock lock(mutex);
+	const auto iter = resources.find(assetId);
+	if (iter != resources.end()) {
+		releaseWrapper(iter->second);
+		resources.erase(iter);
+	}
 }
 
 void ResourceCollectionBase::unloadAll(int minDepth)
 {
+	std::unique_lock lock(mutex);
 	for (auto iter = resources.begin(); iter != resources.end(); ) {
-		auto next = iter;
-		++next;
-
 		auto& res = (*iter).second;
 		if (res.depth >= minDepth) {
-			resources.erase(iter);
+			releaseWrapper(res);
+			iter = resources.erase(iter);
+		} else {
+			++iter;
 		}
-
-		iter = next;
 	}
 }
 
 void ResourceCollectionBase::reload(std::string_view assetId)
 {
-	auto res = resources.find(assetId);
-	if (res != resources.end()) {
-		auto& resWrap = res->second;
-		try {
-			const auto [newAsset, loaded] = loadAsset(assetId, ResourceLoadPriority::High, false);
-			newAsset->setAssetId(assetId);
-			newAsset->onLoaded(parent);
-			resWrap.res->reloadResource(std::move(*newAsset));
-		} catch (std::exception& e) {
-			Logger::logError("Error while reloading " + String(assetId) + ": " + e.what());
-		} catch (...) {
-			Logger::logError("Unknown error while reloading " + String(assetId));
+	std::shared_ptr<Resource> res;
+	{
+		std::shared_lock lock(mutex);
+		const auto iter = resources.find(assetId);
+		if (iter == resources.end()) {
+			return;
 		}
+		res = iter->second.res;
+	}
+
+	try {
+		// Its dependencies might have changed, so they're recorded again as it loads
+		const auto id = ResourceDependencyGraph::makeAssetId(type, assetId);
+		parent.dependencyGraph.clearDependencies(id);
+		LoadingAssetGuard guard(id);
+
+		const auto [newAsset, loaded] = loadAsset(assetId, ResourceLoadPriority::High, false);
+		newAsset->setAssetId(assetId);
+		newAsset->onLoaded(parent);
+		res->reloadResource(std::move(*newAsset));
+
+		std::unique_lock lock(mutex);
+		const auto iter = resources.find(assetId);
+		if (iter != resources.end() && !iter->second.memoryUsageStale) {
+			iter->second.memoryUsageStale = true;
+			++staleMemoryUsages;
+		}
+	} catch (std::exception& e) {
+		Logger::logError("Error while reloading " + String(assetId) + ": " + e.what());
+	} catch (...) {
+		Logger::logError("Unknown error while reloading " + String(assetId));
 	}
 }
 
@@ -106,6 +169,50 @@ std::shared_ptr<Resource> ResourceCollectionBase::getUntyped(std::string_view na
 	return doGet(name, priority, true);
 }
 
+std::shared_future<std::shared_ptr<Resource>> ResourceCollectionBase::getUntypedAsync(std::string_view name, ResourceLoadPriority priority)
+{
+	onRequested(name);
+
+	// Tasks have to be copyable, so the promise is shared
+	auto promise = std::make_shared<std::promise<std::shared_ptr<Resource>>>();
+	auto result = promise->get_future().share();
+	{
+		std::unique_lock lockWrite(mutex);
+		const auto res = resources.find(name);
+		if (res != resources.end()) {
+			res->second.lastUsed.store(parent.nextResourceAccess(), std::memory_order_relaxed);
+			promise->set_value(res->second.res);
+			return result;
+		}
+
+		const auto pending = pendingLoads.find(name);
+		if (pending != pendingLoads.end()) {
+			return pending->second.result;
+		}
+
+		// Not owned by any thread until it starts loading, so requests for it in the meantime wait for it
+		pendingLoads[name] = PendingLoad{ result, std::thread::id() };
+	}
+
+	Concurrent::execute(Executors::getCPU(), ResourceLoader::getExecutionPriority(priority), [this, assetId = String(name), priority, promise = std::move(promise)] ()
+	{
+		{
+			std::unique_lock lockWrite(mutex);
+			if (const auto pending = pendingLoads.find(assetId); pending != pendingLoads.end()) {
+				pending->second.thread = std::this_thread::get_id();
+			}
+		}
+
+		try {
+			doLoad(assetId, priority, true, std::move(*promise));
+		} catch (...) {
+			// Already passed on through the future
+		}
+	});
+
+	return result;
+}
+
 Vector<String> ResourceCollectionBase::enumerate() const
 {
 	if (resourceEnumerator) {
@@ -138,7 +245,7 @@ void ResourceCollectionBase::age(float time)
 
 	for (auto& r: resources) {
 		const auto& resourcePtr = r.second.res;
-		if (resourcePtr.use_count() <= 2) {
+		if (!isInUse(r.second)) {
 			resourcePtr->increaseAge(time);
 		} else {
 			resourcePtr->resetAge();
@@ -148,27 +255,28 @@ void ResourceCollectionBase::age(float time)
 
 ResourceMemoryUsage ResourceCollectionBase::clearOldResources(float maxAge)
 {
-	Vector<decltype(resources)::iterator> toDelete;
+	Vector<std::shared_ptr<Resource>> toDelete;
 	ResourceMemoryUsage usage;
 
 	{
-		std::shared_lock lock(mutex);
-
-		for (auto iter = resources.begin(); iter != resources.end(); ) {
-			auto next = iter;
-			++next;
+		std::unique_lock lock(mutex);
 
-			auto& resourcePtr = iter->second.res;
-			if (resourcePtr.use_count() <= 2 && resourcePtr->getAge() > maxAge) {
+		Vector<String> toErase;
+		for (auto& [assetId, wrapper]: resources) {
+			auto& resourcePtr = wrapper.res;
+			if (!isInUse(wrapper) && resourcePtr->getAge() > maxAge && !pinned.contains(assetId)) {
 				usage += resourcePtr->getMemoryUsage();
-				toDelete.push_back(iter);
+				toErase.push_back(assetId);
 			}
-
-			iter = next;
 		}
 
-		for (auto& a: toDelete) {
-			resources.erase(a);
+		// Erasing moves other entries around, so erase by key rather than holding on to iterators
+		toDelete.reserve(toErase.size());
+		for (const auto& assetId: toErase) {
+			const auto iter = resources.find(assetId);
+			releaseWrapper(iter->second);
+			toDelete.push_back(std::move(iter->second.res));
+			resources.erase(iter);
 		}
 	}
 
@@ -185,7 +293,7 @@ ResourceMemoryUsage ResourceCollectionBase::getMemoryUsageAndAge(float time)
 
 	for (auto& r: resources) {
 		auto& resourcePtr = r.second.res;
-		if (resourcePtr.use_count() <= 2) {
+		if (!isInUse(r.second)) {
 			resourcePtr->increaseAge(time);
 		} else {
 			resourcePtr->resetAge();
@@ -211,6 +319,7 @@ std::pair<std::shared_ptr<Resource>, bool> ResourceCollectionBase::loadAsset(std
 		newRes = loadResource(resLoader);
 		if (newRes) {
 			newRes->setMeta(resLoader.getMeta());
+			parent.dependencyGraph.addDependencies(ResourceDependencyGraph::makeAssetId(type, assetId), resLoader.getMeta().getEntries()["dependencies"]);
 		} else if (resLoader.loaded) {
 			throw Exception("Unable to construct resource from data: " + toString(type) + ":" + assetId, HalleyExceptions::Resources);
 		}
@@ -228,36 +337,123 @@ std::pair<std::shared_ptr<Resource>, bool> ResourceCollectionBase::loadAsset(std
 	return std::make_pair(newRes, true);
 }
 
+void ResourceCollectionBase::onRequested(std::string_view assetId)
+{
+	// Dependencies are loaded along with whatever needs them, so only outermost requests are seen by the prefetcher
+	if (loadingAssets.empty()) {
+		parent.prefetcher->onRequested(type, assetId);
+	} else {
+		parent.dependencyGraph.addDependency(loadingAssets.back(), ResourceDependencyGraph::makeAssetId(type, assetId));
+	}
+}
+
 std::shared_ptr<Resource> ResourceCollectionBase::doGet(std::string_view assetId, ResourceLoadPriority priority, bool allowFallback)
 {
+	onRequested(assetId);
+
 	// Look in cache and return if it's there
 	{
 		std::shared_lock lock(mutex);
 		const auto res = resources.find(assetId);
 		if (res != resources.end()) {
+			res->second.lastUsed.store(parent.nextResourceAccess(), std::memory_order_relaxed);
 			return res->second.res;
 		}
 	}
 
 	// Lock mutex, and make sure it's still not there (someone else might have gone through this by now)
-	std::unique_lock lockWrite(mutex);
-	const auto res = resources.find(assetId);
-	if (res != resources.end()) {
-		return res->second.res;
+	// The lock is only held to look up and register the load, so different assets can load concurrently
+	std::shared_future<std::shared_ptr<Resource>> pendingResult;
+	{
+		std::unique_lock lockWrite(mutex);
+		const auto res = resources.find(assetId);
+		if (res != resources.end()) {
+			return res->second.res;
+		}
+
+		const auto pending = pendingLoads.find(assetId);
+		if (pending == pendingLoads.end()) {
+			std::promise<std::shared_ptr<Resource>> promise;
+			pendingLoads[assetId] = PendingLoad{ promise.get_future().share(), std::this_thread::get_id() };
+			lockWrite.unlock();
+			return doLoad(assetId, priority, allowFallback, std::move(promise));
+		}
+
+		if (pending->second.thread == std::this_thread::get_id()) {
+			throw Exception("Circular dependency while loading \"" + toString(type) + ":" + assetId + "\"", HalleyExceptions::Resources);
+		}
+		if (loadingAssets.empty()) {
+			pendingResult = pending->second.result;
+		}
 	}
-	
-	// Load resource from disk
-	const auto [newRes, loaded] = loadAsset(assetId, priority, allowFallback);
 
-	// Store in cache
-	if (loaded) {
-		newRes->setAssetId(assetId);
-		resources.emplace(assetId, Wrapper(newRes, 0));
+	if (pendingResult.valid()) {
+		// Someone else is already loading it, wait for them
+		return pendingResult.get();
+	} else {
+		// Waiting while in the middle of another load could deadlock, if the other thread is waiting on something this one is loading, so load a copy instead
+		return doLoad(assetId, priority, allowFallback, std::nullopt);
+	}
+}
+
+std::shared_ptr<Resource> ResourceCollectionBase::doLoad(std::string_view assetId, ResourceLoadPriority priority, bool allowFallback, std::optional<std::promise<std::shared_ptr<Resource>>> promise)
+{
+	std::shared_ptr<Resource> result;
+	try {
+		// Load resource from disk
+		bool loaded = false;
+		{
+			const auto id = ResourceDependencyGraph::makeAssetId(type, assetId);
+			if (promise) {
+				parent.dependencyGraph.clearDependencies(id);
+			}
+			LoadingAssetGuard guard(id);
+			std::tie(result, loaded) = loadAsset(assetId, priority, allowFallback);
+		}
+
+		// Store in cache
+		std::unique_lock lockWrite(mutex);
+		bool inserted = false;
+		if (loaded) {
+			result->setAssetId(assetId);
+			// Another load of the same asset may have finished first, in which case its copy is kept, and this one never counts towards memory usage
+			if (const auto iter = resources.find(assetId); iter != resources.end()) {
+				result = iter->second.res;
+			} else {
+				resources.emplace(assetId, makeWrapper(result, 0, priority));
+				inserted = true;
+			}
+		}
+		if (promise) {
+			pendingLoads.erase(assetId);
+		}
 		lockWrite.unlock();
-		newRes->onLoaded(parent);
+
+		if (inserted) {
+			{
+				LoadingAssetGuard guard(ResourceDependencyGraph::makeAssetId(type, assetId));
+				result->onLoaded(parent);
+			}
+			if (loadingAssets.empty()) {
+				// Only from the outermost load, so nothing is evicted halfway through loading its dependencies
+				parent.onResourceAdded();
+			}
+		}
+	} catch (...) {
+		if (promise) {
+			{
+				std::unique_lock lockWrite(mutex);
+				pendingLoads.erase(assetId);
+			}
+			promise->set_exception(std::current_exception());
+		}
+		throw;
 	}
 
-	return newRes;
+	if (promise) {
+		promise->set_value(result);
+	}
+	return result;
 }
 
 bool ResourceCollectionBase::exists(std::string_view assetId) const
@@ -277,7 +473,10 @@ void ResourceCollectionBase::setFallback(std::string_view assetId)
 }
 
 void ResourceCollectionBase::setResource(int curDepth, std::string_view name, std::shared_ptr<Resource> resource) {
-	resources.emplace(name, Wrapper(std::move(resource), curDepth));
+	std::unique_lock lock(mutex);
+	if (resources.find(name) == resources.end()) {
+		resources.emplace(name, makeWrapper(std::move(resource), curDepth, ResourceLoadPriority::Normal));
+	}
 }
 
 void ResourceCollectionBase::setResourceLoader(ResourceLoaderFunc loader)
@@ -289,3 +488,126 @@ void ResourceCollectionBase::setResourceEnumerator(ResourceEnumeratorFunc enumer
 {
 	resourceEnumerator = std::move(enumerator);
 }
+
+void ResourceCollectionBase::setPinned(std::string_view assetId, bool pin)
+{
+	std::unique_lock lock(mutex);
+	if (pin) {
+		pinned.insert(String(assetId));
+	} else {
+		pinned.erase(assetId);
+	}
+}
+
+bool ResourceCollectionBase::isPinned(std::string_view assetId) const
+{
+	std::shared_lock lock(mutex);
+	return pinned.contains(assetId);
+}
+
+void ResourceCollectionBase::setEvictionPriority(int priority)
+{
+	evictionPriority = priority;
+}
+
+int ResourceCollectionBase::getEvictionPriority() const
+{
+	return evictionPriority;
+}
+
+void ResourceCollectionBase::getEvictionCandidates(Vector<EvictionCandidate>& candidates)
+{
+	refreshMemoryUsage();
+
+	std::shared_lock lock(mutex);
+	for (const auto& [assetId, wrapper]: resources) {
+		if (!isInUse(wrapper) && !pinned.contains(assetId) && !wrapper.memoryUsageStale) {
+			candidates.push_back(EvictionCandidate{ this, assetId, wrapper.priority, wrapper.lastUsed.load(std::memory_order_relaxed), wrapper.memoryUsage });
+		}
+	}
+}
+
+ResourceMemoryUsage ResourceCollectionBase::evict(std::string_view assetId)
+{
+	std::shared_ptr<Resource> toDelete;
+	ResourceMemoryUsage usage;
+
+	{
+		std::unique_lock lock(mutex);
+		const auto iter = resources.find(assetId);
+		// Might have been picked up again since it was listed as a candidate
+		if (iter == resources.end() || isInUse(iter->second) || pinned.contains(assetId)) {
+			return {};
+		}
+
+		usage = iter->second.memoryUsage;
+		releaseWrapper(iter->second);
+		toDelete = std::move(iter->second.res);
+		resources.erase(iter);
+	}
+
+	// Delete out of the lock to avoid stalling resources for too long
+	toDelete.reset();
+
+	return usage;
+}
+
+void ResourceCollectionBase::releaseCaches()
+{
+	std::shared_lock lock(mutex);
+	for (auto& [assetId, wrapper]: resources) {
+		wrapper.res->releaseCaches();
+	}
+}
+
+ResourceCollectionBase::Wrapper ResourceCollectionBase::makeWrapper(std::shared_ptr<Resource> resource, int loadDepth, ResourceLoadPriority priority)
+{
+	auto wrapper = Wrapper(std::move(resource), loadDepth, priority, parent.nextResourceAccess());
+
+	// Async resources only know their real size once they finish loading
+	const auto* asyncResource = dynamic_cast<const AsyncResource*>(wrapper.res.get());
+	if (asyncResource && !asyncResource->isLoaded()) {
+		wrapper.memoryUsageStale = true;
+		++staleMemoryUsages;
+	} else {
+		wrapper.memoryUsage = wrapper.res->getMemoryUsage();
+	}
+	parent.addMemoryUsage(wrapper.memoryUsage);
+
+	return wrapper;
+}
+
+void ResourceCollectionBase::releaseWrapper(const Wrapper& wrapper)
+{
+	parent.removeMemoryUsage(wrapper.memoryUsage);
+	if (wrapper.memoryUsageStale) {
+		--staleMemoryUsages;
+	}
+}
+
+bool ResourceCollectionBase::isInUse(const Wrapper& wrapper) const
+{
+	// The collection holds one reference, so any more means it's still used elsewhere, and evicting or ageing it wouldn't free anything
+	return wrapper.res.use_count() > 1;
+}
+
+void ResourceCollectionBase::refreshMemoryUsage()
+{
+	std::unique_lock lock(mutex);
+	if (staleMemoryUsages == 0) {
+		return;
+	}
+
+	for (auto& [assetId, wrapper]: resources) {
+		if (wrapper.memoryUsageStale) {
+			const auto* asyncResource = dynamic_cast<const AsyncResource*>(wrapper.res.get());
+			if (!asyncResource || asyncResource->isLoaded()) {
+				parent.removeMemoryUsage(wrapper.memoryUsage);
+				wrapper.memoryUsage = wrapper.res->getMemoryUsage();
+				parent.addMemoryUsage(wrapper.memoryUsage);
+				wrapper.memoryUsageStale = false;
+				--staleMemoryUsages;
+			}
+		}
+	}
+}
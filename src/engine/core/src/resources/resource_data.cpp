@@ -7,6 +7,10 @@
 #include "halley/api/halley_api.h"
 #include "halley/support/profiler.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 using namespace Halley;
 
 Bytes ResourceDataReader::readAll()
@@ -16,6 +20,11 @@ Bytes ResourceDataReader::readAll()
 	return result;
 }
 
+int ResourceDataReader::readAt(size_t pos, gsl::span<gsl::byte> dst)
+{
+	throw Exception("Positional reads are not supported by this reader.", HalleyExceptions::Resources);
+}
+
 ResourceDataReaderFileSystem::ResourceDataReaderFileSystem(Path path)
 {
 	FILE* f;
@@ -82,7 +91,163 @@ void ResourceDataReaderFileSystem::close()
 	if (fp) {
 		FILE* f = static_cast<FILE*>(fp);
 		fclose(f);
+		fp = nullptr;
+	}
+}
+
+bool ResourceDataReaderFileSystem::supportsReadAt() const
+{
+#ifdef _WIN32
+	return false;
+#else
+	return fp != nullptr;
+#endif
+}
+
+int ResourceDataReaderFileSystem::readAt(size_t pos, gsl::span<gsl::byte> dst)
+{
+#ifdef _WIN32
+	return ResourceDataReader::readAt(pos, dst);
+#else
+	if (!fp) {
+		return 0;
+	}
+
+	// pread goes straight to the descriptor, bypassing FILE's buffer and position
+	const int fd = fileno(static_cast<FILE*>(fp));
+	size_t total = 0;
+	while (total < dst.size()) {
+		const auto n = pread(fd, dst.data() + total, dst.size() - total, static_cast<off_t>(pos + total));
+		if (n <= 0) {
+			break;
+		}
+		total += static_cast<size_t>(n);
+	}
+	return static_cast<int>(total);
+#endif
+}
+
+
+ResourceDataReaderLZ4Chunked::ResourceDataReaderLZ4Chunked(std::unique_ptr<ResourceDataReader> src)
+	: source(std::move(src))
+{
+	std::array<gsl::byte, sizeof(Compression::LZ4ChunkedHeader)> headerBytes;
+	readSource(0, headerBytes);
+	header = Compression::lz4ReadChunkedHeader(headerBytes);
+
+	offsets.resize(header.numChunks + 1);
+	readSource(sizeof(header), gsl::as_writable_bytes(gsl::span<uint64_t>(offsets)));
+	for (size_t i = 0; i < header.numChunks; ++i) {
+		if (offsets[i] > offsets[i + 1] || offsets[i + 1] > source->size()) {
+			throw Exception("Chunked LZ4 stream has an invalid chunk table", HalleyExceptions::Resources);
+		}
+	}
+}
+
+size_t ResourceDataReaderLZ4Chunked::size() const
+{
+	return static_cast<size_t>(header.size);
+}
+
+int ResourceDataReaderLZ4Chunked::read(gsl::span<gsl::byte> dst)
+{
+	std::unique_lock lock(mutex);
+	const int n = doReadAt(curPos, dst);
+	curPos += n;
+	return n;
+}
+
+void ResourceDataReaderLZ4Chunked::seek(int64_t pos, int whence)
+{
+	std::unique_lock lock(mutex);
+	switch (whence) {
+	case SEEK_SET:
+		curPos = size_t(pos);
+		break;
+	case SEEK_CUR:
+		curPos = size_t(curPos + pos);
+		break;
+	case SEEK_END:
+		curPos = size_t(header.size + pos);
+		break;
+	}
+}
+
+size_t ResourceDataReaderLZ4Chunked::tell() const
+{
+	std::unique_lock lock(mutex);
+	return curPos;
+}
+
+void ResourceDataReaderLZ4Chunked::close()
+{
+	std::unique_lock lock(mutex);
+	source->close();
+	curChunk.reset();
+	compressed.clear();
+	decompressed.clear();
+}
+
+bool ResourceDataReaderLZ4Chunked::isAvailable() const
+{
+	return source->isAvailable();
+}
+
+bool ResourceDataReaderLZ4Chunked::supportsReadAt() const
+{
+	// Positional reads share the cached chunk, so they're serialized, but they never disturb the read position
+	return true;
+}
+
+int ResourceDataReaderLZ4Chunked::readAt(size_t pos, gsl::span<gsl::byte> dst)
+{
+	std::unique_lock lock(mutex);
+	return doReadAt(pos, dst);
+}
+
+void ResourceDataReaderLZ4Chunked::readSource(size_t pos, gsl::span<gsl::byte> dst)
+{
+	size_t n;
+	if (source->supportsReadAt()) {
+		n = size_t(source->readAt(pos, dst));
+	} else {
+		source->seek(int64_t(pos), SEEK_SET);
+		n = size_t(source->read(dst));
+	}
+	if (n != dst.size()) {
+		throw Exception("Unexpected end of chunked LZ4 stream", HalleyExceptions::Resources);
+	}
+}
+
+int ResourceDataReaderLZ4Chunked::doReadAt(size_t pos, gsl::span<gsl::byte> dst)
+{
+	size_t total = 0;
+	while (total < dst.size() && pos + total < header.size) {
+		const size_t p = pos + total;
+		const size_t chunkIdx = p / header.chunkSize;
+		loadChunk(chunkIdx);
+
+		const size_t offsetInChunk = p - chunkIdx * header.chunkSize;
+		const size_t n = std::min(decompressed.size() - offsetInChunk, dst.size() - total);
+		memcpy(dst.data() + total, decompressed.data() + offsetInChunk, n);
+		total += n;
 	}
+	return int(total);
+}
+
+void ResourceDataReaderLZ4Chunked::loadChunk(size_t idx)
+{
+	if (curChunk == idx) {
+		return;
+	}
+	curChunk.reset();
+
+	compressed.resize(offsets[idx + 1] - offsets[idx]);
+	readSource(offsets[idx], compressed.byte_span());
+
+	decompressed.resize(std::min(size_t(header.chunkSize), size_t(header.size - idx * header.chunkSize)));
+	Compression::lz4DecompressChunk(header, idx, compressed.byte_span(), decompressed.byte_span());
+	curChunk = idx;
 }
 
 
@@ -104,6 +269,14 @@ ResourceDataStatic::ResourceDataStatic(const void* _data, size_t _size, String p
 	set(_data, _size, owning);
 }
 
+ResourceDataStatic::ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path)
+	: ResourceData(path)
+	, data(std::move(data))
+	, size(size)
+	, loaded(true)
+{
+}
+
 static void deleter(const char* data)
 {
 	delete[] data;
@@ -157,6 +330,11 @@ void ResourceDataStatic::lz4Decompress()
 	data = Compression::lz4DecompressFileToSharedPtr(getSpan(), {}, size);
 }
 
+void ResourceDataStatic::lz4DecompressChunked()
+{
+	data = Compression::lz4DecompressChunkedToSharedPtr(getSpan(), size);
+}
+
 std::unique_ptr<ResourceDataStatic> ResourceDataStatic::loadFromFileSystem(Path path)
 {
 	std::ifstream fp(path.string(), std::ios::binary | std::ios::in);
@@ -222,6 +400,8 @@ std::unique_ptr<ResourceDataStatic> ResourceLoader::getStatic(bool throwOnFail)
 		try {
 			if (metadata && metadata->getString("asset_compression", "") == "lz4") {
 				result->lz4Decompress();
+			} else if (metadata && metadata->getString("asset_compression", "") == "lz4chunked") {
+				result->lz4DecompressChunked();
 			} else if (metadata && metadata->getString("asset_compression", "") == "deflate") {
 				result->inflate();
 			}
@@ -241,25 +421,63 @@ std::unique_ptr<ResourceDataStream> ResourceLoader::getStream(bool throwOnFail)
 {
 	auto result = locator.getStream(name, type, throwOnFail);
 	if (result) {
+		if (metadata && metadata->getString("asset_compression", "") == "lz4chunked") {
+			// Decompressed on the fly, one chunk at a time
+			std::shared_ptr<ResourceDataStream> compressed = std::move(result);
+			result = std::make_unique<ResourceDataStream>(compressed->getPath(), [compressed] () -> std::unique_ptr<ResourceDataReader>
+			{
+				return std::make_unique<ResourceDataReaderLZ4Chunked>(compressed->getReader());
+			});
+		}
 		loaded = true;
 	}
 	return result;
 }
 
-Future<std::unique_ptr<ResourceDataStatic>> ResourceLoader::getAsync(bool throwOnFail) const
+ExecutionPriority ResourceLoader::getExecutionPriority() const
+{
+	return getExecutionPriority(priority);
+}
+
+ExecutionPriority ResourceLoader::getExecutionPriority(ResourceLoadPriority priority)
+{
+	switch (priority) {
+	case ResourceLoadPriority::Low:
+		return ExecutionPriority::Low;
+	case ResourceLoadPriority::High:
+		return ExecutionPriority::High;
+	default:
+		return ExecutionPriority::Normal;
+	}
+}
+
+Future<std::unique_ptr<ResourceDataStatic>> ResourceLoader::getAsync(bool throwOnFail, std::weak_ptr<const void> owner) const
 {
 	std::reference_wrapper<IResourceLocator> loc = locator;
 	auto n = name;
 	auto t = type;
-	auto meta = getMeta();
-	return Concurrent::execute(Executors::getDiskIO(), [meta, loc, n, t, throwOnFail] () -> std::unique_ptr<ResourceDataStatic>
+	const auto compression = getMeta().getString("asset_compression", "");
+	const auto executionPriority = getExecutionPriority();
+	const bool hasOwner = !owner.expired();
+
+	// The I/O thread only does the read, so a large decompression can't hold back other reads
+	return Concurrent::execute(Executors::getDiskIO(), executionPriority, [loc, n, t, throwOnFail, owner, hasOwner] () -> std::unique_ptr<ResourceDataStatic>
 	{
+		if (hasOwner && owner.expired()) {
+			return {};
+		}
 		ProfilerEvent event(ProfilerEventType::DiskIO);
-		auto result = loc.get().getStatic(n, t, throwOnFail);
-		if (meta.getString("asset_compression", "") == "lz4") {
-			result->lz4Decompress();
-		} else if (meta.getString("asset_compression", "") == "deflate") {
-			result->inflate();
+		return loc.get().getStatic(n, t, throwOnFail);
+	}).then(Executors::getCPU(), executionPriority, [compression] (std::unique_ptr<ResourceDataStatic> result) -> std::unique_ptr<ResourceDataStatic>
+	{
+		if (result) {
+			if (compression == "lz4") {
+				result->lz4Decompress();
+			} else if (compression == "lz4chunked") {
+				result->lz4DecompressChunked();
+			} else if (compression == "deflate") {
+				result->inflate();
+			}
 		}
 		return result;
 	});
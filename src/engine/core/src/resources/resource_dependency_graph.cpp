@@ -0,0 +1,167 @@
+#include "halley/resources/resource_dependency_graph.h"
+#include "halley/resources/resource.h"
+#include <algorithm>
+
+using namespace Halley;
+
+String ResourceDependencyGraph::makeAssetId(AssetType type, std::string_view name)
+{
+	return toString(type) + ":" + name;
+}
+
+ConfigNode ResourceDependencyGraph::makeDependencyList(const HashSet<String>& assetIds)
+{
+	Vector<String> sorted(assetIds.begin(), assetIds.end());
+	std::sort(sorted.begin(), sorted.end());
+
+	ConfigNode::SequenceType result;
+	result.reserve(sorted.size());
+	for (auto& id: sorted) {
+		result.push_back(ConfigNode(std::move(id)));
+	}
+	return result;
+}
+
+void ResourceDependencyGraph::addDependency(const String& dependent, const String& dependency)
+{
+	if (dependent == dependency) {
+		return;
+	}
+
+	std::unique_lock lock(mutex);
+	dependencies[dependent].insert(dependency);
+	dependents[dependency].insert(dependent);
+}
+
+void ResourceDependencyGraph::addDependencies(const String& dependent, const ConfigNode& dependencyList)
+{
+	if (dependencyList.getType() == ConfigNodeType::Sequence) {
+		for (const auto& dependency: dependencyList.asSequence()) {
+			addDependency(dependent, dependency.asString());
+		}
+	}
+}
+
+void ResourceDependencyGraph::clearDependencies(const String& dependent)
+{
+	std::unique_lock lock(mutex);
+	const auto iter = dependencies.find(dependent);
+	if (iter == dependencies.end()) {
+		return;
+	}
+
+	for (const auto& dependency: iter->second) {
+		const auto depIter = dependents.find(dependency);
+		if (depIter != dependents.end()) {
+			depIter->second.erase(dependent);
+			if (depIter->second.empty()) {
+				dependents.erase(depIter);
+			}
+		}
+	}
+	dependencies.erase(iter);
+}
+
+Vector<String> ResourceDependencyGraph::getDependencies(const String& assetId) const
+{
+	std::unique_lock lock(mutex);
+	const auto iter = dependencies.find(assetId);
+	return iter != dependencies.end() ? Vector<String>(iter->second.begin(), iter->second.end()) : Vector<String>();
+}
+
+Vector<String> ResourceDependencyGraph::getDependents(const String& assetId) const
+{
+	std::unique_lock lock(mutex);
+	const auto iter = dependents.find(assetId);
+	return iter != dependents.end() ? Vector<String>(iter->second.begin(), iter->second.end()) : Vector<String>();
+}
+
+Vector<Vector<String>> ResourceDependencyGraph::getReloadOrder(const Vector<String>& changed) const
+{
+	std::unique_lock lock(mutex);
+
+	// Everything that depends on a changed asset, directly or not
+	HashSet<String> affected;
+	Vector<String> toVisit = changed;
+	while (!toVisit.empty()) {
+		auto cur = std::move(toVisit.back());
+		toVisit.pop_back();
+		if (affected.contains(cur)) {
+			continue;
+		}
+
+		const auto iter = dependents.find(cur);
+		if (iter != dependents.end()) {
+			for (const auto& dependent: iter->second) {
+				if (!affected.contains(dependent)) {
+					toVisit.push_back(dependent);
+				}
+			}
+		}
+		affected.insert(std::move(cur));
+	}
+
+	// Kahn's algorithm, restricted to the affected assets
+	HashMap<String, int> pendingDependencies;
+	for (const auto& id: affected) {
+		int count = 0;
+		const auto iter = dependencies.find(id);
+		if (iter != dependencies.end()) {
+			for (const auto& dependency: iter->second) {
+				if (affected.contains(dependency)) {
+					++count;
+				}
+			}
+		}
+		pendingDependencies[id] = count;
+	}
+
+	Vector<Vector<String>> result;
+	Vector<String> stage;
+	for (const auto& [id, count]: pendingDependencies) {
+		if (count == 0) {
+			stage.push_back(id);
+		}
+	}
+
+	size_t placed = 0;
+	while (!stage.empty()) {
+		placed += stage.size();
+		Vector<String> next;
+		for (const auto& id: stage) {
+			const auto iter = dependents.find(id);
+			if (iter != dependents.end()) {
+				for (const auto& dependent: iter->second) {
+					if (--pendingDependencies.at(dependent) == 0) {
+						next.push_back(dependent);
+					}
+				}
+			}
+		}
+		result.push_back(std::move(stage));
+		stage = std::move(next);
+	}
+
+	// Loading rejects circular dependencies, but metadata could still describe one, so don't leave anything out
+	if (placed < affected.size()) {
+		Vector<String> remaining;
+		for (const auto& [id, count]: pendingDependencies) {
+			if (count > 0) {
+				remaining.push_back(id);
+			}
+		}
+		result.push_back(std::move(remaining));
+	}
+
+	// Sort each stage by type, as the order of AssetType still matters for dependencies that weren't recorded
+	for (auto& s: result) {
+		std::sort(s.begin(), s.end(), [] (const String& a, const String& b)
+		{
+			const auto typeA = fromString<AssetType>(a.left(a.find(':')));
+			const auto typeB = fromString<AssetType>(b.left(b.find(':')));
+			return typeA != typeB ? typeA < typeB : a < b;
+		});
+	}
+
+	return result;
+}
@@ -5,13 +5,14 @@
 #include "halley/utils/algorithm.h"
 using namespace Halley;
 
-PackResourceLocator::PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String key, bool preLoad, std::optional<int> priority)
+PackResourceLocator::PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String key, bool preLoad, std::optional<int> priority, bool memoryMapped)
 	: path(std::move(path))
 	, encryptionKey(std::move(key))
 	, preLoad(preLoad)
+	, memoryMapped(memoryMapped)
 	, priority(priority)
 {
-	assetPack = std::make_unique<AssetPack>(std::move(reader), encryptionKey, preLoad);
+	load(std::move(reader));
 }
 
 PackResourceLocator::~PackResourceLocator()
@@ -54,7 +55,15 @@ bool PackResourceLocator::purgeIfAffected(SystemAPI& system, gsl::span<const Str
 
 void PackResourceLocator::loadAfterPurge()
 {
-	assetPack = std::make_unique<AssetPack>(system->getDataReader(path.string()), encryptionKey, preLoad);
+	load(system->getDataReader(path.string()));
+}
+
+void PackResourceLocator::load(std::unique_ptr<ResourceDataReader> reader)
+{
+	assetPack = std::make_unique<AssetPack>(std::move(reader), encryptionKey, preLoad);
+	if (memoryMapped && !assetPack->mapToMemory(path)) {
+		Logger::logWarning("Unable to memory map pack \"" + path.string() + "\", reading it from file instead.");
+	}
 }
 
 int PackResourceLocator::getPriority() const
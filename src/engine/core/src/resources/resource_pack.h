@@ -9,7 +9,7 @@ namespace Halley {
 
 	class PackResourceLocator final : public IResourceLocatorProvider {
 	public:
-		explicit PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {});
+		explicit PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {}, bool memoryMapped = false);
 		~PackResourceLocator();
 
 	protected:
@@ -21,12 +21,14 @@ namespace Halley {
 		
 	private:
 		void loadAfterPurge();
+		void load(std::unique_ptr<ResourceDataReader> reader);
 
 		std::unique_ptr<AssetPack> assetPack;
 
 		Path path;
 		String encryptionKey; // :(
 		bool preLoad;
+		bool memoryMapped;
 		std::optional<int> priority;
 		SystemAPI* system = nullptr;
 	};
@@ -0,0 +1,349 @@
+#include "halley/resources/resource_prefetcher.h"
+#include "halley/resources/resources.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/utils/algorithm.h"
+#include "halley/support/logger.h"
+
+using namespace Halley;
+
+namespace {
+	// Set while the prefetcher itself is requesting assets, so those requests aren't recorded or counted
+	thread_local bool isPrefetching = false;
+
+	String makeKey(AssetType type, std::string_view name)
+	{
+		return toString(type) + ":" + name;
+	}
+}
+
+ResourcePrefetchManifest::ResourcePrefetchManifest(const ConfigNode& node)
+{
+	if (node.getType() == ConfigNodeType::Map) {
+		for (const auto& [stageId, stageNode]: node["stages"].asMap()) {
+			Vector<Entry> entries;
+			for (const auto& entryNode: stageNode.asSequence()) {
+				const auto assetId = entryNode["asset"].asString();
+				const auto splitPos = assetId.find(':');
+				entries.push_back(Entry{ fromString<AssetType>(assetId.left(splitPos)), assetId.mid(splitPos + 1), entryNode["time"].asFloat(0) });
+			}
+			stages[stageId] = std::move(entries);
+		}
+	}
+}
+
+ConfigNode ResourcePrefetchManifest::toConfigNode() const
+{
+	ConfigNode::MapType stagesNode;
+	for (const auto& [stageId, entries]: stages) {
+		ConfigNode::SequenceType entriesNode;
+		entriesNode.reserve(entries.size());
+		for (const auto& entry: entries) {
+			ConfigNode::MapType entryNode;
+			entryNode["asset"] = makeKey(entry.type, entry.name);
+			entryNode["time"] = entry.time;
+			entriesNode.push_back(std::move(entryNode));
+		}
+		stagesNode[stageId] = std::move(entriesNode);
+	}
+
+	ConfigNode::MapType result;
+	result["stages"] = std::move(stagesNode);
+	return result;
+}
+
+void ResourcePrefetchManifest::setStage(const String& stageId, Vector<Entry> entries)
+{
+	stages[stageId] = std::move(entries);
+}
+
+void ResourcePrefetchManifest::mergeStage(const String& stageId, Vector<Entry> entries)
+{
+	auto& stage = stages[stageId];
+
+	HashMap<String, size_t> indices;
+	for (size_t i = 0; i < stage.size(); ++i) {
+		indices[makeKey(stage[i].type, stage[i].name)] = i;
+	}
+
+	for (auto& entry: entries) {
+		const auto iter = indices.find(makeKey(entry.type, entry.name));
+		if (iter != indices.end()) {
+			stage[iter->second].time = std::min(stage[iter->second].time, entry.time);
+		} else {
+			indices[makeKey(entry.type, entry.name)] = stage.size();
+			stage.push_back(std::move(entry));
+		}
+	}
+
+	std::stable_sort(stage.begin(), stage.end(), [] (const Entry& a, const Entry& b) { return a.time < b.time; });
+}
+
+const Vector<ResourcePrefetchManifest::Entry>* ResourcePrefetchManifest::tryGetStage(const String& stageId) const
+{
+	const auto iter = stages.find(stageId);
+	return iter != stages.end() ? &iter->second : nullptr;
+}
+
+Vector<String> ResourcePrefetchManifest::getStages() const
+{
+	Vector<String> result;
+	for (const auto& [stageId, entries]: stages) {
+		result.push_back(stageId);
+	}
+	return result;
+}
+
+
+ResourcePrefetcher::ResourcePrefetcher(Resources& resources)
+	: resources(resources)
+{
+}
+
+ResourcePrefetcher::~ResourcePrefetcher()
+{
+	stopPrefetch(true);
+}
+
+void ResourcePrefetcher::startRecording()
+{
+	stopPlayback();
+
+	std::unique_lock lock(mutex);
+	manifest = ResourcePrefetchManifest();
+	recordedEntries.clear();
+	requested.clear();
+	stageStart = std::chrono::steady_clock::now();
+	mode = Mode::Recording;
+}
+
+ResourcePrefetchManifest ResourcePrefetcher::stopRecording()
+{
+	std::unique_lock lock(mutex);
+	if (mode != Mode::Recording) {
+		return {};
+	}
+	flushRecording();
+	mode = Mode::Disabled;
+	return std::move(manifest);
+}
+
+void ResourcePrefetcher::startPlayback(ResourcePrefetchManifest m)
+{
+	stopPlayback();
+
+	std::unique_lock lock(mutex);
+	manifest = std::move(m);
+	requested.clear();
+	prefetched.clear();
+	stats = {};
+	mode = Mode::Playback;
+
+	if (const auto* entries = manifest.tryGetStage(stageId)) {
+		startPrefetch(*entries);
+	}
+}
+
+void ResourcePrefetcher::stopPlayback()
+{
+	if (mode == Mode::Playback) {
+		stopPrefetch(true);
+		std::unique_lock lock(mutex);
+		mode = Mode::Disabled;
+		expected.clear();
+	}
+}
+
+ResourcePrefetcher::Mode ResourcePrefetcher::getMode() const
+{
+	return mode;
+}
+
+void ResourcePrefetcher::setStage(const String& id)
+{
+	// Don't wait for the current prefetch to finish, it stops after the asset it's loading, and is waited for on stopPlayback or destruction
+	stopPrefetch(false);
+
+	std::unique_lock lock(mutex);
+	if (mode == Mode::Recording) {
+		flushRecording();
+	}
+
+	stageId = id;
+	stageStart = std::chrono::steady_clock::now();
+	requested.clear();
+	expected.clear();
+
+	if (mode == Mode::Playback) {
+		if (const auto* entries = manifest.tryGetStage(stageId)) {
+			startPrefetch(*entries);
+		}
+	}
+}
+
+ResourcePrefetcher::Stats ResourcePrefetcher::getStats() const
+{
+	std::unique_lock lock(mutex);
+	return stats;
+}
+
+void ResourcePrefetcher::onRequested(AssetType type, std::string_view name)
+{
+	if (mode == Mode::Disabled || isPrefetching) {
+		return;
+	}
+
+	auto key = makeKey(type, name);
+	std::unique_lock lock(mutex);
+	if (requested.contains(key)) {
+		return;
+	}
+	requested.insert(key);
+
+	if (mode == Mode::Recording) {
+		const float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - stageStart).count();
+		recordedEntries.push_back(ResourcePrefetchManifest::Entry{ type, String(name), time });
+	} else if (mode == Mode::Playback) {
+		if (prefetched.contains(key)) {
+			++stats.hits;
+		} else if (expected.contains(key)) {
+			++stats.late;
+		} else {
+			++stats.unlisted;
+		}
+	}
+}
+
+void ResourcePrefetcher::flushRecording()
+{
+	if (!recordedEntries.empty()) {
+		manifest.mergeStage(stageId, std::move(recordedEntries));
+		recordedEntries.clear();
+	}
+}
+
+void ResourcePrefetcher::startPrefetch(const Vector<ResourcePrefetchManifest::Entry>& entries)
+{
+	// Recorded in order of first request, so loading them in sequence gets each one ready as early as possible
+	for (const auto& entry: entries) {
+		expected.insert(makeKey(entry.type, entry.name));
+	}
+
+	// Finished prefetches don't need to be waited for anymore
+	std_ex::erase_if(prefetchStates, [] (const std::shared_ptr<PrefetchState>& state)
+	{
+		std::unique_lock lock(state->mutex);
+		return state->done;
+	});
+
+	auto state = std::make_shared<PrefetchState>();
+	prefetchStates.push_back(state);
+
+	Concurrent::execute(Executors::getCPUAux(), ExecutionPriority::Low, [this, state, entries, start = stageStart] ()
+	{
+		{
+			std::unique_lock lock(state->mutex);
+			if (state->cancelled) {
+				// Never started, so nothing to wait for, and this might no longer be around
+				state->done = true;
+				return;
+			}
+			state->busy = true;
+		}
+
+		// Recorded in order of first request, so each asset starts loading a little before it was needed last time, in the same order
+		Vector<std::pair<const ResourcePrefetchManifest::Entry*, std::shared_future<std::shared_ptr<Resource>>>> loads;
+		size_t nextToFinish = 0;
+		for (const auto& entry: entries) {
+			const auto startTime = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(entry.time - prefetchLead));
+
+			// Nothing else to start until then, so wrap up whatever is loading first
+			if (std::chrono::steady_clock::now() < startTime) {
+				for (; nextToFinish < loads.size(); ++nextToFinish) {
+					finishLoad(*loads[nextToFinish].first, loads[nextToFinish].second);
+				}
+			}
+
+			{
+				std::unique_lock lock(state->mutex);
+				state->cancel.wait_until(lock, startTime, [&] () { return state->cancelled; });
+				if (state->cancelled) {
+					break;
+				}
+			}
+
+			if (loads.size() - nextToFinish >= maxLoadsInFlight) {
+				finishLoad(*loads[nextToFinish].first, loads[nextToFinish].second);
+				++nextToFinish;
+			}
+			loads.emplace_back(&entry, startLoad(entry));
+		}
+
+		// Loads that already started are finished even if cancelled, as they need this to stay around
+		for (; nextToFinish < loads.size(); ++nextToFinish) {
+			finishLoad(*loads[nextToFinish].first, loads[nextToFinish].second);
+		}
+
+		{
+			std::unique_lock lock(state->mutex);
+			state->busy = false;
+			state->done = true;
+		}
+		state->idle.notify_all();
+	});
+}
+
+void ResourcePrefetcher::stopPrefetch(bool wait)
+{
+	// Cancelled prefetches stay listed until waited for, as they might still be loading an asset
+	Vector<std::shared_ptr<PrefetchState>> states;
+	{
+		std::unique_lock lock(mutex);
+		if (wait) {
+			states = std::move(prefetchStates);
+			prefetchStates.clear();
+		} else {
+			states = prefetchStates;
+		}
+	}
+
+	for (const auto& state: states) {
+		std::unique_lock lock(state->mutex);
+		state->cancelled = true;
+		state->cancel.notify_all();
+		if (wait) {
+			state->idle.wait(lock, [&] () { return !state->busy; });
+		}
+	}
+}
+
+std::shared_future<std::shared_ptr<Resource>> ResourcePrefetcher::startLoad(const ResourcePrefetchManifest::Entry& entry)
+{
+	isPrefetching = true;
+	std::shared_future<std::shared_ptr<Resource>> result;
+	try {
+		result = resources.ofType(entry.type).getUntypedAsync(entry.name, ResourceLoadPriority::Low);
+	} catch (const std::exception& e) {
+		Logger::logWarning("Unable to prefetch \"" + makeKey(entry.type, entry.name) + "\": " + e.what());
+	}
+	isPrefetching = false;
+	return result;
+}
+
+void ResourcePrefetcher::finishLoad(const ResourcePrefetchManifest::Entry& entry, const std::shared_future<std::shared_ptr<Resource>>& load)
+{
+	if (!load.valid()) {
+		return;
+	}
+
+	try {
+		static_cast<void>(load.get());
+
+		std::unique_lock lock(mutex);
+		prefetched.insert(makeKey(entry.type, entry.name));
+		++stats.prefetched;
+	} catch (const std::exception& e) {
+		Logger::logWarning("Unable to prefetch \"" + makeKey(entry.type, entry.name) + "\": " + e.what());
+	} catch (...) {
+		Logger::logWarning("Unable to prefetch \"" + makeKey(entry.type, entry.name) + "\"");
+	}
+}
@@ -1,6 +1,7 @@
 #include "halley/resources/resources.h"
 #include "halley/resources/resource_locator.h"
 #include "halley/api/halley_api.h"
+#include "halley/concurrency/concurrent.h"
 #include "halley/support/logger.h"
 
 using namespace Halley;
@@ -9,6 +10,7 @@ Resources::Resources(std::unique_ptr<ResourceLocator> locator, const HalleyAPI&
 	: locator(std::move(locator))
 	, api(&api)
 	, options(options)
+	, prefetcher(std::make_unique<ResourcePrefetcher>(*this))
 {
 }
 
@@ -37,30 +39,197 @@ void Resources::reloadAssets(const Vector<String>& ids, const Vector<String>& pa
 
 void Resources::reloadAssets(const std::map<AssetType, Vector<String>>& byType)
 {
+	const bool reloadingAudio = byType.find(AssetType::AudioClip) != byType.end();
+	if (reloadingAudio) {
+		api->audio->pausePlayback();
+	}
+
 	// Purge assets first, to force re-loading of any affected packs
+	Vector<String> changed;
 	for (auto& curType: byType) {
-		if (curType.first == AssetType::AudioClip) {
-			api->audio->pausePlayback();
-		}
-
 		auto& resources = ofType(curType.first);
 		for (auto& asset: curType.second) {
 			resources.purge(asset);
+			changed.push_back(ResourceDependencyGraph::makeAssetId(curType.first, asset));
 		}
 	}
 
-	// Reload assets
-	for (auto& curType: byType) {
-		auto& resources = ofType(curType.first);
-		for (auto& asset: curType.second) {
-			//Logger::logInfo("Reloading " + curType.first + ": " + asset);
-			resources.reload(asset);
+	// Reload them and everything built from them, one stage at a time, since each stage only depends on the ones before it
+	for (const auto& stage: dependencyGraph.getReloadOrder(changed)) {
+		Vector<std::pair<AssetType, String>> parallel;
+		Vector<std::pair<AssetType, String>> sequential;
+		for (const auto& id: stage) {
+			const auto splitPos = id.find(':');
+			const auto type = fromString<AssetType>(id.left(splitPos));
+			(canReloadInParallel(type) ? parallel : sequential).emplace_back(type, id.mid(splitPos + 1));
+		}
+
+		if (parallel.size() > 1 && Executors::hasInstance()) {
+			Concurrent::parallelFor(Executors::getCPU(), parallel.size(), [&] (size_t i)
+			{
+				ofType(parallel[i].first).reload(parallel[i].second);
+			});
+		} else {
+			for (const auto& [type, asset]: parallel) {
+				ofType(type).reload(asset);
+			}
 		}
 
-		if (curType.first == AssetType::AudioClip) {
-			api->audio->resumePlayback();
+		for (const auto& [type, asset]: sequential) {
+			//Logger::logInfo("Reloading " + toString(type) + ": " + asset);
+			ofType(type).reload(asset);
 		}
 	}
+
+	++reloadGeneration;
+
+	if (reloadingAudio) {
+		api->audio->resumePlayback();
+	}
+}
+
+bool Resources::canReloadInParallel(AssetType type)
+{
+	// Anything that might create GPU or audio objects while loading has to stay on the calling thread.
+	// Prefabs and scenes also wait on the assets they reference, which may be loading on this same pool, so they can't run on it either.
+	switch (type) {
+	case AssetType::BinaryFile:
+	case AssetType::TextFile:
+	case AssetType::ConfigFile:
+	case AssetType::GameProperties:
+	case AssetType::Shader:
+	case AssetType::Image:
+	case AssetType::VariableTable:
+	case AssetType::ScriptGraph:
+	case AssetType::NavmeshSet:
+	case AssetType::UIDefinition:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Resources::setMemoryBudget(ResourceMemoryUsage budget)
+{
+	ramBudget = budget.ramUsage;
+	vramBudget = budget.vramUsage;
+}
+
+ResourceMemoryUsage Resources::getMemoryBudget() const
+{
+	return ResourceMemoryUsage{ ramBudget, vramBudget };
+}
+
+ResourceMemoryUsage Resources::getMemoryUsage() const
+{
+	return ResourceMemoryUsage{ ramUsage, vramUsage };
+}
+
+ResourceMemoryUsage Resources::enforceMemoryBudget()
+{
+	std::unique_lock lock(evictionMutex);
+	return doEnforceMemoryBudget();
+}
+
+void Resources::addMemoryUsage(const ResourceMemoryUsage& usage)
+{
+	ramUsage += usage.ramUsage;
+	vramUsage += usage.vramUsage;
+}
+
+void Resources::removeMemoryUsage(const ResourceMemoryUsage& usage)
+{
+	ramUsage -= usage.ramUsage;
+	vramUsage -= usage.vramUsage;
+}
+
+bool Resources::isOverBudget() const
+{
+	return (ramBudget > 0 && ramUsage > ramBudget) || (vramBudget > 0 && vramUsage > vramBudget);
+}
+
+uint64_t Resources::nextResourceAccess()
+{
+	return resourceAccessClock.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Resources::onResourceAdded()
+{
+	if (!isOverBudget()) {
+		return;
+	}
+
+	// If another thread is already evicting, let it do the work
+	std::unique_lock lock(evictionMutex, std::try_to_lock);
+	if (lock.owns_lock() && std::chrono::steady_clock::now() - lastEviction >= minEvictionInterval) {
+		doEnforceMemoryBudget();
+	}
+}
+
+ResourceMemoryUsage Resources::doEnforceMemoryBudget()
+{
+	lastEviction = std::chrono::steady_clock::now();
+
+	auto freed = evictUnusedResources();
+
+	// Whatever is left might be kept in use by caches (e.g. prefab templates holding on to materials and their textures), so drop those and try again
+	if (isOverBudget()) {
+		for (auto& collection: resources) {
+			if (collection) {
+				collection->releaseCaches();
+			}
+		}
+		freed += evictUnusedResources();
+	}
+
+	if (isOverBudget()) {
+		Logger::logWarning("Resources are over the memory budget after eviction, using " + getMemoryUsage().toString() + " out of " + getMemoryBudget().toString());
+	}
+
+	return freed;
+}
+
+ResourceMemoryUsage Resources::evictUnusedResources()
+{
+	Vector<ResourceCollectionBase::EvictionCandidate> candidates;
+	for (auto& collection: resources) {
+		if (collection) {
+			collection->getEvictionCandidates(candidates);
+		}
+	}
+
+	if (!isOverBudget()) {
+		return {};
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [] (const ResourceCollectionBase::EvictionCandidate& a, const ResourceCollectionBase::EvictionCandidate& b)
+	{
+		const int priorityA = a.collection->getEvictionPriority();
+		const int priorityB = b.collection->getEvictionPriority();
+		if (priorityA != priorityB) {
+			return priorityA < priorityB;
+		}
+		if (a.priority != b.priority) {
+			return a.priority < b.priority;
+		}
+		return a.lastUsed < b.lastUsed;
+	});
+
+	ResourceMemoryUsage freed;
+	for (const auto& candidate: candidates) {
+		const bool ramOver = ramBudget > 0 && ramUsage > ramBudget;
+		const bool vramOver = vramBudget > 0 && vramUsage > vramBudget;
+		if (!ramOver && !vramOver) {
+			break;
+		}
+
+		// Only evict things that help with whichever budget is exceeded
+		if ((ramOver && candidate.memoryUsage.ramUsage > 0) || (vramOver && candidate.memoryUsage.vramUsage > 0)) {
+			freed += candidate.collection->evict(candidate.assetId);
+		}
+	}
+
+	return freed;
 }
 
 void Resources::generateMemoryReport()
@@ -0,0 +1,230 @@
+#include "asio_udp_batch_socket.h"
+#include <iostream>
+
+#if defined(__linux__)
+#define HALLEY_ASIO_UDP_MMSG
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#endif
+
+using namespace Halley;
+namespace asio = boost::asio;
+
+namespace {
+#ifdef HALLEY_ASIO_UDP_MMSG
+	// Limits how long a single wake up can keep reading, so a flood of packets can't starve everything else
+	constexpr int maxReceiveRounds = 8;
+
+	bool isWouldBlock(int error)
+	{
+		return error == EAGAIN || error == EWOULDBLOCK;
+	}
+#endif
+}
+
+AsioUDPBatchSocket::AsioUDPBatchSocket(asio::io_service& service, const UDPEndpoint& localEndpoint)
+	: socket(service, localEndpoint)
+	, bufferPool(std::make_shared<NetworkBufferPool>())
+{
+#ifdef HALLEY_ASIO_UDP_MMSG
+	constexpr size_t nBuffers = maxBatchSize;
+#else
+	constexpr size_t nBuffers = 1;
+#endif
+	receiveEndpoints.resize(nBuffers);
+	for (size_t i = 0; i < nBuffers; ++i) {
+		receiveBuffers.push_back(bufferPool->acquire(maxDatagramSize));
+	}
+}
+
+void AsioUDPBatchSocket::startReceiving(ReceiveCallback callback)
+{
+	receiveCallback = std::move(callback);
+	receiveNext();
+}
+
+void AsioUDPBatchSocket::setSendErrorCallback(SendErrorCallback callback)
+{
+	sendErrorCallback = std::move(callback);
+}
+
+void AsioUDPBatchSocket::send(const UDPEndpoint& remote, const OutboundNetworkPacket& packet)
+{
+	const size_t offset = sendData.size();
+	sendData.resize_no_init(offset + maxDatagramSize);
+	const size_t size = packet.copyTo(gsl::as_writable_bytes(gsl::span<Byte>(sendData.data() + offset, maxDatagramSize)));
+	sendData.resize(offset + size);
+
+	sendQueue.push_back(QueuedDatagram{ remote, offset, size });
+}
+
+void AsioUDPBatchSocket::flush()
+{
+	size_t pos = 0;
+
+#ifdef HALLEY_ASIO_UDP_MMSG
+	std::array<mmsghdr, maxBatchSize> msgs;
+	std::array<iovec, maxBatchSize> iovecs;
+	while (pos < sendQueue.size()) {
+		const size_t n = std::min(maxBatchSize, sendQueue.size() - pos);
+		for (size_t i = 0; i < n; ++i) {
+			auto& datagram = sendQueue[pos + i];
+			iovecs[i].iov_base = sendData.data() + datagram.offset;
+			iovecs[i].iov_len = datagram.size;
+			msgs[i] = {};
+			msgs[i].msg_hdr.msg_name = datagram.remote.data();
+			msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(datagram.remote.size());
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		const int sent = sendmmsg(socket.native_handle(), msgs.data(), static_cast<unsigned int>(n), MSG_DONTWAIT);
+		if (sent < 0) {
+			const int error = errno;
+			if (isWouldBlock(error)) {
+				// Socket buffer is full, keep the rest for the next flush
+				break;
+			} else if (error != EINTR) {
+				// Errors are only reported for the first datagram of the batch
+				onSendError(sendQueue[pos].remote, strerror(error));
+				++pos;
+			}
+		} else {
+			pos += static_cast<size_t>(sent);
+		}
+	}
+#else
+	for (; pos < sendQueue.size(); ++pos) {
+		const auto& datagram = sendQueue[pos];
+		boost::system::error_code error;
+		socket.send_to(asio::buffer(sendData.data() + datagram.offset, datagram.size), datagram.remote, 0, error);
+		if (error) {
+			onSendError(datagram.remote, error.message());
+		}
+	}
+#endif
+
+	if (pos == sendQueue.size()) {
+		sendQueue.clear();
+		sendData.clear();
+	} else if (pos > 0) {
+		const size_t start = sendQueue[pos].offset;
+		sendData.erase(sendData.begin(), sendData.begin() + start);
+		sendQueue.erase(sendQueue.begin(), sendQueue.begin() + pos);
+		for (auto& datagram: sendQueue) {
+			datagram.offset -= start;
+		}
+	}
+}
+
+void AsioUDPBatchSocket::shutdown()
+{
+	flush();
+	socket.shutdown(UDPSocket::shutdown_both);
+}
+
+void AsioUDPBatchSocket::receiveNext()
+{
+#ifdef HALLEY_ASIO_UDP_MMSG
+	socket.async_wait(UDPSocket::wait_read, [this] (const boost::system::error_code& error)
+	{
+		if (error == asio::error::operation_aborted) {
+			return;
+		}
+
+		if (error) {
+			std::string errorMsg = error.message();
+			receiveCallback(receiveEndpoints[0], InboundNetworkPacket(), &errorMsg);
+		} else {
+			receiveBatch();
+		}
+
+		receiveNext();
+	});
+#else
+	socket.async_receive_from(asio::buffer(receiveBuffers[0].getData().data(), maxDatagramSize), receiveEndpoints[0], [this] (const boost::system::error_code& error, size_t size)
+	{
+		try {
+			Expects(size <= maxDatagramSize);
+
+			std::string errorMsg;
+			std::string* errorMsgPtr = nullptr;
+			if (error) {
+				errorMsg = error.message();
+				errorMsgPtr = &errorMsg;
+			}
+
+			receiveCallback(receiveEndpoints[0], error ? InboundNetworkPacket() : takeReceived(0, size), errorMsgPtr);
+		} catch (...) {
+			std::cout << "Exception while receiving a packet." << std::endl;
+		}
+
+		receiveNext();
+	});
+#endif
+}
+
+void AsioUDPBatchSocket::receiveBatch()
+{
+#ifdef HALLEY_ASIO_UDP_MMSG
+	std::array<mmsghdr, maxBatchSize> msgs;
+	std::array<iovec, maxBatchSize> iovecs;
+
+	for (int round = 0; round < maxReceiveRounds; ++round) {
+		for (size_t i = 0; i < maxBatchSize; ++i) {
+			iovecs[i].iov_base = receiveBuffers[i].getData().data();
+			iovecs[i].iov_len = maxDatagramSize;
+			msgs[i] = {};
+			msgs[i].msg_hdr.msg_name = receiveEndpoints[i].data();
+			msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(receiveEndpoints[i].capacity());
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		const int received = recvmmsg(socket.native_handle(), msgs.data(), static_cast<unsigned int>(maxBatchSize), MSG_DONTWAIT, nullptr);
+		if (received < 0) {
+			const int error = errno;
+			if (!isWouldBlock(error) && error != EINTR) {
+				std::string errorMsg = strerror(error);
+				receiveCallback(receiveEndpoints[0], InboundNetworkPacket(), &errorMsg);
+			}
+			return;
+		}
+
+		for (int i = 0; i < received; ++i) {
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				// Larger than any datagram we send, can't be valid
+				continue;
+			}
+
+			try {
+				receiveEndpoints[i].resize(msgs[i].msg_hdr.msg_namelen);
+				receiveCallback(receiveEndpoints[i], takeReceived(i, msgs[i].msg_len), nullptr);
+			} catch (...) {
+				std::cout << "Exception while receiving a packet." << std::endl;
+			}
+		}
+
+		if (received < static_cast<int>(maxBatchSize)) {
+			return;
+		}
+	}
+#endif
+}
+
+InboundNetworkPacket AsioUDPBatchSocket::takeReceived(size_t idx, size_t size)
+{
+	// The packet keeps the buffer it was received into, and the slot gets a recycled one
+	auto packet = InboundNetworkPacket(std::move(receiveBuffers[idx]), size);
+	receiveBuffers[idx] = bufferPool->acquire(maxDatagramSize);
+	return packet;
+}
+
+void AsioUDPBatchSocket::onSendError(const UDPEndpoint& remote, const std::string& error)
+{
+	std::cout << "Error sending packet: " << error << std::endl;
+	if (sendErrorCallback) {
+		sendErrorCallback(remote, error);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4834)
+#endif
+#define BOOST_SYSTEM_NO_DEPRECATED
+#define BOOST_ERROR_CODE_HEADER_ONLY
+#include <boost/asio.hpp>
+
+#include <array>
+#include <functional>
+#include <string>
+#include <gsl/gsl>
+#include "halley/data_structures/vector.h"
+#include "halley/net/connection/network_packet.h"
+#include "halley/utils/utils.h"
+
+namespace Halley
+{
+	using UDPEndpoint = boost::asio::ip::udp::endpoint;
+	using UDPSocket = boost::asio::ip::udp::socket;
+
+	// UDP socket shared by every connection of an AsioUDPNetworkService.
+	// Outbound datagrams are queued and sent together on flush(), and inbound ones are read straight into pooled NetworkBuffers, which are handed to the connections without copying.
+	// On Linux both directions use sendmmsg/recvmmsg, moving up to maxBatchSize datagrams per syscall.
+	class AsioUDPBatchSocket
+	{
+	public:
+		constexpr static size_t maxDatagramSize = 2048;
+		constexpr static size_t maxBatchSize = 64;
+
+		using ReceiveCallback = std::function<void(const UDPEndpoint& remote, InboundNetworkPacket packet, std::string* error)>;
+		using SendErrorCallback = std::function<void(const UDPEndpoint& remote, const std::string& error)>;
+
+		AsioUDPBatchSocket(boost::asio::io_service& service, const UDPEndpoint& localEndpoint);
+
+		void startReceiving(ReceiveCallback callback);
+		void setSendErrorCallback(SendErrorCallback callback);
+
+		void send(const UDPEndpoint& remote, const OutboundNetworkPacket& packet);
+		void flush();
+
+		void shutdown();
+
+	private:
+		struct QueuedDatagram {
+			UDPEndpoint remote;
+			size_t offset;
+			size_t size;
+		};
+
+		UDPSocket socket;
+		ReceiveCallback receiveCallback;
+		SendErrorCallback sendErrorCallback;
+
+		std::shared_ptr<NetworkBufferPool> bufferPool;
+		Vector<NetworkBufferRef> receiveBuffers;
+		Vector<UDPEndpoint> receiveEndpoints;
+
+		Bytes sendData;
+		Vector<QueuedDatagram> sendQueue;
+
+		void receiveNext();
+		void receiveBatch();
+		InboundNetworkPacket takeReceived(size_t idx, size_t size);
+		void onSendError(const UDPEndpoint& remote, const std::string& error);
+	};
+}
@@ -20,7 +20,7 @@ struct HandshakeAccept
 
 
 
-AsioUDPConnection::AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote)
+AsioUDPConnection::AsioUDPConnection(AsioUDPBatchSocket& socket, UDPEndpoint remote)
 	: socket(socket)
 	, remote(remote)
 	, status(ConnectionStatus::Connecting)
@@ -63,11 +63,8 @@ void AsioUDPConnection::send(TransmissionType type, OutboundNetworkPacket packet
 		}
 		packet.addHeader(gsl::as_bytes(gsl::span<unsigned char>(id).subspan(0, len)));
 
-		bool needsSend = pendingSend.empty();
-		pendingSend.emplace_back(std::move(packet));
-		if (needsSend) {
-			sendNext();
-		}
+		// Sent along with every other connection's packets when the service updates
+		socket.send(remote, packet);
 	}
 }
 
@@ -87,8 +84,9 @@ bool AsioUDPConnection::matchesEndpoint(const UDPEndpoint& remoteEndpoint) const
 	return remote == remoteEndpoint;
 }
 
-void AsioUDPConnection::onReceive(gsl::span<const gsl::byte> data)
+void AsioUDPConnection::onReceive(InboundNetworkPacket packet)
 {
+	const auto data = packet.getBytes();
 	Expects(data.size() <= 1500);
 
 	if (status == ConnectionStatus::Connecting) {
@@ -102,7 +100,7 @@ void AsioUDPConnection::onReceive(gsl::span<const gsl::byte> data)
 		}
 	} else if (status == ConnectionStatus::Connected) {
 		if (data.size() <= 1500) {
-			pendingReceive.push_back(InboundNetworkPacket(data));
+			pendingReceive.push_back(std::move(packet));
 		}
 	}
 }
@@ -130,24 +128,3 @@ void AsioUDPConnection::onOpen(short id)
 	connectionId = id;
 	status = ConnectionStatus::Connected;
 }
-
-void AsioUDPConnection::sendNext()
-{
-	if (pendingSend.empty()) {
-		return;
-	}
-
-	auto& packet = pendingSend.front();
-	size_t size = packet.copyTo(sendBuffer);
-	pendingSend.pop_front();
-
-	socket.async_send_to(boost::asio::buffer(sendBuffer, size), remote, [this] (const boost::system::error_code& error, std::size_t)
-	{
-		if (error) {
-			std::cout << "Error sending packet: " << error.message() << std::endl;
-			close();
-		} else if (!pendingSend.empty()) {
-			sendNext();
-		}
-	});
-}
@@ -3,28 +3,20 @@
 #include "halley/net/connection/iconnection.h"
 #include "halley/net/connection/network_packet.h"
 
-#ifdef _MSC_VER
-#pragma warning(disable: 4834)
-#endif
-#define BOOST_SYSTEM_NO_DEPRECATED
-#define BOOST_ERROR_CODE_HEADER_ONLY
-#include <boost/asio.hpp>
+#include "asio_udp_batch_socket.h"
 
 #include <deque>
-#include <array>
 #include <string>
 #include <gsl/gsl>
 
 namespace Halley
 {
 	class NetworkService;
-	using UDPEndpoint = boost::asio::ip::udp::endpoint;
-	using UDPSocket = boost::asio::ip::udp::socket;
 
 	class AsioUDPConnection : public IConnection
 	{
 	public:
-		AsioUDPConnection(UDPSocket& socket, UDPEndpoint remote);
+		AsioUDPConnection(AsioUDPBatchSocket& socket, UDPEndpoint remote);
 
 		void close() override;
 		ConnectionStatus getStatus() const override { return status; }
@@ -33,7 +25,7 @@ namespace Halley
 		bool receive(InboundNetworkPacket& packet) override;
 		
 		bool matchesEndpoint(const UDPEndpoint& remoteEndpoint) const;
-		void onReceive(gsl::span<const gsl::byte> data);
+		void onReceive(InboundNetworkPacket packet);
 		void setError(const std::string& cs);
 		
 		void open(short connectionId);
@@ -42,16 +34,12 @@ namespace Halley
 		short getConnectionId() const { return connectionId; }
 
 	private:
-		UDPSocket& socket;
+		AsioUDPBatchSocket& socket;
 		UDPEndpoint remote;
 		ConnectionStatus status;
 		short connectionId;
 
-		std::deque<OutboundNetworkPacket> pendingSend;
 		std::deque<InboundNetworkPacket> pendingReceive;
-		std::array<gsl::byte, 2048> sendBuffer;
 		std::string error;
-
-		void sendNext();
 	};
 }
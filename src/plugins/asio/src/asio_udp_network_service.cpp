@@ -29,6 +29,11 @@ AsioUDPNetworkService::AsioUDPNetworkService(int port, IPVersion version)
 {
 	Expects(port == 0 || port > 1024);
 	Expects(port < 65536);
+
+	socket.setSendErrorCallback([this] (const UDPEndpoint& remote, const std::string& error)
+	{
+		onSendError(remote, error);
+	});
 }
 
 
@@ -43,7 +48,7 @@ AsioUDPNetworkService::~AsioUDPNetworkService()
 	}
 	try {
 		service.poll();
-		socket.shutdown(UDPSocket::shutdown_both);
+		socket.shutdown();
 	} catch (...) {
 		std::cout << "Error polling service on ~NetworkService()" << std::endl;
 	}
@@ -67,6 +72,9 @@ void AsioUDPNetworkService::update(Time t)
 		active.erase(i);
 	}
 
+	// Send everything queued since the last update in as few syscalls as possible
+	socket.flush();
+
 	// Update service
 	service.poll();
 }
@@ -98,7 +106,10 @@ String AsioUDPNetworkService::startListening(AcceptCallback callback)
 	acceptCallback = std::move(callback);
 	if (!startedListening) {
 		startedListening = true;
-		receiveNext();
+		socket.startReceiving([this] (const UDPEndpoint& remote, InboundNetworkPacket packet, std::string* error)
+		{
+			receivePacket(remote, std::move(packet), error);
+		});
 	}
 	return "";
 }
@@ -108,31 +119,7 @@ void AsioUDPNetworkService::stopListening()
 	acceptCallback = {};
 }
 
-void AsioUDPNetworkService::receiveNext()
-{
-	auto buffer = asio::buffer(receiveBuffer);
-	socket.async_receive_from(buffer, remoteEndpoint, [this] (const boost::system::error_code& error, size_t size)
-	{
-		try {
-			Expects(size <= receiveBuffer.size());
-
-			std::string errorMsg;
-			std::string* errorMsgPtr = nullptr;
-			if (error) {
-				errorMsg = error.message();
-				errorMsgPtr = &errorMsg;
-			}
-
-			receivePacket(gsl::span<gsl::byte>(receiveBuffer.data(), size), errorMsgPtr);
-		} catch (...) {
-			std::cout << "Exception while receiving a packet." << std::endl;
-		}
-
-		receiveNext();
-	});
-}
-
-void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::string* error)
+void AsioUDPNetworkService::receivePacket(const UDPEndpoint& remoteEndpoint, InboundNetworkPacket packet, std::string* error)
 {
 	if (error) {
 		std::cout << "Error receiving packet: " << (*error) << std::endl;
@@ -146,7 +133,7 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 		return;
 	}
 
-	if (received.size_bytes() == 0) {
+	if (packet.getSize() == 0) {
 		return;
 	}
 
@@ -154,23 +141,21 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 	short id = -1;
 	std::array<unsigned char, 2> bytes;
 	auto dst = gsl::as_writable_bytes(gsl::span<unsigned char, 2>(bytes));
-	dst[0] = received[0];
+	packet.extractHeader(dst.subspan(0, 1));
 	if (bytes[0] & 0x80) {
-		if (received.size_bytes() < 2) {
+		if (packet.getSize() < 1) {
 			// Invalid header
 			std::cout << "Invalid header\n";
 			return;
 		}
-		dst[1] = received[1];
-		received = received.subspan(2);
+		packet.extractHeader(dst.subspan(1, 1));
 		id = short(bytes[0] & 0x7F) | short(bytes[1]);
 	} else {
-		received = received.subspan(1);
 		id = short(bytes[0]);
 	}
 
 	// No connection id, check if it's a connection request
-	if (id == 0 && isValidConnectionRequest(received)) {
+	if (id == 0 && isValidConnectionRequest(packet.getBytes())) {
 		auto a = UDPAcceptor(*this, remoteEndpoint);
 		if (acceptCallback) {
 			acceptCallback(a);
@@ -200,7 +185,7 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 			connection->close();
 		} else {
 			try {
-				connection->onReceive(received);
+				connection->onReceive(std::move(packet));
 
 				if (conn->first == 0) {
 					// Hold on, we're still on 0, re-bind to the id
@@ -221,6 +206,16 @@ void AsioUDPNetworkService::receivePacket(gsl::span<gsl::byte> received, std::st
 	}
 }
 
+void AsioUDPNetworkService::onSendError(const UDPEndpoint& remoteEndpoint, const std::string& error)
+{
+	for (auto& conn: activeConnections) {
+		if (conn.second->matchesEndpoint(remoteEndpoint)) {
+			conn.second->setError(error);
+			conn.second->close();
+		}
+	}
+}
+
 bool AsioUDPNetworkService::isValidConnectionRequest(gsl::span<const gsl::byte> data)
 {
 	HandshakeOpen open;
@@ -44,14 +44,11 @@ namespace Halley
 
 		asio::io_service service;
 		UDPEndpoint localEndpoint;
-		UDPEndpoint remoteEndpoint;
-		asio::ip::udp::socket socket;
+		AsioUDPBatchSocket socket;
 		HashMap<short, std::shared_ptr<AsioUDPConnection>> activeConnections;
 
-		std::array<gsl::byte, 2048> receiveBuffer;
-
-		void receiveNext();
-		void receivePacket(gsl::span<gsl::byte> data, std::string* error);
+		void receivePacket(const UDPEndpoint& remoteEndpoint, InboundNetworkPacket packet, std::string* error);
+		void onSendError(const UDPEndpoint& remoteEndpoint, const std::string& error);
 		bool isValidConnectionRequest(gsl::span<const gsl::byte> data);
 		short getFreeId() const;
 
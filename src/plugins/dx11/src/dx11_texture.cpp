@@ -114,11 +114,23 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 	case TextureFormat::RGBAFloat16:
 		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
 		break;
+	case TextureFormat::BC1:
+		desc.Format = DXGI_FORMAT_BC1_UNORM;
+		break;
+	case TextureFormat::BC3:
+		desc.Format = DXGI_FORMAT_BC3_UNORM;
+		break;
+	case TextureFormat::BC7:
+		desc.Format = DXGI_FORMAT_BC7_UNORM;
+		break;
+	case TextureFormat::ETC2:
+	case TextureFormat::ETC2Alpha:
+		throw Exception("ETC2 textures are not supported", HalleyExceptions::VideoPlugin);
 	default:
 		throw Exception("Unknown texture format", HalleyExceptions::VideoPlugin);
 	}
 
-	vramUsage = bpp * size.x * size.y;
+	vramUsage = TextureDescriptor::getVRamUsage(descriptor.format, size, descriptor.useMipMap);
 
 	desc.BindFlags = 0;
 	if (descriptor.isDepthStencil) {
@@ -151,7 +163,12 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 			desc.Usage = D3D11_USAGE_IMMUTABLE;
 		}
 		subResData.pSysMem = descriptor.pixelData.getSpan().data();
-		subResData.SysMemPitch = descriptor.pixelData.getStrideOr(bpp * size.x);
+		if (const int blockBytes = TextureDescriptor::getBlockBytes(descriptor.format); blockBytes != 0) {
+			// Pitch is one row of 4x4 blocks
+			subResData.SysMemPitch = ((size.x + 3) / 4) * blockBytes;
+		} else {
+			subResData.SysMemPitch = descriptor.pixelData.getStrideOr(bpp * size.x);
+		}
 		subResData.SysMemSlicePitch = 0;
 		hasPixelData = true;
 	}
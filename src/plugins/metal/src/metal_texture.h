@@ -17,10 +17,14 @@ namespace Halley {
 		void doLoad(TextureDescriptor& descriptor) override;
 		void bind(id<MTLRenderCommandEncoder> encoder, int bindIndex) const;
 
+	protected:
+		size_t getVRamUsage() const override;
+
 	private:
 		MetalVideo& video;
 		id<MTLTexture> metalTexture;
 		id<MTLSamplerState> sampler;
+		size_t vramUsage = 0;
 
 		static MTLSamplerAddressMode getMetalAddressMode(TextureDescriptor& descriptor);
 	};
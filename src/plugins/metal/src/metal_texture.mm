@@ -41,6 +41,7 @@ void MetalTexture::doLoad(TextureDescriptor& descriptor)
 		mipmapped:descriptor.useMipMap
 	];
 	metalTexture = [video.getDevice() newTextureWithDescriptor:textureDescriptor];
+	vramUsage = TextureDescriptor::getVRamUsage(descriptor.format, descriptor.size, descriptor.useMipMap);
 
 	NSUInteger bytesPerRow = bytesPerPixel * descriptor.size.x;
 	MTLRegion region = {
@@ -89,6 +90,11 @@ void MetalTexture::bind(id<MTLRenderCommandEncoder> encoder, int bindIndex) cons
 	[encoder setFragmentSamplerState:sampler atIndex:bindIndex];
 }
 
+size_t MetalTexture::getVRamUsage() const
+{
+	return vramUsage;
+}
+
 MTLSamplerAddressMode MetalTexture::getMetalAddressMode(TextureDescriptor& descriptor)
 {
 	switch (descriptor.addressMode) {
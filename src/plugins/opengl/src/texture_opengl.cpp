@@ -3,6 +3,8 @@
 #include "halley_gl.h"
 #include "texture_opengl.h"
 #include "halley/graphics/texture_descriptor.h"
+#include "halley/file_formats/block_compression.h"
+#include "halley/file_formats/image.h"
 #include <gsl/gsl_assert>
 #include "video_opengl.h"
 #include "halley/support/logger.h"
@@ -10,6 +12,23 @@
 
 using namespace Halley;
 
+// Compressed formats from EXT_texture_compression_s3tc, ARB_texture_compression_bptc and GL 4.3 / ES 3.0, which not every header defines
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
 TextureOpenGL::TextureOpenGL(VideoOpenGL& parent, Vector2i size)
 	: Texture(size)
 	, parent(parent)
@@ -20,7 +39,9 @@ TextureOpenGL::TextureOpenGL(VideoOpenGL& parent, Vector2i size)
 
 TextureOpenGL::~TextureOpenGL()
 {
-	waitForOpenGLLoad();
+	if (!hasFailed()) {
+		waitForOpenGLLoad();
+	}
 	if (textureId != 0) {
 		glDeleteTextures(1, &textureId);
 		textureId = 0;
@@ -34,6 +55,7 @@ TextureOpenGL& TextureOpenGL::operator=(TextureOpenGL&& other) noexcept
 	size = other.size;
 	textureId = other.textureId;
 	texSize = other.texSize;
+	vramUsage = other.vramUsage;
 
 	doneLoading();
 
@@ -42,6 +64,13 @@ TextureOpenGL& TextureOpenGL::operator=(TextureOpenGL&& other) noexcept
 
 void TextureOpenGL::doLoad(TextureDescriptor& d)
 {
+	if (TextureDescriptor::isBlockCompressed(d.format) && !d.pixelData.empty() && !parent.supportsTextureFormat(d.format)) {
+		// Decode on the CPU instead, which loses the VRAM savings but still renders correctly
+		Logger::logWarning("Texture format " + toString(d.format) + " is not supported by this OpenGL driver, decoding \"" + getAssetId() + "\" to RGBA");
+		d.pixelData = TextureDescriptorImageData(BlockCompression::decode(d.pixelData.getSpan(), d.size, d.format));
+		d.format = TextureFormat::RGBA;
+	}
+
 	GLUtils glUtils;
     glUtils.setTextureUnit(0);
 	glUtils.bindTexture(textureId);
@@ -71,6 +100,11 @@ void TextureOpenGL::generateMipMaps()
 	}
 }
 
+size_t TextureOpenGL::getVRamUsage() const
+{
+	return vramUsage;
+}
+
 unsigned TextureOpenGL::getNativeId() const
 {
 	return textureId;
@@ -151,6 +185,18 @@ void TextureOpenGL::create(Vector2i size, TextureFormat format, bool useMipMap,
 #endif
 
 	GLuint internalFormat = getGLInternalFormat(format);
+	vramUsage = TextureDescriptor::getVRamUsage(format, size, useMipMap);
+
+	if (TextureDescriptor::isBlockCompressed(format)) {
+		Expects(!pixelData.empty());
+		const auto imageSize = TextureDescriptor::getImageByteSize(format, size);
+		Expects(pixelData.getSpan().size() >= imageSize);
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size.x, size.y, 0, static_cast<GLsizei>(imageSize), pixelData.getBytes());
+		glCheckError();
+		texSize = size;
+		return;
+	}
+
 	GLuint pixelFormat = getGLPixelFormat(format);
 
 	if (format != TextureFormat::Depth) {
@@ -172,6 +218,14 @@ void TextureOpenGL::create(Vector2i size, TextureFormat format, bool useMipMap,
 
 void TextureOpenGL::updateImage(TextureDescriptorImageData& pixelData, TextureFormat format, bool useMipMap)
 {
+	if (TextureDescriptor::isBlockCompressed(format)) {
+		const auto imageSize = TextureDescriptor::getImageByteSize(format, size);
+		Expects(pixelData.getSpan().size() >= imageSize);
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, getGLInternalFormat(format), static_cast<GLsizei>(imageSize), pixelData.getBytes());
+		glCheckError();
+		return;
+	}
+
 	int stride = pixelData.getStrideOr(size.x);
 
 #if defined (WITH_OPENGL) || defined(WITH_OPENGL_ES3)
@@ -202,6 +256,16 @@ unsigned TextureOpenGL::getGLInternalFormat(TextureFormat format)
 		return GL_RGBA;
 	case TextureFormat::Depth:
 		return GL_DEPTH_COMPONENT24;
+	case TextureFormat::BC1:
+		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case TextureFormat::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureFormat::BC7:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case TextureFormat::ETC2:
+		return GL_COMPRESSED_RGB8_ETC2;
+	case TextureFormat::ETC2Alpha:
+		return GL_COMPRESSED_RGBA8_ETC2_EAC;
 	default:
 		throw Exception("Unknown texture format: " + toString(static_cast<int>(format)), HalleyExceptions::VideoPlugin);
 	}
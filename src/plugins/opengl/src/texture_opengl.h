@@ -25,6 +25,9 @@ namespace Halley
 
 		void generateMipMaps() override;
 
+	protected:
+		size_t getVRamUsage() const override;
+
 	private:
 		void updateImage(TextureDescriptorImageData& pixelData, TextureFormat format, bool useMipMap);
 		void create(Vector2i size, TextureFormat format, bool useMipMap, bool useFiltering, TextureAddressMode addressMode, TextureDescriptorImageData& imgData);
@@ -38,6 +41,7 @@ namespace Halley
 
 		unsigned int textureId = 0;
 		Vector2i texSize;
+		size_t vramUsage = 0;
 		VideoOpenGL& parent;
 #if defined (WITH_OPENGL) || defined(WITH_OPENGL_ES3)
 		mutable GLsync fence = nullptr;
@@ -12,6 +12,7 @@
 #include "constant_buffer_opengl.h"
 #include "halley/game/game_platform.h"
 #include "halley/graphics/material/uniform_type.h"
+#include "halley/graphics/texture_descriptor.h"
 using namespace Halley;
 
 #ifdef _MSC_VER
@@ -112,19 +113,36 @@ void VideoOpenGL::initOpenGL()
 	std::cout << "\tRenderer: " << ConsoleColour(Console::DARK_GREY) << glGetString(GL_RENDERER) << ConsoleColour() << std::endl;
 	std::cout << "\tGLSL Version: " << ConsoleColour(Console::DARK_GREY) << glGetString(GL_SHADING_LANGUAGE_VERSION) << ConsoleColour() << std::endl;
 
-	// Print extensions
-#ifndef _DEBUG
-	std::cout << "\tExtensions: " << ConsoleColour(Console::DARK_GREY);
+	// Read extensions
+	extensions.clear();
 #ifdef WITH_OPENGL
 	int nExtensions;
 	glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
 	for (int i = 0; i < nExtensions; i++) {
-		String str = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
-		std::cout << str << " ";
+		extensions.insert(String(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))));
 	}
 #else
-	String str = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	for (const auto& str: String(reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS))).split(' ')) {
+		if (!str.isEmpty()) {
+			extensions.insert(str);
+		}
+	}
 #endif
+
+#if defined(WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	int majorVersion = 0;
+	int minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	glVersion = majorVersion * 10 + minorVersion;
+#endif
+
+	// Print extensions
+#ifndef _DEBUG
+	std::cout << "\tExtensions: " << ConsoleColour(Console::DARK_GREY);
+	for (const auto& str: extensions) {
+		std::cout << str << " ";
+	}
 	std::cout << ConsoleColour() << std::endl;
 #endif
 
@@ -133,6 +151,29 @@ void VideoOpenGL::initOpenGL()
 	std::cout << ConsoleColour(Console::GREEN) << "OpenGL init done.\n" << ConsoleColour() << std::endl;
 }
 
+bool VideoOpenGL::supportsTextureFormat(TextureFormat format) const
+{
+#ifdef WITH_OPENGL
+	constexpr bool isDesktopGL = true;
+#else
+	constexpr bool isDesktopGL = false;
+#endif
+
+	switch (format) {
+	case TextureFormat::BC1:
+	case TextureFormat::BC3:
+		return extensions.contains("GL_EXT_texture_compression_s3tc");
+	case TextureFormat::BC7:
+		return extensions.contains("GL_ARB_texture_compression_bptc") || extensions.contains("GL_EXT_texture_compression_bptc") || (isDesktopGL && glVersion >= 42);
+	case TextureFormat::ETC2:
+	case TextureFormat::ETC2Alpha:
+		// Core in OpenGL ES 3.0 and OpenGL 4.3
+		return extensions.contains("GL_ARB_ES3_compatibility") || (isDesktopGL ? glVersion >= 43 : glVersion >= 30);
+	default:
+		return true;
+	}
+}
+
 void VideoOpenGL::initGLBindings()
 {
 #ifdef WITH_OPENGL
@@ -3,12 +3,14 @@
 #include <map>
 #include <mutex>
 #include <halley/data_structures/flat_map.h>
+#include <halley/data_structures/hash_map.h>
 #include "halley/api/halley_api_internal.h"
 #include "halley/graphics/window.h"
 #include "loader_thread_opengl.h"
 
 namespace Halley {
 	class SystemAPI;
+	enum class TextureFormat;
 
 	class VideoOpenGL final : public VideoAPIInternal
 	{
@@ -35,6 +37,9 @@ namespace Halley {
 
 		bool isLoaderThread() const;
 
+		// Block compressed formats depend on extensions or newer GL versions, other formats are always supported
+		bool supportsTextureFormat(TextureFormat format) const;
+
 		static void initGLBindings();
 
 	protected:
@@ -61,6 +66,8 @@ namespace Halley {
 		mutable std::mutex messagesMutex;
 
 		std::unique_ptr<GLContext> context;
+		HashSet<String> extensions;
+		int glVersion = 0; // e.g. 43 for 4.3
 		bool initialized = false;
 
 		std::unique_ptr<LoaderThreadOpenGL> loaderThread;
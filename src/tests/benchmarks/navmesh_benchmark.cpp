@@ -0,0 +1,90 @@
+#include <halley.hpp>
+#include <chrono>
+#include <iostream>
+using namespace Halley;
+
+// Compares the packed navmesh polygon queries against the equivalent Polygon ones, on the same random polygons and queries.
+//
+// Usage: halley-navmesh-benchmark [queries=200000] [polygons=256]
+
+namespace {
+	Vector<Polygon> makeTestPolygons(Random& rng, size_t count)
+	{
+		Vector<Polygon> result;
+		for (size_t i = 0; i < count; ++i) {
+			const size_t sides = 3 + i % 6;
+			const auto centre = Vector2f(rng.getFloat(-100.0f, 100.0f), rng.getFloat(-100.0f, 100.0f));
+			const float radius = rng.getFloat(5.0f, 20.0f);
+
+			VertexList vs;
+			for (size_t j = 0; j < sides; ++j) {
+				vs.push_back(centre + Vector2f(radius, 0).rotate(Angle1f::fromRadians(static_cast<float>(j) * 2 * static_cast<float>(pi()) / static_cast<float>(sides))));
+			}
+			auto& poly = result.emplace_back(std::move(vs));
+			if (i % 2 == 1) {
+				poly.invertWinding();
+			}
+		}
+		return result;
+	}
+
+	Vector2f makeTestPoint(Random& rng)
+	{
+		return Vector2f(rng.getFloat(-120.0f, 120.0f), rng.getFloat(-120.0f, 120.0f));
+	}
+
+	Ray makeTestRay(Random& rng)
+	{
+		return Ray(makeTestPoint(rng), Vector2f(1, 0).rotate(Angle1f::fromRadians(rng.getFloat(0, 2 * static_cast<float>(pi())))));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t nQueries = argc > 1 ? static_cast<size_t>(String(argv[1]).toInteger()) : 200000;
+	const size_t nPolygons = argc > 2 ? static_cast<size_t>(String(argv[2]).toInteger()) : 256;
+
+	Random rng(5678u);
+	const auto polygons = makeTestPolygons(rng, nPolygons);
+	const NavmeshPackedPolygons packed(polygons);
+
+	Vector<Vector2f> points;
+	Vector<Ray> rays;
+	for (size_t i = 0; i < nQueries; ++i) {
+		points.push_back(makeTestPoint(rng));
+		rays.push_back(makeTestRay(rng));
+	}
+
+	auto measure = [&] (const char* name, auto f)
+	{
+		size_t hits = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < nQueries; ++i) {
+			hits += f(i % polygons.size(), i) ? 1 : 0;
+		}
+		const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		std::cout << name << ": " << elapsed << " us (" << hits << " hits)" << std::endl;
+		return hits;
+	};
+
+	int result = 0;
+
+	const auto insidePoly = measure("Polygon::isPointInside", [&] (size_t poly, size_t i) { return polygons[poly].isPointInside(points[i]); });
+	const auto insidePacked = measure("NavmeshPackedPolygons::isPointInside", [&] (size_t poly, size_t i) { return packed.isPointInside(poly, points[i]); });
+	if (insidePoly != insidePacked) {
+		std::cout << "Mismatch in isPointInside results" << std::endl;
+		result = 1;
+	}
+
+	measure("Polygon::getClosestPoint", [&] (size_t poly, size_t i) { return (polygons[poly].getClosestPoint(points[i]) - points[i]).squaredLength() < 25.0f; });
+	measure("NavmeshPackedPolygons::getSquaredDistanceTo", [&] (size_t poly, size_t i) { return packed.getSquaredDistanceTo(poly, points[i]) < 25.0f; });
+
+	const auto exitPoly = measure("Polygon::getExitEdge", [&] (size_t poly, size_t i) { return polygons[poly].getExitEdge(rays[i]).has_value(); });
+	const auto exitPacked = measure("NavmeshPackedPolygons::getExitEdge", [&] (size_t poly, size_t i) { return packed.getExitEdge(poly, rays[i]).has_value(); });
+	if (exitPoly != exitPacked) {
+		std::cout << "Mismatch in getExitEdge results" << std::endl;
+		result = 1;
+	}
+
+	return result;
+}
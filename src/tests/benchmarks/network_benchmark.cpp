@@ -0,0 +1,219 @@
+#include <halley.hpp>
+#include "test_world.h"
+#include <chrono>
+#include <iostream>
+using namespace Halley;
+
+// Replicates a world from a host EntityNetworkSession to N clients over a LoopbackNetworkService, reporting bandwidth and CPU cost per tick.
+// Everything runs on one thread with fixed time steps and a fixed random seed, so runs are comparable between builds.
+//
+// Usage: halley-network-benchmark [clients=4] [entities=1000] [ticks=600] [motion=mixed] [viewSize=0] [replication=messages]
+//   motion is one of static, linear, random or mixed (10% of entities moving)
+//   viewSize is the size of each client's view centred on the world's origin, 0 to see everything
+//   replication is either messages or snapshots
+
+namespace {
+	enum class MotionPattern {
+		Static,
+		Linear,
+		Random,
+		Mixed
+	};
+
+	class BenchmarkListener : public EntityNetworkSession::IEntityNetworkSessionListener {
+	public:
+		void onStartSession(NetworkSession::PeerId myPeerId) override {}
+		void setupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote) override {}
+
+		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) override
+		{
+			if (!clientData.viewRect || clientData.viewRect->getWidth() == 0) {
+				return true;
+			}
+			const auto* transform = entity.tryGetComponent<Transform2DComponent>();
+			return !transform || Rect4f(*clientData.viewRect).contains(transform->getGlobalPosition());
+		}
+
+		std::optional<Rect4f> getInterestArea(const EntityClientSharedData& clientData) override
+		{
+			if (!clientData.viewRect || clientData.viewRect->getWidth() == 0) {
+				return {};
+			}
+			return Rect4f(*clientData.viewRect);
+		}
+	};
+
+	struct Peer {
+		std::unique_ptr<LoopbackNetworkService> service;
+		std::shared_ptr<NetworkSession> session;
+		std::unique_ptr<World> world;
+		std::unique_ptr<EntityNetworkSession> entitySession;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double toMilliseconds(Clock::duration d)
+	{
+		return std::chrono::duration<double, std::milli>(d).count();
+	}
+
+	MotionPattern parseMotion(const String& str)
+	{
+		if (str == "static") {
+			return MotionPattern::Static;
+		} else if (str == "linear") {
+			return MotionPattern::Linear;
+		} else if (str == "random") {
+			return MotionPattern::Random;
+		} else if (str == "mixed") {
+			return MotionPattern::Mixed;
+		}
+		throw Exception("Unknown motion pattern: " + str, HalleyExceptions::Tools);
+	}
+}
+
+namespace Halley {
+	std::unique_ptr<CodegenFunctions> createCodegenFunctions()
+	{
+		return std::make_unique<TestCodegenFunctions>();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int nClients = argc > 1 ? String(argv[1]).toInteger() : 4;
+	const int nEntities = argc > 2 ? String(argv[2]).toInteger() : 1000;
+	const int nTicks = argc > 3 ? String(argv[3]).toInteger() : 600;
+	const auto motion = parseMotion(argc > 4 ? String(argv[4]) : String("mixed"));
+	const int viewSize = argc > 5 ? String(argv[5]).toInteger() : 0;
+	const bool snapshots = argc > 6 && String(argv[6]) == "snapshots";
+	constexpr Time dt = 1.0 / 60.0;
+	// Entities are spawned in batches, so the warmup isn't dominated by one large initial transfer
+	constexpr int spawnPerTick = 64;
+	const int warmupTicks = 60 + (nEntities + spawnPerTick - 1) / spawnPerTick;
+
+	TestCoreAPI core;
+	HalleyAPI api{};
+	api.core = &core;
+	Resources resources(nullptr, api, ResourceOptions());
+	TestCodegenFunctions codegen;
+	BenchmarkListener listener;
+
+	auto network = std::make_shared<LoopbackNetwork>();
+	auto makePeer = [&] () -> Peer
+	{
+		Peer peer;
+		peer.service = std::make_unique<LoopbackNetworkService>(network);
+		peer.session = std::make_shared<NetworkSession>(*peer.service, 0, "benchmark");
+		peer.world = std::make_unique<World>(api, resources, WorldReflection(codegen));
+		peer.entitySession = std::make_unique<EntityNetworkSession>(peer.session, resources, std::set<String>(), &listener);
+		peer.world->setNetworkInterface(peer.entitySession.get());
+		peer.entitySession->setWorld(*peer.world, SystemMessageBridge());
+		if (snapshots) {
+			peer.entitySession->setReplicationMode(EntityNetworkReplicationMode::Snapshots);
+		}
+		return peer;
+	};
+
+	// Start session
+	auto host = makePeer();
+	host.session->host(static_cast<uint16_t>(nClients + 1)); // Includes the host
+	const auto address = host.session->getHostAddress();
+
+	Vector<Peer> clients;
+	for (int i = 0; i < nClients; ++i) {
+		clients.push_back(makePeer());
+		clients.back().session->join(address);
+	}
+	for (int i = 0; i < 100 && std_ex::contains_if(clients, [] (const Peer& c) { return !c.session->getMyPeerId(); }); ++i) {
+		host.entitySession->receiveUpdates();
+		for (auto& c: clients) {
+			c.entitySession->receiveUpdates();
+		}
+	}
+	if (std_ex::contains_if(clients, [] (const Peer& c) { return !c.session->getMyPeerId(); })) {
+		std::cout << "Clients failed to connect." << std::endl;
+		return 1;
+	}
+
+	// Populate world
+	Random rng(static_cast<uint32_t>(0x5EED));
+	const float areaSize = std::sqrt(static_cast<float>(nEntities)) * 64.0f;
+	Vector<EntityNetworkUpdateInfo> entityIds;
+	Vector<Vector2f> velocities;
+	auto spawnEntities = [&] (int count)
+	{
+		for (int n = 0; n < count && static_cast<int>(entityIds.size()) < nEntities; ++n) {
+			const int i = static_cast<int>(entityIds.size());
+			const auto pos = Vector2f(rng.getFloat(-areaSize, areaSize), rng.getFloat(-areaSize, areaSize)) * 0.5f;
+			auto entity = host.world->createEntity("entity" + toString(i)).addComponent(Transform2DComponent(pos));
+			entityIds.push_back(EntityNetworkUpdateInfo{ entity.getEntityId(), 0 });
+
+			const bool moving = motion == MotionPattern::Linear || motion == MotionPattern::Random || (motion == MotionPattern::Mixed && i % 10 == 0);
+			velocities.push_back(moving ? Vector2f(rng.getFloat(-1, 1), rng.getFloat(-1, 1)) * 100.0f : Vector2f());
+		}
+		host.world->spawnPending();
+	};
+
+	const auto viewRect = viewSize > 0 ? Rect4i(Vector2i(-viewSize / 2, -viewSize / 2), viewSize, viewSize) : Rect4i(0, 0, 0, 0);
+
+	// Run
+	Clock::duration hostTime = {};
+	Clock::duration clientTime = {};
+	size_t startBytes = 0;
+	size_t startPackets = 0;
+	for (int tick = 0; tick < warmupTicks + nTicks; ++tick) {
+		if (tick == warmupTicks) {
+			hostTime = {};
+			clientTime = {};
+			startBytes = host.service->getTotalBytesSent();
+			startPackets = host.service->getTotalPacketsSent();
+		}
+
+		spawnEntities(spawnPerTick);
+
+		// Move entities
+		for (int i = 0; i < static_cast<int>(entityIds.size()); ++i) {
+			if (velocities[i] != Vector2f()) {
+				auto& transform = host.world->getEntity(entityIds[i].entityId).getComponent<Transform2DComponent>();
+				if (motion == MotionPattern::Random) {
+					velocities[i] = (velocities[i] + Vector2f(rng.getFloat(-10, 10), rng.getFloat(-10, 10))).unit() * 100.0f;
+				}
+				auto pos = transform.getGlobalPosition() + velocities[i] * static_cast<float>(dt);
+				if (std::abs(pos.x) > areaSize * 0.5f || std::abs(pos.y) > areaSize * 0.5f) {
+					velocities[i] = -velocities[i];
+				}
+				transform.setGlobalPosition(pos);
+			}
+		}
+
+		const auto t0 = Clock::now();
+		host.entitySession->receiveUpdates();
+		host.entitySession->sendUpdates(dt, viewRect, entityIds);
+		const auto t1 = Clock::now();
+		for (auto& c: clients) {
+			c.entitySession->receiveUpdates();
+			c.world->spawnPending();
+			c.entitySession->sendUpdates(dt, viewRect, {});
+		}
+		const auto t2 = Clock::now();
+
+		hostTime += t1 - t0;
+		clientTime += t2 - t1;
+	}
+
+	const auto bytes = host.service->getTotalBytesSent() - startBytes;
+	const auto packets = host.service->getTotalPacketsSent() - startPackets;
+	size_t replicated = 0;
+	for (auto& c: clients) {
+		replicated += c.world->numEntities();
+	}
+
+	std::cout << "Clients: " << nClients << ", entities: " << nEntities << ", ticks: " << nTicks << ", motion: " << (argc > 4 ? argv[4] : "mixed") << ", view size: " << viewSize << ", replication: " << (snapshots ? "snapshots" : "messages") << "\n";
+	std::cout << "Entities on clients: " << (nClients > 0 ? replicated / nClients : 0) << " on average\n";
+	std::cout << "Host bytes/tick: " << (bytes / nTicks) << " (" << (bytes / nTicks / std::max(nClients, 1)) << " per client), packets/tick: " << (static_cast<double>(packets) / nTicks) << "\n";
+	std::cout << "Host CPU/tick: " << (toMilliseconds(hostTime) / nTicks) << " ms\n";
+	std::cout << "Client apply/tick: " << (toMilliseconds(clientTime) / nTicks / std::max(nClients, 1)) << " ms per client" << std::endl;
+
+	return 0;
+}
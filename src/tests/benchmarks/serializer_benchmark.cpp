@@ -0,0 +1,75 @@
+#include <halley.hpp>
+#include <chrono>
+#include <iostream>
+using namespace Halley;
+
+// Compares Serializer::toBytes and toBytesInto against measuring the size first and then serializing into a buffer of that size.
+//
+// Usage: halley-serializer-benchmark [iterations=2000] [entries=200]
+
+namespace {
+	struct BenchmarkData {
+		Vector<String> names;
+		Vector<int64_t> values;
+		Vector<Vector2f> positions;
+
+		void serialize(Serializer& s) const
+		{
+			s << names;
+			s << values;
+			s << positions;
+		}
+	};
+
+	BenchmarkData makeBenchmarkData(Random& rng, size_t n)
+	{
+		BenchmarkData data;
+		for (size_t i = 0; i < n; ++i) {
+			data.names.push_back("entity_" + toString(i));
+			data.values.push_back(static_cast<int64_t>(rng.getSizeT(0, 1000000)) - 500000);
+			data.positions.push_back(Vector2f(rng.getFloat(-1000.0f, 1000.0f), rng.getFloat(-1000.0f, 1000.0f)));
+		}
+		return data;
+	}
+
+	Bytes toBytesTwoPass(const BenchmarkData& data, SerializerOptions options)
+	{
+		Bytes result(Serializer::getSize(data, options));
+		auto s = Serializer(gsl::as_writable_bytes(gsl::span<Byte>(result)), options);
+		s << data;
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int nIterations = argc > 1 ? String(argv[1]).toInteger() : 2000;
+	const size_t nEntries = argc > 2 ? static_cast<size_t>(String(argv[2]).toInteger()) : 200;
+
+	Random rng(1234u);
+	const auto data = makeBenchmarkData(rng, nEntries);
+	const auto options = SerializerOptions(SerializerOptions::maxVersion);
+
+	auto measure = [&] (const char* name, auto f)
+	{
+		size_t total = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < nIterations; ++i) {
+			total += f();
+		}
+		const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		std::cout << name << ": " << elapsed << " us (" << total << " bytes)" << std::endl;
+		return total;
+	};
+
+	const auto twoPass = measure("Two pass", [&] () { return toBytesTwoPass(data, options).size(); });
+	const auto singlePass = measure("Serializer::toBytes", [&] () { return Serializer::toBytes(data, options).size(); });
+	Bytes buffer;
+	const auto reused = measure("Serializer::toBytesInto", [&] () { Serializer::toBytesInto(data, buffer, options); return buffer.size(); });
+
+	if (singlePass != twoPass || reused != twoPass) {
+		std::cout << "Mismatch in serialized sizes" << std::endl;
+		return 1;
+	}
+	return 0;
+}
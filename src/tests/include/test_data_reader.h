@@ -0,0 +1,55 @@
+#pragma once
+
+#include <halley.hpp>
+
+namespace Halley {
+	// Reads from a buffer in memory, counting how many reads reach it
+	class TestMemoryReader : public ResourceDataReader {
+	public:
+		explicit TestMemoryReader(Bytes bytes, bool readAt = true)
+			: bytes(std::move(bytes))
+			, readAtSupported(readAt)
+		{}
+
+		size_t size() const override { return bytes.size(); }
+		size_t tell() const override { return pos; }
+		void close() override {}
+		bool supportsReadAt() const override { return readAtSupported; }
+
+		int read(gsl::span<gsl::byte> dst) override
+		{
+			const int n = readAt(pos, dst);
+			pos += static_cast<size_t>(n);
+			return n;
+		}
+
+		int readAt(size_t at, gsl::span<gsl::byte> dst) override
+		{
+			++nReads;
+			const size_t n = std::min(dst.size(), bytes.size() - std::min(at, bytes.size()));
+			if (n > 0) {
+				memcpy(dst.data(), bytes.data() + at, n);
+			}
+			return static_cast<int>(n);
+		}
+
+		void seek(int64_t offset, int whence) override
+		{
+			if (whence == SEEK_SET) {
+				pos = static_cast<size_t>(offset);
+			} else if (whence == SEEK_CUR) {
+				pos = static_cast<size_t>(static_cast<int64_t>(pos) + offset);
+			} else if (whence == SEEK_END) {
+				pos = static_cast<size_t>(static_cast<int64_t>(bytes.size()) + offset);
+			}
+		}
+
+		size_t getNumReads() const { return nReads; }
+
+	private:
+		Bytes bytes;
+		bool readAtSupported;
+		size_t pos = 0;
+		size_t nReads = 0;
+	};
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <halley.hpp>
+
+namespace Halley {
+	// Sets up CPU thread pools shared by every test that needs one, as Executors only supports a single instance
+	inline Executors& getTestExecutors()
+	{
+		static Executors executors;
+		Executors::setInstance(executors);
+		static ThreadPool cpuPool("CPU", Executors::getCPU(), 2, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+		static ThreadPool cpuAuxPool("CPUAux", Executors::getCPUAux(), 1, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+		return executors;
+	}
+}
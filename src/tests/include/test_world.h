@@ -0,0 +1,88 @@
+#pragma once
+
+#include <halley.hpp>
+#include "halley/entity/components/transform_2d_component.h"
+#include "components/velocity_component.h"
+#include "components/sprite_component.h"
+#include "components/colour_component.h"
+#include "components/text_label_component.h"
+#include "components/sprite_animation_component.h"
+#include "components/camera_component.h"
+#include "components/particles_component.h"
+#include "components/sprite_animation_replicator_component.h"
+#include "components/audio_listener_component.h"
+#include "components/audio_source_component.h"
+#include "components/scriptable_component.h"
+#include "components/embedded_script_component.h"
+#include "components/script_target_component.h"
+#include "components/script_tag_target_component.h"
+#include "components/network_component.h"
+
+namespace Halley {
+	class TestCoreAPI : public CoreAPI {
+	public:
+		void quit(int exitCode) override {}
+		void setStage(StageID stage) override {}
+		void setStage(std::unique_ptr<Stage> stage) override {}
+		void initStage(Stage& stage) override {}
+		Stage& getCurrentStage() override { throw Exception("No stage in tests", HalleyExceptions::Core); }
+		HalleyStatics& getStatics() override { throw Exception("No statics in tests", HalleyExceptions::Core); }
+		const Environment& getEnvironment() override { throw Exception("No environment in tests", HalleyExceptions::Core); }
+		void addProfilerCallback(IProfileCallback* callback) override {}
+		void removeProfilerCallback(IProfileCallback* callback) override {}
+		void addStartFrameCallback(IStartFrameCallback* callback) override {}
+		void removeStartFrameCallback(IStartFrameCallback* callback) override {}
+		Future<std::unique_ptr<RenderSnapshot>> requestRenderSnapshot() override { return {}; }
+		bool isDevMode() override { return false; }
+		DevConClient* getDevConClient() const override { return nullptr; }
+	};
+
+	class TestCodegenFunctions : public CodegenFunctions {
+	public:
+		Vector<SystemReflector> makeSystemReflectors() override { return {}; }
+		Vector<std::unique_ptr<ComponentReflector>> makeComponentReflectors() override
+		{
+			Vector<std::unique_ptr<ComponentReflector>> result;
+			result.push_back(std::make_unique<ComponentReflectorImpl<Transform2DComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<VelocityComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<SpriteComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<ColourComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<TextLabelComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<SpriteAnimationComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<CameraComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<ParticlesComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<SpriteAnimationReplicatorComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<AudioListenerComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<AudioSourceComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<ScriptableComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<EmbeddedScriptComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<ScriptTargetComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<ScriptTagTargetComponent>>());
+			result.push_back(std::make_unique<ComponentReflectorImpl<NetworkComponent>>());
+			return result;
+		}
+		Vector<std::unique_ptr<MessageReflector>> makeMessageReflectors() override { return {}; }
+		Vector<std::unique_ptr<SystemMessageReflector>> makeSystemMessageReflectors() override { return {}; }
+	};
+
+	// An API, resources and world with the components above, and no systems
+	class TestWorld {
+	public:
+		TestWorld()
+			: resources(nullptr, makeAPI(), ResourceOptions())
+			, world(api, resources, WorldReflection(codegen))
+		{}
+
+		HalleyAPI& makeAPI()
+		{
+			api.core = &core;
+			return api;
+		}
+
+		TestCoreAPI core;
+		HalleyAPI api{};
+		Resources resources;
+		TestCodegenFunctions codegen;
+		World world;
+	};
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_data_reader.h"
+using namespace Halley;
+
+namespace {
+	Metadata makeMetadata(int i)
+	{
+		Metadata meta;
+		meta.set("index", i);
+		meta.set("name", "asset" + toString(i));
+		return meta;
+	}
+
+	Bytes makeData(size_t size, int seed)
+	{
+		Bytes result(size);
+		for (size_t i = 0; i < size; ++i) {
+			result[i] = static_cast<Byte>((i * 31 + seed * 7) & 0xFF);
+		}
+		return result;
+	}
+
+	String getString(const ResourceData& data)
+	{
+		return dynamic_cast<const ResourceDataStatic&>(data).getString();
+	}
+}
+
+TEST(HalleyAssetPack, IndexRoundTrip)
+{
+	Vector<Metadata> metas;
+	for (int i = 0; i < 50; ++i) {
+		metas.push_back(makeMetadata(i));
+	}
+
+	// The same names under different types, and entries without metadata
+	Vector<AssetPackIndex::Source> sources;
+	for (int i = 0; i < 50; ++i) {
+		const auto type = i % 3 == 0 ? AssetType::Sprite : (i % 3 == 1 ? AssetType::Texture : AssetType::ConfigFile);
+		sources.push_back(AssetPackIndex::Source{ type, "folder/asset" + toString(i % 20), static_cast<uint64_t>(i) * 1000, static_cast<uint64_t>(i) + 1, i % 5 == 0 ? nullptr : &metas[i] });
+	}
+
+	const auto index = AssetPackIndex(AssetPackIndex::build(sources));
+	EXPECT_EQ(sources.size(), index.getEntries().size());
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		const auto& source = sources[i];
+		const auto* entry = index.find(source.type, source.name.cppStr());
+		ASSERT_NE(nullptr, entry) << source.name;
+		EXPECT_EQ(source.pos, entry->pos);
+		EXPECT_EQ(source.size, entry->size);
+		EXPECT_EQ(static_cast<int32_t>(source.type), entry->type);
+		EXPECT_EQ(source.name.cppStr(), index.getName(*entry));
+		if (source.meta) {
+			EXPECT_EQ(*source.meta, index.getMetadata(*entry));
+		} else {
+			EXPECT_EQ(0, entry->metaSize);
+		}
+	}
+
+	EXPECT_EQ(nullptr, index.find(AssetType::ConfigFile, "folder/asset10")); // Only a Texture and a Sprite
+	EXPECT_EQ(nullptr, index.find(AssetType::Texture, "folder/asset"));
+	EXPECT_EQ(nullptr, index.find(AssetType::Shader, "folder/asset0"));
+
+	const auto empty = AssetPackIndex(AssetPackIndex::build({}));
+	EXPECT_TRUE(empty.getEntries().empty());
+	EXPECT_EQ(nullptr, empty.find(AssetType::Sprite, "folder/asset0"));
+}
+
+TEST(HalleyAssetPack, LegacyPackIsConverted)
+{
+	// Lays out a pack the way it was written before indices, with a compressed AssetDatabase where entries are located by "pos:size" paths
+	Bytes packData;
+	AssetDatabase db;
+	for (int i = 0; i < 10; ++i) {
+		const auto bytes = makeData(100 + i * 37, i);
+		db.addAsset("asset" + toString(i), i % 2 == 0 ? AssetType::BinaryFile : AssetType::TextFile, AssetDatabase::Entry(toString(packData.size()) + ":" + toString(bytes.size()), makeMetadata(i)));
+		packData.insert(packData.end(), bytes.begin(), bytes.end());
+	}
+	const auto dbBytes = Compression::compress(Serializer::toBytes(db));
+
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.identifier.data(), "HALLEYPK", 8);
+	header.assetDbStartPos = sizeof(AssetPackHeader);
+	header.dataStartPos = header.assetDbStartPos + dbBytes.size();
+
+	Bytes packBytes(sizeof(AssetPackHeader));
+	memcpy(packBytes.data(), &header, sizeof(header));
+	packBytes.insert(packBytes.end(), dbBytes.begin(), dbBytes.end());
+	packBytes.insert(packBytes.end(), packData.begin(), packData.end());
+
+	for (const bool preLoad: { false, true }) {
+		AssetPack pack(std::make_unique<TestMemoryReader>(packBytes), "", preLoad);
+
+		for (int i = 0; i < 10; ++i) {
+			const auto type = i % 2 == 0 ? AssetType::BinaryFile : AssetType::TextFile;
+			const auto name = "asset" + toString(i);
+			const auto& entry = pack.getAssetDatabase().getDatabase(type).get(name);
+			EXPECT_EQ(makeMetadata(i), entry.meta);
+
+			auto data = pack.getData(name, type, false);
+			ASSERT_NE(nullptr, data) << name;
+			const auto expected = makeData(100 + i * 37, i);
+			EXPECT_EQ(String(reinterpret_cast<const char*>(expected.data()), expected.size()), getString(*data)) << name;
+		}
+		EXPECT_EQ(nullptr, pack.getData("asset0", AssetType::TextFile, false));
+		EXPECT_EQ(nullptr, pack.getData("asset10", AssetType::BinaryFile, false));
+
+		// Writing it back out produces an indexed pack with the same contents
+		if (preLoad) {
+			AssetPack rewritten(std::make_unique<TestMemoryReader>(pack.writeOut()), "", true);
+			auto data = rewritten.getData("asset3", AssetType::TextFile, false);
+			ASSERT_NE(nullptr, data);
+			const auto expected = makeData(100 + 3 * 37, 3);
+			EXPECT_EQ(String(reinterpret_cast<const char*>(expected.data()), expected.size()), getString(*data));
+			EXPECT_EQ(makeMetadata(3), rewritten.getAssetDatabase().getDatabase(AssetType::TextFile).get("asset3").meta);
+		}
+	}
+}
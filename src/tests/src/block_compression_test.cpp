@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <cmath>
+#include "halley/file_formats/block_compression.h"
+using namespace Halley;
+
+namespace {
+	// Smooth gradients with a little noise and some hard edges, like typical sprite or photo content
+	std::unique_ptr<Image> makeTestImage(Vector2i size, bool binaryAlpha)
+	{
+		Random rng(42u);
+		auto image = std::make_unique<Image>(Image::Format::RGBA, size);
+		auto bytes = image->getPixelBytes();
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				auto* px = bytes.data() + (y * size.x + x) * 4;
+				const bool edge = (x / 16 + y / 16) % 2 == 0;
+				px[0] = static_cast<uint8_t>(std::clamp(x * 255 / size.x + rng.getInt(-4, 4), 0, 255));
+				px[1] = static_cast<uint8_t>(std::clamp(y * 255 / size.y + rng.getInt(-4, 4), 0, 255));
+				px[2] = static_cast<uint8_t>(edge ? 200 : 40);
+				if (binaryAlpha) {
+					px[3] = (x * 7 + y * 3) % 29 < 6 ? 0 : 255;
+				} else {
+					px[3] = static_cast<uint8_t>(std::clamp((x + y) * 255 / (size.x + size.y) + rng.getInt(-3, 3), 0, 255));
+				}
+			}
+		}
+		return image;
+	}
+
+	double getPSNR(const Image& a, const Image& b, int firstChannel, int lastChannel, bool skipTransparent = false)
+	{
+		const auto bytesA = a.getPixelBytes();
+		const auto bytesB = b.getPixelBytes();
+		double error = 0;
+		size_t count = 0;
+		for (size_t i = 0; i < bytesA.size(); i += 4) {
+			if (skipTransparent && bytesA[i + 3] == 0) {
+				continue;
+			}
+			for (int c = firstChannel; c <= lastChannel; ++c) {
+				const double d = double(bytesA[i + c]) - double(bytesB[i + c]);
+				error += d * d;
+				++count;
+			}
+		}
+		const double mse = error / double(count);
+		return mse == 0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	std::unique_ptr<Image> roundTrip(const Image& image, TextureFormat format)
+	{
+		const auto blocks = BlockCompression::encode(image, format);
+		EXPECT_EQ(TextureDescriptor::getImageByteSize(format, image.getSize()), blocks.size());
+		return BlockCompression::decode(blocks.byte_span(), image.getSize(), format);
+	}
+}
+
+TEST(HalleyBlockCompression, BC1)
+{
+	const auto image = makeTestImage(Vector2i(64, 48), true);
+	const auto decoded = roundTrip(*image, TextureFormat::BC1);
+	EXPECT_GT(getPSNR(*image, *decoded, 0, 2, true), 35.0);
+
+	// Transparency is one bit, and transparent pixels come back as transparent black
+	const auto src = image->getPixelBytes();
+	const auto dst = decoded->getPixelBytes();
+	for (size_t i = 0; i < src.size(); i += 4) {
+		ASSERT_EQ(src[i + 3], dst[i + 3]) << "Pixel " << i / 4;
+		if (dst[i + 3] == 0) {
+			EXPECT_EQ(0, dst[i] | dst[i + 1] | dst[i + 2]) << "Pixel " << i / 4;
+		}
+	}
+}
+
+TEST(HalleyBlockCompression, BC3)
+{
+	const auto image = makeTestImage(Vector2i(64, 48), false);
+	const auto decoded = roundTrip(*image, TextureFormat::BC3);
+	EXPECT_GT(getPSNR(*image, *decoded, 0, 2), 35.0);
+	EXPECT_GT(getPSNR(*image, *decoded, 3, 3), 48.0);
+}
+
+TEST(HalleyBlockCompression, BC7)
+{
+	const auto image = makeTestImage(Vector2i(64, 48), false);
+	const auto decoded = roundTrip(*image, TextureFormat::BC7);
+	EXPECT_GT(getPSNR(*image, *decoded, 0, 2), 37.0);
+	EXPECT_GT(getPSNR(*image, *decoded, 3, 3), 38.0);
+
+	// Mode 6 is always used
+	const auto blocks = BlockCompression::encode(*image, TextureFormat::BC7);
+	for (size_t i = 0; i < blocks.size(); i += 16) {
+		ASSERT_EQ(1 << 6, blocks[i] & 0x7F);
+	}
+}
+
+TEST(HalleyBlockCompression, ETC2)
+{
+	const auto image = makeTestImage(Vector2i(64, 48), false);
+	const auto decoded = roundTrip(*image, TextureFormat::ETC2);
+	EXPECT_GT(getPSNR(*image, *decoded, 0, 2), 35.0);
+	for (size_t i = 3; i < decoded->getPixelBytes().size(); i += 4) {
+		ASSERT_EQ(255, decoded->getPixelBytes()[i]);
+	}
+}
+
+TEST(HalleyBlockCompression, EAC)
+{
+	const auto image = makeTestImage(Vector2i(64, 48), false);
+	const auto decoded = roundTrip(*image, TextureFormat::ETC2Alpha);
+	EXPECT_GT(getPSNR(*image, *decoded, 0, 2), 35.0);
+	EXPECT_GT(getPSNR(*image, *decoded, 3, 3), 48.0);
+}
+
+TEST(HalleyBlockCompression, FlatBlocks)
+{
+	auto image = std::make_unique<Image>(Image::Format::RGBA, Vector2i(8, 8));
+	image->clear(Image::convertRGBAToInt(0, 0, 0, 255));
+	for (const auto format: { TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC7, TextureFormat::ETC2, TextureFormat::ETC2Alpha }) {
+		const auto decoded = roundTrip(*image, format);
+
+		// BC7 mode 6 shares a p-bit between all channels of an endpoint, so black can't be exact alongside opaque alpha
+		const int maxError = format == TextureFormat::BC7 ? 1 : 0;
+		const auto src = image->getPixelBytes();
+		const auto dst = decoded->getPixelBytes();
+		for (size_t i = 0; i < src.size(); ++i) {
+			ASSERT_LE(std::abs(int(src[i]) - int(dst[i])), maxError) << toString(format) << " byte " << i;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	Bytes makeTestData(size_t size, uint32_t seed)
+	{
+		// Repetitive enough to compress well, but not trivially
+		Random rng(seed);
+		Bytes result;
+		result.resize(size);
+		for (size_t i = 0; i < size; ++i) {
+			result[i] = static_cast<Byte>(i % 64 < 48 ? (i / 64) % 7 : rng.getInt(0, 255));
+		}
+		return result;
+	}
+}
+
+TEST(HalleyCompression, ZlibInflaterRoundTrip)
+{
+	ZlibInflater inflater;
+	Bytes dst;
+
+	// Reused across buffers of different sizes, including ones that inflate to several times the initial output block
+	for (const size_t size: { 0, 1, 100, 1300, 4096, 64 * 1024, 300, 1024 * 1024 }) {
+		const auto data = makeTestData(size, static_cast<uint32_t>(size));
+		const auto compressed = Compression::compressRaw(data.byte_span(), false);
+		inflater.decompressRaw(compressed.byte_span(), std::numeric_limits<size_t>::max(), dst);
+		EXPECT_EQ(data, dst) << size;
+		EXPECT_EQ(data, Compression::decompressRaw(compressed.byte_span(), std::numeric_limits<size_t>::max()));
+	}
+}
+
+TEST(HalleyCompression, ZlibInflaterMultiChunkInput)
+{
+	// Several deflate blocks, fed from a buffer that's larger than zlib's window
+	Bytes data;
+	for (uint32_t i = 0; i < 16; ++i) {
+		const auto chunk = makeTestData(40 * 1024, i);
+		data.insert(data.end(), chunk.begin(), chunk.end());
+	}
+	const auto compressed = Compression::compressRaw(data.byte_span(), false, 1);
+	ASSERT_GT(compressed.size(), 32 * 1024);
+
+	ZlibInflater inflater;
+	Bytes dst;
+	inflater.decompressRaw(compressed.byte_span(), std::numeric_limits<size_t>::max(), dst);
+	EXPECT_EQ(data, dst);
+
+	// A stream that's been cut short, or that goes over the limit, is an error rather than a partial result
+	EXPECT_THROW(inflater.decompressRaw(compressed.byte_span().subspan(0, compressed.size() / 2), std::numeric_limits<size_t>::max(), dst), Exception);
+	EXPECT_THROW(inflater.decompressRaw(compressed.byte_span(), data.size() / 2, dst), Exception);
+
+	// And it's still usable afterwards
+	inflater.decompressRaw(compressed.byte_span(), data.size(), dst);
+	EXPECT_EQ(data, dst);
+}
@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_world.h"
+using namespace Halley;
+
+namespace {
+	Bytes getNetworkState(World& world, Resources& resources, EntityRef entity)
+	{
+		EntityFactory::SerializationOptions options;
+		options.type = EntitySerialization::Type::Network;
+		return Serializer::toBytes([&] (Serializer& s) { EntityFactory(world, resources).serializeEntityState(entity, options, s); });
+	}
+
+	class TestNetworkListener : public EntityNetworkSession::IEntityNetworkSessionListener {
+	public:
+		void onStartSession(NetworkSession::PeerId myPeerId) override {}
+		bool isEntityInView(EntityRef entity, const EntityClientSharedData& clientData) override { return true; }
+
+		void setupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote) override
+		{
+			if (remote && entity.getName() == "interpolated") {
+				interpolatorSet.setInterpolator(std::make_shared<DataInterpolator<Vector2f>>(), entity.getEntityId(), "Transform2D", "position");
+			}
+		}
+	};
+
+	// A host and a client replicating in snapshot mode over a LoopbackNetwork, stepped with a fixed time step
+	class TestSnapshotSession {
+	public:
+		struct Peer {
+			std::unique_ptr<LoopbackNetworkService> service;
+			std::shared_ptr<NetworkSession> session;
+			std::unique_ptr<World> world;
+			std::unique_ptr<EntityNetworkSession> entitySession;
+		};
+
+		constexpr static Time dt = 1.0 / 60.0;
+
+		TestSnapshotSession()
+		{
+			api.core = &core;
+			host = makePeer();
+			client = makePeer();
+			host.session->host(2);
+			client.session->join(host.session->getHostAddress());
+			for (int i = 0; i < 100 && !client.session->getMyPeerId(); ++i) {
+				host.entitySession->receiveUpdates();
+				client.entitySession->receiveUpdates();
+			}
+		}
+
+		void tick()
+		{
+			host.entitySession->receiveUpdates();
+			host.entitySession->sendUpdates(dt, Rect4i(0, 0, 0, 0), entityIds);
+			client.entitySession->receiveUpdates();
+			client.world->spawnPending();
+			client.entitySession->sendUpdates(dt, Rect4i(0, 0, 0, 0), {});
+		}
+
+		EntityRef createEntity(const String& name, Vector2f pos)
+		{
+			auto entity = host.world->createEntity(name).addComponent(Transform2DComponent(pos));
+			host.world->spawnPending();
+			entityIds.push_back(EntityNetworkUpdateInfo{ entity.getEntityId(), 0 });
+			return entity;
+		}
+
+		std::optional<Vector2f> getClientPosition(EntityRef hostEntity) const
+		{
+			if (const auto entity = client.world->findEntity(hostEntity.getInstanceUUID())) {
+				return entity->getComponent<Transform2DComponent>().getGlobalPosition();
+			}
+			return {};
+		}
+
+		TestCoreAPI core;
+		HalleyAPI api{};
+		Resources resources{ nullptr, api, ResourceOptions() };
+		TestCodegenFunctions codegen;
+		TestNetworkListener listener;
+		std::shared_ptr<LoopbackNetwork> network = std::make_shared<LoopbackNetwork>();
+		Peer host;
+		Peer client;
+		Vector<EntityNetworkUpdateInfo> entityIds;
+
+	private:
+		Peer makePeer()
+		{
+			Peer peer;
+			peer.service = std::make_unique<LoopbackNetworkService>(network);
+			peer.session = std::make_shared<NetworkSession>(*peer.service, 0, "test");
+			peer.world = std::make_unique<World>(api, resources, WorldReflection(codegen));
+			peer.entitySession = std::make_unique<EntityNetworkSession>(peer.session, resources, std::set<String>(), &listener);
+			peer.world->setNetworkInterface(peer.entitySession.get());
+			peer.entitySession->setWorld(*peer.world, SystemMessageBridge());
+			peer.entitySession->setReplicationMode(EntityNetworkReplicationMode::Snapshots);
+			return peer;
+		}
+	};
+}
+
+TEST(HalleyEntityNetwork, StateOnlyChangesWhenEntityIsWritten)
+{
+	TestWorld test;
+	auto& world = test.world;
+	auto entity = world.createEntity("entity")
+		.addComponent(Transform2DComponent(Vector2f(10, 20)))
+		.addComponent(VelocityComponent(Vector2f(1, 0)));
+	world.spawnPending();
+
+	auto state = getNetworkState(world, test.resources, entity);
+	EXPECT_EQ(state, getNetworkState(world, test.resources, entity));
+
+	// Reading the transform, or setting it to the same value, doesn't count as a write
+	auto& transform = entity.getComponent<Transform2DComponent>();
+	transform.getGlobalPosition();
+	transform.setLocalPosition(Vector2f(10, 20));
+	EXPECT_EQ(state, getNetworkState(world, test.resources, entity));
+
+	transform.setLocalPosition(Vector2f(11, 20));
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	// Every setter is detected as a write
+	transform.setLocalRotation(Angle1f::fromDegrees(90));
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	transform.setLocalScale(Vector2f(2, 2));
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	transform.setLocalHeight(5.0f);
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	// Components without a write version are compared by their fields
+	entity.getComponent<VelocityComponent>().velocity = Vector2f(2, 0);
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	// A replaced transform doesn't reuse the previous version, even if nothing else has been written since
+	entity.removeComponent<Transform2DComponent>();
+	world.spawnPending();
+	entity.addComponent(Transform2DComponent(Vector2f(50, 50)));
+	world.spawnPending();
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	// Children are part of the state
+	auto child = world.createEntity("child").addComponent(Transform2DComponent(Vector2f(1, 1)));
+	child.setParent(entity);
+	world.spawnPending();
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+	state = getNetworkState(world, test.resources, entity);
+
+	child.getComponent<Transform2DComponent>().setLocalPosition(Vector2f(2, 2));
+	EXPECT_NE(state, getNetworkState(world, test.resources, entity));
+}
+
+TEST(HalleyEntityNetwork, InterestGridQuery)
+{
+	Random rng(4321u);
+	EntityNetworkInterestGrid grid(64.0f);
+
+	Vector<std::optional<Vector2f>> positions;
+	for (uint32_t i = 0; i < 2000; ++i) {
+		// Include positions right around cell and rect boundaries, especially negative ones
+		std::optional<Vector2f> pos;
+		if (i % 50 != 0) {
+			pos = i % 3 == 0
+				? Vector2f(static_cast<float>(rng.getInt(-8, 8)) * 64.0f + rng.getFloat(-0.75f, 0.75f), static_cast<float>(rng.getInt(-8, 8)) * 32.0f - 0.5f)
+				: Vector2f(rng.getFloat(-600.0f, 600.0f), rng.getFloat(-600.0f, 600.0f));
+		}
+		positions.push_back(pos);
+		grid.add(i, pos);
+	}
+	EXPECT_EQ(positions.size(), grid.size());
+
+	Vector<uint32_t> result;
+	grid.query({}, result);
+	ASSERT_EQ(positions.size(), result.size());
+	EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
+
+	for (int i = 0; i < 200; ++i) {
+		// Integer rects, like the client view rects, tested with the same rounding as SessionMultiplayer::isEntityInView
+		const auto p0 = i % 2 == 0 ? Vector2i(rng.getInt(-20, 20), rng.getInt(-20, 20)) * 32 : Vector2i(rng.getInt(-700, 700), rng.getInt(-700, 700));
+		const auto rect = Rect4i(p0, rng.getInt(0, 400), rng.getInt(0, 400));
+		grid.query(Rect4f(rect), result);
+		EXPECT_TRUE(std::is_sorted(result.begin(), result.end()));
+
+		for (uint32_t j = 0; j < positions.size(); ++j) {
+			const bool candidate = std::binary_search(result.begin(), result.end(), j);
+			if (!positions[j]) {
+				EXPECT_TRUE(candidate);
+			} else if (rect.contains(Vector2i(positions[j]->floor()))) {
+				EXPECT_TRUE(candidate) << "Position " << positions[j]->x << ", " << positions[j]->y << " in " << rect;
+			}
+		}
+	}
+
+	grid.clear();
+	EXPECT_EQ(0, grid.size());
+	grid.query(Rect4f(-1000, -1000, 2000, 2000), result);
+	EXPECT_TRUE(result.empty());
+}
+
+TEST(HalleyEntityNetwork, SnapshotsOverLossyLoopback)
+{
+	TestSnapshotSession test;
+	ASSERT_TRUE(test.client.session->getMyPeerId().has_value());
+	for (int i = 0; i < 10; ++i) {
+		test.tick();
+	}
+
+	constexpr int nEntities = 300;
+	Vector<EntityRef> entities;
+	for (int i = 0; i < nEntities; ++i) {
+		entities.push_back(test.createEntity("entity" + toString(i), Vector2f(static_cast<float>(i % 20), static_cast<float>(i / 20)) * 64.0f));
+	}
+
+	// Snapshots are lost, and acknowledgements too, but each one that arrives brings the client up to date
+	test.network->setPacketLoss(0.2f, 1234);
+	bool partiallyCreated = false;
+	size_t lastCount = 0;
+	for (int tick = 0; tick < 300; ++tick) {
+		for (int i = 0; i < nEntities; i += 10) {
+			auto& transform = entities[i].getComponent<Transform2DComponent>();
+			transform.setGlobalPosition(transform.getGlobalPosition() + Vector2f(1, 0));
+		}
+		test.tick();
+
+		// Snapshots are capped in size, so creating everything takes several of them, but nothing the client has is destroyed meanwhile
+		const auto count = test.client.world->numEntities();
+		partiallyCreated = partiallyCreated || (count > 0 && count < nEntities);
+		EXPECT_GE(count, lastCount) << "Tick " << tick;
+		lastCount = count;
+	}
+	EXPECT_TRUE(partiallyCreated);
+
+	test.network->setPacketLoss(0);
+	for (int tick = 0; tick < 60; ++tick) {
+		test.tick();
+	}
+
+	EXPECT_EQ(nEntities, test.client.world->numEntities());
+	for (auto& entity: entities) {
+		const auto pos = test.getClientPosition(entity);
+		ASSERT_TRUE(pos.has_value()) << entity.getName();
+		EXPECT_NEAR(entity.getComponent<Transform2DComponent>().getGlobalPosition().x, pos->x, 0.1f) << entity.getName();
+		EXPECT_NEAR(entity.getComponent<Transform2DComponent>().getGlobalPosition().y, pos->y, 0.1f) << entity.getName();
+	}
+}
+
+TEST(HalleyEntityNetwork, SnapshotInterpolation)
+{
+	TestSnapshotSession test;
+	ASSERT_TRUE(test.client.session->getMyPeerId().has_value());
+	for (int i = 0; i < 10; ++i) {
+		test.tick();
+	}
+
+	auto interpolated = test.createEntity("interpolated", Vector2f());
+	auto stepped = test.createEntity("stepped", Vector2f(0, 100));
+
+	Vector<float> interpolatedX;
+	Vector<float> steppedX;
+	for (int tick = 0; tick < 120; ++tick) {
+		// Moves one unit per tick, while snapshots are sent every few ticks
+		for (auto* entity: { &interpolated, &stepped }) {
+			auto& transform = entity->getComponent<Transform2DComponent>();
+			transform.setGlobalPosition(transform.getGlobalPosition() + Vector2f(1, 0));
+		}
+		test.tick();
+
+		if (tick >= 60) {
+			interpolatedX.push_back(test.getClientPosition(interpolated).value().x);
+			steppedX.push_back(test.getClientPosition(stepped).value().x);
+		}
+	}
+
+	// Fields with an interpolator move on every tick, the rest only when a snapshot is reached
+	size_t steppedChanges = 0;
+	for (size_t i = 1; i < interpolatedX.size(); ++i) {
+		const float delta = interpolatedX[i] - interpolatedX[i - 1];
+		EXPECT_GT(delta, 0.5f) << "Tick " << i;
+		EXPECT_LT(delta, 1.5f) << "Tick " << i;
+		if (steppedX[i] != steppedX[i - 1]) {
+			++steppedChanges;
+		}
+	}
+	EXPECT_GT(steppedChanges, 0);
+	EXPECT_LT(steppedChanges, interpolatedX.size() / 2);
+}
+
+TEST(HalleyEntityNetwork, SnapshotsRejectOversizedEntities)
+{
+	TestSnapshotSession test;
+	ASSERT_TRUE(test.client.session->getMyPeerId().has_value());
+	for (int i = 0; i < 10; ++i) {
+		test.tick();
+	}
+
+	// Snapshots are never split across packets, so an entity too large for one is left out, instead of stalling everything else
+	Random rng(99u);
+	String name;
+	for (int i = 0; i < 3000; ++i) {
+		name.appendCharacter(static_cast<int>(rng.getInt('a', 'z')));
+	}
+	const auto oversized = test.createEntity(name, Vector2f());
+	const auto regular = test.createEntity("regular", Vector2f(10, 10));
+	for (int tick = 0; tick < 30; ++tick) {
+		test.tick();
+	}
+
+	EXPECT_EQ(1, test.client.world->numEntities());
+	EXPECT_TRUE(test.getClientPosition(regular).has_value());
+	EXPECT_FALSE(test.getClientPosition(oversized).has_value());
+}
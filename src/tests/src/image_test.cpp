@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "halley/file_formats/hlif_file.h"
+#include "test_executors.h"
+using namespace Halley;
+
+namespace {
+	std::unique_ptr<Image> makeNoiseImage(Image::Format format, Vector2i size, uint32_t seed, int numColours = 0)
+	{
+		Random rng(seed);
+		auto image = std::make_unique<Image>(format, size);
+		if (numColours > 0) {
+			Vector<int> colours;
+			for (int i = 0; i < numColours; ++i) {
+				colours.push_back(static_cast<int>(rng.getRawInt()));
+			}
+			for (auto& px: image->getPixels4BPP()) {
+				px = colours[rng.getInt(0, numColours - 1)];
+			}
+		} else {
+			rng.getBytes(gsl::as_writable_bytes(image->getPixelBytes()));
+		}
+		return image;
+	}
+
+	// The pixel buffer is padded, so only the bytes within the image are compared
+	gsl::span<const unsigned char> getImageBytes(const Image& image)
+	{
+		return image.getPixelBytes().subspan(0, image.getWidth() * image.getHeight() * image.getBytesPerPixel());
+	}
+
+	// Large images are stored in bands, which is flagged in the header, right after the id, size and data sizes
+	bool isBanded(const Bytes& hlif)
+	{
+		return (hlif.at(21) & 2) != 0;
+	}
+
+	int getPixel(const Image& image, Vector2i pos)
+	{
+		return image.getPixels4BPP()[pos.x + pos.y * static_cast<int>(image.getWidth())];
+	}
+
+	void expectRoundTrip(const Image& image, bool expectBanded)
+	{
+		const auto bytes = HLIFFile::encode(image, "test");
+		EXPECT_EQ(expectBanded, isBanded(bytes)) << image.getSize();
+
+		Image decoded;
+		HLIFFile::decode(decoded, bytes.byte_span());
+		EXPECT_EQ(image.getSize(), decoded.getSize());
+		EXPECT_EQ(image.getFormat(), decoded.getFormat());
+		const auto expected = getImageBytes(image);
+		const auto actual = getImageBytes(decoded);
+		ASSERT_EQ(expected.size(), actual.size());
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin())) << image.getSize();
+	}
+}
+
+TEST(HalleyImage, HLIFBandedRGBANoise)
+{
+	getTestExecutors();
+	expectRoundTrip(*makeNoiseImage(Image::Format::RGBA, Vector2i(513, 301), 1), true);
+	expectRoundTrip(*makeNoiseImage(Image::Format::RGBAPremultiplied, Vector2i(257, 1029), 2), true);
+
+	// Too small to be split
+	expectRoundTrip(*makeNoiseImage(Image::Format::RGBA, Vector2i(61, 37), 3), false);
+}
+
+TEST(HalleyImage, HLIFBandedPaletted)
+{
+	getTestExecutors();
+	const auto image = makeNoiseImage(Image::Format::RGBA, Vector2i(517, 1031), 4, 40);
+	expectRoundTrip(*image, true);
+
+	// Paletted images store one byte per pixel, which random indices can't compress much below
+	EXPECT_LT(HLIFFile::encode(*image).size(), image->getPixelBytes().size() / 3);
+}
+
+TEST(HalleyImage, HLIFBandedSingleChannel)
+{
+	getTestExecutors();
+	expectRoundTrip(*makeNoiseImage(Image::Format::SingleChannel, Vector2i(1001, 1033), 5), true);
+	expectRoundTrip(*makeNoiseImage(Image::Format::Indexed, Vector2i(999, 1025), 6), true);
+	expectRoundTrip(*makeNoiseImage(Image::Format::SingleChannel, Vector2i(3, 5), 7), false);
+}
+
+TEST(HalleyImage, PreMultiplyMatchesScalar)
+{
+	// Wide images go through the SIMD path, while single pixels only take the scalar one
+	auto image = makeNoiseImage(Image::Format::RGBA, Vector2i(37, 5), 8);
+	auto pixels = image->getPixels4BPP();
+	pixels[0] = Image::convertRGBAToInt(255, 255, 255, 0);
+	pixels[1] = Image::convertRGBAToInt(255, 255, 255, 255);
+	pixels[2] = Image::convertRGBAToInt(1, 128, 254, 127);
+
+	const auto original = Vector<int>(pixels.begin(), pixels.end());
+	image->preMultiply();
+	EXPECT_EQ(Image::Format::RGBAPremultiplied, image->getFormat());
+
+	for (size_t i = 0; i < original.size(); ++i) {
+		Image single(Image::Format::RGBA, Vector2i(1, 1));
+		single.getPixels4BPP()[0] = original[i];
+		single.preMultiply();
+		ASSERT_EQ(single.getPixels4BPP()[0], image->getPixels4BPP()[i]) << "Pixel " << i;
+	}
+}
+
+TEST(HalleyImage, BlitFromMatchesScalar)
+{
+	Random rng(9u);
+	constexpr size_t width = 53;
+	constexpr size_t height = 3;
+	constexpr size_t pitch = 60;
+	Bytes alpha(pitch * height);
+	rng.getBytes(alpha.byte_span());
+
+	Image wide(Image::Format::RGBA, Vector2i(64, 8));
+	wide.blitFrom(Vector2i(3, 2), gsl::span<const unsigned char>(alpha.data(), alpha.size()), width, height, pitch, 8);
+
+	Image narrow(Image::Format::RGBA, Vector2i(64, 8));
+	for (size_t y = 0; y < height; ++y) {
+		for (size_t x = 0; x < width; ++x) {
+			narrow.blitFrom(Vector2i(int(x) + 3, int(y) + 2), gsl::span<const unsigned char>(alpha.data() + y * pitch + x, 1), 1, 1, 1, 8);
+		}
+	}
+
+	const auto widePx = wide.getPixels4BPP();
+	const auto narrowPx = narrow.getPixels4BPP();
+	for (size_t i = 0; i < widePx.size(); ++i) {
+		ASSERT_EQ(narrowPx[i], widePx[i]) << "Pixel " << i;
+	}
+	EXPECT_EQ(static_cast<int>(Image::convertRGBAToInt(255, 255, 255, alpha[0])), getPixel(wide, Vector2i(3, 2)));
+
+	// 32-bit blits copy the pixels as they are
+	const auto src = makeNoiseImage(Image::Format::RGBA, Vector2i(21, 7), 10);
+	Image copy(Image::Format::RGBA, Vector2i(32, 16));
+	copy.blitFrom(Vector2i(5, 4), *src);
+	for (int y = 0; y < 7; ++y) {
+		for (int x = 0; x < 21; ++x) {
+			ASSERT_EQ(getPixel(*src, Vector2i(x, y)), getPixel(copy, Vector2i(x + 5, y + 4)));
+		}
+	}
+}
+
+TEST(HalleyImage, BlitDownsampledMatchesScalar)
+{
+	auto src = makeNoiseImage(Image::Format::RGBA, Vector2i(27, 10), 11);
+	Image wide(Image::Format::RGBA, Vector2i(13, 5));
+	wide.blitDownsampled(*src, 2);
+
+	// One output column at a time only takes the scalar path
+	for (int x = 0; x < 13; ++x) {
+		Image column(Image::Format::RGBA, Vector2i(2, 10));
+		column.blitFrom(Vector2i(), *src, Rect4i(x * 2, 0, 2, 10));
+		Image narrow(Image::Format::RGBA, Vector2i(1, 5));
+		narrow.blitDownsampled(column, 2);
+		for (int y = 0; y < 5; ++y) {
+			ASSERT_EQ(getPixel(narrow, Vector2i(0, y)), getPixel(wide, Vector2i(x, y))) << x << ", " << y;
+			ASSERT_EQ(getPixel(*src, Vector2i(x * 2, y * 2)), getPixel(wide, Vector2i(x, y))) << x << ", " << y;
+		}
+	}
+}
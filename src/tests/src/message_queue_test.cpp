@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "halley/net/connection/message_queue_udp.h"
+using namespace Halley;
+
+namespace {
+	// Connects two MessageQueueUDPs over a LoopbackNetwork, with one reliable ordered channel, timed by a clock that only moves on step()
+	class TestMessageQueues {
+	public:
+		TestMessageQueues()
+			: hostService(network)
+			, clientService(network)
+		{
+			std::shared_ptr<IConnection> hostConnection;
+			const auto address = hostService.startListening([&] (NetworkService::Acceptor& acceptor) { hostConnection = acceptor.accept(); });
+			auto clientConnection = clientService.connect(address);
+			hostService.update(0);
+
+			host = makeQueue(hostConnection);
+			client = makeQueue(clientConnection);
+		}
+
+		void step(std::chrono::milliseconds time = std::chrono::milliseconds(5))
+		{
+			client->sendAll();
+			host->sendAll();
+			now += time;
+		}
+
+		std::shared_ptr<LoopbackNetwork> network = std::make_shared<LoopbackNetwork>();
+		LoopbackNetworkService hostService;
+		LoopbackNetworkService clientService;
+		std::shared_ptr<MessageQueueUDP> host;
+		std::shared_ptr<MessageQueueUDP> client;
+		AckUnreliableConnection::Clock::time_point now = AckUnreliableConnection::Clock::now();
+
+	private:
+		std::shared_ptr<MessageQueueUDP> makeQueue(std::shared_ptr<IConnection> connection)
+		{
+			auto ackConnection = std::make_shared<AckUnreliableConnection>(std::move(connection));
+			ackConnection->setTimeSource([this] () { return now; });
+			auto queue = std::make_shared<MessageQueueUDP>(std::move(ackConnection));
+			queue->setChannel(0, ChannelSettings(true, true));
+			queue->setFragmentBandwidth(4 * 1024 * 1024);
+			return queue;
+		}
+	};
+}
+
+TEST(HalleyMessageQueue, FragmentedMessagesUnderLoss)
+{
+	TestMessageQueues test;
+	ASSERT_TRUE(test.host->isConnected());
+	ASSERT_TRUE(test.client->isConnected());
+	test.network->setPacketLoss(0.2f, 4321);
+
+	// Large messages with small ones in between, which have to wait for the fragments before them
+	Random rng(1234u);
+	Vector<Bytes> sent;
+	for (int i = 0; i < 12; ++i) {
+		Bytes bytes(i % 4 == 3 ? static_cast<size_t>(rng.getInt(1, 200)) : static_cast<size_t>(rng.getInt(4 * 1024, 12 * 1024)));
+		for (auto& b: bytes) {
+			b = static_cast<Byte>(rng.getInt(0, 255));
+		}
+		test.client->enqueue(OutboundNetworkPacket(gsl::as_bytes(gsl::span<const Byte>(bytes))), 0);
+		sent.push_back(std::move(bytes));
+	}
+
+	// Up to 20 seconds, though it should take well under one
+	Vector<Bytes> received;
+	for (int i = 0; i < 4000 && received.size() < sent.size(); ++i) {
+		test.step();
+		for (auto& packet: test.host->receivePackets()) {
+			const auto bytes = packet.getBytes();
+			const auto* src = reinterpret_cast<const Byte*>(bytes.data());
+			received.emplace_back(src, src + bytes.size());
+		}
+		test.client->receivePackets();
+	}
+
+	ASSERT_EQ(sent.size(), received.size());
+	for (size_t i = 0; i < sent.size(); ++i) {
+		EXPECT_EQ(sent[i], received[i]) << "Message " << i;
+	}
+	EXPECT_TRUE(test.host->isConnected());
+	EXPECT_TRUE(test.client->isConnected());
+}
+
+TEST(HalleyMessageQueue, FragmentsAreSentAtLowBandwidth)
+{
+	// 100 ms worth of budget is less than a fragment here, so the budget has to allow for at least one
+	TestMessageQueues test;
+	test.client->setFragmentBandwidth(2000);
+
+	Bytes bytes(6000);
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<Byte>(i);
+	}
+	test.client->enqueue(OutboundNetworkPacket(gsl::as_bytes(gsl::span<const Byte>(bytes))), 0);
+
+	Vector<InboundNetworkPacket> received;
+	int steps = 0;
+	for (; steps < 2000 && received.empty(); ++steps) {
+		test.step();
+		received = test.host->receivePackets();
+		test.client->receivePackets();
+	}
+
+	ASSERT_EQ(1, received.size());
+	const auto receivedBytes = received[0].getBytes();
+	EXPECT_TRUE(std::equal(bytes.begin(), bytes.end(), reinterpret_cast<const Byte*>(receivedBytes.data()), reinterpret_cast<const Byte*>(receivedBytes.data()) + receivedBytes.size()));
+
+	// Still paced to the bandwidth, after the initial burst
+	EXPECT_GE(steps * 5, 2000);
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_executors.h"
+using namespace Halley;
+
+namespace {
+	Vector<Polygon> makeTestPolygons(Random& rng, size_t count)
+	{
+		Vector<Polygon> result;
+		for (size_t i = 0; i < count; ++i) {
+			const size_t sides = 3 + i % 6;
+			const auto centre = Vector2f(rng.getFloat(-100.0f, 100.0f), rng.getFloat(-100.0f, 100.0f));
+			const float radius = rng.getFloat(5.0f, 20.0f);
+
+			VertexList vs;
+			for (size_t j = 0; j < sides; ++j) {
+				vs.push_back(centre + Vector2f(radius, 0).rotate(Angle1f::fromRadians(static_cast<float>(j) * 2 * static_cast<float>(pi()) / static_cast<float>(sides))));
+			}
+			auto& poly = result.emplace_back(std::move(vs));
+			if (i % 2 == 1) {
+				poly.invertWinding();
+			}
+		}
+		return result;
+	}
+
+	Vector2f makeTestPoint(Random& rng)
+	{
+		return Vector2f(rng.getFloat(-120.0f, 120.0f), rng.getFloat(-120.0f, 120.0f));
+	}
+
+	Ray makeTestRay(Random& rng)
+	{
+		return Ray(makeTestPoint(rng), Vector2f(1, 0).rotate(Angle1f::fromRadians(rng.getFloat(0, 2 * static_cast<float>(pi())))));
+	}
+
+	// A grid of square cells with random weights, some of them missing
+	Navmesh makeTestGridNavmesh(Random& rng, int width, int height)
+	{
+		constexpr float cellSize = 10.0f;
+		Vector<int> cellIds(width * height, -1);
+		int nCells = 0;
+		for (auto& id: cellIds) {
+			if (rng.getFloat(0.0f, 1.0f) > 0.2f) {
+				id = nCells++;
+			}
+		}
+
+		auto getCell = [&] (int x, int y) -> int
+		{
+			return x >= 0 && y >= 0 && x < width && y < height ? cellIds[x + y * width] : -1;
+		};
+
+		Vector<Navmesh::PolygonData> polygons;
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				if (getCell(x, y) >= 0) {
+					const auto p = Vector2f(static_cast<float>(x), static_cast<float>(y)) * cellSize;
+					auto& poly = polygons.emplace_back();
+					poly.polygon = Polygon(VertexList{ p, p + Vector2f(cellSize, 0), p + Vector2f(cellSize, cellSize), p + Vector2f(0, cellSize) });
+					poly.connections = { getCell(x, y - 1), getCell(x + 1, y), getCell(x, y + 1), getCell(x - 1, y) };
+					poly.weight = rng.getFloat(1.0f, 4.0f);
+				}
+			}
+		}
+
+		const auto size = Vector2f(static_cast<float>(width), static_cast<float>(height)) * cellSize;
+		return Navmesh(std::move(polygons), NavmeshBounds(Vector2f(), Vector2f(size.x, 0), Vector2f(0, size.y), 1, 1, Vector2f(1, 1)), 0);
+	}
+
+	// Bellman-Ford, as a reference that doesn't share any logic with the flow field
+	Vector<float> getReferenceCostsToGoal(const Navmesh& navmesh, Navmesh::NodeId goal)
+	{
+		const auto& nodes = navmesh.getNodes();
+		Vector<float> cost(nodes.size(), std::numeric_limits<float>::infinity());
+		cost[goal] = 0;
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (size_t i = 0; i < nodes.size(); ++i) {
+				for (size_t j = 0; j < nodes[i].nConnections; ++j) {
+					if (nodes[i].connections[j]) {
+						const float c = cost[nodes[i].connections[j].value()] + nodes[i].costs[j];
+						if (c < cost[i] - 0.0001f) {
+							cost[i] = c;
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+		return cost;
+	}
+
+	float getPathCost(const Navmesh& navmesh, const Vector<Navmesh::NodeAndConn>& path)
+	{
+		float cost = 0;
+		for (size_t i = 0; i + 1 < path.size(); ++i) {
+			cost += navmesh.getNodes()[path[i].node].costs[path[i].connectionIdx];
+		}
+		return cost;
+	}
+
+	void checkFlowField(const Navmesh& navmesh, const NavmeshFlowField& field)
+	{
+		const auto& nodes = navmesh.getNodes();
+		const auto goal = field.getGoal();
+		const auto reference = getReferenceCostsToGoal(navmesh, goal);
+
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			const auto node = static_cast<Navmesh::NodeId>(i);
+			const auto path = navmesh.pathfindNodes(NavigationQuery(WorldPosition(nodes[i].pos), WorldPosition(nodes[goal].pos), NavigationQuery::PostProcessingType::None));
+			ASSERT_EQ(path.has_value(), field.isReachable(node));
+			ASSERT_EQ(std::isfinite(reference[i]), field.isReachable(node));
+			if (!field.isReachable(node)) {
+				EXPECT_FALSE(field.getNextHop(node));
+				continue;
+			}
+
+			// pathfind's heuristic is inflated, so it can't beat the flow field, which must be optimal
+			const float cost = field.getCostToGoal(node);
+			EXPECT_NEAR(reference[i], cost, 0.01f);
+			EXPECT_LE(cost, getPathCost(navmesh, path.value()) + 0.01f);
+
+			if (node == goal) {
+				EXPECT_FALSE(field.getNextHop(node));
+			} else {
+				// Following the next hop must reach the goal at exactly the stated cost
+				const auto hop = field.getNextHop(node);
+				ASSERT_TRUE(hop);
+				const auto next = nodes[i].connections[hop->connectionIdx];
+				ASSERT_TRUE(next);
+				EXPECT_EQ(next.value(), field.getNextNode(node).value());
+				EXPECT_NEAR(cost, field.getCostToGoal(next.value()) + nodes[i].costs[hop->connectionIdx], 0.01f);
+				EXPECT_TRUE(field.getNextWaypoint(node));
+			}
+		}
+	}
+}
+
+TEST(HalleyNavmesh, PackedPolygonsMatchPolygon)
+{
+	Random rng(1234u);
+	const auto polygons = makeTestPolygons(rng, 60);
+	const NavmeshPackedPolygons packed(polygons);
+
+	for (size_t i = 0; i < polygons.size(); ++i) {
+		ASSERT_TRUE(packed.isPacked(i));
+		for (int j = 0; j < 500; ++j) {
+			const auto p = makeTestPoint(rng);
+			EXPECT_EQ(polygons[i].isPointInside(p), packed.isPointInside(i, p));
+
+			const float expectedDist = (polygons[i].getClosestPoint(p) - p).length();
+			EXPECT_NEAR(expectedDist, std::sqrt(packed.getSquaredDistanceTo(i, p)), 0.001f + expectedDist * 0.0001f);
+
+			const auto ray = makeTestRay(rng);
+			EXPECT_EQ(polygons[i].getExitEdge(ray), packed.getExitEdge(i, ray));
+			EXPECT_EQ(polygons[i].getExitEdge(ray, 2), packed.getExitEdge(i, ray, 2));
+		}
+	}
+}
+
+TEST(HalleyNavmesh, FlowFieldMatchesPathfind)
+{
+	Random rng(4242u);
+	for (int i = 0; i < 20; ++i) {
+		const auto navmesh = makeTestGridNavmesh(rng, 12, 9);
+		const auto nNodes = navmesh.getNodes().size();
+		ASSERT_GT(nNodes, 0);
+		for (int j = 0; j < 3; ++j) {
+			const auto goal = static_cast<Navmesh::NodeId>(rng.getSizeT(0, nNodes - 1));
+			const NavmeshFlowField field(navmesh, goal);
+			EXPECT_EQ(goal, field.getGoal());
+			EXPECT_EQ(nNodes, field.getNumNodes());
+			checkFlowField(navmesh, field);
+		}
+	}
+}
+
+TEST(HalleyNavmesh, FlowFieldCache)
+{
+	getTestExecutors();
+
+	Random rng(777u);
+	const auto navmesh = makeTestGridNavmesh(rng, 10, 10);
+	const auto nNodes = navmesh.getNodes().size();
+
+	NavmeshFlowFieldCache cache(navmesh, 2);
+	const auto goalA = static_cast<Navmesh::NodeId>(0);
+	const auto goalB = static_cast<Navmesh::NodeId>(nNodes / 2);
+	const auto goalC = static_cast<Navmesh::NodeId>(nNodes - 1);
+
+	const auto fieldA = cache.request(goalA).get();
+	ASSERT_TRUE(fieldA);
+	EXPECT_EQ(goalA, fieldA->getGoal());
+	checkFlowField(navmesh, *fieldA);
+
+	// Cached fields are returned as they are
+	EXPECT_EQ(fieldA, cache.request(goalA).get());
+	EXPECT_EQ(1, cache.size());
+
+	const auto fieldB = cache.request(goalB).get();
+	checkFlowField(navmesh, *fieldB);
+	EXPECT_EQ(2, cache.size());
+
+	// Touch A, so B is the least recently used when C comes in
+	EXPECT_EQ(fieldA, cache.tryGet(goalA));
+	const auto fieldC = cache.request(goalC).get();
+	checkFlowField(navmesh, *fieldC);
+	EXPECT_EQ(2, cache.size());
+	EXPECT_EQ(fieldA, cache.tryGet(goalA));
+	EXPECT_EQ(fieldC, cache.tryGet(goalC));
+
+	cache.clear();
+	EXPECT_EQ(0, cache.size());
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	void fill(const NetworkBufferRef& buffer, size_t size)
+	{
+		auto& data = buffer.getData();
+		for (size_t i = 0; i < size; ++i) {
+			data[i] = static_cast<Byte>(i);
+		}
+	}
+}
+
+TEST(HalleyNetworkPacket, BufferReturnsToPoolWhenReleased)
+{
+	auto pool = std::make_shared<NetworkBufferPool>();
+	auto buffer = pool->acquire(100);
+	const auto* storage = &buffer.getData();
+
+	// Any remaining reference keeps it out of the pool
+	auto copy = buffer;
+	buffer = {};
+	auto other = pool->acquire(100);
+	EXPECT_NE(storage, &other.getData());
+	EXPECT_EQ(storage, &copy.getData());
+
+	copy = {};
+	auto reused = pool->acquire(100);
+	EXPECT_EQ(storage, &reused.getData());
+}
+
+TEST(HalleyNetworkPacket, BufferIsReusedWithoutReallocating)
+{
+	auto pool = std::make_shared<NetworkBufferPool>();
+	const Byte* bytes = nullptr;
+	{
+		auto buffer = pool->acquire(1500);
+		bytes = buffer.getData().data();
+	}
+
+	// Smaller sizes fit in the capacity it already has
+	for (const size_t size: { 1500, 20, 800, 1500 }) {
+		auto buffer = pool->acquire(size);
+		EXPECT_EQ(size, buffer.getData().size());
+		EXPECT_EQ(bytes, buffer.getData().data());
+	}
+}
+
+TEST(HalleyNetworkPacket, SubPacketsShareTheirBuffer)
+{
+	auto pool = std::make_shared<NetworkBufferPool>();
+	auto buffer = pool->acquire(64);
+	const auto* storage = &buffer.getData();
+	fill(buffer, 64);
+
+	std::optional<InboundNetworkPacket> packet = InboundNetworkPacket(std::move(buffer), 64);
+	uint16_t header = 0;
+	packet->extractHeader(header);
+	auto sub = packet->subPacket(10, 4);
+
+	// The sub-packet keeps the buffer alive, and points into it without copying
+	packet.reset();
+	ASSERT_EQ(4, sub.getSize());
+	EXPECT_EQ(storage->data() + 12, reinterpret_cast<const Byte*>(sub.getBytes().data()));
+	EXPECT_EQ(Byte(12), static_cast<Byte>(sub.getBytes()[0]));
+	EXPECT_NE(storage, &pool->acquire(64).getData());
+
+	sub = InboundNetworkPacket();
+	EXPECT_EQ(storage, &pool->acquire(64).getData());
+}
+
+TEST(HalleyNetworkPacket, BufferOutlivesItsPool)
+{
+	auto pool = std::make_shared<NetworkBufferPool>();
+	auto buffer = pool->acquire(32);
+	fill(buffer, 32);
+	const std::weak_ptr<NetworkBufferPool> weakPool = pool;
+
+	pool.reset();
+	EXPECT_FALSE(weakPool.expired());
+	EXPECT_EQ(Byte(31), buffer.getData()[31]);
+
+	buffer = {};
+	EXPECT_TRUE(weakPool.expired());
+}
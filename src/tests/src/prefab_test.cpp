@@ -0,0 +1,353 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_world.h"
+using namespace Halley;
+
+namespace {
+	// Like a generated component, but referencing another entity, which no component in the engine does in prefabs
+	class TargetComponent final : public Component {
+	public:
+		static constexpr int componentIndex{ 16 };
+		static const constexpr char* componentName{ "Target" };
+
+		EntityId target{};
+		float range{};
+
+		ConfigNode serialize(const EntitySerializationContext& _context) const
+		{
+			using namespace EntitySerialization;
+			ConfigNode _node = ConfigNode::MapType();
+			EntityConfigNodeSerializer<decltype(target)>::serialize(target, EntityId{}, _context, _node, componentName, "target", makeMask(Type::Prefab, Type::SaveData));
+			EntityConfigNodeSerializer<decltype(range)>::serialize(range, float{}, _context, _node, componentName, "range", makeMask(Type::Prefab, Type::SaveData));
+			return _node;
+		}
+
+		void deserialize(const EntitySerializationContext& _context, const ConfigNode& _node)
+		{
+			using namespace EntitySerialization;
+			EntityConfigNodeSerializer<decltype(target)>::deserialize(target, EntityId{}, _context, _node, componentName, "target", makeMask(Type::Prefab, Type::SaveData));
+			EntityConfigNodeSerializer<decltype(range)>::deserialize(range, float{}, _context, _node, componentName, "range", makeMask(Type::Prefab, Type::SaveData));
+		}
+	};
+
+	class PrefabTestCodegenFunctions : public TestCodegenFunctions {
+	public:
+		Vector<std::unique_ptr<ComponentReflector>> makeComponentReflectors() override
+		{
+			auto result = TestCodegenFunctions::makeComponentReflectors();
+			result.push_back(std::make_unique<ComponentReflectorImpl<TargetComponent>>());
+			return result;
+		}
+	};
+
+	class PrefabTestWorld {
+	public:
+		PrefabTestWorld()
+		{
+			api.core = &core;
+			resources = std::make_unique<Resources>(nullptr, api, ResourceOptions());
+			resources->init<Prefab>();
+			resources->init<Scene>();
+			world = std::make_unique<World>(api, *resources, WorldReflection(codegen));
+		}
+
+		std::shared_ptr<Prefab> addPrefab(const String& name, std::string_view yaml)
+		{
+			auto prefab = std::make_shared<Prefab>();
+			prefab->setAssetId(name);
+			prefab->parseYAML(gsl::as_bytes(gsl::span<const char>(yaml.data(), yaml.size())));
+			resources->of<Prefab>().setResource(0, name, prefab);
+			return prefab;
+		}
+
+		EntityData serialize(EntityRef entity)
+		{
+			EntityFactory::SerializationOptions options;
+			options.type = EntitySerialization::Type::SaveData;
+			return EntityFactory(*world, *resources).serializeEntity(entity, options);
+		}
+
+		TestCoreAPI core;
+		HalleyAPI api{};
+		std::unique_ptr<Resources> resources;
+		PrefabTestCodegenFunctions codegen;
+		std::unique_ptr<World> world;
+	};
+
+	constexpr std::string_view targetingPrefab = R"(
+uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c001
+name: turret
+components:
+  - Transform2D:
+      position: [10, 20]
+  - Velocity:
+      velocity: [1, 2]
+  - Target:
+      target: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c002
+      range: 5
+children:
+  - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c002
+    name: barrel
+    components:
+      - Transform2D:
+          position: [1, 0]
+      - Target:
+          target: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c001
+    children:
+      - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c003
+        name: muzzle
+        components:
+          - Transform2D:
+              position: [2, 0]
+          - Velocity:
+              velocity: [3, 4]
+  - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c004
+    name: base
+    components:
+      - Transform2D:
+          position: [0, -1]
+)";
+
+	constexpr std::string_view nestingPrefab = R"(
+uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c011
+name: fort
+components:
+  - Transform2D:
+      position: [100, 0]
+children:
+  - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c012
+    prefab: turret
+    components:
+      - Transform2D:
+          position: [5, 5]
+  - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c013
+    name: wall
+    components:
+      - Transform2D:
+          position: [0, 5]
+      - Target:
+          target: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c011
+)";
+
+	// Instances the prefab through the template in one world, and through EntityData with the same instance UUID in another
+	void expectSameAsRegularPath(const String& prefabName, bool expectInstantiable)
+	{
+		PrefabTestWorld templateWorld;
+		PrefabTestWorld regularWorld;
+		for (auto* test: { &templateWorld, &regularWorld }) {
+			test->addPrefab("turret", targetingPrefab);
+			test->addPrefab("fort", nestingPrefab);
+		}
+
+		auto entity = EntityFactory(*templateWorld.world, *templateWorld.resources).createEntity(prefabName);
+		templateWorld.world->spawnPending();
+		const auto prefabTemplate = templateWorld.resources->get<Prefab>(prefabName)->getCompiledTemplate();
+		ASSERT_TRUE(prefabTemplate);
+		EXPECT_EQ(expectInstantiable, prefabTemplate->instantiable);
+
+		EntityData data(entity.getInstanceUUID());
+		data.setPrefab(prefabName);
+		auto regularEntity = EntityFactory(*regularWorld.world, *regularWorld.resources).createEntity(data, EntitySerialization::makeMask(EntitySerialization::Type::Prefab));
+		regularWorld.world->spawnPending();
+		EXPECT_EQ(regularWorld.world->numEntities(), templateWorld.world->numEntities());
+
+		const auto expected = regularWorld.serialize(regularEntity).toConfigNode(true);
+		const auto actual = templateWorld.serialize(entity).toConfigNode(true);
+		EXPECT_EQ(expected, actual) << YAMLConvert::generateYAML(expected, {}) << "\n" << YAMLConvert::generateYAML(actual, {});
+	}
+}
+
+TEST(HalleyPrefab, TemplateMatchesRegularPath)
+{
+	expectSameAsRegularPath("turret", true);
+}
+
+TEST(HalleyPrefab, TemplateMatchesRegularPathWithNestedPrefabs)
+{
+	expectSameAsRegularPath("fort", false);
+}
+
+TEST(HalleyPrefab, TemplateResolvesReferencesPerInstance)
+{
+	PrefabTestWorld test;
+	test.addPrefab("turret", targetingPrefab);
+
+	const auto entities = EntityFactory(*test.world, *test.resources).createEntities("turret", 3, [] (EntityRef entity, size_t i)
+	{
+		entity.getComponent<TargetComponent>().range = static_cast<float>(i);
+	});
+	test.world->spawnPending();
+	ASSERT_EQ(3, entities.size());
+	EXPECT_EQ(12, test.world->numEntities());
+
+	// Only the components referencing other entities are deserialized again for each instance
+	const auto prefabTemplate = test.resources->get<Prefab>("turret")->getCompiledTemplate();
+	ASSERT_TRUE(prefabTemplate);
+	EXPECT_TRUE(prefabTemplate->needsContext);
+	ASSERT_EQ(4, prefabTemplate->nodes.size());
+	ASSERT_EQ(3, prefabTemplate->nodes[0].components.size());
+	EXPECT_TRUE(prefabTemplate->nodes[0].components[0].prototype);
+	EXPECT_TRUE(prefabTemplate->nodes[0].components[1].prototype);
+	EXPECT_FALSE(prefabTemplate->nodes[0].components[2].prototype);
+
+	// Each instance points at its own entities, and copies of the prototypes aren't shared
+	for (size_t i = 0; i < entities.size(); ++i) {
+		auto root = entities[i];
+		auto barrel = root.getChildWithName("barrel");
+		EXPECT_EQ(barrel.getEntityId(), root.getComponent<TargetComponent>().target);
+		EXPECT_EQ(root.getEntityId(), barrel.getComponent<TargetComponent>().target);
+		EXPECT_EQ(static_cast<float>(i), root.getComponent<TargetComponent>().range);
+		EXPECT_EQ(Vector2f(10, 20), root.getComponent<Transform2DComponent>().getLocalPosition());
+	}
+}
+
+TEST(HalleyPrefab, TemplateIsDroppedWithCaches)
+{
+	PrefabTestWorld test;
+	test.addPrefab("turret", targetingPrefab);
+	const auto prefab = test.resources->get<Prefab>("turret");
+
+	EntityFactory(*test.world, *test.resources).createEntity("turret");
+	const std::weak_ptr<const PrefabTemplate> prefabTemplate = prefab->getCompiledTemplate();
+	EXPECT_FALSE(prefabTemplate.expired());
+
+	// Nothing else holds on to it, so the resources its prototypes reference are released with it
+	test.resources->ofType(AssetType::Prefab).releaseCaches();
+	EXPECT_TRUE(prefabTemplate.expired());
+	EXPECT_FALSE(prefab->getCompiledTemplate());
+
+	EntityFactory(*test.world, *test.resources).createEntity("turret");
+	test.world->spawnPending();
+	EXPECT_TRUE(prefab->getCompiledTemplate());
+	EXPECT_EQ(8, test.world->numEntities());
+}
+
+namespace {
+	constexpr std::string_view fullPrefab = R"(
+entity:
+  uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c021
+  name: crate
+  icon: crate_icon
+  flags: 1
+  components:
+    - Transform2D:
+        position: [3, 4]
+    - TextLabel:
+        text:
+          text: "crate"
+    - Target:
+        target: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c022
+  children:
+    - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c022
+      name: lid
+      flags: 4
+      components:
+        - Transform2D:
+            position: [0, 1]
+        - Velocity: {}
+    - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c023
+      prefab: turret
+game:
+  loot: [coin, coin, gem]
+  weight: 2.5
+)";
+
+	constexpr std::string_view scene = R"(
+- uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c031
+  name: ground
+  components:
+    - Transform2D:
+        position: [0, 0]
+  children:
+    - uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c032
+      name: crate
+      prefab: crate
+- uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c033
+  name: sky
+  components:
+    - Transform2D:
+        position: [0, -100]
+    - Target:
+        target: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c031
+- uuid: 1b6b4a1e-56a3-4b0c-9a3c-2b2d56a0c034
+  prefab: turret
+)";
+
+	template <typename T>
+	std::shared_ptr<T> parsePrefab(std::string_view yaml)
+	{
+		auto prefab = std::make_shared<T>();
+		prefab->parseYAML(gsl::as_bytes(gsl::span<const char>(yaml.data(), yaml.size())));
+		return prefab;
+	}
+
+	template <typename T>
+	void expectLoadsAs(const T& expected, const Bytes& bytes)
+	{
+		T loaded;
+		Deserializer::fromBytes(loaded, bytes, SerializerOptions(SerializerOptions::maxVersion));
+		EXPECT_EQ(expected.toConfigNode(), loaded.toConfigNode()) << loaded.toYAML();
+		EXPECT_EQ(expected.getEntityData().toConfigNode(true), loaded.getEntityData().toConfigNode(true));
+		EXPECT_EQ(expected.getEntityDatas().size(), loaded.getEntityDatas().size());
+		EXPECT_EQ(expected.getPrefabDependencies(), loaded.getPrefabDependencies());
+		EXPECT_EQ(expected.isScene(), loaded.getEntityData().isSceneRoot());
+	}
+
+	template <typename T>
+	void expectTableRoundTrip(std::string_view yaml)
+	{
+		const auto prefab = parsePrefab<T>(yaml);
+		const auto bytes = Serializer::toBytes(*prefab, SerializerOptions(SerializerOptions::maxVersion));
+
+		// Entity tables start with a marker that no EntityDataDelta can start with
+		Deserializer s(bytes, SerializerOptions(SerializerOptions::maxVersion));
+		uint16_t marker = 0;
+		s >> marker;
+		EXPECT_EQ(0xFFFF, marker);
+
+		expectLoadsAs(*prefab, bytes);
+	}
+
+	// Assets imported before entity tables were a delta of the entity data, followed by the game data
+	template <typename T>
+	void expectLegacyLoads(std::string_view yaml)
+	{
+		const auto prefab = parsePrefab<T>(yaml);
+		const auto bytes = Serializer::toBytes([&] (Serializer& s)
+		{
+			s << prefab->getEntityData();
+			s << ConfigFile(ConfigNode(prefab->toConfigNode()["game"]));
+		}, SerializerOptions(SerializerOptions::maxVersion));
+
+		Deserializer s(bytes, SerializerOptions(SerializerOptions::maxVersion));
+		uint16_t marker = 0;
+		s >> marker;
+		EXPECT_NE(0xFFFF, marker);
+
+		expectLoadsAs(*prefab, bytes);
+	}
+}
+
+TEST(HalleyPrefab, PrefabTableRoundTrip)
+{
+	expectTableRoundTrip<Prefab>(fullPrefab);
+	expectTableRoundTrip<Prefab>(targetingPrefab);
+	expectTableRoundTrip<Prefab>(nestingPrefab);
+}
+
+TEST(HalleyPrefab, SceneTableRoundTrip)
+{
+	expectTableRoundTrip<Scene>(scene);
+	expectTableRoundTrip<Scene>("[]");
+}
+
+TEST(HalleyPrefab, LegacyPrefabLoads)
+{
+	expectLegacyLoads<Prefab>(fullPrefab);
+	expectLegacyLoads<Prefab>(nestingPrefab);
+}
+
+TEST(HalleyPrefab, LegacySceneLoads)
+{
+	expectLegacyLoads<Scene>(scene);
+}
@@ -0,0 +1,511 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "test_executors.h"
+#include "test_world.h"
+using namespace Halley;
+
+namespace {
+	class TestResource : public Resource {
+	public:
+		explicit TestResource(ResourceMemoryUsage usage = {})
+			: usage(usage)
+		{}
+
+		constexpr static AssetType getAssetType() { return AssetType::BinaryFile; }
+		static std::shared_ptr<TestResource> loadResource(ResourceLoader& loader) { return {}; }
+
+		ResourceMemoryUsage getMemoryUsage() const override { return usage; }
+		void releaseCaches() override { cached.reset(); }
+
+		std::shared_ptr<const Resource> cached;
+
+	private:
+		ResourceMemoryUsage usage;
+	};
+
+	class TestResources {
+	public:
+		TestResources()
+		{
+			api.core = &core;
+			resources = std::make_unique<Resources>(nullptr, api, ResourceOptions());
+			resources->init<TestResource>();
+		}
+
+		void setLoader(ResourceCollectionBase::ResourceLoaderFunc loader)
+		{
+			resources->ofType(AssetType::BinaryFile).setResourceLoader(std::move(loader));
+		}
+
+		TestCoreAPI core;
+		HalleyAPI api{};
+		std::unique_ptr<Resources> resources;
+	};
+}
+
+TEST(HalleyResources, PrefetcherWaitsForCancelledStages)
+{
+	getTestExecutors();
+
+	std::atomic<int> loading = 0;
+	std::atomic<int> loaded = 0;
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		++loading;
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		++loaded;
+		--loading;
+		return std::make_shared<TestResource>();
+	});
+
+	ResourcePrefetchManifest manifest;
+	for (int i = 0; i < 10; ++i) {
+		Vector<ResourcePrefetchManifest::Entry> entries;
+		for (int j = 0; j < 20; ++j) {
+			entries.push_back(ResourcePrefetchManifest::Entry{ AssetType::BinaryFile, "stage" + toString(i) + "_asset" + toString(j), 0.0f });
+		}
+		manifest.setStage("stage" + toString(i), std::move(entries));
+	}
+
+	// Each stage change cancels the previous prefetch without waiting for it, so several can be in flight at once
+	auto& prefetcher = test.resources->getPrefetcher();
+	prefetcher.startPlayback(std::move(manifest));
+	for (int i = 0; i < 50; ++i) {
+		prefetcher.setStage("stage" + toString(i % 10));
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+
+	// Destroying it waits for all of them, not just the latest, so none are still using it
+	test.resources.reset();
+	EXPECT_EQ(0, loading.load());
+	const int loadedAfterDestruction = loaded;
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_EQ(loadedAfterDestruction, loaded.load());
+	EXPECT_GT(loadedAfterDestruction, 0);
+}
+
+TEST(HalleyResources, PrefetcherRecordsFirstRequestsInOrder)
+{
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		if (name == "sheet") {
+			// Dependencies come along with whatever needs them, so they aren't recorded
+			static_cast<void>(test.resources->get<TestResource>("sheet_texture"));
+		}
+		return std::make_shared<TestResource>();
+	});
+	auto& resources = *test.resources;
+	auto& prefetcher = resources.getPrefetcher();
+
+	prefetcher.startRecording();
+	prefetcher.setStage("menu");
+	for (const auto* name: { "logo", "sheet", "logo", "font" }) {
+		resources.get<TestResource>(name);
+	}
+	prefetcher.setStage("level");
+	resources.get<TestResource>("tiles");
+	resources.get<TestResource>("logo");
+
+	// Revisiting a stage adds to its recording, rather than replacing it
+	prefetcher.setStage("menu");
+	resources.get<TestResource>("music");
+	resources.get<TestResource>("font");
+	const auto manifest = prefetcher.stopRecording();
+	EXPECT_EQ(ResourcePrefetcher::Mode::Disabled, prefetcher.getMode());
+
+	auto getNames = [] (const Vector<ResourcePrefetchManifest::Entry>* entries)
+	{
+		Vector<String> result;
+		float lastTime = 0;
+		for (const auto& entry: *entries) {
+			EXPECT_EQ(AssetType::BinaryFile, entry.type);
+			EXPECT_GE(entry.time, lastTime);
+			lastTime = entry.time;
+			result.push_back(entry.name);
+		}
+		return result;
+	};
+	ASSERT_TRUE(manifest.tryGetStage("menu"));
+	ASSERT_TRUE(manifest.tryGetStage("level"));
+	EXPECT_EQ(Vector<String>({ "tiles", "logo" }), getNames(manifest.tryGetStage("level")));
+
+	// Sorted by the time since the start of whichever visit first requested them, so only the order within one visit is known
+	auto menu = getNames(manifest.tryGetStage("menu"));
+	const auto logoPos = std::find(menu.begin(), menu.end(), "logo");
+	const auto sheetPos = std::find(menu.begin(), menu.end(), "sheet");
+	EXPECT_LT(logoPos, sheetPos);
+	std::sort(menu.begin(), menu.end());
+	EXPECT_EQ(Vector<String>({ "font", "logo", "music", "sheet" }), menu);
+	EXPECT_EQ(2, manifest.getStages().size());
+}
+
+TEST(HalleyResources, PrefetchManifestConfigNodeRoundTrip)
+{
+	ResourcePrefetchManifest manifest;
+	manifest.setStage("menu", { { AssetType::Sprite, "logo", 0.0f }, { AssetType::Texture, "ui/background:with:colons", 0.5f } });
+	manifest.setStage("level", { { AssetType::Prefab, "player", 1.25f } });
+	manifest.setStage("empty", {});
+
+	const auto node = manifest.toConfigNode();
+	const auto loaded = ResourcePrefetchManifest(ConfigNode(node));
+	EXPECT_EQ(node, loaded.toConfigNode());
+
+	auto stages = loaded.getStages();
+	std::sort(stages.begin(), stages.end());
+	EXPECT_EQ(Vector<String>({ "empty", "level", "menu" }), stages);
+
+	const auto* menu = loaded.tryGetStage("menu");
+	ASSERT_TRUE(menu);
+	ASSERT_EQ(2, menu->size());
+	EXPECT_EQ(AssetType::Sprite, (*menu)[0].type);
+	EXPECT_EQ(String("logo"), (*menu)[0].name);
+	EXPECT_EQ(AssetType::Texture, (*menu)[1].type);
+	EXPECT_EQ(String("ui/background:with:colons"), (*menu)[1].name);
+	EXPECT_FLOAT_EQ(0.5f, (*menu)[1].time);
+	EXPECT_FALSE(loaded.tryGetStage("missing"));
+}
+
+TEST(HalleyResources, PrefetcherStats)
+{
+	getTestExecutors();
+
+	std::mutex mutex;
+	HashSet<String> loaded;
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		std::unique_lock lock(mutex);
+		loaded.insert(String(name));
+		return std::make_shared<TestResource>();
+	});
+	auto& resources = *test.resources;
+	auto& prefetcher = resources.getPrefetcher();
+
+	// The last one was only needed well into the stage last time, so it won't be loaded yet
+	ResourcePrefetchManifest manifest;
+	manifest.setStage("level", { { AssetType::BinaryFile, "a", 0.0f }, { AssetType::BinaryFile, "b", 0.1f }, { AssetType::BinaryFile, "later", 1000.0f } });
+	prefetcher.startPlayback(std::move(manifest));
+	prefetcher.setStage("level");
+
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (prefetcher.getStats().prefetched < 2 && std::chrono::steady_clock::now() < timeout) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	{
+		std::unique_lock lock(mutex);
+		EXPECT_TRUE(loaded.contains("a"));
+		EXPECT_TRUE(loaded.contains("b"));
+		EXPECT_FALSE(loaded.contains("later"));
+	}
+
+	for (const auto* name: { "a", "b", "later", "unlisted", "a" }) {
+		resources.get<TestResource>(name);
+	}
+
+	// Stopping doesn't wait for the rest of the stage's timeline
+	const auto stopStart = std::chrono::steady_clock::now();
+	prefetcher.stopPlayback();
+	EXPECT_LT(std::chrono::steady_clock::now() - stopStart, std::chrono::seconds(5));
+
+	const auto stats = prefetcher.getStats();
+	EXPECT_EQ(2, stats.prefetched);
+	EXPECT_EQ(2, stats.hits);
+	EXPECT_EQ(1, stats.late);
+	EXPECT_EQ(1, stats.unlisted);
+}
+
+TEST(HalleyResources, AsyncLoadsAreShared)
+{
+	getTestExecutors();
+
+	std::atomic<int> loads = 0;
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		++loads;
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		return std::make_shared<TestResource>();
+	});
+	auto& collection = test.resources->ofType(AssetType::BinaryFile);
+
+	auto first = collection.getUntypedAsync("asset");
+	auto second = collection.getUntypedAsync("asset");
+	const auto sync = collection.getUntyped("asset");
+	EXPECT_EQ(sync, first.get());
+	EXPECT_EQ(sync, second.get());
+	EXPECT_EQ(sync, collection.getUntypedAsync("asset").get());
+	EXPECT_EQ(1, loads.load());
+}
+
+TEST(HalleyResources, MemoryBudgetEvictsLeastRecentlyUsed)
+{
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		return std::make_shared<TestResource>(ResourceMemoryUsage{ 100, 0 });
+	});
+	auto& resources = *test.resources;
+	resources.setMemoryBudget(ResourceMemoryUsage{ 450, 0 });
+
+	// Only the collection holds on to them, apart from the one kept here and the pinned one
+	HashMap<String, std::weak_ptr<const TestResource>> loaded;
+	auto load = [&] (const String& name)
+	{
+		auto res = resources.get<TestResource>(name);
+		loaded[name] = res;
+		return res;
+	};
+
+	resources.pin<TestResource>("a2");
+	for (int i = 0; i < 5; ++i) {
+		load("a" + toString(i));
+	}
+	const auto held = load("a1");
+	for (int i = 5; i < 8; ++i) {
+		load("a" + toString(i));
+	}
+
+	resources.enforceMemoryBudget();
+	EXPECT_LE(resources.getMemoryUsage().ramUsage, 450);
+
+	// The oldest ones go first, unless they're still in use or pinned
+	EXPECT_TRUE(loaded["a0"].expired());
+	EXPECT_FALSE(loaded["a1"].expired());
+	EXPECT_FALSE(loaded["a2"].expired());
+	EXPECT_TRUE(loaded["a3"].expired());
+	EXPECT_FALSE(loaded["a6"].expired());
+	EXPECT_FALSE(loaded["a7"].expired());
+
+	// Usage is kept up to date as they're loaded and evicted
+	size_t expectedUsage = 0;
+	for (const auto& [name, res]: loaded) {
+		expectedUsage += res.expired() ? 0 : 100;
+	}
+	EXPECT_EQ(expectedUsage, resources.getMemoryUsage().ramUsage);
+}
+
+TEST(HalleyResources, DuplicateLoadsDontCountTwice)
+{
+	TestResources test;
+	auto& resources = *test.resources;
+
+	// Stands in for another load of the same asset finishing first
+	std::shared_ptr<TestResource> first;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		first = std::make_shared<TestResource>(ResourceMemoryUsage{ 100, 10 });
+		resources.of<TestResource>().setResource(0, name, first);
+		return std::make_shared<TestResource>(ResourceMemoryUsage{ 100, 10 });
+	});
+
+	EXPECT_EQ(first, resources.get<TestResource>("a"));
+	EXPECT_EQ(100, resources.getMemoryUsage().ramUsage);
+	EXPECT_EQ(10, resources.getMemoryUsage().vramUsage);
+
+	resources.of<TestResource>().setResource(0, "a", std::make_shared<TestResource>(ResourceMemoryUsage{ 100, 10 }));
+	EXPECT_EQ(first, resources.get<TestResource>("a"));
+	EXPECT_EQ(100, resources.getMemoryUsage().ramUsage);
+
+	first = {};
+	resources.of<TestResource>().unload("a");
+	EXPECT_EQ(0, resources.getMemoryUsage().ramUsage);
+	EXPECT_EQ(0, resources.getMemoryUsage().vramUsage);
+}
+
+TEST(HalleyResources, VRamBudgetOnlyEvictsVRam)
+{
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		return std::make_shared<TestResource>(name.substr(0, 3) == "tex" ? ResourceMemoryUsage{ 10, 1000 } : ResourceMemoryUsage{ 100, 0 });
+	});
+	auto& resources = *test.resources;
+	resources.setMemoryBudget(ResourceMemoryUsage{ 0, 2500 });
+
+	Vector<std::weak_ptr<const TestResource>> data;
+	Vector<std::weak_ptr<const TestResource>> textures;
+	for (int i = 0; i < 4; ++i) {
+		data.push_back(resources.get<TestResource>("data" + toString(i)));
+		textures.push_back(resources.get<TestResource>("tex" + toString(i)));
+	}
+	resources.enforceMemoryBudget();
+
+	EXPECT_LE(resources.getMemoryUsage().vramUsage, 2500);
+	EXPECT_TRUE(textures[0].expired());
+	EXPECT_TRUE(textures[1].expired());
+	EXPECT_FALSE(textures[3].expired());
+	for (const auto& res: data) {
+		EXPECT_FALSE(res.expired());
+	}
+	EXPECT_EQ(4 * 100 + 2 * 10, resources.getMemoryUsage().ramUsage);
+}
+
+TEST(HalleyResources, CachesAreOnlyReleasedWhenStillOverBudget)
+{
+	TestResources test;
+	auto& resources = *test.resources;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority) -> std::shared_ptr<Resource>
+	{
+		if (name.substr(0, 6) == "holder") {
+			auto result = std::make_shared<TestResource>(ResourceMemoryUsage{ 10, 0 });
+			result->cached = resources.get<TestResource>("tex" + String(name.substr(6)));
+			return result;
+		}
+		return std::make_shared<TestResource>(ResourceMemoryUsage{ 10, 1000 });
+	});
+
+	const auto holder0 = resources.get<TestResource>("holder0");
+	const auto holder1 = resources.get<TestResource>("holder1");
+	const std::weak_ptr<const TestResource> unused = resources.get<TestResource>("tex2");
+
+	// Evicting the unused texture is enough, so the caches are left alone
+	resources.setMemoryBudget(ResourceMemoryUsage{ 0, 2000 });
+	resources.enforceMemoryBudget();
+	EXPECT_TRUE(unused.expired());
+	EXPECT_TRUE(holder0->cached);
+	EXPECT_TRUE(holder1->cached);
+
+	// Otherwise, the textures the caches were holding on to can be evicted too
+	const std::weak_ptr<const Resource> tex0 = holder0->cached;
+	resources.setMemoryBudget(ResourceMemoryUsage{ 0, 500 });
+	resources.enforceMemoryBudget();
+	EXPECT_FALSE(holder0->cached);
+	EXPECT_TRUE(tex0.expired());
+	EXPECT_EQ(0, resources.getMemoryUsage().vramUsage);
+	EXPECT_EQ(20, resources.getMemoryUsage().ramUsage);
+}
+
+TEST(HalleyResources, ResourcesInUseDontAge)
+{
+	TestResources test;
+	test.setLoader([&] (std::string_view name, ResourceLoadPriority priority)
+	{
+		return std::make_shared<TestResource>(ResourceMemoryUsage{ 100, 0 });
+	});
+	auto& resources = *test.resources;
+	auto& collection = resources.ofType(AssetType::BinaryFile);
+
+	auto held = resources.get<TestResource>("held");
+	std::weak_ptr<const TestResource> unused = resources.get<TestResource>("unused");
+
+	// Ageing agrees with eviction on what's in use, so a single reference from outside is enough to keep it
+	collection.age(10.0f);
+	collection.clearOldResources(5.0f);
+	EXPECT_TRUE(unused.expired());
+	EXPECT_EQ(0, held->getAge());
+
+	std::weak_ptr<const TestResource> released = held;
+	held.reset();
+	collection.clearOldResources(5.0f);
+	EXPECT_FALSE(released.expired());
+	collection.age(10.0f);
+	collection.clearOldResources(5.0f);
+	EXPECT_TRUE(released.expired());
+	EXPECT_EQ(0, resources.getMemoryUsage().ramUsage);
+}
+
+TEST(HalleyResources, TextureVRamUsage)
+{
+	EXPECT_EQ(64 * 32 * 4, TextureDescriptor::getVRamUsage(TextureFormat::RGBA, Vector2i(64, 32), false));
+	EXPECT_EQ(4 * 4 * 4 + 2 * 2 * 4 + 4, TextureDescriptor::getVRamUsage(TextureFormat::RGBA, Vector2i(4, 4), true));
+	EXPECT_EQ(4 * 2 + 2 + 1, TextureDescriptor::getVRamUsage(TextureFormat::Red, Vector2i(4, 2), true));
+
+	// Block compressed mips never go below one block
+	EXPECT_EQ(4 * 8 + 8 + 8 + 8, TextureDescriptor::getVRamUsage(TextureFormat::BC1, Vector2i(8, 8), true));
+	EXPECT_EQ(2 * 16, TextureDescriptor::getVRamUsage(TextureFormat::BC7, Vector2i(8, 3), false));
+}
+
+namespace {
+	String makeId(AssetType type, std::string_view name)
+	{
+		return ResourceDependencyGraph::makeAssetId(type, name);
+	}
+}
+
+TEST(HalleyResources, ReloadOrderChain)
+{
+	const auto image = makeId(AssetType::Image, "image");
+	const auto sheet = makeId(AssetType::SpriteSheet, "sheet");
+	const auto prefab = makeId(AssetType::Prefab, "prefab");
+	const auto scene = makeId(AssetType::Scene, "scene");
+
+	ResourceDependencyGraph graph;
+	graph.addDependency(sheet, image);
+	graph.addDependency(prefab, sheet);
+	graph.addDependency(scene, prefab);
+
+	EXPECT_EQ(Vector<Vector<String>>({ { image }, { sheet }, { prefab }, { scene } }), graph.getReloadOrder({ image }));
+	EXPECT_EQ(Vector<Vector<String>>({ { prefab }, { scene } }), graph.getReloadOrder({ prefab }));
+	EXPECT_EQ(Vector<Vector<String>>({ { scene } }), graph.getReloadOrder({ scene }));
+
+	// Reloading an asset records its dependencies again
+	graph.clearDependencies(prefab);
+	EXPECT_EQ(Vector<Vector<String>>({ { image }, { sheet } }), graph.getReloadOrder({ image }));
+}
+
+TEST(HalleyResources, ReloadOrderDiamond)
+{
+	const auto image = makeId(AssetType::Image, "image");
+	const auto sheetA = makeId(AssetType::SpriteSheet, "a");
+	const auto sheetB = makeId(AssetType::SpriteSheet, "b");
+	const auto prefab = makeId(AssetType::Prefab, "prefab");
+
+	ResourceDependencyGraph graph;
+	graph.addDependency(sheetA, image);
+	graph.addDependency(sheetB, image);
+	graph.addDependency(prefab, sheetA);
+	graph.addDependency(prefab, sheetB);
+	graph.addDependency(prefab, image);
+
+	// The prefab is only reloaded once, after both sheets
+	EXPECT_EQ(Vector<Vector<String>>({ { image }, { sheetA, sheetB }, { prefab } }), graph.getReloadOrder({ image }));
+	EXPECT_EQ(Vector<Vector<String>>({ { image }, { sheetA, sheetB }, { prefab } }), graph.getReloadOrder({ sheetB, image }));
+	EXPECT_EQ(Vector<Vector<String>>({ { sheetA, sheetB }, { prefab } }), graph.getReloadOrder({ sheetB, sheetA }));
+}
+
+TEST(HalleyResources, ReloadOrderCycleFromMetadata)
+{
+	const auto image = makeId(AssetType::Image, "image");
+	const auto prefabA = makeId(AssetType::Prefab, "a");
+	const auto prefabB = makeId(AssetType::Prefab, "b");
+	const auto scene = makeId(AssetType::Scene, "scene");
+
+	// Loading rejects cycles, but nothing stops the metadata from describing one
+	ResourceDependencyGraph graph;
+	graph.addDependencies(prefabA, ResourceDependencyGraph::makeDependencyList({ prefabB, image }));
+	graph.addDependencies(prefabB, ResourceDependencyGraph::makeDependencyList({ prefabA }));
+	graph.addDependencies(scene, ResourceDependencyGraph::makeDependencyList({ prefabB }));
+	EXPECT_EQ(Vector<String>({ prefabA }), graph.getDependencies(prefabB));
+
+	// Everything in and after the cycle is still reloaded, once, after what it doesn't depend on circularly
+	const auto order = graph.getReloadOrder({ image });
+	ASSERT_EQ(2, order.size());
+	EXPECT_EQ(Vector<String>({ image }), order[0]);
+	EXPECT_EQ(Vector<String>({ prefabA, prefabB, scene }), order[1]);
+}
+
+TEST(HalleyResources, ReloadOrderExcludesUnrelated)
+{
+	const auto image = makeId(AssetType::Image, "image");
+	const auto otherImage = makeId(AssetType::Image, "other");
+	const auto sheet = makeId(AssetType::SpriteSheet, "sheet");
+	const auto otherSheet = makeId(AssetType::SpriteSheet, "other");
+	const auto prefab = makeId(AssetType::Prefab, "prefab");
+	const auto config = makeId(AssetType::ConfigFile, "config");
+
+	ResourceDependencyGraph graph;
+	graph.addDependency(sheet, image);
+	graph.addDependency(otherSheet, otherImage);
+	graph.addDependency(prefab, otherSheet);
+	graph.addDependency(config, config);
+
+	EXPECT_EQ(Vector<Vector<String>>({ { image }, { sheet } }), graph.getReloadOrder({ image }));
+	EXPECT_EQ(Vector<Vector<String>>({ { config } }), graph.getReloadOrder({ config }));
+
+	// Assets that aren't in the graph are still reloaded themselves, sorted by type
+	const auto unknown = makeId(AssetType::BinaryFile, "unknown");
+	EXPECT_EQ(Vector<Vector<String>>({ { unknown, otherImage }, { otherSheet }, { prefab } }), graph.getReloadOrder({ otherImage, unknown }));
+	EXPECT_TRUE(graph.getReloadOrder({}).empty());
+}
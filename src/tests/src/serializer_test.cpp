@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <halley.hpp>
+#include "test_data_reader.h"
 using namespace Halley;
 
 namespace {
@@ -73,3 +74,335 @@ TEST(Serializer, UInt64Conversion)
 		EXPECT_EQ(n, convertBackAndForth(n));
 	}
 }
+
+namespace {
+	struct SerializerTestData {
+		Vector<String> names;
+		Vector<int64_t> values;
+		Vector<Vector2f> positions;
+
+		void serialize(Serializer& s) const
+		{
+			s << names;
+			s << values;
+			s << positions;
+		}
+	};
+
+	SerializerTestData makeSerializerTestData(size_t n)
+	{
+		auto& rng = Random::getGlobal();
+		SerializerTestData data;
+		for (size_t i = 0; i < n; ++i) {
+			data.names.push_back("entity_" + toString(i));
+			data.values.push_back(static_cast<int64_t>(rng.getSizeT(0, 1000000)) - 500000);
+			data.positions.push_back(Vector2f(rng.getFloat(-1000.0f, 1000.0f), rng.getFloat(-1000.0f, 1000.0f)));
+		}
+		return data;
+	}
+
+	Bytes toBytesTwoPass(const SerializerTestData& data, SerializerOptions options)
+	{
+		Bytes result(Serializer::getSize(data, options));
+		auto s = Serializer(gsl::as_writable_bytes(gsl::span<Byte>(result)), options);
+		s << data;
+		return result;
+	}
+}
+
+TEST(Serializer, SinglePassMatchesTwoPass)
+{
+	const auto data = makeSerializerTestData(1000);
+	const auto options = SerializerOptions(SerializerOptions::maxVersion);
+	const auto expected = toBytesTwoPass(data, options);
+
+	EXPECT_EQ(expected, Serializer::toBytes(data, options));
+
+	Bytes reused(10, 0xFF);
+	Serializer::toBytesInto(data, reused, options);
+	EXPECT_EQ(expected, reused);
+
+	const auto chunks = Serializer::toChunks(data, 1000, options);
+	Bytes joined;
+	for (const auto& chunk: chunks) {
+		EXPECT_LE(chunk.size(), 1000);
+		joined.insert(joined.end(), chunk.begin(), chunk.end());
+	}
+	EXPECT_EQ(expected, joined);
+}
+
+TEST(Serializer, BitSerializer)
+{
+	const auto pos = BitQuantization::makeFloat2(-1000, 1000, 0.01);
+	const auto angle = BitQuantization::makeAngle(12);
+	const auto small = BitQuantization::makeInt(-5, 10);
+	EXPECT_EQ(18, pos.bits);
+	EXPECT_EQ(4, small.bits);
+
+	Bytes bytes;
+	auto s = BitSerializer(bytes);
+	s.writeBool(true);
+	s.writeQuantized(123.456, pos);
+	s.writeQuantized(-999.999, pos);
+	s.writeQuantized(5000, pos);
+	s.writeQuantized(-90, angle);
+	s.writeQuantized(-3, small);
+	s.writeVarUInt(300);
+	s.writeBits(0xABCDEF0123456789ull, 64);
+	EXPECT_EQ((s.getBitPosition() + 7) / 8, bytes.size());
+
+	auto ds = BitDeserializer(gsl::as_bytes(gsl::span<const Byte>(bytes)));
+	EXPECT_TRUE(ds.readBool());
+	EXPECT_NEAR(123.456, ds.readQuantized(pos), 0.005);
+	EXPECT_NEAR(-999.999, ds.readQuantized(pos), 0.005);
+	EXPECT_NEAR(1000, ds.readQuantized(pos), 0.005);
+	EXPECT_NEAR(270, ds.readQuantized(angle), 360.0 / 4096);
+	EXPECT_EQ(-3, ds.readQuantized(small));
+	EXPECT_EQ(300, ds.readVarUInt());
+	EXPECT_EQ(0xABCDEF0123456789ull, ds.readBits(64));
+	EXPECT_THROW(ds.readBits(8), Exception);
+}
+
+TEST(Serializer, LZ4Stream)
+{
+	// Packets which share most of their structure, enough to slide the stream's window several times
+	auto makePacket = [] (int i)
+	{
+		const auto text = String("entity_") + toString(i % 7) + " position=" + toString(i * 3) + " sprite=characters/player_idle_" + toString(i % 3) + ";";
+		Bytes bytes;
+		while (bytes.size() < 3000) {
+			bytes.insert(bytes.end(), text.c_str(), text.c_str() + text.size());
+			bytes.push_back(static_cast<Byte>(i));
+		}
+		return bytes;
+	};
+	const auto dictionary = std::make_shared<const Bytes>(makePacket(1000));
+
+	auto compressor = LZ4StreamCompressor(dictionary);
+	auto decompressor = LZ4StreamDecompressor(dictionary);
+	size_t streamSize = 0;
+	size_t independentSize = 0;
+	for (int i = 0; i < 500; ++i) {
+		const auto packet = makePacket(i);
+		const auto span = gsl::as_bytes(gsl::span<const Byte>(packet));
+
+		Bytes compressed;
+		streamSize += compressor.compress(span, compressed);
+		independentSize += Compression::lz4Compress(span).size();
+
+		Bytes decompressed;
+		decompressor.decompress(gsl::as_bytes(gsl::span<const Byte>(compressed)), packet.size(), decompressed);
+		ASSERT_EQ(packet, decompressed);
+	}
+	EXPECT_LT(streamSize, independentSize);
+
+	compressor.reset();
+	decompressor.reset();
+	const auto packet = makePacket(1);
+	Bytes compressed;
+	compressor.compress(gsl::as_bytes(gsl::span<const Byte>(packet)), compressed);
+	Bytes decompressed;
+	decompressor.decompress(gsl::as_bytes(gsl::span<const Byte>(compressed)), packet.size(), decompressed);
+	EXPECT_EQ(packet, decompressed);
+	EXPECT_THROW(decompressor.decompress(gsl::as_bytes(gsl::span<const Byte>(compressed)), packet.size() + 1, decompressed), Exception);
+}
+
+TEST(Serializer, LZ4StreamIndependentBlocks)
+{
+	auto makePacket = [] (int i)
+	{
+		const auto text = String("snapshot_") + toString(i % 5) + " position=" + toString(i * 7) + ";";
+		Bytes bytes;
+		while (bytes.size() < 2000) {
+			bytes.insert(bytes.end(), text.c_str(), text.c_str() + text.size());
+		}
+		return bytes;
+	};
+	const auto dictionary = std::make_shared<const Bytes>(makePacket(1000));
+
+	auto compressor = LZ4StreamCompressor(dictionary);
+	auto decompressor = LZ4StreamDecompressor(dictionary);
+	EXPECT_TRUE(compressor.isAtStart());
+
+	// Independent blocks are interleaved with the stream, and decompressed in reverse order after it
+	Vector<std::pair<Bytes, Bytes>> independent;
+	for (int i = 0; i < 100; ++i) {
+		const auto packet = makePacket(i);
+		const auto span = gsl::as_bytes(gsl::span<const Byte>(packet));
+
+		Bytes compressed;
+		if (i % 3 == 0) {
+			compressor.compressIndependent(span, compressed);
+			EXPECT_LT(compressed.size(), packet.size() / 4);
+			independent.emplace_back(packet, std::move(compressed));
+		} else {
+			compressor.compress(span, compressed);
+			EXPECT_FALSE(compressor.isAtStart());
+			Bytes decompressed;
+			decompressor.decompress(gsl::as_bytes(gsl::span<const Byte>(compressed)), packet.size(), decompressed);
+			ASSERT_EQ(packet, decompressed);
+		}
+	}
+
+	for (auto iter = independent.rbegin(); iter != independent.rend(); ++iter) {
+		Bytes decompressed;
+		decompressor.decompressIndependent(gsl::as_bytes(gsl::span<const Byte>(iter->second)), iter->first.size(), decompressed);
+		ASSERT_EQ(iter->first, decompressed);
+
+		// A fresh decompressor that never saw the stream can read it too
+		decompressed.clear();
+		LZ4StreamDecompressor(dictionary).decompressIndependent(gsl::as_bytes(gsl::span<const Byte>(iter->second)), iter->first.size(), decompressed);
+		ASSERT_EQ(iter->first, decompressed);
+	}
+
+	compressor.reset();
+	EXPECT_TRUE(compressor.isAtStart());
+}
+
+TEST(Serializer, NetworkDictionaryTrainer)
+{
+	// Small packets made of the same kinds of records with different values, too short to compress well on their own
+	auto makePacket = [] (Random& rng)
+	{
+		Bytes bytes;
+		const int nRecords = rng.getInt(2, 5);
+		for (int i = 0; i < nRecords; ++i) {
+			const auto text = String("{\"entity\":") + toString(rng.getInt(0, 9999)) + ",\"components\":{\"Transform2D\":{\"position\":[" + toString(rng.getInt(-500, 500))
+				+ "," + toString(rng.getInt(-500, 500)) + "]},\"Sprite\":{\"sprite\":\"characters/" + (rng.getInt(0, 1) ? "player" : "enemy") + "_walk\"}}}";
+			bytes.insert(bytes.end(), text.c_str(), text.c_str() + text.size());
+		}
+		return bytes;
+	};
+
+	Random trainingRng(1u);
+	NetworkDictionaryTrainer trainer;
+	Bytes capture;
+	for (int i = 0; i < 300; ++i) {
+		const auto packet = makePacket(trainingRng);
+		const auto size = static_cast<uint32_t>(packet.size());
+		const auto* sizeBytes = reinterpret_cast<const Byte*>(&size);
+		capture.insert(capture.end(), sizeBytes, sizeBytes + sizeof(size));
+		capture.insert(capture.end(), packet.begin(), packet.end());
+	}
+	trainer.addCapture(gsl::as_bytes(gsl::span<const Byte>(capture)));
+	EXPECT_EQ(300, trainer.getNumSamples());
+
+	const auto dictionary = std::make_shared<const Bytes>(trainer.train(4 * 1024));
+	EXPECT_FALSE(dictionary->empty());
+	EXPECT_LE(dictionary->size(), 4 * 1024);
+
+	// Packets it wasn't trained on compress better with it than without, and still round trip
+	Random testRng(2u);
+	auto withDictionary = LZ4StreamCompressor(dictionary);
+	auto withoutDictionary = LZ4StreamCompressor();
+	const auto decompressor = LZ4StreamDecompressor(dictionary);
+	size_t sizeWith = 0;
+	size_t sizeWithout = 0;
+	for (int i = 0; i < 100; ++i) {
+		const auto packet = makePacket(testRng);
+		const auto span = gsl::as_bytes(gsl::span<const Byte>(packet));
+
+		Bytes compressed;
+		sizeWith += withDictionary.compressIndependent(span, compressed);
+		Bytes uncompressed;
+		sizeWithout += withoutDictionary.compressIndependent(span, uncompressed);
+
+		Bytes decompressed;
+		decompressor.decompressIndependent(gsl::as_bytes(gsl::span<const Byte>(compressed)), packet.size(), decompressed);
+		ASSERT_EQ(packet, decompressed);
+	}
+	EXPECT_LT(sizeWith, sizeWithout * 2 / 3);
+
+	// Truncated captures are rejected
+	EXPECT_THROW(trainer.addCapture(gsl::as_bytes(gsl::span<const Byte>(capture)).subspan(0, 10)), Exception);
+}
+
+TEST(Serializer, LZ4Chunked)
+{
+	// Alternates compressible and random chunks, and ends on a partial one
+	constexpr size_t chunkSize = 1024;
+	Random rng(1234u);
+	Bytes data(chunkSize * 10 + 300);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = static_cast<Byte>((i / chunkSize) % 2 == 0 ? (i / 16) & 0xFF : 0);
+	}
+	for (size_t chunk = 1; chunk * chunkSize < data.size(); chunk += 2) {
+		const auto len = std::min(chunkSize, data.size() - chunk * chunkSize);
+		rng.getBytes(gsl::as_writable_bytes(gsl::span<Byte>(data.data() + chunk * chunkSize, len)));
+	}
+
+	const auto compressed = Compression::lz4CompressChunked(gsl::as_bytes(gsl::span<const Byte>(data)), chunkSize);
+	const auto compressedSpan = gsl::as_bytes(gsl::span<const Byte>(compressed));
+	const auto header = Compression::lz4ReadChunkedHeader(compressedSpan);
+	EXPECT_EQ(11, header.numChunks);
+	EXPECT_EQ(data.size(), header.size);
+
+	// Random chunks don't shrink, so they're stored as they are
+	Vector<uint64_t> offsets(header.numChunks + 1);
+	memcpy(offsets.data(), compressed.data() + sizeof(header), offsets.size() * sizeof(uint64_t));
+	for (size_t i = 0; i < header.numChunks; ++i) {
+		const auto chunkLen = std::min(chunkSize, data.size() - i * chunkSize);
+		if (i % 2 == 0) {
+			EXPECT_LT(offsets[i + 1] - offsets[i], chunkLen) << "Chunk " << i;
+		} else {
+			EXPECT_EQ(offsets[i + 1] - offsets[i], chunkLen) << "Chunk " << i;
+			EXPECT_EQ(0, memcmp(compressed.data() + offsets[i], data.data() + i * chunkSize, chunkLen)) << "Chunk " << i;
+		}
+	}
+
+	size_t outSize = 0;
+	const auto decompressed = Compression::lz4DecompressChunkedToSharedPtr(compressedSpan, outSize);
+	ASSERT_EQ(data.size(), outSize);
+	EXPECT_EQ(0, memcmp(decompressed.get(), data.data(), data.size()));
+
+	for (const bool readAt: { true, false }) {
+		auto source = std::make_unique<TestMemoryReader>(compressed, readAt);
+		const auto& sourceRef = *source;
+		ResourceDataReaderLZ4Chunked reader(std::move(source));
+		EXPECT_EQ(data.size(), reader.size());
+
+		auto expectRead = [&] (size_t pos, size_t len)
+		{
+			Bytes buffer(len);
+			const auto n = reader.readAt(pos, buffer.byte_span());
+			const auto expected = pos < data.size() ? std::min(len, data.size() - pos) : 0;
+			ASSERT_EQ(expected, static_cast<size_t>(n)) << "Reading " << len << " at " << pos;
+			EXPECT_EQ(0, memcmp(buffer.data(), data.data() + pos, expected)) << "Reading " << len << " at " << pos;
+		};
+
+		// Across chunk boundaries, between compressed and stored chunks, and past the end
+		expectRead(0, 10);
+		expectRead(chunkSize - 10, 30);
+		expectRead(chunkSize * 2 - 1, 2);
+		expectRead(chunkSize + 500, chunkSize * 3);
+		expectRead(chunkSize * 10 - 5, 100);
+		expectRead(data.size() - 50, 100);
+		expectRead(data.size(), 10);
+		expectRead(0, data.size());
+
+		// Reads within the current chunk don't go back to the source
+		expectRead(chunkSize * 4 + 1, 10);
+		const auto nReads = sourceRef.getNumReads();
+		expectRead(chunkSize * 4 + 100, 10);
+		EXPECT_EQ(nReads, sourceRef.getNumReads());
+
+		// The read position is separate from readAt, and moves with seeks
+		Bytes buffer(200);
+		reader.seek(chunkSize * 3 - 100, SEEK_SET);
+		ASSERT_EQ(200, reader.read(buffer.byte_span()));
+		EXPECT_EQ(0, memcmp(buffer.data(), data.data() + chunkSize * 3 - 100, 200));
+		EXPECT_EQ(chunkSize * 3 + 100, reader.tell());
+		reader.seek(-150, SEEK_CUR);
+		ASSERT_EQ(200, reader.read(buffer.byte_span()));
+		EXPECT_EQ(0, memcmp(buffer.data(), data.data() + chunkSize * 3 - 50, 200));
+		reader.seek(-100, SEEK_END);
+		EXPECT_EQ(100, reader.read(buffer.byte_span()));
+		EXPECT_EQ(0, memcmp(buffer.data(), data.data() + data.size() - 100, 100));
+	}
+
+	// Empty input has no chunks
+	const auto empty = Compression::lz4CompressChunked(gsl::span<const gsl::byte>(), chunkSize);
+	EXPECT_EQ(0, Compression::lz4ReadChunkedHeader(gsl::as_bytes(gsl::span<const Byte>(empty))).numChunks);
+	ResourceDataReaderLZ4Chunked emptyReader(std::make_unique<TestMemoryReader>(empty));
+	EXPECT_EQ(0, emptyReader.size());
+}
@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "halley/maths/range.h"
+#include "halley/bytes/bit_serializer.h"
 #include "halley/bytes/config_node_serializer_base.h"
 
 namespace Halley
@@ -99,6 +100,7 @@ namespace Halley
 		bool hideInEditor = false;
 		bool collapse = false;
 		std::optional<Range<float>> range;
+		std::optional<BitQuantization> quantization;
 
 		ComponentFieldSchema(TypeSchema type, String name, Vector<String> defaultValue, std::optional<MemberAccess> access = {})
 			: MemberSchema(std::move(type), std::move(name), std::move(defaultValue), access)
@@ -0,0 +1,11 @@
+#pragma once
+#include "halley/tools/cli_tool.h"
+
+namespace Halley
+{
+	class NetworkDictionaryTool : public CommandLineTool
+	{
+	public:
+		int run(Vector<std::string> args) override;
+	};
+}
@@ -6,6 +6,8 @@
 #include "halley/resources/asset_database.h"
 
 namespace Halley {
+	class AssetPackIndex;
+
     class AssetPackInspector {
     public:
 	    explicit AssetPackInspector(String name);
@@ -33,6 +35,7 @@ namespace Halley {
 
 		void parseTable(Deserializer s, const Bytes& packBytes);
 	    void parseTypedDB(Deserializer& s, const Bytes& packBytes);
+		void parseIndex(const AssetPackIndex& index, const Bytes& packBytes);
 		void computeHash();
     };
 
@@ -26,6 +26,11 @@ void AssetCollector::output(const String& name, AssetType type, const Bytes& dat
 		Compression::LZ4Options options;
 		options.mode = Compression::LZ4Mode::HC;
 		outFiles.emplace_back(fullPath, Compression::lz4CompressFile(data.byte_span(), {}, options));
+	} else if (metadata && metadata->getString("asset_compression", "") == "lz4chunked") {
+		Compression::LZ4Options options;
+		options.mode = Compression::LZ4Mode::HC;
+		const auto chunkSize = static_cast<size_t>(metadata->getInt("asset_compression_chunk_size", static_cast<int>(Compression::defaultLZ4ChunkSize)));
+		outFiles.emplace_back(fullPath, Compression::lz4CompressChunked(data.byte_span(), chunkSize, options));
 	} else if (metadata && metadata->getString("asset_compression", "") == "deflate") {
 		auto newData = Compression::compress(data);
 		outFiles.emplace_back(fullPath, newData);
@@ -4,9 +4,24 @@
 #include "halley/file_formats/config_file.h"
 #include "halley/file_formats/yaml_convert.h"
 #include "halley/navigation/navmesh_set.h"
+#include "halley/resources/resource_dependency_graph.h"
 
 using namespace Halley;
 
+namespace {
+	void setPrefabDependencies(Metadata& meta, const Prefab& prefab)
+	{
+		// Instanced prefabs are loaded separately, so they're listed for hot reloading to find them
+		HashSet<String> ids;
+		for (const auto& name: prefab.getPrefabDependencies()) {
+			ids.insert(ResourceDependencyGraph::makeAssetId(AssetType::Prefab, name));
+		}
+		if (!ids.empty()) {
+			meta.set("dependencies", ResourceDependencyGraph::makeDependencyList(ids));
+		}
+	}
+}
+
 void ConfigImporter::import(const ImportingAsset& asset, IAssetCollector& collector)
 {
 	ConfigFile config = YAMLConvert::parseConfig(gsl::as_bytes(gsl::span<const Byte>(asset.inputFiles.at(0).data)));
@@ -24,6 +39,7 @@ void PrefabImporter::import(const ImportingAsset& asset, IAssetCollector& collec
 
 	Metadata meta = asset.inputFiles.at(0).metadata;
 	meta.set("asset_compression", "lz4");
+	setPrefabDependencies(meta, prefab);
 
 	collector.output(Path(asset.assetId).replaceExtension("").string(), AssetType::Prefab, Serializer::toBytes(prefab, SerializerOptions(SerializerOptions::maxVersion)), meta);
 }
@@ -35,6 +51,7 @@ void SceneImporter::import(const ImportingAsset& asset, IAssetCollector& collect
 
 	Metadata meta = asset.inputFiles.at(0).metadata;
 	meta.set("asset_compression", "lz4");
+	setPrefabDependencies(meta, scene);
 
 	collector.output(Path(asset.assetId).replaceExtension("").string(), AssetType::Scene, Serializer::toBytes(scene, SerializerOptions(SerializerOptions::maxVersion)), meta);
 }
@@ -4,6 +4,9 @@
 #include "halley/tools/assets/import_assets_database.h"
 #include "halley/tools/file/filesystem.h"
 #include "halley/file_formats/image.h"
+#include "halley/file_formats/block_compression.h"
+#include "halley/file_formats/hlif_file.h"
+#include "halley/support/logger.h"
 
 using namespace Halley;
 
@@ -23,6 +26,24 @@ void TextureImporter::import(const ImportingAsset& asset, IAssetCollector& colle
 	const bool useQOI = false;
 	const bool useHLIF = true;
 
+	// Opt-in per texture, e.g. "blockCompression: bc7" (or etc2/etc2Alpha for mobile), as it's lossy
+	if (const auto blockCompression = meta.getString("blockCompression", ""); !blockCompression.isEmpty()) {
+		const auto format = fromString<TextureFormat>(blockCompression);
+		if (useHLIF && BlockCompression::canEncode(image, format)) {
+			if (meta.getBool("mipmap", false)) {
+				// GPUs can't render into block compressed textures, so they can't generate mipmaps for them either
+				Logger::logWarning("Texture \"" + asset.assetId + "\" has mipmaps disabled, as they're not supported with blockCompression.");
+				meta.set("mipmap", false);
+			}
+			meta.set("compression", "hlif");
+			collector.output(asset.assetId, AssetType::Texture, HLIFFile::encodeBlocks(image, format, lz4hc), meta);
+			return;
+		}
+
+		Logger::logWarning("Texture \"" + asset.assetId + "\" can't be encoded as " + blockCompression + ", as it's " + toString(image.getSize()) + " " + toString(image.getFormat()) + ". Block compressed textures must be RGB(A), with dimensions that are multiples of 4.");
+		meta.erase("blockCompression");
+	}
+
 	if (useHLIF) {
 		meta.set("compression", "hlif");
 		collector.output(asset.assetId, AssetType::Texture, image.saveHLIFToBytes(asset.assetId, lz4hc), meta);
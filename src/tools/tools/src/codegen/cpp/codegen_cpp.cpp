@@ -27,6 +27,23 @@ static String lowerFirst(String name)
 	return name;
 }
 
+static String getQuantizationString(const BitQuantization& q)
+{
+	auto number = [] (double v) { return toString(v, 15, '.', false); };
+
+	switch (q.type) {
+	case BitQuantization::Type::Float:
+		return "Halley::BitQuantization::makeFloat(" + number(q.min) + ", " + number(q.max) + ", " + number(q.precision) + ")";
+	case BitQuantization::Type::Float2:
+		return "Halley::BitQuantization::makeFloat2(" + number(q.min) + ", " + number(q.max) + ", " + number(q.precision) + ")";
+	case BitQuantization::Type::Angle:
+		return "Halley::BitQuantization::makeAngle(" + toString(static_cast<int>(q.bits)) + ")";
+	case BitQuantization::Type::Int:
+		return "Halley::BitQuantization::makeInt(" + toString(static_cast<int64_t>(q.min)) + ", " + toString(static_cast<int64_t>(q.max)) + ")";
+	}
+	return "";
+}
+
 CodeGenResult CodegenCPP::generateComponent(ComponentSchema component)
 {
 	const String className = component.name + "Component" + (component.customImplementation ? "Base" : "");
@@ -208,11 +225,24 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 	const String lineBreak = getPlatform() == GamePlatform::Windows ? "\r\n\t\t" : "\n\t\t";
 	String serializeBody = "using namespace Halley::EntitySerialization;" + lineBreak + "Halley::ConfigNode _node = Halley::ConfigNode::MapType();" + lineBreak;
 	String deserializeBody = "using namespace Halley::EntitySerialization;" + lineBreak;
+	String networkStateBody;
+	Vector<String> quantizedFields;
 	bool first = true;
 	for (auto& member: component.members) {
 		if (member.serializationTypes.empty()) {
 			continue;
 		}
+
+		if (std_ex::contains(member.serializationTypes, EntitySerialization::Type::Network)) {
+			if (!networkStateBody.isEmpty()) {
+				networkStateBody += lineBreak;
+			}
+			networkStateBody += "Halley::EntityNetworkStateSerializer<decltype(" + member.name + ")>::serialize(" + member.name + ", _context, _s);";
+
+			if (member.quantization) {
+				quantizedFields.push_back("Halley::NetworkQuantizedField{ \"" + member.name + "\", " + getQuantizationString(*member.quantization) + " }");
+			}
+		}
 		
 		Vector<String> serializationTypes;
 		for (auto t: member.serializationTypes) {
@@ -235,7 +265,11 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 	gen
 		.setAccessLevel(MemberAccess::Public)
 		.addMember(MemberSchema(TypeSchema("int", false, true, true), "componentIndex", toString(component.id)))
-		.addMember(MemberSchema(TypeSchema("char*", true, true, true), "componentName", component.name))
+		.addMember(MemberSchema(TypeSchema("char*", true, true, true), "componentName", component.name));
+	if (!quantizedFields.empty()) {
+		gen.addMember(MemberSchema(TypeSchema("std::array<Halley::NetworkQuantizedField, " + toString(quantizedFields.size()) + ">", false, true, true), "networkQuantizedFields", quantizedFields));
+	}
+	gen
 		.addBlankLine()
 		.addMembers(component.members)
 		.addBlankLine()
@@ -260,6 +294,10 @@ Vector<String> CodegenCPP::generateComponentHeader(ComponentSchema component)
 		.addMethodDefinition(MethodSchema(TypeSchema("void"), {
 			VariableSchema(TypeSchema("Halley::EntitySerializationContext&", true), "_context"), VariableSchema(TypeSchema("Halley::ConfigNode&", true), "_node")
 		}, "deserialize"), deserializeBody)
+		.addBlankLine()
+		.addMethodDefinition(MethodSchema(TypeSchema("void"), {
+			VariableSchema(TypeSchema("Halley::EntitySerializationContext&", true), "_context"), VariableSchema(TypeSchema("Halley::Serializer&"), "_s")
+		}, "serializeNetworkState", true), networkStateBody.isEmpty() ? Vector<String>{} : Vector<String>{ networkStateBody })
 		.addBlankLine();
 
 	gen.finish()
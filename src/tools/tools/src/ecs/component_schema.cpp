@@ -7,6 +7,46 @@
 
 using namespace Halley;
 
+namespace {
+	enum class QuantizedFieldType {
+		Angle,
+		Float2,
+		Float,
+		Int
+	};
+
+	std::optional<QuantizedFieldType> getQuantizedFieldType(const String& typeName)
+	{
+		// Exact names only, so types that merely contain one of these (e.g. "Interval" or "Vector<Angle1f>") aren't mistaken for them
+		static const HashMap<String, QuantizedFieldType> types = {
+			{ "Angle1f", QuantizedFieldType::Angle },
+			{ "Halley::Angle1f", QuantizedFieldType::Angle },
+			{ "Vector2f", QuantizedFieldType::Float2 },
+			{ "Halley::Vector2f", QuantizedFieldType::Float2 },
+			{ "float", QuantizedFieldType::Float },
+			{ "double", QuantizedFieldType::Float },
+			{ "int", QuantizedFieldType::Int },
+			{ "short", QuantizedFieldType::Int },
+			{ "long", QuantizedFieldType::Int },
+			{ "int8_t", QuantizedFieldType::Int },
+			{ "int16_t", QuantizedFieldType::Int },
+			{ "int32_t", QuantizedFieldType::Int },
+			{ "int64_t", QuantizedFieldType::Int },
+			{ "uint8_t", QuantizedFieldType::Int },
+			{ "uint16_t", QuantizedFieldType::Int },
+			{ "uint32_t", QuantizedFieldType::Int },
+			{ "uint64_t", QuantizedFieldType::Int },
+			{ "size_t", QuantizedFieldType::Int }
+		};
+
+		const auto iter = types.find(typeName);
+		if (iter == types.end()) {
+			return std::nullopt;
+		}
+		return iter->second;
+	}
+}
+
 ComponentSchema::ComponentSchema() {}
 
 ComponentSchema::ComponentSchema(YAML::Node node, bool generate)
@@ -64,6 +104,35 @@ ComponentSchema::ComponentSchema(YAML::Node node, bool generate)
 					}
 				}
 
+				// e.g.
+				// quantize: { min: -1000, max: 1000, precision: 0.01 }
+				// quantize: { bits: 12 } (for angles)
+				std::optional<BitQuantization> quantization;
+				if (const auto& q = memberProperties["quantize"]; q.IsDefined()) {
+					const auto& fieldType = typeSchema.name;
+					const auto quantizedType = getQuantizedFieldType(fieldType);
+					if (!quantizedType) {
+						throw Exception("Field " + name + " of type " + fieldType + " can't be quantized.", HalleyExceptions::Tools);
+					}
+					switch (*quantizedType) {
+					case QuantizedFieldType::Angle:
+						quantization = BitQuantization::makeAngle(q["bits"].as<int>(12));
+						break;
+					case QuantizedFieldType::Float2:
+						quantization = BitQuantization::makeFloat2(q["min"].as<double>(), q["max"].as<double>(), q["precision"].as<double>());
+						break;
+					case QuantizedFieldType::Float:
+						quantization = BitQuantization::makeFloat(q["min"].as<double>(), q["max"].as<double>(), q["precision"].as<double>());
+						break;
+					case QuantizedFieldType::Int:
+						quantization = BitQuantization::makeInt(q["min"].as<int64_t>(), q["max"].as<int64_t>());
+						break;
+					}
+					if (serializeTypes.count(EntitySerialization::Type::Network) == 0) {
+						throw Exception("Field " + name + " is quantized, but isn't networked.", HalleyExceptions::Tools);
+					}
+				}
+
 				if (memberProperties["serializable"].IsDefined()) {
 					throw Exception("serializable field is removed from ECS component definitions. Use canSave and canEdit instead.", HalleyExceptions::Entity);
 				}
@@ -86,6 +155,7 @@ ComponentSchema::ComponentSchema(YAML::Node node, bool generate)
 				field.hideInEditor = hideInEditor;
 				field.displayName = displayName;
 				field.range = range;
+				field.quantization = quantization;
 			}
 		}
 	}
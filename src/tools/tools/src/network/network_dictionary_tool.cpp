@@ -0,0 +1,39 @@
+#include "halley/tools/network/network_dictionary_tool.h"
+#include "halley/net/entity/network_dictionary_trainer.h"
+#include "halley/tools/file/filesystem.h"
+#include "halley/text/halleystring.h"
+#include "halley/text/string_converter.h"
+#include "halley/support/logger.h"
+#include <iostream>
+
+using namespace Halley;
+
+int NetworkDictionaryTool::run(Vector<std::string> args)
+{
+	if (args.size() < 3) {
+		std::cout << "Usage: halley-cmd netDictionary dstFile maxSizeKB captureFile [captureFile...]" << std::endl;
+		std::cout << "Capture files are sequences of [uint32 size][bytes] records, one per packet." << std::endl;
+		return 1;
+	}
+
+	const auto dstPath = Path(args[0]);
+	const auto maxSize = static_cast<size_t>(String(args[1]).toInteger()) * 1024;
+
+	NetworkDictionaryTrainer trainer;
+	size_t totalSize = 0;
+	for (size_t i = 2; i < args.size(); ++i) {
+		const auto bytes = FileSystem::readFile(Path(args[i]));
+		trainer.addCapture(gsl::as_bytes(gsl::span<const Byte>(bytes)));
+		totalSize += bytes.size();
+	}
+
+	const auto dictionary = trainer.train(maxSize);
+	if (dictionary.empty()) {
+		Logger::logError("Not enough samples to train a dictionary.");
+		return 1;
+	}
+	FileSystem::writeFile(dstPath, dictionary);
+
+	Logger::logInfo("Trained " + String::prettySize(dictionary.size()) + " dictionary from " + toString(trainer.getNumSamples()) + " packets (" + String::prettySize(totalSize) + ").");
+	return 0;
+}
@@ -6,6 +6,7 @@
 #include "halley/bytes/compression.h"
 #include "halley/support/console.h"
 #include "halley/resources/asset_database.h"
+#include "halley/resources/asset_pack_index.h"
 #include "halley/utils/hash.h"
 
 using namespace Halley;
@@ -29,9 +30,14 @@ void AssetPackInspector::parse(const Bytes& bytes)
 	s >> tableSpan;
 
 	rawTableSize = tableData.size();
-	auto rawTableData = Compression::decompress(tableData);
-	tableSize = rawTableData.size();
-	parseTable(Deserializer(rawTableData), bytes);
+	if (header.isIndexed()) {
+		tableSize = tableData.size();
+		parseIndex(AssetPackIndex(std::move(tableData)), bytes);
+	} else {
+		auto rawTableData = Compression::decompress(tableData);
+		tableSize = rawTableData.size();
+		parseTable(Deserializer(rawTableData), bytes);
+	}
 
 	// Generated sorted entries
 	sortedEntries.resize(entries.size());
@@ -80,6 +86,26 @@ void AssetPackInspector::parseTypedDB(Deserializer& s, const Bytes& packBytes)
 	}
 }
 
+void AssetPackInspector::parseIndex(const AssetPackIndex& index, const Bytes& packBytes)
+{
+	// Listed in the same order as the serialized database, by type
+	Vector<const AssetPackIndex::Entry*> indexEntries;
+	for (const auto& e: index.getEntries()) {
+		indexEntries.push_back(&e);
+	}
+	std::stable_sort(indexEntries.begin(), indexEntries.end(), [] (const AssetPackIndex::Entry* a, const AssetPackIndex::Entry* b)
+	{
+		return a->type < b->type;
+	});
+
+	entries.reserve(indexEntries.size());
+	for (const auto* e: indexEntries) {
+		auto hash = Hash::hash(gsl::as_bytes(gsl::span<const Byte>(packBytes.data() + e->pos + dataStartPos, e->size)));
+		auto entry = AssetDatabase::Entry(toString(e->pos) + ":" + toString(e->size), index.getMetadata(*e));
+		entries.emplace_back(e->type, hash, String(index.getName(*e)), std::move(entry));
+	}
+}
+
 void AssetPackInspector::computeHash()
 {
 	Hash::Hasher hasher;
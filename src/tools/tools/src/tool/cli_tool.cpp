@@ -3,6 +3,7 @@
 #include "halley/tools/codegen/codegen_tool.h"
 #include "halley/tools/distance_field/distance_field_tool.h"
 #include "halley/tools/make_font/make_font_tool.h"
+#include "halley/tools/network/network_dictionary_tool.h"
 #include "halley/tools/assets/import_tool.h"
 #include "halley/tools/packer/asset_packer_tool.h"
 #include "halley/support/logger.h"
@@ -21,6 +22,7 @@ CommandLineTools::CommandLineTools()
 	factories["codegen"] = []() { return std::make_unique<CodegenTool>(); };
 	factories["distField"] = []() { return std::make_unique<DistanceFieldTool>(); };
 	factories["makeFont"] = []() { return std::make_unique<MakeFontTool>(); };
+	factories["netDictionary"] = []() { return std::make_unique<NetworkDictionaryTool>(); };
 	factories["pack"] = []() { return std::make_unique<AssetPackerTool>(); };
 	factories["pack-inspector"] = []() { return std::make_unique<AssetPackInspectorTool>(); };
 	factories["vs_project"] = []() { return std::make_unique<VSProjectTool>(); };